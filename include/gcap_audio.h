@@ -1,4 +1,5 @@
 #pragma once
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -43,16 +44,47 @@ extern "C"
     {
         const char *device_id; // 來自 Step 2 選到的 id
         int sample_rate;       // 建議 48000
-        int channels;          // 1 or 2
+        int channels;          // 1..8 (0 = 2); the device layout is up/down-mixed to it
     } gcap_audio_capture_config_t;
 
-    // 開始 audio capture（for recording）
+    // One captured packet: interleaved PCM16 at the configured rate / channels.
+    typedef struct gcap_audio_packet_t
+    {
+        const int16_t *data; // valid only during the callback
+        int frames;
+        int channels;
+        int sample_rate;
+        int64_t pts_100ns; // capture timeline, 0 = first sample
+        int discontinuity; // 1 = packets were dropped before this one
+    } gcap_audio_packet_t;
+
+    typedef void (*gcap_on_audio_cb)(const gcap_audio_packet_t *pkt, void *user);
+
+    // 開始 audio capture（獨立於錄影）
+    // Output is always PCM16 at cfg->sample_rate (0 = 48000) / cfg->channels (0 = 2),
+    // converted and resampled from the device format. A recording from the
+    // same endpoint shares the device client with this session.
+    // return: 0 (GCAP_OK) or a gcap_status_t error code
     GCAP_API int gcap_start_audio_capture(
         const gcap_audio_capture_config_t *cfg);
 
     // 停止 audio capture
     GCAP_API void gcap_stop_audio_capture(void);
 
+    // Callback mode: packets are handed over on a library thread straight
+    // from the capture ring (no copy); keep the callback short.
+    // Set before gcap_start_audio_capture; cb = NULL selects pull mode.
+    // return: 0 or a gcap_status_t error code (GCAP_ESTATE while capturing)
+    GCAP_API int gcap_set_audio_callback(gcap_on_audio_cb cb, void *user);
+
+    // Pull mode: wait up to timeout_ms for audio, then copy up to `frames`
+    // frames (channels * int16 each) of what is buffered into buf.
+    // Call from one thread at a time.
+    // return: frames copied (0 = timeout), or a negated gcap_status_t:
+    //         -GCAP_EINVAL (buf == NULL, frames < 0),
+    //         -GCAP_ESTATE (not capturing and nothing buffered, or callback mode)
+    GCAP_API int gcap_audio_read(int16_t *buf, int frames, int timeout_ms);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,4 +1,5 @@
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 #include "gcap_audio.h"
 
@@ -37,7 +38,8 @@ extern "C"
         GCAP_ENODEV,
         GCAP_ESTATE,
         GCAP_EIO,
-        GCAP_ENOTSUP
+        GCAP_ENOTSUP,
+        GCAP_ETIMEOUT
     } gcap_status_t;
 
     typedef enum
@@ -47,7 +49,12 @@ extern "C"
         GCAP_FMT_ARGB,
         GCAP_FMT_P010,
         GCAP_FMT_V210,
-        GCAP_FMT_R210
+        GCAP_FMT_R210,
+        GCAP_FMT_NV16, // 4:2:2 semi-planar, 8-bit (Y plane + full-height interleaved UV)
+        GCAP_FMT_P210, // 4:2:2 semi-planar, 10-bit in 16-bit containers (MSB-aligned)
+        GCAP_FMT_NV24, // 4:4:4 semi-planar, 8-bit
+        GCAP_FMT_Y210, // 4:2:2 packed Y0 U Y1 V, 10-bit in 16-bit containers (MSB-aligned)
+        GCAP_FMT_GRAY8 // luma only, 8-bit (video-range Y, as in NV12)
     } gcap_pixfmt_t;
 
     typedef struct
@@ -112,7 +119,7 @@ extern "C"
 
     typedef struct
     {
-        gcap_pixfmt_t preferred_pixfmt; // Auto=GCAP_FMT_*?（你可用 NV12/YUY2/P010）
+        gcap_pixfmt_t preferred_pixfmt; // format delivered to the video callback (CPU path); ARGB when no conversion exists
         gcap_deinterlace_t deinterlace;
         gcap_range_t force_range; // unknown=auto
     } gcap_processing_opts_t;
@@ -134,22 +141,266 @@ extern "C"
         gcap_pixfmt_t format;
         uint64_t pts_ns;
         uint64_t frame_id;
+        void *pool_ref; // internal; non-NULL when the frame lives in a pooled buffer
     } gcap_frame_t;
 
+    // ---- Privacy masks (burned into native planes before record / convert) ----
+#define GCAP_MASK_MAX_POINTS 16
+
+    typedef enum
+    {
+        GCAP_MASK_PIXELATE = 0,
+        GCAP_MASK_BLUR,
+        GCAP_MASK_FILL
+    } gcap_mask_mode_t;
+
+    typedef struct
+    {
+        gcap_mask_mode_t mode;
+        int x, y, width, height;              // rectangle (used when point_count == 0)
+        int point_count;                      // 3..GCAP_MASK_MAX_POINTS => polygon
+        int points[GCAP_MASK_MAX_POINTS][2];  // polygon vertices (x, y) in frame pixels
+        int strength;                         // pixelate block / blur radius in pixels (0=default)
+        uint8_t fill_r, fill_g, fill_b;       // GCAP_MASK_FILL colour
+    } gcap_mask_region_t;
+
+    // ---- Per-input picture health (computed on a subsampled luma grid) ----
+    typedef struct
+    {
+        uint64_t frame_id;    // frame the metrics were computed on (0 = none yet)
+        double focus;         // Laplacian variance, higher = sharper
+        double noise;         // estimated noise sigma (8-bit code values)
+        double clipped_ratio; // share of luma samples at/above nominal white (235)
+        double crushed_ratio; // share of luma samples at/below nominal black (16)
+        double mean_luma;     // 8-bit code values
+    } gcap_health_stats_t;
+
+    // ---- Recording audio levels (updated every 100 ms on the capture thread) ----
+#define GCAP_AUDIO_MAX_CHANNELS 8
+#define GCAP_AUDIO_LEVEL_FLOOR_DB (-120.0f) // silence / not measured yet
+    typedef struct
+    {
+        int channels;                            // 0 = no audio measured yet
+        float peak_db[GCAP_AUDIO_MAX_CHANNELS];  // sample peak of the last 100 ms, dBFS
+        float rms_db[GCAP_AUDIO_MAX_CHANNELS];   // RMS of the last 100 ms, dBFS (full-scale sine = -3)
+        float momentary_lufs;                    // EBU R128, 400 ms window
+        float short_term_lufs;                   // EBU R128, 3 s window
+        float integrated_lufs;                   // EBU R128 gated, since the recording started
+        uint64_t frames;                         // sample frames measured
+    } gcap_audio_levels_t;
+
+    // ---- Recording A/V clock drift (audio clock measured against video PTS) ----
+    typedef struct
+    {
+        int active;            // 1 while the estimate spans enough history to be applied
+        double drift_ppm;      // audio clock rate vs video clock, + = audio runs fast
+        double correction_ppm; // resampling trim applied to the recorded audio
+        double drift_ms;       // A/V offset the drift would have built up since recording started
+        double jitter_ms;      // RMS scatter of audio arrival around the fitted line
+        double window_s;       // video time covered by the current estimate
+        uint32_t rebases;      // restarts after audio glitches / timestamp jumps
+    } gcap_av_sync_stats_t;
+
+    // ---- Video clock recovery (device timestamps smoothed into frame PTS) ----
+    typedef struct
+    {
+        int locked;          // 1 once the fit spans enough frames to stand without the nominal rate
+        double nominal_fps;  // negotiated media type rate (0 = unknown)
+        double measured_fps; // frames actually delivered per second, over the fit window
+        double clock_fps;    // recovered frame clock (1 / fitted frame period)
+        double jitter_ms;    // RMS of device timestamps around the recovered clock
+        double offset_ms;    // last delivered pts minus its device timestamp
+        uint64_t frames;     // frames timed since gcap_start
+        uint64_t dropped;    // frames missing from the device clock (gaps in the timestamps)
+        uint32_t resyncs;    // restarts after discontinuities / timestamp jumps
+    } gcap_clock_stats_t;
+
+    // ---- Pipeline statistics (gcap_get_stats) ----
+    typedef enum
+    {
+        GCAP_STAGE_READ = 0, // waiting in ReadSample for the next frame
+        GCAP_STAGE_LOCK,     // getting at the sample's pixels (contiguous buffer + Lock, or GPU upload)
+        GCAP_STAGE_CONVERT,  // CPU conversion for the callback, or GPU conversion + readback
+        GCAP_STAGE_RECORD,   // handing the frame to the recorder (incl. its conversion)
+        GCAP_STAGE_CALLBACK, // inside the video callback
+        GCAP_STAGE_COUNT
+    } gcap_stage_t;
+
+    typedef struct
+    {
+        uint64_t count;                           // samples
+        uint64_t mean_ns, max_ns;
+        uint64_t p50_ns, p90_ns, p99_ns, p999_ns; // within 12.5%
+    } gcap_latency_t;
+
+    typedef struct
+    {
+        uint64_t frames_captured;   // samples read from the device
+        uint64_t frames_delivered;  // video callbacks made
+        uint64_t frames_dropped;    // not delivered: queue / buffer drops and frame-rate pacing
+        uint64_t frames_duplicated; // extra deliveries from frame-rate pacing
+        uint64_t frames_lost;       // gaps in the device clock (see gcap_get_clock_stats)
+        uint64_t bytes_copied;      // frame data deep-copied for the queue, the mailbox and pacing
+        int queue_depth;            // frames waiting for the callback right now
+        int queue_high_water;
+        gcap_latency_t stage[GCAP_STAGE_COUNT];
+    } gcap_stats_t;
+
+    // ---- Recording output scaler (applied to native planes) ----
+    typedef enum
+    {
+        GCAP_SCALE_BILINEAR = 0,
+        GCAP_SCALE_BICUBIC,  // Catmull-Rom
+        GCAP_SCALE_LANCZOS3
+    } gcap_scale_filter_t;
+
+    // ---- Video callback delivery ----
+    typedef enum
+    {
+        GCAP_DELIVERY_SYNC = 0,    // callback runs on the capture thread (default)
+        GCAP_DELIVERY_DROP_OLDEST, // queue full: evict the oldest queued frame
+        GCAP_DELIVERY_DROP_NEWEST, // queue full: discard the incoming frame
+        GCAP_DELIVERY_BLOCK,       // queue full: capture thread waits for the consumer
+        GCAP_DELIVERY_LATEST       // mailbox: only the newest frame is kept
+    } gcap_delivery_policy_t;
+
+    typedef struct
+    {
+        gcap_delivery_policy_t policy;
+        int queue_depth;            // configured capacity (1 for LATEST, 0 for SYNC)
+        int queued;                 // frames waiting right now
+        int high_water;             // most frames ever waiting
+        uint64_t delivered;         // callbacks made
+        uint64_t dropped_oldest;    // evicted (DROP_OLDEST / LATEST)
+        uint64_t dropped_newest;    // discarded on arrival (DROP_NEWEST)
+        uint64_t dropped_no_buffer; // no free frame buffer (consumer holds them all)
+        uint64_t flushed;           // still queued at gcap_stop
+        uint64_t blocked_ns;        // capture thread time spent waiting (BLOCK)
+    } gcap_delivery_stats_t;
+
+    // Frame-rate conversion of the main video output (gcap_set_frame_rate)
+    typedef struct
+    {
+        int fps_num, fps_den; // target; 0 / 1 = pacing off
+        int blend;            // non-zero: in-between frames are blended
+        uint64_t frames_in;   // source frames seen
+        uint64_t frames_out;  // frames delivered at the target rate
+        uint64_t dropped;     // source frames not delivered (never converted unless blending)
+        uint64_t duplicated;  // extra deliveries of a source frame
+        uint64_t blended;     // deliveries mixed from two source frames
+        uint64_t skipped;     // output slots left empty by a source gap
+    } gcap_pacing_stats_t;
+
     typedef void (*gcap_on_video_cb)(const gcap_frame_t *frame, void *user);
     typedef void (*gcap_on_error_cb)(gcap_status_t code, const char *msg, void *user);
 
+    // ---- Structured logging (gcap_set_log_callback) ----
+    typedef enum
+    {
+        GCAP_LOG_DEBUG = 0,
+        GCAP_LOG_INFO,
+        GCAP_LOG_WARN,
+        GCAP_LOG_ERROR
+    } gcap_log_level_t;
+
+    typedef struct
+    {
+        gcap_log_level_t level;
+        uint64_t time_ns;    // steady clock when the message was logged (the clock of gcap_write_trace)
+        uint32_t thread_id;  // OS id of the logging thread
+        uint32_t suppressed; // messages from the same call site rate-limited away since the previous one
+        const char *file;    // call site in the library source
+        int line;
+        const char *message; // formatted; valid during the callback only
+    } gcap_log_record_t;
+
+    typedef void (*gcap_on_log_cb)(const gcap_log_record_t *rec, void *user);
+
+    // ---- Thread scheduling and placement (gcap_set_thread_config) ----
+    typedef enum
+    {
+        GCAP_THREAD_PRIORITY_NORMAL = 0, // OS default
+        GCAP_THREAD_PRIORITY_HIGH,       // Windows: HIGHEST (MMCSS: HIGH); Linux: nice -10
+        GCAP_THREAD_PRIORITY_REALTIME    // Windows: TIME_CRITICAL (MMCSS: CRITICAL); Linux: SCHED_FIFO
+    } gcap_thread_priority_t;
+
+    typedef struct
+    {
+        gcap_thread_priority_t priority;
+        int mmcss;              // Windows: join MMCSS ("Capture" / "Pro Audio"); ignored elsewhere
+        uint64_t affinity_mask; // bit n = logical CPU n of affinity_group; 0 = no restriction
+        int affinity_group;     // Windows processor group; Linux: CPUs 64 * group + n
+        int numa_node;          // -1 = none; else the threads keep to this node's CPUs (within
+                                // affinity_mask) and frame buffers are allocated on it
+    } gcap_thread_config_t;
+
+    // ---- Additional video consumers (each with its own format / size / rate) ----
+    typedef struct
+    {
+        gcap_pixfmt_t format;         // delivered format
+        int width, height;            // 0, 0 = capture size; otherwise even
+        gcap_scale_filter_t filter;   // used when resizing
+        int max_fps_num, max_fps_den; // rate cap, e.g. 15/1; 0 = every frame
+        gcap_on_video_cb cb;
+        void *user;
+    } gcap_consumer_desc_t;
+
     typedef struct gcap_handle_t *gcap_handle;
 
+    // Device lists (video and audio) are cached process-wide and refreshed on
+    // hotplug / default-device changes, so polling these calls is cheap.
     gcap_status_t gcap_enumerate(gcap_device_info_t *out, int max, int *count);
     gcap_status_t gcap_open(int device_index, gcap_handle *out);
     gcap_status_t gcap_set_profile(gcap_handle h, const gcap_profile_t *prof);
+    // count = frames the CPU path can have in flight (0 = default 4, max 64);
+    // bytes_hint = minimum size of each buffer (0 = frame size).
     gcap_status_t gcap_set_buffers(gcap_handle h, int count, size_t bytes_hint);
     gcap_status_t gcap_set_callbacks(gcap_handle h, gcap_on_video_cb vcb, gcap_on_error_cb ecb, void *user);
+    // Diagnostics of this handle at min_level and above go to cb, on a logger
+    // thread, instead of the error callback (where they arrive with GCAP_OK
+    // while no log callback is set). Messages logged before the callback was
+    // set (e.g. during gcap_open) are delivered first. Each call site is
+    // rate-limited; logging never blocks or allocates on the capture thread.
+    // cb = NULL restores the error-callback route. Not from inside cb.
+    GCAP_API gcap_status_t gcap_set_log_callback(gcap_handle h, gcap_on_log_cb cb, gcap_log_level_t min_level, void *user);
+    // Priority, CPU affinity and NUMA node of this handle's capture, delivery
+    // and recording-audio threads; takes effect at the next gcap_start (audio:
+    // gcap_start_recording). EINVAL for a node the machine does not have. What
+    // the OS refuses (e.g. realtime priority without the privilege) is logged
+    // as a warning and the thread runs with the rest of the settings.
+    GCAP_API gcap_status_t gcap_set_thread_config(gcap_handle h, const gcap_thread_config_t *cfg);
+    // Register another video consumer next to gcap_set_callbacks' callback.
+    // Consumers asking for the same format and size share one conversion,
+    // the primary callback's output is reused when it matches, and an output
+    // is not converted at all on frames where all of its consumers are
+    // rate-limited out. Callbacks run on the capture thread (CPU and GPU
+    // paths); keep frames with gcap_frame_ref. Usable while streaming.
+    GCAP_API gcap_status_t gcap_add_consumer(gcap_handle h, const gcap_consumer_desc_t *desc, int *out_id);
+    // After this returns the consumer's callback is not running and is not
+    // called again (when called from that callback: after it returns).
+    GCAP_API gcap_status_t gcap_remove_consumer(gcap_handle h, int consumer_id);
+    // Run the video callback on a delivery thread behind a bounded queue of
+    // queue_depth frames (0 = default 3; ignored for SYNC / LATEST), so a slow
+    // consumer no longer stalls capture. Takes effect at the next gcap_start.
+    GCAP_API gcap_status_t gcap_set_delivery(gcap_handle h, gcap_delivery_policy_t policy, int queue_depth);
+    // Counters since the last gcap_start; lock-free, any thread.
+    GCAP_API gcap_status_t gcap_get_delivery_stats(gcap_handle h, gcap_delivery_stats_t *out);
+    // Deliver the main video output at a constant fps_num / fps_den (0 = source
+    // rate), dropping or repeating frames by pts before they are converted.
+    // Delivered frames carry the output-slot time in pts_ns and the source
+    // frame_id. With blend, a slot between two source frames gets a mix of
+    // both (one frame more latency; V210 / R210 are never blended). Takes
+    // effect on the next frame; extra consumers keep their own rate caps.
+    GCAP_API gcap_status_t gcap_set_frame_rate(gcap_handle h, int fps_num, int fps_den, int blend);
+    // Counters since the last gcap_start; lock-free, any thread.
+    GCAP_API gcap_status_t gcap_get_pacing_stats(gcap_handle h, gcap_pacing_stats_t *out);
     gcap_status_t gcap_start(gcap_handle h);
     gcap_status_t gcap_start_recording(gcap_handle h, const char *path_utf8);
     gcap_status_t gcap_stop_recording(gcap_handle h);
     gcap_status_t gcap_stop(gcap_handle h);
+    // Encode at width x height instead of the capture size (0, 0 = capture size).
+    // Sizes must be even; takes effect at the next gcap_start_recording.
+    GCAP_API gcap_status_t gcap_set_recording_size(gcap_handle h, int width, int height, gcap_scale_filter_t filter);
     // Enumerate WASAPI capture endpoints (microphones / capture devices)
     GCAP_API gcap_status_t gcap_enumerate_audio_devices(gcap_audio_device_t *out, int max, int *count);
     // Select which WASAPI capture endpoint to use for recording.
@@ -166,6 +417,38 @@ extern "C"
     gcap_status_t gcap_get_signal_status(gcap_handle h, gcap_signal_status_t *out);
     gcap_status_t gcap_set_processing(gcap_handle h, const gcap_processing_opts_t *opts);
 
+    // Replace the privacy mask list (count = 0 clears). Masks apply from the next frame.
+    GCAP_API gcap_status_t gcap_set_privacy_masks(gcap_handle h, const gcap_mask_region_t *regions, int count);
+
+    // Compute health metrics every N frames (0 = off, the default).
+    GCAP_API gcap_status_t gcap_set_health_interval(gcap_handle h, int every_n_frames);
+    // Latest health metrics; frame_id = 0 until the first computation.
+    GCAP_API gcap_status_t gcap_get_health_stats(gcap_handle h, gcap_health_stats_t *out);
+
+    // Levels of the recording audio (see gcap_audio_levels_t); lock-free, any thread.
+    // Values persist after gcap_stop_recording until the next recording starts.
+    GCAP_API gcap_status_t gcap_get_audio_levels(gcap_handle h, gcap_audio_levels_t *out);
+    // Drift of the recording audio clock against the video timestamps, and the
+    // correction applied to it; lock-free, any thread.
+    GCAP_API gcap_status_t gcap_get_av_sync_stats(gcap_handle h, gcap_av_sync_stats_t *out);
+    // Video frame PTS are device timestamps smoothed by clock recovery: steady,
+    // strictly increasing, and free of USB arrival jitter. These are its
+    // measurements since the last gcap_start; lock-free, any thread.
+    GCAP_API gcap_status_t gcap_get_clock_stats(gcap_handle h, gcap_clock_stats_t *out);
+    // Frame counters and per-stage latency histograms since the last gcap_start;
+    // collected with relaxed atomics on the capture / delivery threads, read
+    // from any thread.
+    GCAP_API gcap_status_t gcap_get_stats(gcap_handle h, gcap_stats_t *out);
+
+    // Pipeline tracing (process-wide): per-thread rings of timed scopes (capture
+    // loop, convert, record, callback, WASAPI reads). enable = 1 starts a fresh
+    // session; events_per_thread = 0 uses the default (65536), at most 4M.
+    // While off the instrumentation costs one relaxed load per scope.
+    GCAP_API gcap_status_t gcap_set_tracing(int enable, int events_per_thread);
+    // Dump the current session as Chrome trace JSON (chrome://tracing, Perfetto).
+    // May be called while tracing is on; the oldest events of a full ring are lost.
+    GCAP_API gcap_status_t gcap_write_trace(const char *path_utf8);
+
     // 回傳系統可用的 audio capture device 數量
     GCAP_API int gcap_get_audio_device_count(void);
 
@@ -173,6 +456,22 @@ extern "C"
     // 回傳實際寫入的數量
     GCAP_API int gcap_enum_audio_devices(gcap_audio_device_t *out_devices, int max_devices);
 
+    // Keep a frame past the video callback. Pooled frames are shared without a
+    // copy (a held frame occupies one gcap_set_buffers slot until released);
+    // any other frame is deep-copied. Returns NULL on allocation failure.
+    // Release with gcap_frame_unref, from any thread, also after gcap_close.
+    GCAP_API const gcap_frame_t *gcap_frame_ref(const gcap_frame_t *frame);
+    GCAP_API void gcap_frame_unref(const gcap_frame_t *frame);
+
+    // Pull mode: the newest frame not acquired yet, without a copy on the CPU
+    // conversion path. Returns at once when one is ready; otherwise waits up
+    // to timeout_ms (0 = poll, -1 = forever) and fails with GCAP_ETIMEOUT, or
+    // GCAP_ESTATE when not streaming. Unread frames are replaced by newer
+    // ones. Works alongside the video callback; the first call enables it.
+    GCAP_API gcap_status_t gcap_acquire_frame(gcap_handle h, int timeout_ms, const gcap_frame_t **out);
+    // Same as gcap_frame_unref; a held frame occupies one gcap_set_buffers slot.
+    GCAP_API gcap_status_t gcap_release_frame(gcap_handle h, const gcap_frame_t *frame);
+
     const char *gcap_strerror(gcap_status_t);
 
 #ifdef __cplusplus
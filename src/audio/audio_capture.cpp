@@ -0,0 +1,166 @@
+// audio_capture.cpp
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include "audio_capture.h"
+#include <windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    std::wstring utf8_to_wide(const char *s)
+    {
+        if (!s || !*s)
+            return {};
+        const int len = MultiByteToWideChar(CP_UTF8, 0, s, -1, nullptr, 0);
+        if (len <= 0)
+            return {};
+        std::wstring out((size_t)len - 1, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, s, -1, out.data(), len);
+        return out;
+    }
+}
+
+namespace gcap::audio
+{
+    AudioCaptureSession::~AudioCaptureSession()
+    {
+        stop();
+    }
+
+    bool AudioCaptureSession::running() const
+    {
+        std::lock_guard<std::mutex> lk(stateMutex_);
+        return capturing();
+    }
+
+    bool AudioCaptureSession::setCallback(gcap_on_audio_cb cb, void *user)
+    {
+        std::lock_guard<std::mutex> lk(stateMutex_);
+        if (capturing())
+            return false;
+        cb_ = cb;
+        user_ = user;
+        return true;
+    }
+
+    bool AudioCaptureSession::start(const char *deviceIdUtf8, int sampleRate, int channels)
+    {
+        std::lock_guard<std::mutex> lk(stateMutex_);
+        if (capturing())
+            return false;
+
+        {
+            // the source is replaced by start(): no reader may be inside its ring
+            std::lock_guard<std::mutex> rlk(readMutex_);
+            hasCur_ = false;
+            curOffset_ = 0;
+
+            const std::wstring id = utf8_to_wide(deviceIdUtf8);
+            capture_ = create_audio_source(id);
+            AudioFormat af{};
+            if (!capture_ || !capture_->start((uint32_t)sampleRate, (uint32_t)channels, 16, id, &af))
+            {
+                if (capture_)
+                    capture_->stop();
+                return false;
+            }
+            sampleRate_ = (int)af.sampleRate;
+            channels_ = (int)af.channels;
+        }
+
+        if (cb_)
+        {
+            dispatching_.store(true);
+            dispatcher_ = std::thread([this]()
+                                      { this->dispatch(); });
+        }
+        return true;
+    }
+
+    void AudioCaptureSession::stop()
+    {
+        std::lock_guard<std::mutex> lk(stateMutex_);
+        // wakes a blocked read() / the dispatcher
+        if (capture_)
+            capture_->stop();
+        dispatching_.store(false);
+        if (dispatcher_.joinable())
+            dispatcher_.join();
+
+        std::lock_guard<std::mutex> rlk(readMutex_);
+        hasCur_ = false;
+        curOffset_ = 0;
+    }
+
+    void AudioCaptureSession::dispatch()
+    {
+        AudioChunk ck;
+        while (dispatching_.load())
+        {
+            if (!capture_->waitForData(50))
+                continue;
+            while (dispatching_.load() && capture_->peek(ck))
+            {
+                gcap_audio_packet_t pkt{};
+                pkt.data = reinterpret_cast<const int16_t *>(ck.pcm);
+                pkt.frames = (int)(ck.bytes / ((uint32_t)channels_ * sizeof(int16_t)));
+                pkt.channels = channels_;
+                pkt.sample_rate = sampleRate_;
+                pkt.pts_100ns = ck.ts100ns;
+                pkt.discontinuity = ck.discontinuity ? 1 : 0;
+                cb_(&pkt, user_);
+                capture_->release();
+            }
+        }
+    }
+
+    int AudioCaptureSession::read(int16_t *dst, int frames, int timeoutMs)
+    {
+        std::lock_guard<std::mutex> lk(readMutex_);
+        if (dispatching_.load())
+            return -1;
+        // after stop() whatever is still buffered can be drained
+        if (!capture_ || (!capture_->running() && !hasCur_ && !capture_->peek(cur_)))
+            return -1;
+
+        const uint32_t frameBytes = (uint32_t)channels_ * sizeof(int16_t);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeoutMs));
+        uint8_t *out = reinterpret_cast<uint8_t *>(dst);
+        int done = 0;
+        while (done < frames)
+        {
+            if (!hasCur_)
+            {
+                if (!capture_->peek(cur_))
+                {
+                    // return what is buffered rather than waiting for a full request
+                    if (done)
+                        break;
+                    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - std::chrono::steady_clock::now());
+                    if (left.count() <= 0 || !capture_->waitForData((int)left.count()))
+                        break;
+                    continue;
+                }
+                hasCur_ = true;
+                curOffset_ = 0;
+            }
+
+            const uint32_t avail = (cur_.bytes - curOffset_) / frameBytes;
+            const uint32_t n = std::min(avail, (uint32_t)(frames - done));
+            memcpy(out + (size_t)done * frameBytes, cur_.pcm + curOffset_, (size_t)n * frameBytes);
+            curOffset_ += n * frameBytes;
+            done += (int)n;
+            if (curOffset_ + frameBytes > cur_.bytes)
+            {
+                capture_->release();
+                hasCur_ = false;
+            }
+        }
+        return done;
+    }
+}
@@ -0,0 +1,69 @@
+// audio_capture.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "gcap_audio.h"
+#include "audio_source.h"
+
+namespace gcap::audio
+{
+    /**
+     * @brief Standalone audio capture behind gcap_start_audio_capture().
+     *
+     * One IAudioSource (WASAPI, or synthetic for "synthetic:..." ids; the
+     * device client is shared with a recording of the same endpoint, see
+     * SharedAudioSource) whose ring is consumed in one of two modes:
+     *  - pull: read() copies PCM16 frames straight out of the ring into the
+     *    caller's buffer, splitting packets across calls as needed;
+     *  - callback: a dispatch thread hands each packet to the callback as a
+     *    pointer into the ring (no copy) and releases it on return.
+     *
+     * start()/stop() may be called from any thread; read() from one thread
+     * at a time (the ring has a single consumer).
+     */
+    class AudioCaptureSession
+    {
+    public:
+        AudioCaptureSession() = default;
+        ~AudioCaptureSession();
+
+        AudioCaptureSession(const AudioCaptureSession &) = delete;
+        AudioCaptureSession &operator=(const AudioCaptureSession &) = delete;
+
+        // Applies to the next start(); nullptr selects pull mode. Fails while running.
+        bool setCallback(gcap_on_audio_cb cb, void *user);
+
+        // deviceIdUtf8: endpoint id (nullptr / "" = default capture device).
+        bool start(const char *deviceIdUtf8, int sampleRate, int channels);
+        void stop();
+        bool running() const;
+
+        // Frames copied (0 on timeout); -1 when not capturing or in callback mode.
+        int read(int16_t *dst, int frames, int timeoutMs);
+
+    private:
+        void dispatch();
+        bool capturing() const { return capture_ && capture_->running(); }
+
+        mutable std::mutex stateMutex_; // start / stop
+        std::mutex readMutex_;          // ring consumer side
+        // replaced by start() under both locks; kept after stop() so read() can drain it
+        std::unique_ptr<IAudioSource> capture_;
+        int sampleRate_ = 0;
+        int channels_ = 0;
+
+        gcap_on_audio_cb cb_ = nullptr;
+        void *user_ = nullptr;
+        std::thread dispatcher_;
+        std::atomic<bool> dispatching_{false};
+
+        // pull mode: packet being consumed
+        AudioChunk cur_{};
+        uint32_t curOffset_ = 0;
+        bool hasCur_ = false;
+    };
+}
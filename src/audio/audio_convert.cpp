@@ -0,0 +1,330 @@
+// audio_convert.cpp
+#include "audio_convert.h"
+#include "../core/simd.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    using gcap::audio::Kernel;
+
+    std::atomic<Kernel> g_kernel{Kernel::Auto};
+
+    // Kernel the next conversion runs, Auto resolved.
+    inline Kernel active_kernel()
+    {
+        const Kernel k = g_kernel.load(std::memory_order_relaxed);
+        if (k != Kernel::Auto)
+            return k;
+#if defined(GCAP_SIMD_SSE2)
+        return gcap::simd::cpu_has_avx2() ? Kernel::Avx2 : Kernel::Sse2;
+#elif defined(GCAP_SIMD_NEON)
+        return Kernel::Neon;
+#else
+        return Kernel::Scalar;
+#endif
+    }
+
+    constexpr float kLo = -32767.0f;
+    constexpr float kHi = 32767.0f;
+
+    // Work in blocks so dither and int->float staging live on the stack.
+    constexpr size_t kBlock = 256;
+
+    inline uint32_t xorshift32(uint32_t &s)
+    {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        return s;
+    }
+
+    // Two 16-bit uniforms from one draw: (a + b) / 65536 - 1 is triangular over [-1, 1).
+    void fill_dither(gcap::audio::TpdfDither &d, float *out, size_t n)
+    {
+        uint32_t s = d.state;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const uint32_t r = xorshift32(s);
+            out[i] = (float)((int)(r & 0xFFFFu) + (int)(r >> 16) - 65536) * (1.0f / 65536.0f);
+        }
+        d.state = s;
+    }
+
+    // Same comparisons as the SIMD max/min, so NaN ends up at kLo.
+    inline int16_t quantize(float v)
+    {
+        v = v > kLo ? v : kLo;
+        v = v < kHi ? v : kHi;
+        return (int16_t)lrintf(v);
+    }
+
+    // dst[i] = quantize(src[i] * scale (+ dith[i])), SIMD part; returns samples done
+#if defined(GCAP_SIMD_AVX2)
+    template <bool Dither>
+    GCAP_TARGET_AVX2 size_t quantize_avx2(const float *src, float scale, const float *dith, int16_t *dst, size_t n)
+    {
+        const __m256 k = _mm256_set1_ps(scale);
+        const __m256 lo = _mm256_set1_ps(kLo);
+        const __m256 hi = _mm256_set1_ps(kHi);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            __m256 a = _mm256_mul_ps(_mm256_loadu_ps(src + i), k);
+            __m256 b = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), k);
+            if (Dither)
+            {
+                a = _mm256_add_ps(a, _mm256_loadu_ps(dith + i));
+                b = _mm256_add_ps(b, _mm256_loadu_ps(dith + i + 8));
+            }
+            a = _mm256_min_ps(_mm256_max_ps(a, lo), hi);
+            b = _mm256_min_ps(_mm256_max_ps(b, lo), hi);
+            // packs works per 128-bit lane: a0-3 b0-3 a4-7 b4-7 -> reorder quadwords
+            const __m256i p = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_permute4x64_epi64(p, 0xD8));
+        }
+        return i;
+    }
+#endif
+
+    template <bool Dither>
+    size_t quantize_simd(const float *src, float scale, const float *dith, int16_t *dst, size_t n)
+    {
+        size_t i = 0;
+        const Kernel kernel = active_kernel();
+        if (kernel == Kernel::Scalar)
+            return i;
+#if defined(GCAP_SIMD_AVX2)
+        if (kernel == Kernel::Avx2)
+            return quantize_avx2<Dither>(src, scale, dith, dst, n);
+#endif
+#if defined(GCAP_SIMD_SSE2)
+        const __m128 k = _mm_set1_ps(scale);
+        const __m128 lo = _mm_set1_ps(kLo);
+        const __m128 hi = _mm_set1_ps(kHi);
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), k);
+            __m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), k);
+            if (Dither)
+            {
+                a = _mm_add_ps(a, _mm_loadu_ps(dith + i));
+                b = _mm_add_ps(b, _mm_loadu_ps(dith + i + 4));
+            }
+            a = _mm_min_ps(_mm_max_ps(a, lo), hi);
+            b = _mm_min_ps(_mm_max_ps(b, lo), hi);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                             _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+        }
+#elif defined(GCAP_SIMD_NEON)
+        const float32x4_t lo = vdupq_n_f32(kLo);
+        const float32x4_t hi = vdupq_n_f32(kHi);
+        for (; i + 8 <= n; i += 8)
+        {
+            float32x4_t a = vmulq_n_f32(vld1q_f32(src + i), scale);
+            float32x4_t b = vmulq_n_f32(vld1q_f32(src + i + 4), scale);
+            if (Dither)
+            {
+                a = vaddq_f32(a, vld1q_f32(dith + i));
+                b = vaddq_f32(b, vld1q_f32(dith + i + 4));
+            }
+            // vmaxq/vminq propagate NaN; select explicitly to match the scalar path
+            a = vbslq_f32(vcgtq_f32(a, lo), a, lo);
+            a = vbslq_f32(vcltq_f32(a, hi), a, hi);
+            b = vbslq_f32(vcgtq_f32(b, lo), b, lo);
+            b = vbslq_f32(vcltq_f32(b, hi), b, hi);
+            vst1q_s16(dst + i, vcombine_s16(vmovn_s32(vcvtnq_s32_f32(a)), vmovn_s32(vcvtnq_s32_f32(b))));
+        }
+#endif
+        return i;
+    }
+
+    template <bool Dither>
+    void quantize_block(const float *src, float scale, const float *dith, int16_t *dst, size_t n)
+    {
+        size_t i = quantize_simd<Dither>(src, scale, dith, dst, n);
+        for (; i < n; ++i)
+        {
+            float v = src[i] * scale;
+            if (Dither)
+                v += dith[i];
+            dst[i] = quantize(v);
+        }
+    }
+
+    // Staged conversion for the dithered integer paths: load() fills `n`
+    // floats already scaled to 16-bit LSBs.
+    template <typename Load>
+    void quantize_staged(size_t samples, int16_t *dst, gcap::audio::TpdfDither &d, Load load)
+    {
+        alignas(32) float tmp[kBlock];
+        alignas(32) float dith[kBlock];
+        for (size_t off = 0; off < samples; off += kBlock)
+        {
+            const size_t n = std::min(kBlock, samples - off);
+            load(off, n, tmp);
+            fill_dither(d, dith, n);
+            quantize_block<true>(tmp, 1.0f, dith, dst + off, n);
+        }
+    }
+
+    inline int32_t load_s24(const uint8_t *p)
+    {
+        return (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+    }
+}
+
+namespace gcap::audio
+{
+    bool kernel_supported(Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case Kernel::Auto:
+        case Kernel::Scalar:
+            return true;
+#if defined(GCAP_SIMD_SSE2)
+        case Kernel::Sse2:
+            return true;
+        case Kernel::Avx2:
+            return simd::cpu_has_avx2();
+#endif
+#if defined(GCAP_SIMD_NEON)
+        case Kernel::Neon:
+            return true;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    bool set_kernel(Kernel kernel)
+    {
+        if (!kernel_supported(kernel))
+            return false;
+        g_kernel.store(kernel, std::memory_order_relaxed);
+        return true;
+    }
+
+    Kernel kernel()
+    {
+        return g_kernel.load(std::memory_order_relaxed);
+    }
+
+    void f32_to_s16(const float *src, int16_t *dst, size_t samples, TpdfDither *dither)
+    {
+        if (!dither)
+        {
+            quantize_block<false>(src, kHi, nullptr, dst, samples);
+            return;
+        }
+
+        alignas(32) float dith[kBlock];
+        for (size_t off = 0; off < samples; off += kBlock)
+        {
+            const size_t n = std::min(kBlock, samples - off);
+            fill_dither(*dither, dith, n);
+            quantize_block<true>(src + off, kHi, dith, dst + off, n);
+        }
+    }
+
+    void s32_to_s16(const int32_t *src, int16_t *dst, size_t samples, TpdfDither *dither)
+    {
+        if (dither)
+        {
+            quantize_staged(samples, dst, *dither, [src](size_t off, size_t n, float *out)
+                            {
+                                for (size_t i = 0; i < n; ++i)
+                                    out[i] = (float)src[off + i] * (1.0f / 65536.0f); });
+            return;
+        }
+
+        size_t i = 0;
+        const size_t vec = active_kernel() == Kernel::Scalar ? 0 : samples;
+#if defined(GCAP_SIMD_SSE2)
+        // >> 16 leaves every value in int16 range, so packs never saturates
+        for (; i + 8 <= vec; i += 8)
+        {
+            const __m128i a = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), 16);
+            const __m128i b = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 4)), 16);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packs_epi32(a, b));
+        }
+#elif defined(GCAP_SIMD_NEON)
+        for (; i + 8 <= vec; i += 8)
+            vst1q_s16(dst + i, vcombine_s16(vshrn_n_s32(vld1q_s32(src + i), 16),
+                                            vshrn_n_s32(vld1q_s32(src + i + 4), 16)));
+#endif
+        for (; i < samples; ++i)
+            dst[i] = (int16_t)(src[i] >> 16);
+    }
+
+    void s24_to_s16(const uint8_t *src, int16_t *dst, size_t samples, TpdfDither *dither)
+    {
+        if (dither)
+        {
+            quantize_staged(samples, dst, *dither, [src](size_t off, size_t n, float *out)
+                            {
+                                for (size_t i = 0; i < n; ++i)
+                                    out[i] = (float)load_s24(src + (off + i) * 3) * (1.0f / 256.0f); });
+            return;
+        }
+
+        // top two bytes of each little-endian triplet
+        for (size_t i = 0; i < samples; ++i)
+            dst[i] = (int16_t)(uint16_t)(src[i * 3 + 1] | src[i * 3 + 2] << 8);
+    }
+
+    void to_s16(const void *src, SampleType type, int16_t *dst, size_t samples, TpdfDither *dither)
+    {
+        switch (type)
+        {
+        case SampleType::F32:
+            f32_to_s16(static_cast<const float *>(src), dst, samples, dither);
+            break;
+        case SampleType::S32:
+            s32_to_s16(static_cast<const int32_t *>(src), dst, samples, dither);
+            break;
+        case SampleType::S24:
+            s24_to_s16(static_cast<const uint8_t *>(src), dst, samples, dither);
+            break;
+        case SampleType::S16:
+        default:
+            memcpy(dst, src, samples * sizeof(int16_t));
+            break;
+        }
+    }
+
+    void to_f32(const void *src, SampleType type, float *dst, size_t samples)
+    {
+        switch (type)
+        {
+        case SampleType::F32:
+            memcpy(dst, src, samples * sizeof(float));
+            break;
+        case SampleType::S32:
+        {
+            const int32_t *in = static_cast<const int32_t *>(src);
+            for (size_t i = 0; i < samples; ++i)
+                dst[i] = (float)in[i] * (1.0f / 2147483648.0f);
+            break;
+        }
+        case SampleType::S24:
+        {
+            const uint8_t *in = static_cast<const uint8_t *>(src);
+            for (size_t i = 0; i < samples; ++i)
+                dst[i] = (float)load_s24(in + i * 3) * (1.0f / 8388608.0f);
+            break;
+        }
+        case SampleType::S16:
+        default:
+        {
+            const int16_t *in = static_cast<const int16_t *>(src);
+            for (size_t i = 0; i < samples; ++i)
+                dst[i] = (float)in[i] * (1.0f / 32768.0f);
+            break;
+        }
+        }
+    }
+}
@@ -0,0 +1,76 @@
+// audio_convert.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace gcap::audio
+{
+    // Interleaved sample layouts accepted by to_s16().
+    enum class SampleType
+    {
+        S16, // int16
+        S24, // packed 3-byte little-endian int24
+        S32, // int32 (also 24-in-32 containers, MSB-aligned)
+        F32, // float32, nominal range [-1, 1]
+    };
+
+    /**
+     * @brief Triangular (TPDF) dither generator, one per stream.
+     *
+     * Each sample gets the sum of two independent uniform values in
+     * [-0.5, 0.5) LSB, i.e. a triangular distribution over (-1, 1) LSB. The
+     * sequence depends only on the seed, so SIMD and scalar paths produce the
+     * same output.
+     */
+    struct TpdfDither
+    {
+        uint32_t state = 0x9E3779B9u;
+
+        explicit TpdfDither(uint32_t seed = 0x9E3779B9u) : state(seed ? seed : 0x9E3779B9u) {}
+    };
+
+    /*
+     * Conversions to int16. All of them accept a null `dither`.
+     *
+     *  - float: x * 32767 (+ dither), clamped to [-32767, 32767], rounded to
+     *    nearest-even (NaN -> -32767).
+     *  - int32/int24 without dither: the top 16 bits (truncation).
+     *  - int32/int24 with dither: the value in 16-bit LSBs (+ dither), clamped
+     *    and rounded like float.
+     *
+     * SSE2 / AVX2 (runtime-selected) / NEON kernels are bit-exact with the
+     * scalar code.
+     */
+    void f32_to_s16(const float *src, int16_t *dst, size_t samples, TpdfDither *dither = nullptr);
+    void s32_to_s16(const int32_t *src, int16_t *dst, size_t samples, TpdfDither *dither = nullptr);
+    void s24_to_s16(const uint8_t *src, int16_t *dst, size_t samples, TpdfDither *dither = nullptr);
+
+    // Dispatch on `type`; S16 is copied unchanged.
+    void to_s16(const void *src, SampleType type, int16_t *dst, size_t samples, TpdfDither *dither = nullptr);
+
+    // Interleaved samples to float; integers are scaled by 2^-(bits-1).
+    void to_f32(const void *src, SampleType type, float *dst, size_t samples);
+
+    // Kernels behind the int16 conversions. Auto takes the best one the CPU
+    // has; the others let tests and benchmarks compare paths. Conversions
+    // without an AVX2 version run their SSE2 code under Avx2.
+    enum class Kernel
+    {
+        Auto,
+        Scalar,
+        Sse2,
+        Avx2,
+        Neon,
+    };
+
+    bool kernel_supported(Kernel kernel);
+    // Process-wide; false (and nothing changes) when the kernel is not supported.
+    bool set_kernel(Kernel kernel);
+    Kernel kernel();
+
+    // Bytes per sample of `type`.
+    constexpr int sample_bytes(SampleType type)
+    {
+        return type == SampleType::S16 ? 2 : type == SampleType::S24 ? 3 : 4;
+    }
+}
@@ -6,6 +6,7 @@
 #include <audioclient.h>
 #include <functiondiscoverykeys_devpkey.h>
 
+#include <utility>
 #include <vector>
 
 #pragma comment(lib, "ole32.lib")
@@ -34,25 +35,106 @@ static std::string wide_to_utf8(const wchar_t *w)
     return out;
 }
 
+namespace
+{
+    // Forwards endpoint changes to a callback; lives as long as the process.
+    class EndpointNotifier final : public IMMNotificationClient
+    {
+    public:
+        explicit EndpointNotifier(std::function<void()> onChange) : onChange_(std::move(onChange)) {}
+
+        ULONG STDMETHODCALLTYPE AddRef() override { return InterlockedIncrement(&ref_); }
+        ULONG STDMETHODCALLTYPE Release() override
+        {
+            const ULONG n = InterlockedDecrement(&ref_);
+            if (n == 0)
+                delete this;
+            return n;
+        }
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv) override
+        {
+            if (!ppv)
+                return E_POINTER;
+            if (riid == __uuidof(IUnknown) || riid == __uuidof(IMMNotificationClient))
+            {
+                *ppv = static_cast<IMMNotificationClient *>(this);
+                AddRef();
+                return S_OK;
+            }
+            *ppv = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR, DWORD) override { return notify(); }
+        HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR) override { return notify(); }
+        HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR) override { return notify(); }
+        HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow flow, ERole, LPCWSTR) override
+        {
+            return flow == eCapture ? notify() : S_OK;
+        }
+        // names and formats are part of the cached list too; other properties change often
+        HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR, const PROPERTYKEY key) override
+        {
+            const bool listed = (key.fmtid == PKEY_Device_FriendlyName.fmtid && key.pid == PKEY_Device_FriendlyName.pid) ||
+                                (key.fmtid == PKEY_AudioEngine_DeviceFormat.fmtid && key.pid == PKEY_AudioEngine_DeviceFormat.pid);
+            return listed ? notify() : S_OK;
+        }
+
+    private:
+        HRESULT notify()
+        {
+            onChange_();
+            return S_OK;
+        }
+
+        LONG ref_ = 1;
+        std::function<void()> onChange_;
+    };
+}
+
 namespace gcap::audio
 {
-    std::vector<device> enumerate_devices()
+    bool enumerate_devices(std::vector<device> &out)
     {
-        std::vector<device> out;
+        out.clear();
 
-        CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        const HRESULT init = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        struct ComScope
+        {
+            bool owned;
+            ~ComScope()
+            {
+                if (owned)
+                    CoUninitialize();
+            }
+        } com{SUCCEEDED(init)};
 
         IMMDeviceEnumerator *enumerator = nullptr;
         if (FAILED(CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr,
                                     CLSCTX_ALL, IID_PPV_ARGS(&enumerator))))
-            return out;
+            return false;
+
+        std::string defaultId;
+        {
+            IMMDevice *def = nullptr;
+            if (SUCCEEDED(enumerator->GetDefaultAudioEndpoint(eCapture, eConsole, &def)))
+            {
+                LPWSTR wid = nullptr;
+                if (SUCCEEDED(def->GetId(&wid)))
+                {
+                    defaultId = wide_to_utf8(wid);
+                    CoTaskMemFree(wid);
+                }
+                def->Release();
+            }
+        }
 
         IMMDeviceCollection *collection = nullptr;
         if (FAILED(enumerator->EnumAudioEndpoints(
                 eCapture, DEVICE_STATE_ACTIVE, &collection)))
         {
             enumerator->Release();
-            return out;
+            return false;
         }
 
         UINT count = 0;
@@ -113,14 +195,44 @@ namespace gcap::audio
                 client->Release();
             }
 
+            info.is_default = !defaultId.empty() && info.id == defaultId;
             dev->Release();
             out.push_back(info);
         }
 
         collection->Release();
         enumerator->Release();
-        CoUninitialize();
+        return true;
+    }
 
-        return out;
+    bool watch_devices(std::function<void()> onChange)
+    {
+        // Keep the process MTA alive instead of joining this thread to it:
+        // the caller's apartment (an STA UI thread, or none) is left as it
+        // was, and without an apartment the thread uses the implicit MTA.
+        CO_MTA_USAGE_COOKIE mta = nullptr;
+        if (FAILED(CoIncrementMTAUsage(&mta)))
+            return false;
+
+        IMMDeviceEnumerator *enumerator = nullptr;
+        if (FAILED(CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr,
+                                    CLSCTX_ALL, IID_PPV_ARGS(&enumerator))))
+        {
+            CoDecrementMTAUsage(mta);
+            return false;
+        }
+
+        auto *client = new EndpointNotifier(std::move(onChange));
+        const HRESULT hr = enumerator->RegisterEndpointNotificationCallback(client);
+        if (FAILED(hr))
+        {
+            client->Release();
+            enumerator->Release();
+            CoDecrementMTAUsage(mta);
+            return false;
+        }
+        // enumerator, client and the MTA usage are intentionally leaked: the
+        // registration lives as long as the process
+        return true;
     }
 }
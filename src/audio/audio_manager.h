@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -13,7 +14,14 @@ namespace gcap::audio
         int sample_rate = 0;
         int bits_per_sample = 0;
         bool is_float = false;
+        bool is_default = false; // default console capture endpoint
     };
 
-    std::vector<device> enumerate_devices();
+    // Active WASAPI capture endpoints; false when the enumerator is unavailable.
+    bool enumerate_devices(std::vector<device> &out);
+
+    // Calls onChange (from a system thread) whenever a capture endpoint is
+    // added, removed, changes state or becomes the default. Registered for
+    // the life of the process; false when notifications are unavailable.
+    bool watch_devices(std::function<void()> onChange);
 }
@@ -0,0 +1,350 @@
+// audio_meter.cpp
+#include "audio_meter.h"
+#include "channel_mixer.h"
+#include "../core/simd.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    using gcap::audio::LevelMeter;
+
+    constexpr double kPi = 3.14159265358979323846;
+    constexpr int kMaxCh = LevelMeter::kMaxChannels;
+    constexpr float kFloor = LevelMeter::kFloorDb;
+    constexpr double kAbsGate = -70.0; // LUFS
+    constexpr double kRelGate = -10.0; // LU below the absolute-gated mean
+
+    double energy_to_lufs(double e)
+    {
+        return e > 0.0 ? -0.691 + 10.0 * std::log10(e) : (double)kFloor;
+    }
+
+    int popcount_mask(uint32_t v)
+    {
+        int n = 0;
+        for (; v; v &= v - 1)
+            ++n;
+        return n;
+    }
+
+    float to_db(float power)
+    {
+        return power > 1e-12f ? std::max(kFloor, 10.0f * std::log10(power)) : kFloor;
+    }
+
+    // BS.1770 gain of a speaker position: surrounds +1.5 dB, LFE excluded.
+    float channel_weight(uint32_t spk)
+    {
+        using namespace gcap::audio;
+        switch (spk)
+        {
+        case kSpkLowFrequency:
+            return 0.0f;
+        case kSpkBackLeft:
+        case kSpkBackRight:
+        case kSpkBackCenter:
+        case kSpkSideLeft:
+        case kSpkSideRight:
+            return 1.41f;
+        default:
+            return 1.0f;
+        }
+    }
+
+    struct Stage
+    {
+        float b0, b1, b2, a1, a2;
+    };
+
+    /*
+     * One frame of up to kMaxCh channels (x is zero-padded to a multiple of
+     * four): both K-weighting stages, then ksum += y^2, sq += x^2 and
+     * peak = max(peak, |x|).
+     */
+    void kweight_frame(const float *x, int groups, const Stage *st, float (*z1)[kMaxCh], float (*z2)[kMaxCh],
+                       float *ksum, float *sq, float *peak)
+    {
+#if defined(GCAP_SIMD_SSE2)
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        for (int g = 0; g < groups; ++g)
+        {
+            const int o = g * 4;
+            const __m128 in = _mm_load_ps(x + o);
+            __m128 v = in;
+            for (int s = 0; s < 2; ++s)
+            {
+                const __m128 za = _mm_load_ps(z1[s] + o);
+                const __m128 zb = _mm_load_ps(z2[s] + o);
+                const __m128 y = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(st[s].b0), v), za);
+                _mm_store_ps(z1[s] + o, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(st[s].b1), v),
+                                                              _mm_mul_ps(_mm_set1_ps(st[s].a1), y)),
+                                                   zb));
+                _mm_store_ps(z2[s] + o, _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(st[s].b2), v),
+                                                   _mm_mul_ps(_mm_set1_ps(st[s].a2), y)));
+                v = y;
+            }
+            _mm_store_ps(ksum + o, _mm_add_ps(_mm_load_ps(ksum + o), _mm_mul_ps(v, v)));
+            _mm_store_ps(sq + o, _mm_add_ps(_mm_load_ps(sq + o), _mm_mul_ps(in, in)));
+            _mm_store_ps(peak + o, _mm_max_ps(_mm_load_ps(peak + o), _mm_and_ps(in, absMask)));
+        }
+#elif defined(GCAP_SIMD_NEON)
+        for (int g = 0; g < groups; ++g)
+        {
+            const int o = g * 4;
+            const float32x4_t in = vld1q_f32(x + o);
+            float32x4_t v = in;
+            for (int s = 0; s < 2; ++s)
+            {
+                const float32x4_t y = vmlaq_n_f32(vld1q_f32(z1[s] + o), v, st[s].b0);
+                vst1q_f32(z1[s] + o, vmlsq_n_f32(vmlaq_n_f32(vld1q_f32(z2[s] + o), v, st[s].b1), y, st[s].a1));
+                vst1q_f32(z2[s] + o, vmlsq_n_f32(vmulq_n_f32(v, st[s].b2), y, st[s].a2));
+                v = y;
+            }
+            vst1q_f32(ksum + o, vmlaq_f32(vld1q_f32(ksum + o), v, v));
+            vst1q_f32(sq + o, vmlaq_f32(vld1q_f32(sq + o), in, in));
+            vst1q_f32(peak + o, vmaxq_f32(vld1q_f32(peak + o), vabsq_f32(in)));
+        }
+#else
+        for (int c = 0; c < groups * 4; ++c)
+        {
+            float v = x[c];
+            for (int s = 0; s < 2; ++s)
+            {
+                const float y = st[s].b0 * v + z1[s][c];
+                z1[s][c] = st[s].b1 * v - st[s].a1 * y + z2[s][c];
+                z2[s][c] = st[s].b2 * v - st[s].a2 * y;
+                v = y;
+            }
+            ksum[c] += v * v;
+            sq[c] += x[c] * x[c];
+            peak[c] = std::max(peak[c], std::fabs(x[c]));
+        }
+#endif
+    }
+}
+
+namespace gcap::audio
+{
+    LevelMeter::LevelMeter()
+    {
+        for (int c = 0; c < kMaxChannels; ++c)
+        {
+            pubPeak_[c].store(kFloorDb, std::memory_order_relaxed);
+            pubRms_[c].store(kFloorDb, std::memory_order_relaxed);
+        }
+        reset();
+    }
+
+    void LevelMeter::configure(int sampleRate, int channels, uint32_t channelMask)
+    {
+        rate_ = sampleRate > 0 ? sampleRate : 0;
+        stride_ = channels > 0 ? channels : 0;
+        channels_ = std::min(stride_, kMaxChannels);
+        blockFrames_ = (size_t)(rate_ / 10);
+
+        // BS.1770-4 K-weighting, coefficients derived for any sample rate
+        // (the published 48 kHz values are reproduced exactly).
+        if (rate_)
+        {
+            const double fs = (double)rate_;
+            // stage 1: high shelf, +4 dB above ~1.7 kHz (head diffraction)
+            double f0 = 1681.974450955533, G = 3.999843853973347, Q = 0.7071752369554196;
+            double K = std::tan(kPi * f0 / fs);
+            const double Vh = std::pow(10.0, G / 20.0);
+            const double Vb = std::pow(Vh, 0.4996667741545416);
+            double a0 = 1.0 + K / Q + K * K;
+            b0_[0] = (float)((Vh + Vb * K / Q + K * K) / a0);
+            b1_[0] = (float)(2.0 * (K * K - Vh) / a0);
+            b2_[0] = (float)((Vh - Vb * K / Q + K * K) / a0);
+            a1_[0] = (float)(2.0 * (K * K - 1.0) / a0);
+            a2_[0] = (float)((1.0 - K / Q + K * K) / a0);
+            // stage 2: RLB high-pass at ~38 Hz
+            f0 = 38.13547087602444;
+            Q = 0.5003270373238773;
+            K = std::tan(kPi * f0 / fs);
+            a0 = 1.0 + K / Q + K * K;
+            b0_[1] = 1.0f;
+            b1_[1] = -2.0f;
+            b2_[1] = 1.0f;
+            a1_[1] = (float)(2.0 * (K * K - 1.0) / a0);
+            a2_[1] = (float)((1.0 - K / Q + K * K) / a0);
+        }
+
+        if (popcount_mask(channelMask) != channels)
+            channelMask = default_channel_mask(channels);
+        int c = 0;
+        for (uint32_t bit = 1; bit && c < channels_; bit <<= 1)
+            if (channelMask & bit)
+                weight_[c++] = channel_weight(bit);
+        for (; c < kMaxChannels; ++c)
+            weight_[c] = c < channels_ ? 1.0f : 0.0f; // unknown layout: count every channel
+
+        reset();
+        pubChannels_.store(channels_, std::memory_order_relaxed);
+    }
+
+    void LevelMeter::reset()
+    {
+        std::fill(&z1_[0][0], &z1_[0][0] + 2 * kMaxChannels, 0.0f);
+        std::fill(&z2_[0][0], &z2_[0][0] + 2 * kMaxChannels, 0.0f);
+        std::fill(kSum_, kSum_ + kMaxChannels, 0.0f);
+        std::fill(sqSum_, sqSum_ + kMaxChannels, 0.0f);
+        std::fill(peak_, peak_ + kMaxChannels, 0.0f);
+        std::fill(blockEnergy_, blockEnergy_ + kShortBlocks, 0.0);
+        std::fill(histCount_, histCount_ + kHistBins, 0u);
+        std::fill(histEnergy_, histEnergy_ + kHistBins, 0.0);
+        blockPos_ = 0;
+        blocks_ = 0;
+        blockHead_ = 0;
+        frames_ = 0;
+        pubFrames_.store(0, std::memory_order_relaxed);
+
+        float floor[kMaxChannels];
+        std::fill(floor, floor + kMaxChannels, kFloorDb);
+        publish(floor, floor, kFloorDb, kFloorDb, kFloorDb);
+    }
+
+    void LevelMeter::process(const int16_t *pcm, size_t frames)
+    {
+        if (!channels_ || !blockFrames_ || !pcm)
+            return;
+
+        const Stage st[2] = {{b0_[0], b1_[0], b2_[0], a1_[0], a2_[0]},
+                             {b0_[1], b1_[1], b2_[1], a1_[1], a2_[1]}};
+        const int groups = (channels_ + 3) / 4;
+        alignas(16) float x[kMaxChannels] = {};
+
+        for (size_t f = 0; f < frames; ++f, pcm += stride_)
+        {
+            for (int c = 0; c < channels_; ++c)
+                x[c] = (float)pcm[c] * (1.0f / 32768.0f);
+            kweight_frame(x, groups, st, z1_, z2_, kSum_, sqSum_, peak_);
+            if (++blockPos_ == blockFrames_)
+                endBlock();
+        }
+        frames_ += frames;
+        pubFrames_.store(frames_, std::memory_order_relaxed);
+    }
+
+    void LevelMeter::endBlock()
+    {
+        const float inv = 1.0f / (float)blockFrames_;
+        float peakDb[kMaxChannels], rmsDb[kMaxChannels];
+        double e = 0.0;
+        for (int c = 0; c < kMaxChannels; ++c)
+        {
+            e += (double)weight_[c] * kSum_[c] * inv;
+            peakDb[c] = c < channels_ ? to_db(peak_[c] * peak_[c]) : kFloorDb;
+            rmsDb[c] = c < channels_ ? to_db(sqSum_[c] * inv) : kFloorDb;
+            kSum_[c] = sqSum_[c] = peak_[c] = 0.0f;
+            // keep decaying filter state out of the denormal range
+            for (int s = 0; s < 2; ++s)
+            {
+                if (std::fabs(z1_[s][c]) < 1e-20f)
+                    z1_[s][c] = 0.0f;
+                if (std::fabs(z2_[s][c]) < 1e-20f)
+                    z2_[s][c] = 0.0f;
+            }
+        }
+        blockPos_ = 0;
+
+        blockEnergy_[blockHead_] = e;
+        blockHead_ = (blockHead_ + 1) % kShortBlocks;
+        if (blocks_ < kShortBlocks)
+            ++blocks_;
+
+        // mean energy of the newest n blocks
+        auto window = [this](int n)
+        {
+            double sum = 0.0;
+            for (int i = 1; i <= n; ++i)
+                sum += blockEnergy_[(blockHead_ - i + kShortBlocks) % kShortBlocks];
+            return sum / n;
+        };
+
+        float momentary = kFloorDb, shortTerm = kFloorDb;
+        if (blocks_ >= 4)
+        {
+            // every 400 ms window (75 % overlap) is one gating block
+            const double em = window(4);
+            const double lm = energy_to_lufs(em);
+            momentary = (float)std::max(lm, (double)kFloorDb);
+            if (lm >= kAbsGate)
+            {
+                const int bin = std::min(kHistBins - 1, (int)((lm - kAbsGate) * 10.0));
+                ++histCount_[bin];
+                histEnergy_[bin] += em;
+            }
+        }
+        if (blocks_ >= kShortBlocks)
+            shortTerm = (float)std::max(energy_to_lufs(window(kShortBlocks)), (double)kFloorDb);
+
+        // two-pass gating over the histogram; the relative gate is resolved to 0.1 LU
+        float integrated = kFloorDb;
+        uint64_t n = 0;
+        double sum = 0.0;
+        for (int i = 0; i < kHistBins; ++i)
+        {
+            n += histCount_[i];
+            sum += histEnergy_[i];
+        }
+        if (n)
+        {
+            const double gate = energy_to_lufs(sum / (double)n) + kRelGate;
+            const int first = std::max(0, (int)std::floor((gate - kAbsGate) * 10.0));
+            n = 0;
+            sum = 0.0;
+            for (int i = first; i < kHistBins; ++i)
+            {
+                n += histCount_[i];
+                sum += histEnergy_[i];
+            }
+            if (n)
+                integrated = (float)std::max(energy_to_lufs(sum / (double)n), (double)kFloorDb);
+        }
+
+        publish(peakDb, rmsDb, momentary, shortTerm, integrated);
+    }
+
+    void LevelMeter::publish(const float *peakDb, const float *rmsDb, float momentary, float shortTerm,
+                             float integrated)
+    {
+        // odd while writing; readers retry on odd or changed values
+        const uint32_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (int c = 0; c < kMaxChannels; ++c)
+        {
+            pubPeak_[c].store(peakDb[c], std::memory_order_relaxed);
+            pubRms_[c].store(rmsDb[c], std::memory_order_relaxed);
+        }
+        pubMomentary_.store(momentary, std::memory_order_relaxed);
+        pubShortTerm_.store(shortTerm, std::memory_order_relaxed);
+        pubIntegrated_.store(integrated, std::memory_order_relaxed);
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    void LevelMeter::levels(gcap_audio_levels_t &out) const
+    {
+        for (;;)
+        {
+            const uint32_t s = seq_.load(std::memory_order_acquire);
+            if (s & 1u)
+                continue;
+            out.channels = pubChannels_.load(std::memory_order_relaxed);
+            out.frames = pubFrames_.load(std::memory_order_relaxed);
+            for (int c = 0; c < kMaxChannels; ++c)
+            {
+                out.peak_db[c] = pubPeak_[c].load(std::memory_order_relaxed);
+                out.rms_db[c] = pubRms_[c].load(std::memory_order_relaxed);
+            }
+            out.momentary_lufs = pubMomentary_.load(std::memory_order_relaxed);
+            out.short_term_lufs = pubShortTerm_.load(std::memory_order_relaxed);
+            out.integrated_lufs = pubIntegrated_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == s)
+                return;
+        }
+    }
+}
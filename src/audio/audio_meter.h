@@ -0,0 +1,83 @@
+// audio_meter.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "gcapture.h"
+
+namespace gcap::audio
+{
+    /**
+     * @brief Sample peak / RMS per channel and EBU R128 loudness.
+     *
+     * process() runs on the capture thread with the PCM16 that goes into the
+     * ring. Each frame passes the BS.1770 K-weighting (high shelf + RLB
+     * high-pass), evaluated four channels per SIMD lane; sums are taken per
+     * 100 ms block, so momentary (400 ms), short-term (3 s) and the gated
+     * integrated loudness are updated incrementally from block energies.
+     * Integrated loudness keeps a 0.1 LU histogram of 400 ms blocks instead
+     * of the block list, so memory is fixed and nothing allocates.
+     *
+     * Results are published once per block through a sequence counter;
+     * levels() may be called from any thread and never blocks the writer.
+     */
+    class LevelMeter
+    {
+    public:
+        static constexpr int kMaxChannels = GCAP_AUDIO_MAX_CHANNELS;
+        static constexpr float kFloorDb = GCAP_AUDIO_LEVEL_FLOOR_DB;
+        static_assert(kMaxChannels % 4 == 0, "channels are filtered in groups of four");
+
+        LevelMeter();
+
+        // Capture thread; resets all measurements. Channels beyond
+        // kMaxChannels are not measured.
+        void configure(int sampleRate, int channels, uint32_t channelMask = 0);
+        void reset();
+        void process(const int16_t *pcm, size_t frames);
+
+        // Any thread. channels = 0 until configure().
+        void levels(gcap_audio_levels_t &out) const;
+
+    private:
+        void endBlock();
+        void publish(const float *peakDb, const float *rmsDb, float momentary, float shortTerm, float integrated);
+
+        static constexpr int kShortBlocks = 30; // 3 s of 100 ms blocks
+        static constexpr int kHistBins = 1000;  // -70 .. +30 LUFS in 0.1 LU
+
+        int rate_ = 0;
+        int channels_ = 0; // measured channels
+        int stride_ = 0;   // interleaved channels in the input
+        size_t blockFrames_ = 0;
+        size_t blockPos_ = 0;
+        uint64_t frames_ = 0;
+
+        // K-weighting: two biquads (shelf, high-pass), transposed direct form II
+        float b0_[2] = {}, b1_[2] = {}, b2_[2] = {}, a1_[2] = {}, a2_[2] = {};
+        alignas(16) float z1_[2][kMaxChannels], z2_[2][kMaxChannels];
+        alignas(16) float weight_[kMaxChannels]; // BS.1770 channel gains (LFE = 0)
+
+        // current 100 ms block
+        alignas(16) float kSum_[kMaxChannels];  // K-weighted square sum
+        alignas(16) float sqSum_[kMaxChannels]; // plain square sum
+        alignas(16) float peak_[kMaxChannels];  // max |x|
+
+        double blockEnergy_[kShortBlocks] = {}; // weighted mean square of recent blocks
+        int blocks_ = 0;                        // total blocks seen (saturates)
+        int blockHead_ = 0;
+
+        uint32_t histCount_[kHistBins] = {};
+        double histEnergy_[kHistBins] = {};
+
+        // published values
+        std::atomic<uint32_t> seq_{0};
+        std::atomic<int> pubChannels_{0};
+        std::atomic<uint64_t> pubFrames_{0};
+        std::atomic<float> pubPeak_[kMaxChannels];
+        std::atomic<float> pubRms_[kMaxChannels];
+        std::atomic<float> pubMomentary_{kFloorDb};
+        std::atomic<float> pubShortTerm_{kFloorDb};
+        std::atomic<float> pubIntegrated_{kFloorDb};
+    };
+}
@@ -0,0 +1,146 @@
+// audio_ring.cpp
+#include "audio_ring.h"
+#include <algorithm>
+
+namespace gcap::audio
+{
+    bool AudioRing::init(size_t capacityBytes)
+    {
+        size_t cap = 64;
+        while (cap < capacityBytes)
+            cap <<= 1;
+        storage_.assign(cap / sizeof(uint64_t), 0);
+        capacity_ = cap;
+        mask_ = cap - 1;
+        reset();
+        return true;
+    }
+
+    void AudioRing::reset()
+    {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+        reservePos_ = 0;
+        reserveBytes_ = 0;
+        reserved_ = false;
+        pendingGap_ = false;
+        peekNext_ = 0;
+        packets_.store(0, std::memory_order_relaxed);
+        bytes_.store(0, std::memory_order_relaxed);
+        droppedPackets_.store(0, std::memory_order_relaxed);
+        droppedBytes_.store(0, std::memory_order_relaxed);
+        highWater_.store(0, std::memory_order_relaxed);
+    }
+
+    uint8_t *AudioRing::reserve(uint32_t bytes)
+    {
+        reserved_ = false;
+        if (!capacity_)
+            return nullptr;
+
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        const size_t need = record_bytes(bytes);
+        const size_t toEnd = capacity_ - (size_t)(head & mask_);
+        const size_t pad = toEnd < need ? toEnd : 0;
+
+        if (need > capacity_ / 2 || (size_t)(head - tail) + pad + need > capacity_)
+        {
+            droppedPackets_.fetch_add(1, std::memory_order_relaxed);
+            droppedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+            pendingGap_ = true;
+            return nullptr;
+        }
+
+        // A tail shorter than a header is skipped implicitly by the consumer.
+        if (pad >= kHeader)
+        {
+            Header *h = header_at(head);
+            h->bytes = 0;
+            h->flags = kPad;
+        }
+
+        reservePos_ = head + pad;
+        reserveBytes_ = bytes;
+        reserved_ = true;
+        return base() + (reservePos_ & mask_) + kHeader;
+    }
+
+    void AudioRing::commit(int64_t ts100ns, int64_t dur100ns, uint32_t bytes)
+    {
+        if (!reserved_)
+            return;
+        reserved_ = false;
+        bytes = std::min(bytes, reserveBytes_);
+        Header *h = header_at(reservePos_);
+        h->ts100ns = ts100ns;
+        h->dur100ns = dur100ns;
+        h->bytes = bytes;
+        h->flags = pendingGap_ ? (uint32_t)kDiscontinuity : 0u;
+        pendingGap_ = false;
+
+        const uint64_t head = reservePos_ + record_bytes(bytes);
+        head_.store(head, std::memory_order_release);
+
+        packets_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        const size_t used = (size_t)(head - tail_.load(std::memory_order_relaxed));
+        if (used > highWater_.load(std::memory_order_relaxed))
+            highWater_.store(used, std::memory_order_relaxed);
+    }
+
+    bool AudioRing::peek(Packet &out)
+    {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        while (tail != head)
+        {
+            const size_t toEnd = capacity_ - (size_t)(tail & mask_);
+            const Header *h = toEnd < kHeader ? nullptr : header_at(tail);
+            if (!h || (h->flags & kPad))
+            {
+                tail += toEnd;
+                tail_.store(tail, std::memory_order_release);
+                continue;
+            }
+
+            out.ts100ns = h->ts100ns;
+            out.dur100ns = h->dur100ns;
+            out.bytes = h->bytes;
+            out.flags = h->flags;
+            out.data = reinterpret_cast<const uint8_t *>(h) + kHeader;
+            peekNext_ = tail + record_bytes(h->bytes);
+            return true;
+        }
+        return false;
+    }
+
+    void AudioRing::release()
+    {
+        if (peekNext_ > tail_.load(std::memory_order_relaxed))
+            tail_.store(peekNext_, std::memory_order_release);
+    }
+
+    bool AudioRing::empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_relaxed);
+    }
+
+    size_t AudioRing::used() const
+    {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        return (size_t)(head_.load(std::memory_order_relaxed) - tail);
+    }
+
+    AudioRing::Stats AudioRing::stats() const
+    {
+        Stats s;
+        s.packets = packets_.load(std::memory_order_relaxed);
+        s.bytes = bytes_.load(std::memory_order_relaxed);
+        s.droppedPackets = droppedPackets_.load(std::memory_order_relaxed);
+        s.droppedBytes = droppedBytes_.load(std::memory_order_relaxed);
+        s.capacity = capacity_;
+        s.highWater = highWater_.load(std::memory_order_relaxed);
+        return s;
+    }
+}
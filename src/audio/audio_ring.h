@@ -0,0 +1,114 @@
+// audio_ring.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gcap::audio
+{
+    /**
+     * @brief Single-producer / single-consumer byte ring of timestamped packets.
+     *
+     * Each packet is a small header (timestamp, duration, size, flags)
+     * followed by its payload, 8-byte aligned. A packet never wraps: when it
+     * does not fit before the end of the buffer the producer writes a padding
+     * marker and starts at offset 0, so the consumer always gets one
+     * contiguous pointer.
+     *
+     * The producer fills the payload in place (reserve() / commit()), the
+     * consumer reads it in place (peek() / release()). Both sides are
+     * wait-free and nothing is allocated after init(). When the ring is full
+     * the new packet is dropped, counted, and the next packet that fits is
+     * flagged kDiscontinuity.
+     */
+    class AudioRing
+    {
+    public:
+        enum : uint32_t
+        {
+            kDiscontinuity = 1u << 0, // one or more packets were dropped before this one
+        };
+
+        struct Packet
+        {
+            int64_t ts100ns = 0;
+            int64_t dur100ns = 0;
+            const uint8_t *data = nullptr;
+            uint32_t bytes = 0;
+            uint32_t flags = 0;
+        };
+
+        struct Stats
+        {
+            uint64_t packets = 0;        // committed
+            uint64_t bytes = 0;          // committed payload
+            uint64_t droppedPackets = 0; // rejected by reserve()
+            uint64_t droppedBytes = 0;
+            size_t capacity = 0;
+            size_t highWater = 0; // max bytes in use (headers included)
+        };
+
+        AudioRing() = default;
+        AudioRing(const AudioRing &) = delete;
+        AudioRing &operator=(const AudioRing &) = delete;
+
+        // Capacity is rounded up to a power of two. Neither side may be running.
+        bool init(size_t capacityBytes);
+        // Drop all packets and counters. Neither side may be running.
+        void reset();
+
+        // ---- producer ----
+        // Contiguous space for a `bytes` payload, or nullptr when full.
+        uint8_t *reserve(uint32_t bytes);
+        // Publish the reserved packet; `bytes` may be smaller than reserved.
+        // No-op when the last reserve() failed.
+        void commit(int64_t ts100ns, int64_t dur100ns, uint32_t bytes);
+
+        // ---- consumer ----
+        // Oldest packet, valid until release().
+        bool peek(Packet &out);
+        void release();
+        bool empty() const;
+
+        // Any thread.
+        Stats stats() const;
+        size_t capacity() const { return capacity_; }
+        // Bytes in use (headers included); a snapshot.
+        size_t used() const;
+
+    private:
+        struct Header
+        {
+            int64_t ts100ns;
+            int64_t dur100ns;
+            uint32_t bytes;
+            uint32_t flags;
+        };
+        static constexpr uint32_t kPad = 1u << 31; // header flag: skip to the end of the buffer
+        static constexpr size_t kHeader = sizeof(Header);
+
+        static size_t record_bytes(uint32_t payload) { return kHeader + ((payload + 7u) & ~size_t(7)); }
+        Header *header_at(uint64_t pos) { return reinterpret_cast<Header *>(base() + (pos & mask_)); }
+        uint8_t *base() { return reinterpret_cast<uint8_t *>(storage_.data()); }
+
+        std::vector<uint64_t> storage_; // 8-byte aligned backing
+        size_t capacity_ = 0;
+        uint64_t mask_ = 0;
+
+        alignas(64) std::atomic<uint64_t> head_{0}; // written by the producer
+        uint64_t reservePos_ = 0;                    // producer-only: header position of the open reservation
+        uint32_t reserveBytes_ = 0;
+        bool reserved_ = false;
+        bool pendingGap_ = false;
+
+        alignas(64) std::atomic<uint64_t> tail_{0}; // written by the consumer
+        uint64_t peekNext_ = 0;                      // consumer-only
+
+        alignas(64) std::atomic<uint64_t> packets_{0};
+        std::atomic<uint64_t> bytes_{0};
+        std::atomic<uint64_t> droppedPackets_{0};
+        std::atomic<uint64_t> droppedBytes_{0};
+        std::atomic<size_t> highWater_{0};
+    };
+}
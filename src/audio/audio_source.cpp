@@ -0,0 +1,263 @@
+// audio_source.cpp
+#include "audio_source.h"
+#include "shared_source.h"
+#include "synthetic_source.h"
+#ifdef _WIN32
+#include "wasapi_capture.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace gcap::audio
+{
+    bool device_format_supported(const DeviceFormat &fmt)
+    {
+        return fmt.channels != 0 && ((fmt.isFloat && fmt.bits == 32) || fmt.bits == 32 || fmt.bits == 24 || fmt.bits == 16);
+    }
+
+    SampleType device_sample_type(const DeviceFormat &fmt)
+    {
+        if (fmt.isFloat && fmt.bits == 32)
+            return SampleType::F32;
+        if (fmt.bits == 32)
+            return SampleType::S32;
+        if (fmt.bits == 24)
+            return SampleType::S24;
+        return SampleType::S16;
+    }
+
+    void AudioOutput::prepare(uint32_t sampleRate, uint32_t channels)
+    {
+        sampleRate_ = sampleRate;
+        channels_ = channels;
+
+        // ~2 s of PCM16 plus packet headers; the device thread never allocates
+        ring_.init((size_t)sampleRate * channels * 2 * 2 + 64 * 1024);
+        ditherState_ = TpdfDither{};
+        outFrames_ = 0;
+    }
+
+    bool AudioOutput::configure(const DeviceFormat &dev, uint32_t maxPacketFrames)
+    {
+        // device layout -> requested channels (e.g. 8ch HDMI -> stereo, ITU downmix,
+        // normalised so full-scale surrounds do not clip the front pair)
+        const bool downmix = dev.channels > channels_;
+        if (!mixer_.configure((int)dev.channels, dev.channelMask, (int)channels_, 0, normalizeDownmix_ && downmix))
+            return false;
+
+        // device rate -> requested rate (typically 44.1 kHz -> 48 kHz for AAC); with drift
+        // correction the converter always runs so its ratio can follow the video clock
+        resampler_ = {};
+        if ((dev.sampleRate != sampleRate_ || drift_) && device_format_supported(dev) &&
+            !resampler_.configure((int)dev.sampleRate, (int)sampleRate_, (int)channels_, resampleQuality_,
+                                  drift_ != nullptr))
+            return false;
+
+        if (meter_)
+            meter_->configure((int)sampleRate_, (int)channels_);
+
+        // Preallocate the resampling scratch for the largest packet.
+        if (maxPacketFrames && resampler_.configured())
+        {
+            mixF32_.reserve((size_t)maxPacketFrames * channels_);
+            outF32_.reserve((resampler_.maxOutput(maxPacketFrames) + 64) * channels_);
+        }
+        return true;
+    }
+
+    size_t AudioOutput::resamplePacket(const DeviceFormat &dev, const void *data, uint32_t frames, bool silent)
+    {
+        // remix to the output layout first so fewer channels go through the filter
+        mixF32_.resize((size_t)frames * channels_);
+        if (silent)
+            std::fill(mixF32_.begin(), mixF32_.end(), 0.0f);
+        else
+            mixer_.process_f32(data, device_sample_type(dev), frames, mixF32_.data());
+
+        if (drift_)
+            resampler_.setRateAdjust(drift_->correction());
+        const size_t maxOut = resampler_.maxOutput(frames);
+        outF32_.resize(maxOut * channels_);
+        return resampler_.process(mixF32_.data(), frames, outF32_.data(), maxOut);
+    }
+
+    uint32_t AudioOutput::deliver(const DeviceFormat &dev, const void *data, uint32_t frames, bool silent)
+    {
+        TpdfDither *dither = dither_ ? &ditherState_ : nullptr;
+
+        // Output is always PCM16 at the requested rate, written straight into the
+        // ring. A full ring drops this packet; the ring counts it and flags the
+        // next one, whose timestamp then shows the gap.
+        const int64_t ts100ns = (int64_t)(outFrames_ * 10'000'000ULL / sampleRate_);
+        uint32_t outFrames = frames;
+        if (resampler_.configured())
+            outFrames = (uint32_t)resamplePacket(dev, data, frames, silent);
+        outFrames_ += outFrames;
+        const int64_t dur100ns = (int64_t)(outFrames_ * 10'000'000ULL / sampleRate_) - ts100ns;
+
+        const uint32_t bytesOut = outFrames * channels_ * 2;
+        uint8_t *dst = outFrames ? ring_.reserve(bytesOut) : nullptr;
+        if (!dst)
+            return outFrames;
+
+        int16_t *pcm = reinterpret_cast<int16_t *>(dst);
+        if (resampler_.configured())
+            f32_to_s16(outF32_.data(), pcm, (size_t)outFrames * channels_, dither);
+        else if (silent)
+            memset(dst, 0, bytesOut);
+        else
+            mixer_.process_s16(data, device_sample_type(dev), frames, pcm, dither);
+        if (meter_)
+            meter_->process(pcm, outFrames);
+        ring_.commit(ts100ns, dur100ns, bytesOut);
+        wake();
+        return outFrames;
+    }
+
+    void AudioOutput::wake()
+    {
+        // Pairs with the fence in waitForData(): either this load sees the
+        // waiter, or the waiter's predicate sees the new packet / live flag.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0)
+            return;
+        // taking the lock orders the notify after the waiter's predicate
+        // check, so it cannot fall between the check and the sleep
+        {
+            std::lock_guard<std::mutex> lk(signalMutex_);
+        }
+        signalCv_.notify_one();
+    }
+
+    bool AudioOutput::peek(AudioChunk &out)
+    {
+        AudioRing::Packet p;
+        if (!ring_.peek(p))
+            return false;
+        out.ts100ns = p.ts100ns;
+        out.dur100ns = p.dur100ns;
+        out.pcm = p.data;
+        out.bytes = p.bytes;
+        out.discontinuity = (p.flags & AudioRing::kDiscontinuity) != 0;
+        return true;
+    }
+
+    void AudioOutput::release()
+    {
+        ring_.release();
+    }
+
+    bool AudioOutput::waitForData(int timeoutMs, const std::atomic<bool> &live)
+    {
+        if (!ring_.empty())
+            return true;
+        if (!live.load())
+            return false;
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lk(signalMutex_);
+            signalCv_.wait_for(lk, std::chrono::milliseconds(std::max(0, timeoutMs)), [this, &live]()
+                               { return !ring_.empty() || !live.load(); });
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return !ring_.empty();
+    }
+
+    void AudioSourceBase::prepare(uint32_t sampleRate, uint32_t channels)
+    {
+        sampleRate_ = sampleRate;
+        channels_ = channels;
+        dev_ = {};
+        maxPacketFrames_ = 0;
+        if (ownOutput_)
+            out_.prepare(sampleRate, channels);
+        capturedFrames_.store(0);
+        discontinuities_.store(0);
+    }
+
+    bool AudioSourceBase::configurePipeline(uint32_t maxPacketFrames)
+    {
+        maxPacketFrames_ = maxPacketFrames;
+        return !ownOutput_ || out_.configure(dev_, maxPacketFrames);
+    }
+
+    uint32_t AudioSourceBase::deliver(const void *data, uint32_t frames, bool silent, bool deviceDiscontinuity)
+    {
+        capturedFrames_.fetch_add(frames, std::memory_order_relaxed);
+        if (deviceDiscontinuity)
+            discontinuities_.fetch_add(1, std::memory_order_relaxed);
+        silent = silent || !data || !device_format_supported(dev_);
+
+        const uint32_t produced = ownOutput_ ? out_.deliver(dev_, data, frames, silent) : 0;
+        passes_.fetch_add(1, std::memory_order_seq_cst);
+        for (auto &slot : attached_)
+            if (AudioOutput *o = slot.load(std::memory_order_seq_cst))
+                o->deliver(dev_, data, frames, silent);
+        passes_.fetch_add(1, std::memory_order_release);
+        return produced;
+    }
+
+    double AudioSourceBase::ringFill()
+    {
+        double fill = ownOutput_ ? out_.ringFill() : 0.0;
+        bool fed = ownOutput_;
+        passes_.fetch_add(1, std::memory_order_seq_cst);
+        for (auto &slot : attached_)
+            if (AudioOutput *o = slot.load(std::memory_order_seq_cst))
+            {
+                fill = std::max(fill, o->ringFill());
+                fed = true;
+            }
+        passes_.fetch_add(1, std::memory_order_release);
+        return fed ? fill : 1.0; // nobody to feed yet counts as full
+    }
+
+    bool AudioSourceBase::attach(AudioOutput *out)
+    {
+        for (auto &slot : attached_)
+        {
+            AudioOutput *expected = nullptr;
+            if (slot.compare_exchange_strong(expected, out, std::memory_order_seq_cst))
+                return true;
+        }
+        return false;
+    }
+
+    void AudioSourceBase::detach(AudioOutput *out)
+    {
+        bool found = false;
+        for (auto &slot : attached_)
+        {
+            AudioOutput *expected = out;
+            found = slot.compare_exchange_strong(expected, nullptr, std::memory_order_seq_cst) || found;
+        }
+        if (!found)
+            return;
+        // A pass that began before the slot was cleared may still hold `out`;
+        // one that begins after it cannot see it.
+        const uint32_t pass = passes_.load(std::memory_order_seq_cst);
+        if (pass & 1)
+            while (passes_.load(std::memory_order_acquire) == pass)
+                std::this_thread::yield();
+    }
+
+    std::unique_ptr<AudioSourceBase> create_device_source(const std::wstring &deviceId)
+    {
+        if (is_synthetic_source_id(deviceId))
+            return std::make_unique<SyntheticAudioSource>();
+#ifdef _WIN32
+        return std::make_unique<WasapiCapture>();
+#else
+        return nullptr;
+#endif
+    }
+
+    std::unique_ptr<IAudioSource> create_audio_source(const std::wstring &deviceId)
+    {
+        (void)deviceId; // the device is picked (and shared) in start()
+        return std::make_unique<SharedAudioSource>();
+    }
+}
@@ -0,0 +1,283 @@
+// audio_source.h
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "audio_convert.h"
+#include "audio_meter.h"
+#include "audio_ring.h"
+#include "av_drift.h"
+#include "channel_mixer.h"
+#include "resampler.h"
+
+namespace gcap::audio
+{
+    // One packet in the source's ring: interleaved PCM16, valid until release().
+    struct AudioChunk
+    {
+        int64_t ts100ns = 0;          // relative timeline
+        int64_t dur100ns = 0;         // duration
+        const uint8_t *pcm = nullptr; // interleaved PCM16
+        uint32_t bytes = 0;
+        bool discontinuity = false; // packets were dropped before this one
+    };
+
+    // What a source hands to its consumer (always PCM16).
+    struct AudioFormat
+    {
+        uint32_t sampleRate = 0;
+        uint32_t channels = 0;
+        uint32_t bits = 0;
+        bool isFloat = false;
+        uint32_t blockAlign = 0;
+    };
+
+    // Native format of the device (or generator) before conversion.
+    struct DeviceFormat
+    {
+        uint32_t sampleRate = 0;
+        uint32_t channels = 0;
+        uint32_t bits = 0;
+        bool isFloat = false;
+        uint32_t blockAlign = 0;
+        uint32_t channelMask = 0; // WAVEFORMATEXTENSIBLE speaker mask; 0 = default for the count
+    };
+
+    // float32 / int32 / int24 / int16 are converted; anything else is captured as silence.
+    bool device_format_supported(const DeviceFormat &fmt);
+    SampleType device_sample_type(const DeviceFormat &fmt);
+
+    /**
+     * @brief A capture endpoint feeding PCM16 packets into an SPSC ring.
+     *
+     * The producer side (device thread) is the implementation's; the
+     * consumer side (peek / release / waitForData) belongs to one thread,
+     * e.g. the recorder's audio thread. Setters apply at the next start().
+     */
+    class IAudioSource
+    {
+    public:
+        virtual ~IAudioSource() = default;
+
+        // Output is PCM16 at sampleRate / channels whatever the device runs at.
+        // deviceId is backend-specific; empty = default device.
+        virtual bool start(uint32_t sampleRate, uint32_t channels, uint32_t bits,
+                           const std::wstring &deviceId, AudioFormat *outFmt = nullptr) = 0;
+        virtual void stop() = 0;
+        virtual bool running() const = 0;
+
+        // non-blocking; consumer thread only. release() consumes the chunk.
+        virtual bool peek(AudioChunk &out) = 0;
+        virtual void release() = 0;
+        // wait until the ring has data or the source stopped (does NOT consume)
+        virtual bool waitForData(int timeoutMs) = 0;
+
+        virtual AudioRing::Stats ringStats() const = 0;
+        // Device-side clock: frames delivered by the device (dropped ring packets
+        // included) and data discontinuities it reported. Any thread.
+        virtual uint64_t capturedFrames() const = 0;
+        virtual uint32_t discontinuities() const = 0;
+        // Device rate the counts above refer to; valid after a successful start().
+        virtual uint32_t deviceRate() const = 0;
+
+        // TPDF dither when the device delivers more than 16 bits
+        virtual void setDither(bool on) = 0;
+        // filter length when the device rate differs from the requested one
+        virtual void setResampleQuality(ResampleQuality q) = 0;
+        // fed with the PCM16 written to the ring; owned by the caller
+        virtual void setMeter(LevelMeter *meter) = 0;
+        // always resample (adjustably) and trim the ratio by drift->correction()
+        virtual void setDriftCorrection(const AvDriftEstimator *drift) = 0;
+        // called on the device thread with true when it starts and false before
+        // it exits (scheduling / placement, e.g. gcap_set_thread_config)
+        virtual void setThreadHook(std::function<void(bool begin)> hook) = 0;
+    };
+
+    /**
+     * @brief One consumer's half of a source: output format, conversion and ring.
+     *
+     * deliver() runs on the device thread for every device packet: remix to
+     * the output layout, resample when the rates differ (or drift correction
+     * is on), quantise to PCM16 in place in the ring, meter, and wake the
+     * consumer. The timeline counts output frames, so packet timestamps
+     * never accumulate rounding. peek / release / waitForData belong to one
+     * consumer thread. Setters and prepare() / configure() apply before the
+     * output is fed.
+     */
+    class AudioOutput
+    {
+    public:
+        void setDither(bool on) { dither_ = on; }
+        void setResampleQuality(ResampleQuality q) { resampleQuality_ = q; }
+        void setMeter(LevelMeter *meter) { meter_ = meter; }
+        void setDriftCorrection(const AvDriftEstimator *drift) { drift_ = drift; }
+        // Scale downmix rows (device has more channels than the output) so a
+        // loud multichannel source cannot clip; on by default. Off keeps the
+        // plain ITU coefficients (louder, may saturate).
+        void setNormalizeDownmix(bool on) { normalizeDownmix_ = on; }
+
+        // Size the ring (~2 s) and reset the timeline.
+        void prepare(uint32_t sampleRate, uint32_t channels);
+        // Mixer / resampler / meter for packets in `dev`; maxPacketFrames
+        // sizes the scratch buffers so deliver() never allocates.
+        bool configure(const DeviceFormat &dev, uint32_t maxPacketFrames);
+        // One device packet (`frames` frames in `dev`). A full ring drops it
+        // (counted, next packet flagged). Returns the output frames produced.
+        uint32_t deliver(const DeviceFormat &dev, const void *data, uint32_t frames, bool silent);
+        // Wake waitForData(). Lock-free unless a consumer is actually waiting.
+        void wake();
+
+        bool peek(AudioChunk &out);
+        void release();
+        // Until there is data, `live` is cleared (followed by wake()) or the
+        // timeout; does not consume.
+        bool waitForData(int timeoutMs, const std::atomic<bool> &live);
+
+        AudioRing::Stats ringStats() const { return ring_.stats(); }
+        // Fraction of the ring in use.
+        double ringFill() const { return ring_.capacity() ? (double)ring_.used() / (double)ring_.capacity() : 0.0; }
+        uint32_t sampleRate() const { return sampleRate_; }
+        uint32_t channels() const { return channels_; }
+
+    private:
+        size_t resamplePacket(const DeviceFormat &dev, const void *data, uint32_t frames, bool silent);
+
+        uint32_t sampleRate_ = 48000;
+        uint32_t channels_ = 2;
+        bool dither_ = false;
+        bool normalizeDownmix_ = true;
+        TpdfDither ditherState_{};
+        ChannelMixer mixer_; // device layout -> channels_
+        ResampleQuality resampleQuality_ = ResampleQuality::Balanced;
+        Resampler resampler_;
+        std::vector<float> mixF32_, outF32_;
+
+        LevelMeter *meter_ = nullptr;
+        const AvDriftEstimator *drift_ = nullptr;
+
+        // device thread -> consumer; sized in prepare(), never grows
+        AudioRing ring_;
+        uint64_t outFrames_ = 0; // timeline, in output frames
+
+        // waitForData() sleeps here; waiters_ lets wake() skip the mutex
+        // (and the notify syscall) while nobody sleeps.
+        std::mutex signalMutex_;
+        std::condition_variable signalCv_;
+        std::atomic<int> waiters_{0};
+    };
+
+    /**
+     * @brief Device side shared by all backends, plus the source's own output.
+     *
+     * A backend calls prepare() from start(), configurePipeline() on its
+     * thread once the device format is known, then deliver() for every
+     * device packet. deliver() feeds the source's own output (what the
+     * IAudioSource consumer methods read) and any outputs attached to it,
+     * so several consumers can share one device client (see
+     * SharedAudioSource).
+     */
+    class AudioSourceBase : public IAudioSource
+    {
+    public:
+        static constexpr int kMaxOutputs = 4; // attached, besides the own one
+
+        bool running() const override { return running_.load(); }
+
+        bool peek(AudioChunk &out) override { return out_.peek(out); }
+        void release() override { out_.release(); }
+        bool waitForData(int timeoutMs) override { return out_.waitForData(timeoutMs, running_); }
+
+        AudioRing::Stats ringStats() const override { return out_.ringStats(); }
+        uint64_t capturedFrames() const override { return capturedFrames_.load(std::memory_order_relaxed); }
+        uint32_t discontinuities() const override { return discontinuities_.load(std::memory_order_relaxed); }
+        uint32_t deviceRate() const override { return dev_.sampleRate; }
+
+        void setDither(bool on) override { out_.setDither(on); }
+        void setResampleQuality(ResampleQuality q) override { out_.setResampleQuality(q); }
+        void setMeter(LevelMeter *meter) override { out_.setMeter(meter); }
+        void setDriftCorrection(const AvDriftEstimator *drift) override { out_.setDriftCorrection(drift); }
+        void setThreadHook(std::function<void(bool begin)> hook) override { threadHook_ = std::move(hook); }
+
+        // Off: only attached outputs are fed and the own ring is not
+        // allocated. Call before start().
+        void setOwnOutput(bool on) { ownOutput_ = on; }
+        // Valid once start() succeeded.
+        const DeviceFormat &deviceFormat() const { return dev_; }
+        uint32_t maxPacketFrames() const { return maxPacketFrames_; }
+
+        // Feed `out` (prepared and configured for deviceFormat()) from the
+        // next packet on; false when kMaxOutputs are attached.
+        bool attach(AudioOutput *out);
+        // Stop feeding `out`; returns once the device thread has let go of it.
+        void detach(AudioOutput *out);
+
+    protected:
+        // Device thread function scope: runs the thread hook at both ends.
+        class ThreadScope
+        {
+        public:
+            explicit ThreadScope(const AudioSourceBase &s) : hook_(s.threadHook_)
+            {
+                if (hook_)
+                    hook_(true);
+            }
+            ~ThreadScope()
+            {
+                if (hook_)
+                    hook_(false);
+            }
+            ThreadScope(const ThreadScope &) = delete;
+            ThreadScope &operator=(const ThreadScope &) = delete;
+
+        private:
+            const std::function<void(bool)> &hook_;
+        };
+
+        // From start(), before the device thread runs: size the own ring,
+        // reset counters and the timeline.
+        void prepare(uint32_t sampleRate, uint32_t channels);
+        // Device thread, once dev_ is filled in. maxPacketFrames sizes the
+        // scratch buffers so deliver() never allocates.
+        bool configurePipeline(uint32_t maxPacketFrames);
+        // Device thread: one device packet (`frames` frames in dev_ format)
+        // to every output. Returns the frames produced for the own output.
+        uint32_t deliver(const void *data, uint32_t frames, bool silent, bool deviceDiscontinuity);
+        // Wake the own output's waitForData(), e.g. after running_ was cleared.
+        void wake() { out_.wake(); }
+        // Device thread: fullest ring among the outputs, 1 when there is
+        // none (back-pressure for sources without a real clock).
+        double ringFill();
+
+        std::atomic<bool> running_{false};
+        uint32_t sampleRate_ = 48000; // requested by start()
+        uint32_t channels_ = 2;       // requested by start()
+        DeviceFormat dev_{};
+
+    private:
+        AudioOutput out_;
+        bool ownOutput_ = true;
+        uint32_t maxPacketFrames_ = 0;
+        std::function<void(bool)> threadHook_;
+        std::atomic<uint64_t> capturedFrames_{0};
+        std::atomic<uint32_t> discontinuities_{0};
+
+        // Attached outputs. The device thread bumps passes_ around every use
+        // (odd while inside), so detach() can wait out a pass in progress.
+        std::atomic<AudioOutput *> attached_[kMaxOutputs] = {};
+        std::atomic<uint32_t> passes_{0};
+    };
+
+    // The backend for `deviceId`: "synthetic:<options>" -> SyntheticAudioSource
+    // (see synthetic_source.h), anything else -> the platform capture backend
+    // (WASAPI; nullptr elsewhere). Each one is a device client of its own.
+    std::unique_ptr<AudioSourceBase> create_device_source(const std::wstring &deviceId);
+
+    // A SharedAudioSource (shared_source.h): consumers of the same endpoint
+    // share one device client.
+    std::unique_ptr<IAudioSource> create_audio_source(const std::wstring &deviceId);
+}
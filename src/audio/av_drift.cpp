@@ -0,0 +1,165 @@
+// av_drift.cpp
+#include "av_drift.h"
+#include <algorithm>
+#include <cmath>
+
+namespace gcap::audio
+{
+    AvDriftEstimator::AvDriftEstimator()
+    {
+        reset();
+    }
+
+    void AvDriftEstimator::reset(int nominalRate)
+    {
+        rate_ = nominalRate > 0 ? nominalRate : 0;
+        based_ = false;
+        head_ = count_ = 0;
+        slope_ = 1.0;
+        intercept_ = 0.0;
+        driftPpm_ = 0.0;
+        offsetMs_ = 0.0;
+        rebases_ = 0;
+        correction_.store(1.0, std::memory_order_relaxed);
+        publish(false, 0.0, 0.0);
+    }
+
+    void AvDriftEstimator::rebase(int64_t videoPts100ns, uint64_t audioFrames, uint32_t epoch)
+    {
+        if (based_)
+            ++rebases_;
+        based_ = true;
+        baseVideo_ = videoPts100ns;
+        baseAudio_ = audioFrames;
+        epoch_ = epoch;
+        last_ = acc_ = {0.0, 0.0};
+        accN_ = 1;
+        accStart_ = 0.0;
+        head_ = count_ = 0;
+        slope_ = 1.0;
+        intercept_ = 0.0;
+    }
+
+    void AvDriftEstimator::observe(int64_t videoPts100ns, uint64_t audioFrames, uint32_t epoch)
+    {
+        if (!rate_)
+            return;
+        if (!based_ || epoch != epoch_ || audioFrames < baseAudio_)
+        {
+            rebase(videoPts100ns, audioFrames, epoch);
+            publish(false, 0.0, 0.0);
+            return;
+        }
+
+        const Point p{(double)(videoPts100ns - baseVideo_) * 1e-7,
+                      (double)(audioFrames - baseAudio_) / (double)rate_};
+        const double dv = p.video - last_.video;
+
+        // timestamp reset, lost signal, or audio that stalled / jumped
+        const double expected = count_ >= 2 ? intercept_ + slope_ * p.video : last_.audio + dv;
+        if (dv < 0.0 || dv > kGap || std::fabs(p.audio - expected) > kJump)
+        {
+            rebase(videoPts100ns, audioFrames, epoch);
+            publish(false, 0.0, 0.0);
+            return;
+        }
+        offsetMs_ += driftPpm_ * 1e-6 * dv * 1000.0;
+        last_ = p;
+
+        acc_.video += p.video;
+        acc_.audio += p.audio;
+        if (++accN_ == 1)
+            accStart_ = p.video;
+        if (p.video - accStart_ < kInterval)
+            return;
+
+        if (count_ < kMaxPoints)
+            ++count_;
+        else
+            head_ = (head_ + 1) % kMaxPoints;
+        pts_[(head_ + count_ - 1) % kMaxPoints] = {acc_.video / accN_, acc_.audio / accN_};
+        acc_ = {0.0, 0.0};
+        accN_ = 0;
+        if (count_ >= 2)
+            fit();
+    }
+
+    void AvDriftEstimator::fit()
+    {
+        // two-pass least squares over the window (centred sums keep precision)
+        double mv = 0.0, ma = 0.0;
+        for (int i = 0; i < count_; ++i)
+        {
+            const Point &q = pts_[(head_ + i) % kMaxPoints];
+            mv += q.video;
+            ma += q.audio;
+        }
+        mv /= count_;
+        ma /= count_;
+        double svv = 0.0, sva = 0.0;
+        for (int i = 0; i < count_; ++i)
+        {
+            const Point &q = pts_[(head_ + i) % kMaxPoints];
+            svv += (q.video - mv) * (q.video - mv);
+            sva += (q.video - mv) * (q.audio - ma);
+        }
+        if (svv <= 0.0)
+            return;
+        slope_ = sva / svv;
+        intercept_ = ma - slope_ * mv;
+
+        double sr = 0.0;
+        for (int i = 0; i < count_; ++i)
+        {
+            const Point &q = pts_[(head_ + i) % kMaxPoints];
+            const double r = q.audio - (intercept_ + slope_ * q.video);
+            sr += r * r;
+        }
+        const double jitterMs = std::sqrt(sr / count_) * 1000.0;
+        const double span = pts_[(head_ + count_ - 1) % kMaxPoints].video - pts_[head_].video;
+
+        const double ppm = (slope_ - 1.0) * 1e6;
+        const bool active = span >= kMinSpan && std::fabs(ppm) <= kMaxDriftPpm;
+        if (active)
+        {
+            // audio running fast (slope > 1) needs fewer output frames per input frame
+            driftPpm_ = ppm;
+            correction_.store(1.0 / slope_, std::memory_order_relaxed);
+        }
+        publish(active, jitterMs, span);
+    }
+
+    void AvDriftEstimator::publish(bool active, double jitterMs, double spanS)
+    {
+        const uint32_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        pubActive_.store(active ? 1 : 0, std::memory_order_relaxed);
+        pubDrift_.store(driftPpm_, std::memory_order_relaxed);
+        pubOffset_.store(offsetMs_, std::memory_order_relaxed);
+        pubJitter_.store(jitterMs, std::memory_order_relaxed);
+        pubSpan_.store(spanS, std::memory_order_relaxed);
+        pubRebase_.store(rebases_, std::memory_order_relaxed);
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    void AvDriftEstimator::stats(gcap_av_sync_stats_t &out) const
+    {
+        for (;;)
+        {
+            const uint32_t s = seq_.load(std::memory_order_acquire);
+            if (s & 1u)
+                continue;
+            out.active = pubActive_.load(std::memory_order_relaxed);
+            out.drift_ppm = pubDrift_.load(std::memory_order_relaxed);
+            out.drift_ms = pubOffset_.load(std::memory_order_relaxed);
+            out.jitter_ms = pubJitter_.load(std::memory_order_relaxed);
+            out.window_s = pubSpan_.load(std::memory_order_relaxed);
+            out.rebases = pubRebase_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == s)
+                break;
+        }
+        out.correction_ppm = (correction() - 1.0) * 1e6;
+    }
+}
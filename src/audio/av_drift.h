@@ -0,0 +1,94 @@
+// av_drift.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "gcapture.h"
+
+namespace gcap::audio
+{
+    /**
+     * @brief Audio-vs-video clock drift estimate and resampling correction.
+     *
+     * Every video frame reports its PTS together with the number of device
+     * audio frames captured so far. Observations are averaged over kInterval
+     * (which smooths the packet-sized audio steps) into points of a sliding
+     * window, and a least-squares line of audio time against video time
+     * gives the audio clock rate relative to the video clock (1 + drift).
+     * Once the window spans kMinSpan seconds, correction()
+     * returns the factor that makes the recorded audio advance at the video
+     * rate; the audio source feeds it to its adjustable Resampler.
+     *
+     * An audio discontinuity (WASAPI glitch, dropped device data), a video
+     * timestamp jump or an outlier restarts the window; the last correction
+     * stays in effect until the new estimate is ready.
+     *
+     * reset() and observe() are called with the recorder lock held;
+     * correction() and stats() may be called from any thread.
+     */
+    class AvDriftEstimator
+    {
+    public:
+        static constexpr double kInterval = 0.5;     // s averaged into one regression point
+        static constexpr int kMaxPoints = 240;       // 2 min window
+        static constexpr double kMinSpan = 30.0;     // s of history before correcting
+        static constexpr double kMaxDriftPpm = 1000; // larger estimates are not trusted
+        static constexpr double kJump = 0.25;        // s off the fitted line restarts
+        static constexpr double kGap = 1.0;          // s without video restarts
+
+        AvDriftEstimator();
+
+        // Forget everything; correction() returns 1 until the next estimate.
+        // nominalRate = device frames per second (0 = inactive).
+        void reset(int nominalRate = 0);
+
+        // videoPts100ns: recorded video timeline; audioFrames: device frames
+        // captured so far; epoch: changes whenever audio data was lost.
+        void observe(int64_t videoPts100ns, uint64_t audioFrames, uint32_t epoch);
+
+        // Output/input rate factor for the audio resampler.
+        double correction() const { return correction_.load(std::memory_order_relaxed); }
+
+        void stats(gcap_av_sync_stats_t &out) const;
+
+    private:
+        struct Point
+        {
+            double video; // s since the window base
+            double audio; // s of device audio since the window base
+        };
+
+        void rebase(int64_t videoPts100ns, uint64_t audioFrames, uint32_t epoch);
+        void fit();
+        void publish(bool active, double jitterMs, double spanS);
+
+        int rate_ = 0;
+        bool based_ = false;
+        int64_t baseVideo_ = 0;
+        uint64_t baseAudio_ = 0;
+        uint32_t epoch_ = 0;
+
+        Point last_{};             // previous observation
+        Point acc_{};              // sums of the open interval
+        int accN_ = 0;
+        double accStart_ = 0.0;
+
+        Point pts_[kMaxPoints];
+        int head_ = 0, count_ = 0;
+        double slope_ = 1.0, intercept_ = 0.0; // audio = intercept + slope * video
+        double driftPpm_ = 0.0;                // last trusted estimate
+        double offsetMs_ = 0.0;                // drift integrated over the recording
+        uint32_t rebases_ = 0;
+
+        std::atomic<double> correction_{1.0};
+
+        // published values
+        std::atomic<uint32_t> seq_{0};
+        std::atomic<int> pubActive_{0};
+        std::atomic<double> pubDrift_{0.0};
+        std::atomic<double> pubOffset_{0.0};
+        std::atomic<double> pubJitter_{0.0};
+        std::atomic<double> pubSpan_{0.0};
+        std::atomic<uint32_t> pubRebase_{0};
+    };
+}
@@ -0,0 +1,321 @@
+// channel_mixer.cpp
+#include "channel_mixer.h"
+#include "../core/simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    using namespace gcap::audio;
+
+    constexpr float kMinus3dB = 0.70710678f;
+    constexpr int kMaxChannels = ChannelMixer::kMaxChannels;
+
+    int popcount32(uint32_t v)
+    {
+        int n = 0;
+        for (; v; v &= v - 1)
+            ++n;
+        return n;
+    }
+
+    // Speaker bit of each interleaved channel (channels follow mask bit order).
+    std::vector<uint32_t> channel_order(uint32_t mask, int channels)
+    {
+        std::vector<uint32_t> pos;
+        for (uint32_t bit = 1; bit && (int)pos.size() < channels; bit <<= 1)
+            if (mask & bit)
+                pos.push_back(bit);
+        while ((int)pos.size() < channels)
+            pos.push_back(0); // unknown position: routed nowhere by the presets
+        return pos;
+    }
+
+    // Stereo gains (left, right) of one source speaker, ITU-R BS.775 style.
+    void stereo_gains(uint32_t spk, float &l, float &r)
+    {
+        l = r = 0.0f;
+        switch (spk)
+        {
+        case kSpkFrontLeft:
+            l = 1.0f;
+            break;
+        case kSpkFrontRight:
+            r = 1.0f;
+            break;
+        case kSpkFrontCenter:
+            l = r = kMinus3dB;
+            break;
+        case kSpkBackLeft:
+        case kSpkSideLeft:
+        case kSpkFrontLeftOfCenter:
+            l = kMinus3dB;
+            break;
+        case kSpkBackRight:
+        case kSpkSideRight:
+        case kSpkFrontRightOfCenter:
+            r = kMinus3dB;
+            break;
+        case kSpkBackCenter:
+            l = r = 0.5f;
+            break;
+        default: // LFE and height channels are dropped
+            break;
+        }
+    }
+
+    // acc[i] (+)= w * x[i]
+    template <bool First>
+    void axpy(float *acc, const float *x, float w, size_t n)
+    {
+        size_t i = 0;
+#if defined(GCAP_SIMD_SSE2)
+        const __m128 vw = _mm_set1_ps(w);
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m128 p = _mm_mul_ps(vw, _mm_loadu_ps(x + i));
+            _mm_storeu_ps(acc + i, First ? p : _mm_add_ps(_mm_loadu_ps(acc + i), p));
+        }
+#elif defined(GCAP_SIMD_NEON)
+        for (; i + 4 <= n; i += 4)
+        {
+            const float32x4_t p = vmulq_n_f32(vld1q_f32(x + i), w);
+            vst1q_f32(acc + i, First ? p : vaddq_f32(vld1q_f32(acc + i), p));
+        }
+#endif
+        for (; i < n; ++i)
+            acc[i] = First ? w * x[i] : acc[i] + w * x[i];
+    }
+
+    inline int32_t load_s24(const uint8_t *p)
+    {
+        return (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+    }
+
+    // Interleaved -> planar float (plane stride = ChannelMixer::kBlock).
+    void load_planar(const void *src, SampleType type, int ch, size_t frames, float *planes)
+    {
+        constexpr size_t S = ChannelMixer::kBlock;
+        switch (type)
+        {
+        case SampleType::F32:
+        {
+            const float *in = static_cast<const float *>(src);
+            for (size_t f = 0; f < frames; ++f)
+                for (int c = 0; c < ch; ++c)
+                    planes[c * S + f] = in[f * ch + c];
+            break;
+        }
+        case SampleType::S32:
+        {
+            const int32_t *in = static_cast<const int32_t *>(src);
+            for (size_t f = 0; f < frames; ++f)
+                for (int c = 0; c < ch; ++c)
+                    planes[c * S + f] = (float)in[f * ch + c] * (1.0f / 2147483648.0f);
+            break;
+        }
+        case SampleType::S24:
+        {
+            const uint8_t *in = static_cast<const uint8_t *>(src);
+            for (size_t f = 0; f < frames; ++f)
+                for (int c = 0; c < ch; ++c)
+                    planes[c * S + f] = (float)load_s24(in + (f * ch + c) * 3) * (1.0f / 8388608.0f);
+            break;
+        }
+        case SampleType::S16:
+        default:
+        {
+            const int16_t *in = static_cast<const int16_t *>(src);
+            for (size_t f = 0; f < frames; ++f)
+                for (int c = 0; c < ch; ++c)
+                    planes[c * S + f] = (float)in[f * ch + c] * (1.0f / 32768.0f);
+            break;
+        }
+        }
+    }
+}
+
+namespace gcap::audio
+{
+    uint32_t default_channel_mask(int channels)
+    {
+        switch (channels)
+        {
+        case 1:
+            return kSpkFrontCenter;
+        case 2:
+            return kSpkFrontLeft | kSpkFrontRight;
+        case 3:
+            return kSpkFrontLeft | kSpkFrontRight | kSpkFrontCenter;
+        case 4:
+            return kSpkFrontLeft | kSpkFrontRight | kSpkBackLeft | kSpkBackRight;
+        case 5:
+            return kSpkFrontLeft | kSpkFrontRight | kSpkFrontCenter | kSpkBackLeft | kSpkBackRight;
+        case 6:
+            return kSpkFrontLeft | kSpkFrontRight | kSpkFrontCenter | kSpkLowFrequency | kSpkBackLeft | kSpkBackRight;
+        case 7:
+            return kSpkFrontLeft | kSpkFrontRight | kSpkFrontCenter | kSpkLowFrequency | kSpkBackCenter |
+                   kSpkSideLeft | kSpkSideRight;
+        case 8:
+            return kSpkFrontLeft | kSpkFrontRight | kSpkFrontCenter | kSpkLowFrequency | kSpkBackLeft |
+                   kSpkBackRight | kSpkSideLeft | kSpkSideRight;
+        default:
+            return 0;
+        }
+    }
+
+    bool ChannelMixer::configure(int inCh, uint32_t inMask, int outCh, uint32_t outMask, bool normalize)
+    {
+        if (inCh <= 0 || outCh <= 0 || inCh > kMaxChannels || outCh > kMaxChannels)
+            return false;
+        if (popcount32(inMask) != inCh)
+            inMask = default_channel_mask(inCh);
+        if (popcount32(outMask) != outCh)
+            outMask = default_channel_mask(outCh);
+
+        inCh_ = inCh;
+        outCh_ = outCh;
+        m_.assign((size_t)outCh * inCh, 0.0f);
+        const std::vector<uint32_t> ip = channel_order(inMask, inCh);
+        const std::vector<uint32_t> op = channel_order(outMask, outCh);
+
+        if (inCh == outCh && inMask == outMask)
+        {
+            for (int c = 0; c < inCh; ++c)
+                m_[(size_t)c * inCh + c] = 1.0f;
+        }
+        else if (inCh == 1)
+        {
+            // mono: to the front pair (or centre), unattenuated
+            for (int o = 0; o < outCh; ++o)
+                if (op[o] == kSpkFrontLeft || op[o] == kSpkFrontRight || op[o] == kSpkFrontCenter || outCh == 1)
+                    m_[(size_t)o] = 1.0f;
+        }
+        else if (outCh <= 2)
+        {
+            for (int i = 0; i < inCh; ++i)
+            {
+                float l, r;
+                stereo_gains(ip[i], l, r);
+                if (outCh == 1)
+                    m_[(size_t)i] = 0.5f * (l + r);
+                else
+                {
+                    m_[(size_t)i] = l;
+                    m_[(size_t)inCh + i] = r;
+                }
+            }
+        }
+        else
+        {
+            // route matching positions; the rest is dropped / silent
+            for (int o = 0; o < outCh; ++o)
+                for (int i = 0; i < inCh; ++i)
+                    if (op[o] && op[o] == ip[i])
+                        m_[(size_t)o * inCh + i] = 1.0f;
+        }
+
+        if (normalize)
+        {
+            for (int o = 0; o < outCh; ++o)
+            {
+                float sum = 0.0f;
+                for (int i = 0; i < inCh; ++i)
+                    sum += std::fabs(m_[(size_t)o * inCh + i]);
+                if (sum > 1.0f)
+                    for (int i = 0; i < inCh; ++i)
+                        m_[(size_t)o * inCh + i] /= sum;
+            }
+        }
+
+        finalize();
+        return true;
+    }
+
+    bool ChannelMixer::setMatrix(int inCh, int outCh, const float *matrix)
+    {
+        if (!matrix || inCh <= 0 || outCh <= 0 || inCh > kMaxChannels || outCh > kMaxChannels)
+            return false;
+        inCh_ = inCh;
+        outCh_ = outCh;
+        m_.assign(matrix, matrix + (size_t)outCh * inCh);
+        finalize();
+        return true;
+    }
+
+    void ChannelMixer::finalize()
+    {
+        identity_ = inCh_ == outCh_;
+        rows_.assign((size_t)outCh_, {});
+        for (int o = 0; o < outCh_; ++o)
+            for (int i = 0; i < inCh_; ++i)
+            {
+                const float w = m_[(size_t)o * inCh_ + i];
+                if (w != 0.0f)
+                    rows_[(size_t)o].push_back({i, w});
+                if (w != (o == i ? 1.0f : 0.0f))
+                    identity_ = false;
+            }
+    }
+
+    void ChannelMixer::mix_block(const void *src, SampleType type, size_t frames, float *out) const
+    {
+        alignas(32) float planes[kMaxChannels * kBlock];
+        alignas(32) float acc[kBlock];
+
+        load_planar(src, type, inCh_, frames, planes);
+        for (int o = 0; o < outCh_; ++o)
+        {
+            const auto &row = rows_[(size_t)o];
+            if (row.empty())
+                std::fill(acc, acc + frames, 0.0f);
+            for (size_t k = 0; k < row.size(); ++k)
+            {
+                const float *x = planes + (size_t)row[k].first * kBlock;
+                if (k == 0)
+                    axpy<true>(acc, x, row[k].second, frames);
+                else
+                    axpy<false>(acc, x, row[k].second, frames);
+            }
+            for (size_t f = 0; f < frames; ++f)
+                out[f * outCh_ + o] = acc[f];
+        }
+    }
+
+    void ChannelMixer::process_s16(const void *src, SampleType type, size_t frames, int16_t *dst, TpdfDither *dither) const
+    {
+        if (identity_)
+        {
+            to_s16(src, type, dst, frames * (size_t)inCh_, dither);
+            return;
+        }
+
+        alignas(32) float mixed[kMaxChannels * kBlock];
+        const size_t inStride = (size_t)sample_bytes(type) * inCh_;
+        const uint8_t *in = static_cast<const uint8_t *>(src);
+        for (size_t off = 0; off < frames; off += kBlock)
+        {
+            const size_t n = std::min(kBlock, frames - off);
+            mix_block(in + off * inStride, type, n, mixed);
+            f32_to_s16(mixed, dst + off * outCh_, n * outCh_, dither);
+        }
+    }
+
+    void ChannelMixer::process_f32(const void *src, SampleType type, size_t frames, float *dst) const
+    {
+        if (identity_)
+        {
+            to_f32(src, type, dst, frames * (size_t)inCh_);
+            return;
+        }
+
+        const size_t inStride = (size_t)sample_bytes(type) * inCh_;
+        const uint8_t *in = static_cast<const uint8_t *>(src);
+        for (size_t off = 0; off < frames; off += kBlock)
+        {
+            const size_t n = std::min(kBlock, frames - off);
+            mix_block(in + off * inStride, type, n, dst + off * outCh_);
+        }
+    }
+}
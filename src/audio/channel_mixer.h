@@ -0,0 +1,76 @@
+// channel_mixer.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "audio_convert.h"
+
+namespace gcap::audio
+{
+    // Speaker positions; same bits as the WAVEFORMATEXTENSIBLE dwChannelMask.
+    enum SpeakerBits : uint32_t
+    {
+        kSpkFrontLeft = 0x1,
+        kSpkFrontRight = 0x2,
+        kSpkFrontCenter = 0x4,
+        kSpkLowFrequency = 0x8,
+        kSpkBackLeft = 0x10,
+        kSpkBackRight = 0x20,
+        kSpkFrontLeftOfCenter = 0x40,
+        kSpkFrontRightOfCenter = 0x80,
+        kSpkBackCenter = 0x100,
+        kSpkSideLeft = 0x200,
+        kSpkSideRight = 0x400,
+    };
+
+    // Conventional mask for a channel count (mono, stereo, 3.0, quad, 5.0, 5.1, 6.1, 7.1).
+    uint32_t default_channel_mask(int channels);
+
+    /**
+     * @brief outCh x inCh mixing matrix applied while converting to PCM16 / float.
+     *
+     * Work is done in blocks of frames that stay in L1: the interleaved
+     * source (int16/int24/int32/float) is loaded into planar float, each
+     * output plane is accumulated with SIMD across frames (zero
+     * coefficients are skipped), and the result is interleaved and quantised
+     * with f32_to_s16 — one pass over the source, no full-size temporaries.
+     *
+     * configure() builds the ITU-R BS.775 downmix (centre and surrounds at
+     * -3 dB, LFE dropped) for 1/2-channel output, a mono upmix to the front
+     * pair, and otherwise routes matching speaker positions. An identity
+     * matrix falls through to the plain converters.
+     */
+    class ChannelMixer
+    {
+    public:
+        static constexpr size_t kBlock = 256;  // frames per pass
+        static constexpr int kMaxChannels = 16; // per side; block scratch lives on the stack
+
+        // Masks of 0 (or not matching the count) use default_channel_mask().
+        // normalize: scale rows so no output can exceed full scale.
+        bool configure(int inCh, uint32_t inMask, int outCh, uint32_t outMask = 0, bool normalize = false);
+        // Row-major outCh x inCh.
+        bool setMatrix(int inCh, int outCh, const float *matrix);
+
+        int inChannels() const { return inCh_; }
+        int outChannels() const { return outCh_; }
+        bool identity() const { return identity_; }
+        float coef(int out, int in) const { return m_[(size_t)out * inCh_ + in]; }
+
+        // src: `frames` interleaved inCh frames; dst: interleaved outCh frames.
+        void process_s16(const void *src, SampleType type, size_t frames, int16_t *dst, TpdfDither *dither = nullptr) const;
+        // Float output scaled like to_f32().
+        void process_f32(const void *src, SampleType type, size_t frames, float *dst) const;
+
+    private:
+        void finalize();
+        // Mix up to kBlock frames into interleaved float.
+        void mix_block(const void *src, SampleType type, size_t frames, float *out) const;
+
+        int inCh_ = 0, outCh_ = 0;
+        bool identity_ = false;
+        std::vector<float> m_;
+        // per output: (input index, weight) of the non-zero coefficients
+        std::vector<std::vector<std::pair<int, float>>> rows_;
+    };
+}
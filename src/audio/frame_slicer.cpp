@@ -0,0 +1,56 @@
+// frame_slicer.cpp
+#include "frame_slicer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace gcap::audio
+{
+    bool FrameSlicer::configure(size_t frameBytes, size_t capacityFrames)
+    {
+        if (!frameBytes || !capacityFrames)
+            return false;
+        frameBytes_ = frameBytes;
+        buf_.assign(frameBytes * capacityFrames, 0);
+        reset();
+        return true;
+    }
+
+    void FrameSlicer::reset()
+    {
+        read_ = 0;
+        size_ = 0;
+    }
+
+    size_t FrameSlicer::push(const uint8_t *data, size_t bytes)
+    {
+        const size_t cap = buf_.size();
+        const size_t n = std::min(bytes, cap - size_);
+        if (!n)
+            return 0;
+
+        size_t write = read_ + size_;
+        if (write >= cap)
+            write -= cap;
+        const size_t first = std::min(n, cap - write);
+        memcpy(buf_.data() + write, data, first);
+        if (n > first)
+            memcpy(buf_.data(), data + first, n - first);
+        size_ += n;
+        return n;
+    }
+
+    const uint8_t *FrameSlicer::front() const
+    {
+        return size_ >= frameBytes_ && frameBytes_ ? buf_.data() + read_ : nullptr;
+    }
+
+    void FrameSlicer::pop()
+    {
+        if (size_ < frameBytes_ || !frameBytes_)
+            return;
+        read_ += frameBytes_;
+        if (read_ == buf_.size())
+            read_ = 0;
+        size_ -= frameBytes_;
+    }
+}
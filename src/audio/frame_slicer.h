@@ -0,0 +1,45 @@
+// frame_slicer.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gcap::audio
+{
+    /**
+     * @brief Cuts a byte stream into fixed-size frames (e.g. 20 ms / 1024-sample AAC input).
+     *
+     * Fixed-capacity circular buffer whose capacity is a whole number of
+     * frames. Reads always consume whole frames, so the read position stays
+     * frame-aligned and front() is one contiguous frame in place: data is
+     * copied in once by push() and then read straight from the buffer. Only
+     * push() splits its copy at the wrap point.
+     *
+     * Not thread-safe; meant for the single audio writer thread.
+     */
+    class FrameSlicer
+    {
+    public:
+        // Allocates frameBytes * capacityFrames bytes; drops buffered data.
+        bool configure(size_t frameBytes, size_t capacityFrames);
+        void reset();
+
+        // Appends up to `bytes`; returns how many were accepted (less when full).
+        size_t push(const uint8_t *data, size_t bytes);
+
+        size_t frameBytes() const { return frameBytes_; }
+        size_t buffered() const { return size_; }
+        size_t space() const { return buf_.size() - size_; }
+        size_t framesReady() const { return frameBytes_ ? size_ / frameBytes_ : 0; }
+
+        // Oldest complete frame (frameBytes() bytes), or nullptr.
+        const uint8_t *front() const;
+        void pop();
+
+    private:
+        std::vector<uint8_t> buf_;
+        size_t frameBytes_ = 0;
+        size_t read_ = 0; // always a multiple of frameBytes_
+        size_t size_ = 0;
+    };
+}
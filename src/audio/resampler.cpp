@@ -0,0 +1,277 @@
+// resampler.cpp
+#include "resampler.h"
+#include "../core/simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+    constexpr double kPi = 3.14159265358979323846;
+
+    // Zeroth-order modified Bessel function of the first kind (series).
+    double bessel_i0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+        const double q = x * x / 4.0;
+        for (int k = 1; k < 50; ++k)
+        {
+            term *= q / ((double)k * k);
+            sum += term;
+            if (term < sum * 1e-12)
+                break;
+        }
+        return sum;
+    }
+
+    struct QualityParams
+    {
+        double beta;    // Kaiser window shape
+        double rolloff; // cutoff as a fraction of the lower Nyquist rate
+    };
+
+    QualityParams quality_params(gcap::audio::ResampleQuality q)
+    {
+        switch (q)
+        {
+        case gcap::audio::ResampleQuality::Fast:
+            return {6.0, 0.80};
+        case gcap::audio::ResampleQuality::High:
+            return {10.0, 0.94};
+        case gcap::audio::ResampleQuality::Balanced:
+        default:
+            return {8.0, 0.88};
+        }
+    }
+
+#if defined(GCAP_SIMD_AVX2)
+    GCAP_TARGET_AVX2 float dot_avx2(const float *a, const float *b, int n)
+    {
+        __m256 s = _mm256_setzero_ps();
+        for (int i = 0; i < n; i += 8)
+            s = _mm256_add_ps(s, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        __m128 h = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+        h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+        h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+        return _mm_cvtss_f32(h);
+    }
+#endif
+
+    // n is a multiple of 8
+    float dot(const float *a, const float *b, int n)
+    {
+#if defined(GCAP_SIMD_AVX2)
+        if (gcap::simd::cpu_has_avx2())
+            return dot_avx2(a, b, n);
+#endif
+#if defined(GCAP_SIMD_SSE2)
+        __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+        for (int i = 0; i < n; i += 8)
+        {
+            s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+        __m128 h = _mm_add_ps(s0, s1);
+        h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+        h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+        return _mm_cvtss_f32(h);
+#elif defined(GCAP_SIMD_NEON)
+        float32x4_t s0 = vdupq_n_f32(0.0f), s1 = vdupq_n_f32(0.0f);
+        for (int i = 0; i < n; i += 8)
+        {
+            s0 = vmlaq_f32(s0, vld1q_f32(a + i), vld1q_f32(b + i));
+            s1 = vmlaq_f32(s1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        }
+        const float32x4_t h = vaddq_f32(s0, s1);
+        const float32x2_t p = vadd_f32(vget_low_f32(h), vget_high_f32(h));
+        return vget_lane_f32(vpadd_f32(p, p), 0);
+#else
+        float s = 0.0f;
+        for (int i = 0; i < n; ++i)
+            s += a[i] * b[i];
+        return s;
+#endif
+    }
+}
+
+namespace gcap::audio
+{
+    bool Resampler::configure(int inRate, int outRate, int channels, ResampleQuality q, bool adjustable)
+    {
+        channels_ = 0;
+        if (inRate <= 0 || outRate <= 0 || channels <= 0)
+            return false;
+
+        const int g = std::gcd(inRate, outRate);
+        uint64_t L = (uint64_t)(outRate / g);
+        uint64_t M = (uint64_t)(inRate / g);
+        if (adjustable)
+        {
+            // M_ only sizes the history; the position is tracked by step_
+            M = std::max<uint64_t>(1, (uint64_t)std::ceil((double)inRate * kMaxPhases * (1.0 + kMaxAdjust) / outRate));
+            L = kMaxPhases;
+        }
+        else if (L > (uint64_t)kMaxPhases)
+        {
+            M = (uint64_t)std::llround((double)M * kMaxPhases / (double)L);
+            L = kMaxPhases;
+        }
+        if (M == 0)
+            return false;
+        L_ = (uint32_t)L;
+        M_ = (uint32_t)M;
+        adjustable_ = adjustable;
+        baseStep_ = (double)inRate / (double)outRate;
+
+        taps_ = (int)q;
+        const QualityParams qp = quality_params(q);
+        const double ratio = adjustable_ ? (double)outRate / (double)inRate : (double)L_ / (double)M_;
+        const double cutoff = qp.rolloff * std::min(1.0, ratio); // of input Nyquist
+        const double half = taps_ / 2.0;
+        const double i0b = bessel_i0(qp.beta);
+
+        // coef[p][k] weighs input (pos + k) for output time pos + (taps/2 - 1) + p/L;
+        // the adjustable table has phase L (= phase 0 one frame later) to interpolate towards
+        const uint32_t phases = L_ + (adjustable_ ? 1 : 0);
+        coef_.assign((size_t)phases * taps_, 0.0f);
+        lerp_.assign(adjustable_ ? (size_t)taps_ : 0, 0.0f);
+        std::vector<double> w((size_t)taps_);
+        for (uint32_t p = 0; p < phases; ++p)
+        {
+            double sum = 0.0;
+            for (int k = 0; k < taps_; ++k)
+            {
+                const double x = (double)k - (half - 1.0) - (double)p / (double)L_;
+                const double r = x / half;
+                const double win = std::fabs(r) < 1.0 ? bessel_i0(qp.beta * std::sqrt(1.0 - r * r)) / i0b : 0.0;
+                const double sx = cutoff * x;
+                const double sinc = std::fabs(sx) < 1e-9 ? 1.0 : std::sin(kPi * sx) / (kPi * sx);
+                w[(size_t)k] = cutoff * sinc * win;
+                sum += w[(size_t)k];
+            }
+            // unity DC gain on every phase
+            for (int k = 0; k < taps_; ++k)
+                coef_[(size_t)p * taps_ + k] = (float)(w[(size_t)k] / sum);
+        }
+
+        channels_ = channels;
+        histStride_ = kBlock + (size_t)taps_ + (M_ + L_ - 1) / L_;
+        hist_.assign(histStride_ * channels_, 0.0f);
+        adjust_ = 1.0;
+        step_ = (uint64_t)std::llround(baseStep_ * 4294967296.0);
+        reset();
+        return true;
+    }
+
+    void Resampler::setRateAdjust(double factor)
+    {
+        if (!adjustable_ || !(factor > 0.0))
+            return;
+        adjust_ = std::clamp(factor, 1.0 - kMaxAdjust, 1.0 + kMaxAdjust);
+        step_ = (uint64_t)std::llround(baseStep_ / adjust_ * 4294967296.0);
+    }
+
+    void Resampler::reset()
+    {
+        std::fill(hist_.begin(), hist_.end(), 0.0f);
+        // taps/2 - 1 zeros of history: the first window is centred on input frame 0
+        avail_ = (size_t)(taps_ / 2 - 1);
+        pos_ = 0;
+        phase_ = 0;
+        frac_ = 0;
+    }
+
+    size_t Resampler::maxOutput(size_t inFrames) const
+    {
+        if (adjustable_)
+            return (size_t)(((uint64_t)(avail_ + inFrames) << 32) / step_) + 2;
+        return (size_t)(((uint64_t)(avail_ + inFrames) * L_) / M_) + 1;
+    }
+
+    void Resampler::advance()
+    {
+        if (adjustable_)
+        {
+            const uint64_t p = (uint64_t)frac_ + step_;
+            pos_ += (size_t)(p >> 32);
+            frac_ = (uint32_t)p;
+            return;
+        }
+        phase_ += M_;
+        pos_ += phase_ / L_;
+        phase_ %= L_;
+    }
+
+    const float *Resampler::phaseCoefs()
+    {
+        if (!adjustable_)
+            return coef_.data() + (size_t)phase_ * taps_;
+
+        // top 10 bits pick the phase, the remaining 22 interpolate to the next one
+        constexpr int kFracBits = 32 - 10;
+        static_assert((1 << 10) == kMaxPhases, "phase index width");
+        const uint32_t p = frac_ >> kFracBits;
+        const float t = (float)(frac_ & ((1u << kFracBits) - 1)) * (1.0f / (float)(1u << kFracBits));
+        const float *a = coef_.data() + (size_t)p * taps_;
+        const float *b = a + taps_;
+        for (int k = 0; k < taps_; ++k)
+            lerp_[(size_t)k] = a[k] + t * (b[k] - a[k]);
+        return lerp_.data();
+    }
+
+    size_t Resampler::process(const float *in, size_t inFrames, float *out, size_t outCapacity)
+    {
+        if (!channels_)
+            return 0;
+
+        const int ch = channels_;
+        size_t produced = 0;
+        while (inFrames)
+        {
+            // leftover history is < taps frames (or empty with pos_ ahead), so a block always fits
+            const size_t n = std::min(kBlock, inFrames);
+            for (int c = 0; c < ch; ++c)
+            {
+                float *h = hist_.data() + (size_t)c * histStride_ + avail_;
+                for (size_t i = 0; i < n; ++i)
+                    h[i] = in[i * ch + c];
+            }
+            avail_ += n;
+            in += n * ch;
+            inFrames -= n;
+
+            // past outCapacity frames are dropped but the timeline still advances
+            while (pos_ + (size_t)taps_ <= avail_)
+            {
+                if (produced < outCapacity)
+                {
+                    const float *k = phaseCoefs();
+                    float *o = out + produced * ch;
+                    for (int c = 0; c < ch; ++c)
+                        o[c] = dot(k, hist_.data() + (size_t)c * histStride_ + pos_, taps_);
+                    ++produced;
+                }
+                advance();
+            }
+
+            // drop consumed frames
+            if (pos_ >= avail_)
+            {
+                pos_ -= avail_;
+                avail_ = 0;
+            }
+            else if (pos_)
+            {
+                for (int c = 0; c < ch; ++c)
+                {
+                    float *h = hist_.data() + (size_t)c * histStride_;
+                    memmove(h, h + pos_, (avail_ - pos_) * sizeof(float));
+                }
+                avail_ -= pos_;
+                pos_ = 0;
+            }
+        }
+        return produced;
+    }
+}
@@ -0,0 +1,93 @@
+// resampler.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gcap::audio
+{
+    // Taps per phase; look-ahead is taps/2 input frames (0.17 / 0.33 / 0.67 ms @ 48 kHz).
+    // Higher quality also widens the passband and raises the Kaiser beta.
+    enum class ResampleQuality
+    {
+        Fast = 16,
+        Balanced = 32,
+        High = 64,
+    };
+
+    /**
+     * @brief Polyphase windowed-sinc (Kaiser) sample-rate converter.
+     *
+     * The ratio out/in is reduced to L/M and one filter phase is precomputed
+     * per output position (L phases x taps). Each output frame is one SIMD dot
+     * product per channel over planar history, so the cost is
+     * taps * channels MACs per output frame regardless of the ratio. The
+     * cutoff follows the lower of the two Nyquist rates.
+     *
+     * Output timing is aligned with the input: output frame n corresponds to
+     * input time n * in / out; the filter's look-ahead is buffered, not
+     * delayed.
+     *
+     * An adjustable converter uses kMaxPhases phases and a 32.32 fixed-point
+     * input position instead, interpolating linearly between the two nearest
+     * phases, so setRateAdjust() can trim the ratio by a few ppm at any
+     * packet boundary without a discontinuity (clock drift compensation;
+     * also valid for inRate == outRate).
+     */
+    class Resampler
+    {
+    public:
+        // Every pair of standard rates (8 kHz .. 192 kHz) reduces to L <= 1024.
+        // Odd ratios needing more phases are rounded to L = kMaxPhases, with
+        // a relative rate error below 0.5 / M.
+        static constexpr int kMaxPhases = 1024;
+
+        // Largest trim accepted by setRateAdjust() (+-0.5 %).
+        static constexpr double kMaxAdjust = 0.005;
+
+        bool configure(int inRate, int outRate, int channels,
+                       ResampleQuality q = ResampleQuality::Balanced, bool adjustable = false);
+        void reset(); // clear history, keep the filter
+
+        bool configured() const { return channels_ > 0; }
+        bool adjustable() const { return adjustable_; }
+        bool passthrough() const { return !adjustable_ && L_ == M_; }
+        int channels() const { return channels_; }
+
+        // Upper bound on frames produced by process(inFrames).
+        size_t maxOutput(size_t inFrames) const;
+
+        // Interleaved float in/out. Consumes all input; returns frames written.
+        // outCapacity must be at least maxOutput(inFrames).
+        size_t process(const float *in, size_t inFrames, float *out, size_t outCapacity);
+
+        // Adjustable converters only: output rate = outRate * factor
+        // (clamped to 1 +- kMaxAdjust). Takes effect at the next output frame.
+        void setRateAdjust(double factor);
+        double rateAdjust() const { return adjust_; }
+
+    private:
+        static constexpr size_t kBlock = 1024; // input frames staged per pass
+
+        void advance();
+        const float *phaseCoefs(); // taps_ coefficients for the current position
+
+        int channels_ = 0;
+        int taps_ = 0;
+        uint32_t L_ = 1, M_ = 1;
+        std::vector<float> coef_; // L_ (+1 when adjustable) phases x taps_
+
+        bool adjustable_ = false;
+        double baseStep_ = 1.0; // in / out
+        double adjust_ = 1.0;
+        uint64_t step_ = 0;       // 32.32 input frames per output frame
+        uint32_t frac_ = 0;       // fractional input position
+        std::vector<float> lerp_; // interpolated phase, taps_
+
+        std::vector<float> hist_; // per channel: kBlock + taps_ floats
+        size_t histStride_ = 0;
+        size_t avail_ = 0; // frames in hist_
+        size_t pos_ = 0;   // first frame of the next window
+        uint32_t phase_ = 0;
+    };
+}
@@ -0,0 +1,135 @@
+// shared_source.cpp
+#include "shared_source.h"
+#include <map>
+#include <mutex>
+
+namespace gcap::audio
+{
+    struct SharedAudioSource::Device
+    {
+        std::wstring id;
+        std::unique_ptr<AudioSourceBase> source;
+        int users = 0;
+    };
+
+    namespace
+    {
+        // open devices by id; guards Device::users and start / stop of the sources
+        std::mutex &devices_mutex()
+        {
+            static std::mutex m;
+            return m;
+        }
+
+        std::map<std::wstring, std::shared_ptr<SharedAudioSource::Device>> &devices()
+        {
+            static std::map<std::wstring, std::shared_ptr<SharedAudioSource::Device>> all;
+            return all;
+        }
+    }
+
+    SharedAudioSource::~SharedAudioSource()
+    {
+        stop();
+    }
+
+    bool SharedAudioSource::start(uint32_t sampleRate, uint32_t channels, uint32_t bits,
+                                  const std::wstring &deviceId, AudioFormat *outFmt)
+    {
+        stop();
+        if (outFmt)
+            *outFmt = {};
+        if (!sampleRate || !channels)
+            return false;
+
+        std::lock_guard<std::mutex> lk(devices_mutex());
+        device_.reset();
+        std::shared_ptr<Device> &dev = devices()[deviceId];
+        if (!dev)
+        {
+            auto d = std::make_shared<Device>();
+            d->id = deviceId;
+            d->source = create_device_source(deviceId);
+            if (d->source)
+            {
+                d->source->setOwnOutput(false);
+                d->source->setThreadHook(threadHook_);
+            }
+            if (!d->source || !d->source->start(sampleRate, channels, bits, deviceId))
+            {
+                if (d->source)
+                    d->source->stop();
+                devices().erase(deviceId);
+                return false;
+            }
+            dev = std::move(d);
+        }
+
+        // this handle's conversion, from whatever format the device runs at
+        out_.prepare(sampleRate, channels);
+        if (!out_.configure(dev->source->deviceFormat(), dev->source->maxPacketFrames()) ||
+            !dev->source->attach(&out_))
+        {
+            if (dev->users == 0)
+            {
+                dev->source->stop();
+                devices().erase(deviceId);
+            }
+            return false;
+        }
+        ++dev->users;
+        device_ = dev;
+        live_.store(true);
+
+        if (outFmt)
+        {
+            outFmt->sampleRate = sampleRate;
+            outFmt->channels = channels;
+            outFmt->bits = 16;
+            outFmt->isFloat = false;
+            outFmt->blockAlign = channels * 2;
+        }
+        return true;
+    }
+
+    void SharedAudioSource::stop()
+    {
+        std::lock_guard<std::mutex> lk(devices_mutex());
+        if (!live_.load())
+            return;
+        // the last user stops the device first, so everything it captured reached this output
+        if (--device_->users == 0)
+        {
+            device_->source->stop();
+            devices().erase(device_->id);
+        }
+        device_->source->detach(&out_);
+
+        // The ring (and device_, for its final counts) is kept until the
+        // next start(): the consumer still drains it.
+        live_.store(false);
+        out_.wake();
+    }
+
+    uint64_t SharedAudioSource::capturedFrames() const
+    {
+        return device_ ? device_->source->capturedFrames() : 0;
+    }
+
+    uint32_t SharedAudioSource::discontinuities() const
+    {
+        return device_ ? device_->source->discontinuities() : 0;
+    }
+
+    uint32_t SharedAudioSource::deviceRate() const
+    {
+        return device_ ? device_->source->deviceRate() : 0;
+    }
+
+    int shared_audio_users(const std::wstring &deviceId)
+    {
+        std::lock_guard<std::mutex> lk(devices_mutex());
+        const auto it = devices().find(deviceId);
+        return it == devices().end() ? 0 : it->second->users;
+    }
+}
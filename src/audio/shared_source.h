@@ -0,0 +1,68 @@
+// shared_source.h
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include "audio_source.h"
+
+namespace gcap::audio
+{
+    /**
+     * @brief Consumer handle on a process-wide capture device.
+     *
+     * Handles started on the same device id share one device source (one
+     * WASAPI client per endpoint), so e.g. a recording and the standalone
+     * audio session of the same microphone do not open it twice. Each
+     * handle has its own AudioOutput: format, resampler (and drift trim),
+     * dither, meter and ring.
+     *
+     * The first start() on an id opens the device with its format request
+     * (the native device format is what the backend negotiates from it) and
+     * its thread hook; later handles attach to the running device and
+     * convert from its format. The last stop() closes the device. The
+     * device counters (capturedFrames, discontinuities) count from the
+     * device's start, not the handle's.
+     */
+    class SharedAudioSource : public IAudioSource
+    {
+    public:
+        SharedAudioSource() = default;
+        ~SharedAudioSource() override;
+
+        SharedAudioSource(const SharedAudioSource &) = delete;
+        SharedAudioSource &operator=(const SharedAudioSource &) = delete;
+
+        bool start(uint32_t sampleRate, uint32_t channels, uint32_t bits,
+                   const std::wstring &deviceId, AudioFormat *outFmt = nullptr) override;
+        void stop() override;
+        bool running() const override { return live_.load(); }
+
+        bool peek(AudioChunk &out) override { return out_.peek(out); }
+        void release() override { out_.release(); }
+        bool waitForData(int timeoutMs) override { return out_.waitForData(timeoutMs, live_); }
+
+        AudioRing::Stats ringStats() const override { return out_.ringStats(); }
+        uint64_t capturedFrames() const override;
+        uint32_t discontinuities() const override;
+        uint32_t deviceRate() const override;
+
+        void setDither(bool on) override { out_.setDither(on); }
+        void setResampleQuality(ResampleQuality q) override { out_.setResampleQuality(q); }
+        void setMeter(LevelMeter *meter) override { out_.setMeter(meter); }
+        void setDriftCorrection(const AvDriftEstimator *drift) override { out_.setDriftCorrection(drift); }
+        // Used only when this handle opens the device.
+        void setThreadHook(std::function<void(bool begin)> hook) override { threadHook_ = std::move(hook); }
+
+        struct Device;
+
+    private:
+        AudioOutput out_;
+        std::atomic<bool> live_{false};
+        std::function<void(bool)> threadHook_;
+        std::shared_ptr<Device> device_; // from start() until the next one (counts stay readable)
+    };
+
+    // Handles currently started on `deviceId` (0 = device closed).
+    int shared_audio_users(const std::wstring &deviceId);
+}
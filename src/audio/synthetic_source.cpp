@@ -0,0 +1,350 @@
+// synthetic_source.cpp
+#include "synthetic_source.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace gcap::audio
+{
+    namespace
+    {
+        constexpr wchar_t kPrefix[] = L"synthetic";
+        constexpr size_t kPrefixLen = sizeof(kPrefix) / sizeof(kPrefix[0]) - 1;
+
+        bool parse_double(const std::string &s, double &out)
+        {
+            char *end = nullptr;
+            const double v = std::strtod(s.c_str(), &end);
+            if (s.empty() || *end || !std::isfinite(v))
+                return false;
+            out = v;
+            return true;
+        }
+
+        bool parse_u32(const std::string &s, uint32_t &out)
+        {
+            char *end = nullptr;
+            const unsigned long long v = std::strtoull(s.c_str(), &end, 0);
+            if (s.empty() || s[0] == '-' || *end || v > 0xFFFFFFFFull)
+                return false;
+            out = (uint32_t)v;
+            return true;
+        }
+
+        bool parse_probability(const std::string &s, double &out)
+        {
+            return parse_double(s, out) && out >= 0.0 && out <= 1.0;
+        }
+
+        bool apply_option(const std::string &key, const std::string &value, SyntheticAudioConfig &cfg)
+        {
+            using Signal = SyntheticAudioConfig::Signal;
+            if (value.empty())
+            {
+                if (key == "sine")
+                    cfg.signal = Signal::Sine;
+                else if (key == "noise")
+                    cfg.signal = Signal::Noise;
+                else if (key == "silence")
+                    cfg.signal = Signal::Silence;
+                else if (key == "fast")
+                    cfg.realtime = false;
+                else
+                    return false;
+                return true;
+            }
+
+            uint32_t u = 0;
+            if (key == "freq")
+                return parse_double(value, cfg.frequency) && cfg.frequency >= 0.0;
+            if (key == "level")
+                return parse_double(value, cfg.levelDb) && cfg.levelDb <= 0.0;
+            if (key == "rate")
+                return parse_u32(value, cfg.format.sampleRate);
+            if (key == "ch")
+                return parse_u32(value, cfg.format.channels);
+            if (key == "bits")
+                return parse_u32(value, cfg.format.bits);
+            if (key == "float")
+            {
+                if (!parse_u32(value, u) || u > 1)
+                    return false;
+                cfg.format.isFloat = u != 0;
+                return true;
+            }
+            if (key == "mask")
+                return parse_u32(value, cfg.format.channelMask);
+            if (key == "packet")
+                return parse_u32(value, cfg.packetFrames) && cfg.packetFrames > 0;
+            if (key == "pjitter")
+                return parse_u32(value, cfg.packetJitterFrames);
+            if (key == "ppm")
+                return parse_double(value, cfg.clockPpm) && std::fabs(cfg.clockPpm) < 1e5;
+            if (key == "jitter")
+                return parse_double(value, cfg.timingJitterMs) && cfg.timingJitterMs >= 0.0;
+            if (key == "burst")
+                return parse_probability(value, cfg.burstProbability);
+            if (key == "burstlen")
+                return parse_u32(value, cfg.burstPackets) && cfg.burstPackets > 0;
+            if (key == "drop")
+                return parse_probability(value, cfg.dropoutProbability);
+            if (key == "seed")
+                return parse_u32(value, cfg.seed);
+            return false;
+        }
+    }
+
+    bool is_synthetic_source_id(const std::wstring &id)
+    {
+        return id.compare(0, kPrefixLen, kPrefix) == 0 && (id.size() == kPrefixLen || id[kPrefixLen] == L':');
+    }
+
+    bool parse_synthetic_source_id(const std::wstring &id, SyntheticAudioConfig &cfg)
+    {
+        if (!is_synthetic_source_id(id))
+            return false;
+
+        // options are plain ASCII
+        std::string opts;
+        opts.reserve(id.size());
+        for (size_t i = kPrefixLen + 1; i < id.size(); ++i)
+        {
+            if (id[i] > 0x7F)
+                return false;
+            opts.push_back((char)id[i]);
+        }
+
+        size_t pos = 0;
+        while (pos < opts.size())
+        {
+            size_t end = opts.find(',', pos);
+            if (end == std::string::npos)
+                end = opts.size();
+            const std::string item = opts.substr(pos, end - pos);
+            pos = end + 1;
+            if (item.empty())
+                continue;
+            const size_t eq = item.find('=');
+            const std::string key = item.substr(0, eq);
+            const std::string value = eq == std::string::npos ? std::string() : item.substr(eq + 1);
+            if (eq != std::string::npos && value.empty())
+                return false;
+            if (!apply_option(key, value, cfg))
+                return false;
+        }
+        return true;
+    }
+
+    SyntheticAudioSource::~SyntheticAudioSource()
+    {
+        stop();
+    }
+
+    bool SyntheticAudioSource::start(uint32_t sampleRate, uint32_t channels, uint32_t /*bits: output is PCM16*/,
+                                     const std::wstring &deviceId, AudioFormat *outFmt)
+    {
+        stop();
+        if (outFmt)
+            *outFmt = {};
+
+        SyntheticAudioConfig cfg = config_;
+        if (!deviceId.empty() && !parse_synthetic_source_id(deviceId, cfg))
+            return false;
+        if (!sampleRate || !channels || !cfg.packetFrames)
+            return false;
+
+        prepare(sampleRate, channels);
+        active_ = cfg;
+        dev_ = cfg.format;
+        if (!dev_.sampleRate)
+            dev_.sampleRate = sampleRate;
+        if (!dev_.channels)
+            dev_.channels = channels;
+        if (dev_.isFloat)
+            dev_.bits = 32;
+        dev_.blockAlign = dev_.channels * (dev_.bits / 8);
+        if (!device_format_supported(dev_))
+            return false;
+
+        const uint32_t maxFrames = cfg.packetFrames + cfg.packetJitterFrames;
+        if (!configurePipeline(maxFrames))
+            return false;
+        signal_.assign((size_t)maxFrames * dev_.channels, 0.0f);
+        packet_.assign((size_t)maxFrames * dev_.blockAlign, 0);
+        // small seeds would start xorshift on a run of tiny values
+        rng_ = (cfg.seed ^ 0x9E3779B9u) * 2654435761u;
+        if (!rng_)
+            rng_ = 1;
+        phase_ = 0.0;
+        dropped_.store(0);
+
+        running_.store(true);
+        thread_ = std::thread([this]()
+                              { this->run(); });
+
+        if (outFmt)
+        {
+            outFmt->sampleRate = sampleRate;
+            outFmt->channels = channels;
+            outFmt->bits = 16;
+            outFmt->isFloat = false;
+            outFmt->blockAlign = channels * 2;
+        }
+        return true;
+    }
+
+    void SyntheticAudioSource::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(sleepMutex_);
+            running_.store(false);
+        }
+        sleepCv_.notify_all();
+        if (thread_.joinable())
+            thread_.join();
+
+        // The ring is kept until the next start(): the consumer still drains it.
+        wake();
+    }
+
+    uint32_t SyntheticAudioSource::random()
+    {
+        // xorshift32: cheap, reproducible from the seed
+        uint32_t x = rng_;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        rng_ = x;
+        return x;
+    }
+
+    void SyntheticAudioSource::generate(uint32_t frames)
+    {
+        using Signal = SyntheticAudioConfig::Signal;
+        const uint32_t ch = dev_.channels;
+        const size_t samples = (size_t)frames * ch;
+        const float amp = (float)std::pow(10.0, active_.levelDb / 20.0);
+
+        switch (active_.signal)
+        {
+        case Signal::Sine:
+        {
+            const double step = active_.frequency / (double)dev_.sampleRate;
+            for (uint32_t i = 0; i < frames; ++i)
+            {
+                const float v = amp * (float)std::sin(2.0 * 3.14159265358979323846 * phase_);
+                std::fill_n(&signal_[(size_t)i * ch], ch, v);
+                phase_ += step;
+                phase_ -= std::floor(phase_);
+            }
+            break;
+        }
+        case Signal::Noise:
+            for (size_t i = 0; i < samples; ++i)
+                signal_[i] = amp * (float)(2.0 * uniform() - 1.0);
+            break;
+        case Signal::Silence:
+            std::fill_n(signal_.begin(), samples, 0.0f);
+            break;
+        }
+
+        // to the device format
+        uint8_t *dst = packet_.data();
+        switch (device_sample_type(dev_))
+        {
+        case SampleType::F32:
+            memcpy(dst, signal_.data(), samples * sizeof(float));
+            break;
+        case SampleType::S32:
+            for (size_t i = 0; i < samples; ++i)
+            {
+                const int32_t v = (int32_t)std::lrint((double)signal_[i] * 2147483647.0);
+                memcpy(dst + i * 4, &v, 4);
+            }
+            break;
+        case SampleType::S24:
+            for (size_t i = 0; i < samples; ++i)
+            {
+                const int32_t v = (int32_t)std::lrint((double)signal_[i] * 8388607.0);
+                dst[i * 3 + 0] = (uint8_t)(v & 0xFF);
+                dst[i * 3 + 1] = (uint8_t)((v >> 8) & 0xFF);
+                dst[i * 3 + 2] = (uint8_t)((v >> 16) & 0xFF);
+            }
+            break;
+        case SampleType::S16:
+            for (size_t i = 0; i < samples; ++i)
+            {
+                const int16_t v = (int16_t)std::lrint((double)signal_[i] * 32767.0);
+                memcpy(dst + i * 2, &v, 2);
+            }
+            break;
+        }
+    }
+
+    void SyntheticAudioSource::run()
+    {
+        const ThreadScope scope(*this);
+        using clock = std::chrono::steady_clock;
+        const SyntheticAudioConfig &cfg = active_;
+        // frames per wall-clock second of the simulated device
+        const double rate = (double)dev_.sampleRate * (1.0 + cfg.clockPpm * 1e-6);
+        const auto t0 = clock::now();
+        uint64_t produced = 0;
+        uint32_t held = 0;  // packets of the current burst still to deliver back-to-back
+        bool lost = false; // a packet was dropped since the last delivery
+
+        while (running_.load())
+        {
+            uint32_t frames = cfg.packetFrames;
+            if (cfg.packetJitterFrames)
+            {
+                const uint32_t j = cfg.packetJitterFrames;
+                const int64_t f = (int64_t)frames - j + (int64_t)(random() % (2 * j + 1));
+                frames = (uint32_t)std::max<int64_t>(1, f);
+            }
+            generate(frames);
+            produced += frames;
+
+            if (cfg.realtime)
+            {
+                if (held)
+                    --held;
+                else
+                {
+                    // due once the last frame has been captured; late, never early
+                    double dueS = (double)produced / rate;
+                    if (cfg.burstPackets > 1 && cfg.burstProbability > 0.0 && uniform() < cfg.burstProbability)
+                    {
+                        held = cfg.burstPackets - 1;
+                        dueS += held * (double)cfg.packetFrames / rate;
+                    }
+                    if (cfg.timingJitterMs > 0.0)
+                        dueS += uniform() * cfg.timingJitterMs * 1e-3;
+                    const auto due = t0 + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(dueS));
+                    std::unique_lock<std::mutex> lk(sleepMutex_);
+                    sleepCv_.wait_until(lk, due, [this]()
+                                        { return !running_.load(); });
+                }
+            }
+            else
+            {
+                // back-pressure instead of a clock: never overrun the consumer
+                while (running_.load() && ringFill() > 0.5)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if (!running_.load())
+                break;
+
+            if (cfg.dropoutProbability > 0.0 && uniform() < cfg.dropoutProbability)
+            {
+                lost = true;
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            deliver(packet_.data(), frames, cfg.signal == SyntheticAudioConfig::Signal::Silence, lost);
+            lost = false;
+        }
+    }
+}
@@ -0,0 +1,110 @@
+// synthetic_source.h
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "audio_source.h"
+
+namespace gcap::audio
+{
+    struct SyntheticAudioConfig
+    {
+        enum class Signal
+        {
+            Sine,
+            Noise, // uniform white noise, independent per channel
+            Silence,
+        };
+
+        Signal signal = Signal::Sine;
+        double frequency = 1000.0; // Hz (Sine)
+        double levelDb = -20.0;    // peak, dBFS
+
+        // Generated format; sampleRate / channels of 0 follow the requested
+        // output format, so by default only the sample conversion runs.
+        DeviceFormat format{0, 0, 32, true, 0, 0};
+
+        uint32_t packetFrames = 480;      // nominal device packet (10 ms @ 48 kHz)
+        uint32_t packetJitterFrames = 0;  // each packet is packetFrames +- this
+        double clockPpm = 0.0;            // device clock error against the wall clock
+        double timingJitterMs = 0.0;      // packets arrive up to this much late
+        double burstProbability = 0.0;    // per packet: start a burst
+        uint32_t burstPackets = 4;        // packets held back and delivered together
+        double dropoutProbability = 0.0;  // per packet: lose it (next one is a discontinuity)
+        uint32_t seed = 1;
+        bool realtime = true; // false: generate as fast as the consumer drains
+    };
+
+    // True for ids of the form "synthetic" / "synthetic:<options>".
+    bool is_synthetic_source_id(const std::wstring &id);
+
+    // Applies the comma-separated options after "synthetic:" on top of `cfg`:
+    //   sine | noise | silence      signal
+    //   freq=<Hz> level=<dBFS>
+    //   rate=<Hz> ch=<n> bits=<16|24|32> float=<0|1> mask=<speaker mask>
+    //   packet=<frames> pjitter=<frames>
+    //   ppm=<clock error> jitter=<ms> burst=<probability> burstlen=<packets>
+    //   drop=<probability> seed=<n> fast
+    // Returns false on an unknown option or a malformed value.
+    bool parse_synthetic_source_id(const std::wstring &id, SyntheticAudioConfig &cfg);
+
+    /**
+     * @brief Device-less IAudioSource: a generator thread paced like a sound card.
+     *
+     * Each packet is synthesised in the configured device format and pushed
+     * through the same conversion, resampling, metering and ring as WASAPI
+     * capture, so the whole audio pipeline (and the A/V drift estimator via
+     * capturedFrames()) can run on machines without audio hardware.
+     *
+     * Packets are due when their last frame has been "captured" on a clock
+     * that runs clockPpm fast or slow; timing jitter, bursts and dropouts
+     * only move or remove deliveries, never the underlying clock, just like
+     * a real device. In non-realtime mode the generator runs unpaced and
+     * stalls while a ring it feeds is more than half full, or while it has
+     * no output to feed.
+     */
+    class SyntheticAudioSource : public AudioSourceBase
+    {
+    public:
+        SyntheticAudioSource() = default;
+        explicit SyntheticAudioSource(const SyntheticAudioConfig &cfg) : config_(cfg) {}
+        ~SyntheticAudioSource() override;
+
+        SyntheticAudioSource(const SyntheticAudioSource &) = delete;
+        SyntheticAudioSource &operator=(const SyntheticAudioSource &) = delete;
+
+        // Base settings; options in the start() id override them. Call before start().
+        void setConfig(const SyntheticAudioConfig &cfg) { config_ = cfg; }
+        const SyntheticAudioConfig &config() const { return config_; }
+
+        bool start(uint32_t sampleRate, uint32_t channels, uint32_t bits,
+                   const std::wstring &deviceId, AudioFormat *outFmt = nullptr) override;
+        void stop() override;
+
+        // Packets lost on purpose (dropoutProbability). Any thread.
+        uint32_t droppedPackets() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        void run();
+        void generate(uint32_t frames);
+        uint32_t random();
+        double uniform() { return (random() >> 8) * (1.0 / 16777216.0); } // [0, 1)
+
+        SyntheticAudioConfig config_{};
+        SyntheticAudioConfig active_{}; // config_ + id options, fixed while running
+
+        std::thread thread_;
+        std::mutex sleepMutex_;
+        std::condition_variable sleepCv_; // cut short by stop()
+
+        uint32_t rng_ = 1;
+        double phase_ = 0.0; // cycles, [0, 1)
+        std::vector<float> signal_;   // one packet, interleaved float
+        std::vector<uint8_t> packet_; // one packet in the device format
+        std::atomic<uint32_t> dropped_{0};
+    };
+}
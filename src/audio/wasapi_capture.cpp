@@ -0,0 +1,281 @@
+// wasapi_capture.cpp
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include "wasapi_capture.h"
+#include "../core/trace.h"
+
+#include <ksmedia.h>
+
+#include <chrono>
+
+// WASAPI 需要 ole32
+#pragma comment(lib, "ole32.lib")
+
+namespace gcap::audio
+{
+    WasapiCapture::~WasapiCapture()
+    {
+        stop();
+    }
+
+    bool WasapiCapture::start(uint32_t sampleRate, uint32_t channels, uint32_t bits,
+                              const std::wstring &endpointId, AudioFormat *outFmt)
+    {
+        stop();
+        // OBS-style: local cursor timeline (do not trust devPos)
+        prepare(sampleRate, channels);
+        bits_ = bits;
+        endpointId_ = endpointId;
+        {
+            std::lock_guard<std::mutex> lk(initMutex_);
+            initDone_ = false;
+            initOk_ = false;
+            actual_ = {};
+        }
+
+        running_.store(true);
+        thread_ = std::thread([this]()
+                              { this->run(); });
+        // Wait for init result so caller can decide whether to enable audio
+
+        std::unique_lock<std::mutex> ulk(initMutex_);
+        initCv_.wait_for(ulk, std::chrono::milliseconds(800), [this]()
+                         { return initDone_; });
+        if (outFmt)
+            *outFmt = actual_;
+        return initOk_;
+    }
+
+    void WasapiCapture::stop()
+    {
+        running_.store(false);
+        if (event_)
+            SetEvent(event_);
+        if (thread_.joinable())
+            thread_.join();
+
+        if (captureClient_)
+            captureClient_.Reset();
+        if (audioClient_)
+            audioClient_.Reset();
+        if (device_)
+            device_.Reset();
+        if (enumerator_)
+            enumerator_.Reset();
+        if (event_)
+        {
+            CloseHandle(event_);
+            event_ = nullptr;
+        }
+
+        // The ring is kept until the next start(): the recorder still drains it.
+        wake();
+    }
+
+    void WasapiCapture::run()
+    {
+        gcap::trace::setThreadName("wasapi");
+        const ThreadScope scope(*this);
+        // COM init for this thread
+        CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        auto notifyInit = [&](bool ok)
+        {
+            std::lock_guard<std::mutex> lk(initMutex_);
+            initDone_ = true;
+            initOk_ = ok;
+            actual_.sampleRate = sampleRate_;
+            actual_.channels = channels_;
+            // We always output PCM16 to the upper layer (OBS-style stability)
+            actual_.bits = 16;
+            actual_.isFloat = false;
+            actual_.blockAlign = actual_.channels * (actual_.bits / 8);
+            initCv_.notify_all();
+        };
+
+        HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+                                      IID_PPV_ARGS(&enumerator_));
+        if (FAILED(hr))
+        {
+            notifyInit(false);
+            CoUninitialize();
+            return;
+        }
+
+        // Use selected endpoint if provided; otherwise fall back to default.
+        if (!endpointId_.empty())
+        {
+            hr = enumerator_->GetDevice(endpointId_.c_str(), &device_);
+            if (FAILED(hr))
+            {
+                // Device may have been removed / id invalid → fallback to default.
+                hr = enumerator_->GetDefaultAudioEndpoint(eCapture, eConsole, &device_);
+            }
+        }
+        else
+        {
+            hr = enumerator_->GetDefaultAudioEndpoint(eCapture, eConsole, &device_);
+        }
+
+        if (FAILED(hr))
+        {
+            notifyInit(false);
+            CoUninitialize();
+            return;
+        }
+
+        hr = device_->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void **)&audioClient_);
+        if (FAILED(hr))
+        {
+            notifyInit(false);
+            CoUninitialize();
+            return;
+        }
+
+        // Request format (preferred), but fallback to mix format if unsupported.
+        WAVEFORMATEX req{};
+        req.wFormatTag = WAVE_FORMAT_PCM;
+        req.nChannels = (WORD)channels_;
+        req.nSamplesPerSec = sampleRate_;
+        req.wBitsPerSample = (WORD)bits_;
+        req.nBlockAlign = (req.nChannels * req.wBitsPerSample) / 8;
+        req.nAvgBytesPerSec = req.nSamplesPerSec * req.nBlockAlign;
+
+        // event-driven; no engine conversion: a rate mismatch is resampled in-library
+        // (the engine SRC adds latency and its quality varies by driver)
+        const DWORD flags = AUDCLNT_STREAMFLAGS_EVENTCALLBACK;
+
+        const REFERENCE_TIME bufferDur = 1'000'000; // 100ms (stable recording priority)
+
+        // try requested
+        hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_SHARED, flags, bufferDur, 0, &req, nullptr);
+        if (FAILED(hr))
+        {
+            // fallback: mix format
+            WAVEFORMATEX *mix = nullptr;
+            if (SUCCEEDED(audioClient_->GetMixFormat(&mix)) && mix)
+            {
+                // parse mix format (engine capture format)
+                dev_.blockAlign = mix->nBlockAlign;
+                dev_.sampleRate = mix->nSamplesPerSec;
+                dev_.channels = mix->nChannels;
+                dev_.bits = mix->wBitsPerSample;
+                dev_.isFloat = false;
+                if (mix->wFormatTag == WAVE_FORMAT_IEEE_FLOAT)
+                    dev_.isFloat = true;
+                else if (mix->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+                         mix->cbSize >= (sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX)))
+                {
+                    auto ext = reinterpret_cast<WAVEFORMATEXTENSIBLE *>(mix);
+                    if (ext->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT)
+                        dev_.isFloat = true;
+                    dev_.channelMask = ext->dwChannelMask;
+                }
+
+                hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_SHARED, flags, bufferDur, 0, mix, nullptr);
+                CoTaskMemFree(mix);
+            }
+            if (FAILED(hr))
+            {
+                notifyInit(false);
+                CoUninitialize();
+                return;
+            }
+        }
+
+        // We ALWAYS output PCM16 to upper layer (match MF input media type),
+        // but the engine capture format may be float32 if we used mix format.
+        if (dev_.sampleRate == 0)
+        {
+            // requested worked => capture format == requested
+            dev_.sampleRate = sampleRate_;
+            dev_.channels = channels_;
+            dev_.bits = bits_;
+            dev_.isFloat = false;
+            dev_.blockAlign = channels_ * (bits_ / 8);
+        }
+
+        // mixer / resampler / meter, with scratch for the largest packet
+        UINT32 bufferFrames = 0;
+        if (FAILED(audioClient_->GetBufferSize(&bufferFrames)) || !configurePipeline(bufferFrames))
+        {
+            notifyInit(false);
+            CoUninitialize();
+            return;
+        }
+
+        event_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!event_)
+        {
+            notifyInit(false);
+            CoUninitialize();
+            return;
+        }
+        hr = audioClient_->SetEventHandle(event_);
+        if (FAILED(hr))
+        {
+            notifyInit(false);
+            CoUninitialize();
+            return;
+        }
+
+        hr = audioClient_->GetService(IID_PPV_ARGS(&captureClient_));
+        if (FAILED(hr))
+        {
+            notifyInit(false);
+            CoUninitialize();
+            return;
+        }
+
+        hr = audioClient_->Start();
+        if (FAILED(hr))
+        {
+            notifyInit(false);
+            CoUninitialize();
+            return;
+        }
+
+        notifyInit(true);
+
+        // capture loop
+        while (running_.load())
+        {
+            // wait signal
+            WaitForSingleObject(event_, 20);
+            if (!running_.load())
+                break;
+
+            UINT32 packet = 0;
+            hr = captureClient_->GetNextPacketSize(&packet);
+            if (FAILED(hr) || packet == 0)
+                continue;
+
+            GCAP_TRACE_SCOPE("wasapi.read");
+            while (packet > 0)
+            {
+                BYTE *data = nullptr;
+                UINT32 frames = 0;
+                DWORD flags2 = 0;
+                UINT64 devPos = 0; // in frames
+                UINT64 qpcPos = 0; // QPC ticks
+                hr = captureClient_->GetBuffer(&data, &frames, &flags2, &devPos, &qpcPos);
+                if (FAILED(hr))
+                    break;
+                const bool silent = (flags2 & AUDCLNT_BUFFERFLAGS_SILENT) || !data;
+
+                // OBS-style: the timeline is built from the frames delivered; devPos is
+                // not trusted (Bluetooth devices may jump).
+                deliver(data, frames, silent, (flags2 & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) != 0);
+                captureClient_->ReleaseBuffer(frames);
+
+                hr = captureClient_->GetNextPacketSize(&packet);
+                if (FAILED(hr))
+                    break;
+            }
+        }
+
+        audioClient_->Stop();
+        CoUninitialize();
+    }
+}
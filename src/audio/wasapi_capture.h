@@ -0,0 +1,67 @@
+// wasapi_capture.h
+#pragma once
+#include "audio_source.h"
+
+#include <windows.h>
+
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <wrl/client.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace gcap::audio
+{
+    // ------------------------------------------------------------
+    // WASAPI capture (old stable behavior)
+    //  - Shared mode
+    //  - Event-driven capture
+    //  - Prefer requested PCM format; fallback to mix format
+    //  - No engine conversion: rate mismatches go through gcap::audio::Resampler
+    //  - Output is ALWAYS PCM16 to the upper layer (OBS-style stability)
+    // Ring, conversion and timeline live in AudioSourceBase.
+    // ------------------------------------------------------------
+    class WasapiCapture : public AudioSourceBase
+    {
+    public:
+        using Chunk = AudioChunk;
+        using ActualFormat = AudioFormat;
+        using CaptureFormat = DeviceFormat; // actual capture format from audio engine (may be float32)
+
+        WasapiCapture() = default;
+        ~WasapiCapture() override;
+
+        WasapiCapture(const WasapiCapture &) = delete;
+        WasapiCapture &operator=(const WasapiCapture &) = delete;
+        WasapiCapture(WasapiCapture &&) = delete;
+        WasapiCapture &operator=(WasapiCapture &&) = delete;
+
+        bool start(uint32_t sampleRate, uint32_t channels, uint32_t bits,
+                   const std::wstring &endpointId, AudioFormat *outFmt = nullptr) override;
+        void stop() override;
+
+    private:
+        void run();
+
+        std::thread thread_;
+        HANDLE event_ = nullptr;
+
+        Microsoft::WRL::ComPtr<IMMDeviceEnumerator> enumerator_;
+        Microsoft::WRL::ComPtr<IMMDevice> device_;
+        Microsoft::WRL::ComPtr<IAudioClient> audioClient_;
+        Microsoft::WRL::ComPtr<IAudioCaptureClient> captureClient_;
+
+        UINT32 bits_ = 16;
+        std::wstring endpointId_;
+
+        std::mutex initMutex_;
+        std::condition_variable initCv_;
+        bool initDone_ = false;
+        bool initOk_ = false;
+        AudioFormat actual_{};
+    };
+}
@@ -0,0 +1,96 @@
+// band_pool.cpp
+#include "band_pool.h"
+#include <algorithm>
+
+namespace gcap
+{
+    BandPool::BandPool(int threads)
+    {
+        if (threads <= 0)
+            threads = (int)std::thread::hardware_concurrency();
+        threads = std::clamp(threads, 1, kMaxThreads);
+
+        for (int i = 1; i < threads; ++i)
+            workers_.emplace_back(&BandPool::worker, this, i);
+    }
+
+    BandPool::~BandPool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            quit_ = true;
+        }
+        cv_.notify_all();
+        for (auto &t : workers_)
+            if (t.joinable())
+                t.join();
+    }
+
+    void BandPool::drain(int worker)
+    {
+        for (;;)
+        {
+            const int t = next_.fetch_add(1, std::memory_order_relaxed);
+            if (t >= tasks_)
+                break;
+            (*fn_)(t, worker);
+            done_.fetch_add(1, std::memory_order_acq_rel);
+        }
+    }
+
+    void BandPool::worker(int index)
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lk(mtx_);
+                cv_.wait(lk, [&]
+                         { return quit_ || generation_ != seen; });
+                if (quit_)
+                    return;
+                seen = generation_;
+                ++active_;
+            }
+            drain(index);
+            {
+                // run() must not return while a worker can still touch next_ / tasks_
+                std::lock_guard<std::mutex> lk(mtx_);
+                --active_;
+            }
+            doneCv_.notify_one();
+        }
+    }
+
+    void BandPool::run(int tasks, const std::function<void(int, int)> &fn)
+    {
+        if (tasks <= 0)
+            return;
+        if (workers_.empty() || tasks == 1)
+        {
+            for (int t = 0; t < tasks; ++t)
+                fn(t, 0);
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            // a late waker from the previous run may still be leaving drain()
+            doneCv_.wait(lk, [&]
+                         { return active_ == 0; });
+            fn_ = &fn;
+            tasks_ = tasks;
+            next_.store(0, std::memory_order_relaxed);
+            done_.store(0, std::memory_order_relaxed);
+            ++generation_;
+        }
+        cv_.notify_all();
+
+        drain(0);
+
+        std::unique_lock<std::mutex> lk(mtx_);
+        doneCv_.wait(lk, [&]
+                     { return active_ == 0 && done_.load(std::memory_order_acquire) == tasks_; });
+        fn_ = nullptr;
+    }
+}
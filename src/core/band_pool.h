@@ -0,0 +1,54 @@
+// band_pool.h
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gcap
+{
+    /**
+     * @brief Small persistent worker pool for row-band parallel kernels.
+     *
+     * run() hands out task indices [0, tasks) to the workers and the calling
+     * thread (worker 0), and returns once every task has finished. Workers are
+     * created once; nothing is allocated per run.
+     */
+    class BandPool
+    {
+    public:
+        // threads <= 0 => hardware_concurrency (capped at kMaxThreads)
+        explicit BandPool(int threads = 0);
+        ~BandPool();
+
+        BandPool(const BandPool &) = delete;
+        BandPool &operator=(const BandPool &) = delete;
+
+        static constexpr int kMaxThreads = 8;
+
+        // total workers including the caller
+        int size() const { return (int)workers_.size() + 1; }
+
+        // fn(task, worker) with worker in [0, size())
+        void run(int tasks, const std::function<void(int, int)> &fn);
+
+    private:
+        void worker(int index);
+        void drain(int worker);
+
+        std::vector<std::thread> workers_;
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        std::condition_variable doneCv_;
+        bool quit_ = false;
+        uint64_t generation_ = 0;
+        int active_ = 0; // workers currently inside drain()
+
+        const std::function<void(int, int)> *fn_ = nullptr;
+        int tasks_ = 0;
+        std::atomic<int> next_{0};
+        std::atomic<int> done_{0};
+    };
+}
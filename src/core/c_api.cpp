@@ -4,31 +4,80 @@
 #error not exporting
 #endif
 #include "gcapture.h"
+#include <chrono>
+#include <cstring>
 #include <memory>
 #include <vector>
+#include "device_cache.h"
+#include "frame_pool.h"
+#include "thread_tuning.h"
+#include "trace.h"
+#include "../audio/audio_capture.h"
 #include "../audio/audio_manager.h"
 #include "gcap_audio.h"
 
 #ifdef _WIN32
-#include <windows.h>
-#include <wrl/client.h>
-#include <mmdeviceapi.h>
-#include <functiondiscoverykeys_devpkey.h>
-#pragma comment(lib, "ole32.lib")
-using Microsoft::WRL::ComPtr;
-
-static std::string w2utf8(const wchar_t *ws)
+#include "../providers/device_watch.h"
+#endif
+
+// Backs gcap_start_audio_capture / gcap_audio_read (one session per process).
+// Never destroyed: joining its threads during DLL unload could deadlock.
+static gcap::audio::AudioCaptureSession &audio_session()
 {
-    if (!ws)
-        return {};
-    int len = WideCharToMultiByte(CP_UTF8, 0, ws, -1, nullptr, 0, nullptr, nullptr);
-    if (len <= 0)
-        return {};
-    std::string out((size_t)len - 1, '\0');
-    WideCharToMultiByte(CP_UTF8, 0, ws, -1, out.data(), len, nullptr, nullptr);
-    return out;
+    static auto *session = new gcap::audio::AudioCaptureSession();
+    return *session;
 }
+
+// Device lists behind gcap_enumerate and the audio enumeration calls. The
+// backends invalidate them on hotplug; without notifications they are
+// re-enumerated once they are older than kUnwatchedMaxAge. Never destroyed,
+// like audio_session(): the notification threads may still call into them.
+static constexpr std::chrono::milliseconds kUnwatchedMaxAge{2000};
+
+static gcap::DeviceListCache<gcap_device_info_t> &video_device_cache()
+{
+    static auto *cache = []()
+    {
+        auto *c = new gcap::DeviceListCache<gcap_device_info_t>(
+            [](std::vector<gcap_device_info_t> &list)
+            {
+                CaptureManager tmp; // provider of the current backend
+                return tmp.enumerate(list);
+            });
+#ifdef _WIN32
+        if (!gcap::watch_video_devices([c]() { c->invalidate(); }))
 #endif
+            c->setMaxAge(kUnwatchedMaxAge);
+        return c;
+    }();
+    return *cache;
+}
+
+static gcap::DeviceListCache<gcap::audio::device> &audio_device_cache()
+{
+    static auto *cache = []()
+    {
+        auto *c = new gcap::DeviceListCache<gcap::audio::device>(
+            [](std::vector<gcap::audio::device> &list)
+            { return gcap::audio::enumerate_devices(list) ? GCAP_OK : GCAP_EIO; });
+        if (!gcap::audio::watch_devices([c]() { c->invalidate(); }))
+            c->setMaxAge(kUnwatchedMaxAge);
+        return c;
+    }();
+    return *cache;
+}
+
+static void copy_audio_device(const gcap::audio::device &d, gcap_audio_device_t &out)
+{
+    memset(&out, 0, sizeof(out));
+    strncpy(out.id, d.id.c_str(), sizeof(out.id) - 1);
+    strncpy(out.name, d.name.c_str(), sizeof(out.name) - 1);
+    out.channels = d.channels;
+    out.sample_rate = d.sample_rate;
+    out.bits_per_sample = d.bits_per_sample;
+    out.is_float = d.is_float ? 1 : 0;
+    out.is_default = d.is_default ? 1 : 0;
+}
 
 extern "C"
 {
@@ -55,6 +104,8 @@ extern "C"
             return "I/O error";
         case GCAP_ENOTSUP:
             return "Not supported";
+        case GCAP_ETIMEOUT:
+            return "Timed out";
         default:
             return "Unknown";
         }
@@ -65,8 +116,16 @@ extern "C"
     {
         if (!out || max <= 0)
             return GCAP_EINVAL;
-        CaptureManager tmp;
-        return tmp.enumerate(out, max, count);
+        std::shared_ptr<const std::vector<gcap_device_info_t>> list;
+        const gcap_status_t st = video_device_cache().get(list);
+        if (st != GCAP_OK)
+            return st;
+        const int n = (int)list->size();
+        if (count)
+            *count = n;
+        for (int i = 0; i < n && i < max; ++i)
+            out[i] = (*list)[i];
+        return GCAP_OK;
     }
 
     gcap_status_t gcap_open(int device_index, gcap_handle *out)
@@ -136,92 +195,19 @@ extern "C"
             *count = 0;
         return GCAP_ENOTSUP;
 #else
-        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
-
-        ComPtr<IMMDeviceEnumerator> enumerator;
-        hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, IID_PPV_ARGS(&enumerator));
-        if (FAILED(hr))
-        {
-            if (count)
-                *count = 0;
-            CoUninitialize();
-            return GCAP_EIO;
-        }
-
-        // Default endpoint id
-        std::wstring defaultId;
-        {
-            ComPtr<IMMDevice> def;
-            if (SUCCEEDED(enumerator->GetDefaultAudioEndpoint(eCapture, eConsole, &def)))
-            {
-                wchar_t *wid = nullptr;
-                if (SUCCEEDED(def->GetId(&wid)) && wid)
-                {
-                    defaultId = wid;
-                    CoTaskMemFree(wid);
-                }
-            }
-        }
-
-        ComPtr<IMMDeviceCollection> coll;
-        hr = enumerator->EnumAudioEndpoints(eCapture, DEVICE_STATE_ACTIVE, &coll);
-        if (FAILED(hr))
+        std::shared_ptr<const std::vector<gcap::audio::device>> list;
+        const gcap_status_t st = audio_device_cache().get(list);
+        if (st != GCAP_OK)
         {
             if (count)
                 *count = 0;
-            CoUninitialize();
-            return GCAP_EIO;
+            return st;
         }
-
-        UINT n = 0;
-        coll->GetCount(&n);
+        const int n = (int)list->size();
         if (count)
-            *count = (int)n;
-
-        UINT toCopy = (UINT)max;
-        if (toCopy > n)
-            toCopy = n;
-
-        for (UINT i = 0; i < toCopy; ++i)
-        {
-            ComPtr<IMMDevice> dev;
-            if (FAILED(coll->Item(i, &dev)))
-                continue;
-
-            // id
-            wchar_t *wid = nullptr;
-            std::wstring idW;
-            if (SUCCEEDED(dev->GetId(&wid)) && wid)
-            {
-                idW = wid;
-                CoTaskMemFree(wid);
-            }
-
-            // name
-            std::wstring nameW;
-            ComPtr<IPropertyStore> store;
-            if (SUCCEEDED(dev->OpenPropertyStore(STGM_READ, &store)))
-            {
-                PROPVARIANT pv;
-                PropVariantInit(&pv);
-                if (SUCCEEDED(store->GetValue(PKEY_Device_FriendlyName, &pv)))
-                {
-                    if (pv.vt == VT_LPWSTR && pv.pwszVal)
-                        nameW = pv.pwszVal;
-                }
-                PropVariantClear(&pv);
-            }
-
-            std::string idU8 = w2utf8(idW.c_str());
-            std::string nameU8 = w2utf8(nameW.c_str());
-
-            memset(&out[i], 0, sizeof(out[i]));
-            strncpy(out[i].id, idU8.c_str(), sizeof(out[i].id) - 1);
-            strncpy(out[i].name, nameU8.c_str(), sizeof(out[i].name) - 1);
-            out[i].is_default = (!defaultId.empty() && idW == defaultId) ? 1 : 0;
-        }
-
-        CoUninitialize();
+            *count = n;
+        for (int i = 0; i < n && i < max; ++i)
+            copy_audio_device((*list)[i], out[i]);
         return GCAP_OK;
 #endif
     }
@@ -233,6 +219,15 @@ extern "C"
         return h->mgr.setRecordingAudioDevice(device_id_utf8);
     }
 
+    GCAP_API gcap_status_t gcap_set_recording_size(gcap_handle h, int width, int height, gcap_scale_filter_t filter)
+    {
+        if (!h || width < 0 || height < 0 || (width == 0) != (height == 0) || ((width | height) & 1))
+            return GCAP_EINVAL;
+        if (filter < GCAP_SCALE_BILINEAR || filter > GCAP_SCALE_LANCZOS3)
+            return GCAP_EINVAL;
+        return h->mgr.setRecordingSize(width, height, filter);
+    }
+
     gcap_status_t gcap_stop(gcap_handle h)
     {
         if (!h)
@@ -272,9 +267,164 @@ extern "C"
         return h->mgr.setProcessing(*opts);
     }
 
+    GCAP_API gcap_status_t gcap_set_privacy_masks(gcap_handle h, const gcap_mask_region_t *regions, int count)
+    {
+        if (!h || count < 0 || (count > 0 && !regions))
+            return GCAP_EINVAL;
+        return h->mgr.setPrivacyMasks(regions, count);
+    }
+
+    GCAP_API gcap_status_t gcap_set_health_interval(gcap_handle h, int every_n_frames)
+    {
+        if (!h || every_n_frames < 0)
+            return GCAP_EINVAL;
+        return h->mgr.setHealthInterval(every_n_frames);
+    }
+
+    GCAP_API gcap_status_t gcap_get_health_stats(gcap_handle h, gcap_health_stats_t *out)
+    {
+        if (!h || !out)
+            return GCAP_EINVAL;
+        return h->mgr.getHealthStats(*out);
+    }
+
+    GCAP_API gcap_status_t gcap_get_audio_levels(gcap_handle h, gcap_audio_levels_t *out)
+    {
+        if (!h || !out)
+            return GCAP_EINVAL;
+        return h->mgr.getAudioLevels(*out);
+    }
+
+    GCAP_API gcap_status_t gcap_get_av_sync_stats(gcap_handle h, gcap_av_sync_stats_t *out)
+    {
+        if (!h || !out)
+            return GCAP_EINVAL;
+        return h->mgr.getAvSyncStats(*out);
+    }
+
+    GCAP_API gcap_status_t gcap_add_consumer(gcap_handle h, const gcap_consumer_desc_t *desc, int *out_id)
+    {
+        if (!h || !desc || !out_id)
+            return GCAP_EINVAL;
+        return h->mgr.addConsumer(*desc, *out_id);
+    }
+
+    GCAP_API gcap_status_t gcap_remove_consumer(gcap_handle h, int consumer_id)
+    {
+        if (!h)
+            return GCAP_EINVAL;
+        return h->mgr.removeConsumer(consumer_id);
+    }
+
+    GCAP_API gcap_status_t gcap_set_delivery(gcap_handle h, gcap_delivery_policy_t policy, int queue_depth)
+    {
+        if (!h)
+            return GCAP_EINVAL;
+        return h->mgr.setDelivery(policy, queue_depth);
+    }
+
+    GCAP_API gcap_status_t gcap_get_delivery_stats(gcap_handle h, gcap_delivery_stats_t *out)
+    {
+        if (!h || !out)
+            return GCAP_EINVAL;
+        return h->mgr.getDeliveryStats(*out);
+    }
+
+    GCAP_API gcap_status_t gcap_set_frame_rate(gcap_handle h, int fps_num, int fps_den, int blend)
+    {
+        if (!h)
+            return GCAP_EINVAL;
+        return h->mgr.setFrameRate(fps_num, fps_den, blend != 0);
+    }
+
+    GCAP_API gcap_status_t gcap_get_pacing_stats(gcap_handle h, gcap_pacing_stats_t *out)
+    {
+        if (!h || !out)
+            return GCAP_EINVAL;
+        return h->mgr.getPacingStats(*out);
+    }
+
+    GCAP_API gcap_status_t gcap_get_clock_stats(gcap_handle h, gcap_clock_stats_t *out)
+    {
+        if (!h || !out)
+            return GCAP_EINVAL;
+        return h->mgr.getClockStats(*out);
+    }
+
+    GCAP_API gcap_status_t gcap_get_stats(gcap_handle h, gcap_stats_t *out)
+    {
+        if (!h || !out)
+            return GCAP_EINVAL;
+        return h->mgr.getStats(*out);
+    }
+
+    GCAP_API gcap_status_t gcap_set_log_callback(gcap_handle h, gcap_on_log_cb cb, gcap_log_level_t min_level, void *user)
+    {
+        if (!h || min_level < GCAP_LOG_DEBUG || min_level > GCAP_LOG_ERROR)
+            return GCAP_EINVAL;
+        return h->mgr.setLogCallback(cb, min_level, user);
+    }
+
+    GCAP_API gcap_status_t gcap_set_thread_config(gcap_handle h, const gcap_thread_config_t *cfg)
+    {
+        if (!h || !cfg || !gcap::thread_config_valid(*cfg))
+            return GCAP_EINVAL;
+        return h->mgr.setThreadConfig(*cfg);
+    }
+
+    GCAP_API gcap_status_t gcap_set_tracing(int enable, int events_per_thread)
+    {
+        return gcap::trace::enable(enable != 0, events_per_thread) ? GCAP_OK : GCAP_EINVAL;
+    }
+
+    GCAP_API gcap_status_t gcap_write_trace(const char *path_utf8)
+    {
+        if (!path_utf8 || !*path_utf8)
+            return GCAP_EINVAL;
+        return gcap::trace::write(path_utf8) ? GCAP_OK : GCAP_EIO;
+    }
+
+    GCAP_API const gcap_frame_t *gcap_frame_ref(const gcap_frame_t *frame)
+    {
+        if (!frame)
+            return nullptr;
+        if (frame->pool_ref)
+        {
+            auto *b = static_cast<gcap::FramePool::Buffer *>(frame->pool_ref);
+            gcap::FramePool::ref(b);
+            return &b->frame;
+        }
+        gcap::FramePool::Buffer *b = gcap::FramePool::copy(*frame);
+        return b ? &b->frame : nullptr;
+    }
+
+    GCAP_API void gcap_frame_unref(const gcap_frame_t *frame)
+    {
+        if (frame && frame->pool_ref)
+            gcap::FramePool::unref(static_cast<gcap::FramePool::Buffer *>(frame->pool_ref));
+    }
+
+    GCAP_API gcap_status_t gcap_acquire_frame(gcap_handle h, int timeout_ms, const gcap_frame_t **out)
+    {
+        if (!h || !out)
+            return GCAP_EINVAL;
+        *out = nullptr;
+        return h->mgr.acquireFrame(timeout_ms, *out);
+    }
+
+    GCAP_API gcap_status_t gcap_release_frame(gcap_handle h, const gcap_frame_t *frame)
+    {
+        if (!h || !frame || !frame->pool_ref)
+            return GCAP_EINVAL;
+        gcap_frame_unref(frame);
+        return GCAP_OK;
+    }
+
     GCAP_API void gcap_set_backend(int backend)
     {
         CaptureManager::setBackendInt(backend);
+        // the list (and its indices) belongs to the backend's provider
+        video_device_cache().invalidate();
     }
 
     GCAP_API void gcap_set_d3d_adapter(int adapter_index)
@@ -284,16 +434,20 @@ extern "C"
 
     extern "C" GCAP_API int gcap_get_audio_device_count(void)
     {
-        auto list = gcap::audio::enumerate_devices();
-        return static_cast<int>(list.size());
+        std::shared_ptr<const std::vector<gcap::audio::device>> list;
+        if (audio_device_cache().get(list) != GCAP_OK)
+            return 0;
+        return static_cast<int>(list->size());
     }
 
     extern "C" GCAP_API int gcap_enum_audio_devices(
         gcap_audio_device_t *out,
         int max_count)
     {
-        auto list = gcap::audio::enumerate_devices();
-        int total = static_cast<int>(list.size());
+        std::shared_ptr<const std::vector<gcap::audio::device>> list;
+        if (audio_device_cache().get(list) != GCAP_OK)
+            return 0;
+        int total = static_cast<int>(list->size());
 
         if (!out || max_count <= 0)
             return total;
@@ -301,19 +455,41 @@ extern "C"
         int n = (total < max_count) ? total : max_count;
 
         for (int i = 0; i < n; ++i)
-        {
-            const auto &d = list[i];
-
-            memset(&out[i], 0, sizeof(gcap_audio_device_t));
-            strncpy_s(out[i].id, d.id.c_str(), GCAP_AUDIO_ID_MAX - 1);
-            strncpy_s(out[i].name, d.name.c_str(), GCAP_AUDIO_NAME_MAX - 1);
-            out[i].channels = d.channels;
-            out[i].sample_rate = d.sample_rate;
-            out[i].bits_per_sample = d.bits_per_sample;
-            out[i].is_float = d.is_float ? 1 : 0;
-        }
+            copy_audio_device((*list)[i], out[i]);
 
         return n;
     }
 
+    GCAP_API int gcap_start_audio_capture(const gcap_audio_capture_config_t *cfg)
+    {
+        if (!cfg)
+            return GCAP_EINVAL;
+        const int rate = cfg->sample_rate > 0 ? cfg->sample_rate : 48000;
+        const int channels = cfg->channels > 0 ? cfg->channels : 2;
+        if (rate < 8000 || rate > 192000 || channels > 8)
+            return GCAP_EINVAL;
+        auto &s = audio_session();
+        if (s.running())
+            return GCAP_ESTATE;
+        return s.start(cfg->device_id, rate, channels) ? GCAP_OK : GCAP_EIO;
+    }
+
+    GCAP_API void gcap_stop_audio_capture(void)
+    {
+        audio_session().stop();
+    }
+
+    GCAP_API int gcap_set_audio_callback(gcap_on_audio_cb cb, void *user)
+    {
+        return audio_session().setCallback(cb, user) ? GCAP_OK : GCAP_ESTATE;
+    }
+
+    GCAP_API int gcap_audio_read(int16_t *buf, int frames, int timeout_ms)
+    {
+        if (!buf || frames < 0)
+            return -GCAP_EINVAL;
+        const int n = audio_session().read(buf, frames, timeout_ms);
+        return n < 0 ? -GCAP_ESTATE : n;
+    }
+
 } // extern "C"
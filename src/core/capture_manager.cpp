@@ -83,11 +83,10 @@ void CaptureManager::setD3dAdapterInt(int index)
  */
 gcap_status_t CaptureManager::enumerate(gcap_device_info_t *out, int max, int *count)
 {
-    if (!provider_)
-        return GCAP_ENOTSUP; // Not supported on this platform
     std::vector<gcap_device_info_t> list;
-    if (!provider_->enumerate(list))
-        return GCAP_EIO;
+    const gcap_status_t st = enumerate(list);
+    if (st != GCAP_OK)
+        return st;
     int n = (int)list.size();
     if (count)
         *count = n;
@@ -96,6 +95,17 @@ gcap_status_t CaptureManager::enumerate(gcap_device_info_t *out, int max, int *c
     return GCAP_OK;
 }
 
+/**
+ * @brief Enumerate all capture devices into a list (backs the process-wide cache).
+ */
+gcap_status_t CaptureManager::enumerate(std::vector<gcap_device_info_t> &list)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP; // Not supported on this platform
+    list.clear();
+    return provider_->enumerate(list) ? GCAP_OK : GCAP_EIO;
+}
+
 /**
  * @brief Open the selected device.
  */
@@ -198,6 +208,21 @@ gcap_status_t CaptureManager::setRecordingAudioDevice(const char *deviceIdUtf8)
     return GCAP_ENOTSUP;
 }
 
+gcap_status_t CaptureManager::setRecordingSize(int width, int height, gcap_scale_filter_t filter)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+
+#ifdef GCAP_WIN_MF
+    if (auto *p = dynamic_cast<WinMFProvider *>(provider_.get()))
+        return p->setRecordingSize(width, height, filter);
+#endif
+    (void)width;
+    (void)height;
+    (void)filter;
+    return GCAP_ENOTSUP;
+}
+
 /**
  * @brief Close the current device and release resources.
  */
@@ -229,3 +254,115 @@ gcap_status_t CaptureManager::setProcessing(const gcap_processing_opts_t &opts)
         return GCAP_ENOTSUP;
     return provider_->setProcessing(opts) ? GCAP_OK : GCAP_ENOTSUP;
 }
+
+gcap_status_t CaptureManager::setPrivacyMasks(const gcap_mask_region_t *regions, int count)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->setPrivacyMasks(regions, count);
+}
+
+gcap_status_t CaptureManager::setHealthInterval(int everyNFrames)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->setHealthInterval(everyNFrames);
+}
+
+gcap_status_t CaptureManager::getHealthStats(gcap_health_stats_t &out)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->getHealthStats(out);
+}
+
+gcap_status_t CaptureManager::getAudioLevels(gcap_audio_levels_t &out)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->getAudioLevels(out);
+}
+
+gcap_status_t CaptureManager::getAvSyncStats(gcap_av_sync_stats_t &out)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->getAvSyncStats(out);
+}
+
+gcap_status_t CaptureManager::acquireFrame(int timeoutMs, const gcap_frame_t *&out)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->acquireFrame(timeoutMs, out);
+}
+
+gcap_status_t CaptureManager::addConsumer(const gcap_consumer_desc_t &desc, int &id)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->addConsumer(desc, id);
+}
+
+gcap_status_t CaptureManager::removeConsumer(int id)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->removeConsumer(id);
+}
+
+gcap_status_t CaptureManager::setDelivery(gcap_delivery_policy_t policy, int queueDepth)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->setDelivery(policy, queueDepth);
+}
+
+gcap_status_t CaptureManager::getDeliveryStats(gcap_delivery_stats_t &out)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->getDeliveryStats(out);
+}
+
+gcap_status_t CaptureManager::setFrameRate(int fpsNum, int fpsDen, bool blend)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->setFrameRate(fpsNum, fpsDen, blend);
+}
+
+gcap_status_t CaptureManager::getPacingStats(gcap_pacing_stats_t &out)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->getPacingStats(out);
+}
+
+gcap_status_t CaptureManager::getClockStats(gcap_clock_stats_t &out)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->getClockStats(out);
+}
+
+gcap_status_t CaptureManager::getStats(gcap_stats_t &out)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->getStats(out);
+}
+
+gcap_status_t CaptureManager::setLogCallback(gcap_on_log_cb cb, gcap_log_level_t minLevel, void *user)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->setLogCallback(cb, minLevel, user);
+}
+
+gcap_status_t CaptureManager::setThreadConfig(const gcap_thread_config_t &cfg)
+{
+    if (!provider_)
+        return GCAP_ENOTSUP;
+    return provider_->setThreadConfig(cfg);
+}
@@ -84,6 +84,94 @@ struct ICaptureProvider
         (void)opts;
         return false;
     }
+    virtual gcap_status_t setPrivacyMasks(const gcap_mask_region_t *regions, int count)
+    {
+        (void)regions;
+        (void)count;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t setHealthInterval(int everyNFrames)
+    {
+        (void)everyNFrames;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t getHealthStats(gcap_health_stats_t &out)
+    {
+        (void)out;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t getAudioLevels(gcap_audio_levels_t &out)
+    {
+        (void)out;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t getAvSyncStats(gcap_av_sync_stats_t &out)
+    {
+        (void)out;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t acquireFrame(int timeoutMs, const gcap_frame_t *&out)
+    {
+        (void)timeoutMs;
+        (void)out;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t addConsumer(const gcap_consumer_desc_t &desc, int &id)
+    {
+        (void)desc;
+        (void)id;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t removeConsumer(int id)
+    {
+        (void)id;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t setDelivery(gcap_delivery_policy_t policy, int queueDepth)
+    {
+        (void)policy;
+        (void)queueDepth;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t getDeliveryStats(gcap_delivery_stats_t &out)
+    {
+        (void)out;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t setFrameRate(int fpsNum, int fpsDen, bool blend)
+    {
+        (void)fpsNum;
+        (void)fpsDen;
+        (void)blend;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t getPacingStats(gcap_pacing_stats_t &out)
+    {
+        (void)out;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t getClockStats(gcap_clock_stats_t &out)
+    {
+        (void)out;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t getStats(gcap_stats_t &out)
+    {
+        (void)out;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t setLogCallback(gcap_on_log_cb cb, gcap_log_level_t minLevel, void *user)
+    {
+        (void)cb;
+        (void)minLevel;
+        (void)user;
+        return GCAP_ENOTSUP;
+    }
+    virtual gcap_status_t setThreadConfig(const gcap_thread_config_t &cfg)
+    {
+        (void)cfg;
+        return GCAP_ENOTSUP;
+    }
 };
 
 /**
@@ -100,6 +188,7 @@ public:
     ~CaptureManager();
 
     gcap_status_t enumerate(gcap_device_info_t *out, int max, int *count);
+    gcap_status_t enumerate(std::vector<gcap_device_info_t> &list);
     gcap_status_t open(int deviceIndex);
     gcap_status_t setProfile(const gcap_profile_t &p);
     gcap_status_t setBuffers(int count, size_t bytes_hint);
@@ -108,11 +197,28 @@ public:
     gcap_status_t startRecording(const char *pathUtf8);
     gcap_status_t stopRecording();
     gcap_status_t setRecordingAudioDevice(const char *deviceIdUtf8);
+    gcap_status_t setRecordingSize(int width, int height, gcap_scale_filter_t filter);
     gcap_status_t stop();
     gcap_status_t close();
     gcap_status_t getDeviceProps(gcap_device_props_t &out);
     gcap_status_t getSignalStatus(gcap_signal_status_t &out);
     gcap_status_t setProcessing(const gcap_processing_opts_t &opts);
+    gcap_status_t setPrivacyMasks(const gcap_mask_region_t *regions, int count);
+    gcap_status_t setHealthInterval(int everyNFrames);
+    gcap_status_t getHealthStats(gcap_health_stats_t &out);
+    gcap_status_t getAudioLevels(gcap_audio_levels_t &out);
+    gcap_status_t getAvSyncStats(gcap_av_sync_stats_t &out);
+    gcap_status_t acquireFrame(int timeoutMs, const gcap_frame_t *&out);
+    gcap_status_t addConsumer(const gcap_consumer_desc_t &desc, int &id);
+    gcap_status_t removeConsumer(int id);
+    gcap_status_t setDelivery(gcap_delivery_policy_t policy, int queueDepth);
+    gcap_status_t getDeliveryStats(gcap_delivery_stats_t &out);
+    gcap_status_t setFrameRate(int fpsNum, int fpsDen, bool blend);
+    gcap_status_t getPacingStats(gcap_pacing_stats_t &out);
+    gcap_status_t getClockStats(gcap_clock_stats_t &out);
+    gcap_status_t getStats(gcap_stats_t &out);
+    gcap_status_t setLogCallback(gcap_on_log_cb cb, gcap_log_level_t minLevel, void *user);
+    gcap_status_t setThreadConfig(const gcap_thread_config_t &cfg);
 
     static void setBackendInt(int v);
     static void setD3dAdapterInt(int index);
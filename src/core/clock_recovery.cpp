@@ -0,0 +1,189 @@
+// clock_recovery.cpp
+#include "clock_recovery.h"
+#include <algorithm>
+#include <cmath>
+
+namespace gcap
+{
+    ClockRecovery::ClockRecovery()
+    {
+        reset();
+    }
+
+    void ClockRecovery::reset(int nominalNum, int nominalDen)
+    {
+        nominalNs_ = nominalNum > 0 && nominalDen > 0 ? 1e9 * nominalDen / nominalNum : 0.0;
+        based_ = false;
+        head_ = count_ = 0;
+        periodNs_ = nominalNs_;
+        interceptNs_ = 0.0;
+        jitterNs_ = 0.0;
+        measuredFps_ = 0.0;
+        frames_ = dropped_ = 0;
+        resyncs_ = 0;
+        lastOut_ = 0;
+        publish();
+    }
+
+    void ClockRecovery::rebase(int64_t rawNs, int64_t outNs)
+    {
+        based_ = true;
+        baseRaw_ = rawNs;
+        baseOut_ = outNs;
+        index_ = 0;
+        lastRaw_ = rawNs;
+        lastOut_ = outNs;
+        head_ = 0;
+        count_ = 1;
+        pts_[0] = {0.0, 0.0};
+        interceptNs_ = 0.0;
+        jitterNs_ = 0.0;
+        // keep the period: it still describes the device after a glitch
+        if (periodNs_ <= 0.0)
+            periodNs_ = nominalNs_;
+    }
+
+    int64_t ClockRecovery::update(int64_t rawNs, bool discontinuity)
+    {
+        ++frames_;
+        if (!based_)
+        {
+            rebase(rawNs, rawNs);
+            publish();
+            return rawNs;
+        }
+
+        const int64_t elapsed = rawNs - lastRaw_;
+        const double period = periodNs_;
+        const double rel = (double)(rawNs - baseRaw_);
+        bool restart = discontinuity || elapsed <= 0 || elapsed > kMaxGapNs;
+        int64_t advance = 1;
+        // without a nominal rate, the first few deltas are too noisy to call drops on
+        if (!restart && period > 0.0 && (nominalNs_ > 0.0 || count_ >= kMinPoints))
+        {
+            // periods since the last frame: measured from its place on the line
+            // once locked, from its own timestamp while the period may still
+            // be the (possibly wrong) nominal one
+            const double since = count_ >= kMinPoints ? (rel - (interceptNs_ + period * (double)index_)) / period
+                                                      : (double)elapsed / period;
+            if ((1.0 - since) * period > (double)kJumpNs)
+                restart = true;
+            else if (since >= kDropFrames)
+                advance = (int64_t)std::llround(since);
+        }
+
+        if (restart)
+        {
+            // carry on from the last output: real elapsed time when there is
+            // some, else one period
+            const int64_t step = elapsed > 0 ? elapsed : (period > 0.0 ? (int64_t)period : 1);
+            const int64_t out = lastOut_ + std::max<int64_t>(step, 1);
+            ++resyncs_;
+            rebase(rawNs, out);
+            publish();
+            return out;
+        }
+
+        dropped_ += (uint64_t)(advance - 1);
+        index_ += advance;
+        lastRaw_ = rawNs;
+        if (count_ < kMaxPoints)
+            ++count_;
+        else
+            head_ = (head_ + 1) % kMaxPoints;
+        pts_[(head_ + count_ - 1) % kMaxPoints] = {(double)index_, rel};
+        fit();
+
+        int64_t out = baseOut_ + (int64_t)std::llround(interceptNs_ + periodNs_ * (double)index_);
+        // a refit may pull the line back a little; never let PTS bunch up or reverse
+        const int64_t minStep = std::max<int64_t>((int64_t)(periodNs_ * 0.5), 1);
+        if (out < lastOut_ + minStep)
+            out = lastOut_ + minStep;
+        lastOut_ = out;
+        publish();
+        return out;
+    }
+
+    void ClockRecovery::fit()
+    {
+        // two-pass least squares over the window (centred sums keep precision)
+        double mi = 0.0, mt = 0.0;
+        for (int i = 0; i < count_; ++i)
+        {
+            const Point &q = pts_[(head_ + i) % kMaxPoints];
+            mi += q.index;
+            mt += q.time;
+        }
+        mi /= count_;
+        mt /= count_;
+        double sii = 0.0, sit = 0.0;
+        for (int i = 0; i < count_; ++i)
+        {
+            const Point &q = pts_[(head_ + i) % kMaxPoints];
+            sii += (q.index - mi) * (q.index - mi);
+            sit += (q.index - mi) * (q.time - mt);
+        }
+        if (count_ < kMinPoints && nominalNs_ > 0.0)
+        {
+            // the nominal period counts as a kMinPoints-frame window of its own
+            const double prior = (double)kMinPoints * ((double)kMinPoints * kMinPoints - 1.0) / 12.0;
+            sit += prior * nominalNs_;
+            sii += prior;
+        }
+        if (sii > 0.0)
+            periodNs_ = sit / sii;
+        interceptNs_ = mt - periodNs_ * mi;
+
+        double sr = 0.0;
+        for (int i = 0; i < count_; ++i)
+        {
+            const Point &q = pts_[(head_ + i) % kMaxPoints];
+            const double r = q.time - (interceptNs_ + periodNs_ * q.index);
+            sr += r * r;
+        }
+        jitterNs_ = std::sqrt(sr / count_);
+
+        const Point &first = pts_[head_];
+        const Point &last = pts_[(head_ + count_ - 1) % kMaxPoints];
+        measuredFps_ = last.time > first.time ? (count_ - 1) * 1e9 / (last.time - first.time) : 0.0;
+    }
+
+    void ClockRecovery::publish()
+    {
+        const uint32_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        pubLocked_.store(count_ >= kMinPoints ? 1 : 0, std::memory_order_relaxed);
+        pubNominal_.store(nominalNs_ > 0.0 ? 1e9 / nominalNs_ : 0.0, std::memory_order_relaxed);
+        pubMeasured_.store(measuredFps_, std::memory_order_relaxed);
+        pubClock_.store(clockFps(), std::memory_order_relaxed);
+        pubJitter_.store(jitterNs_ * 1e-6, std::memory_order_relaxed);
+        pubOffset_.store(based_ ? (double)(lastOut_ - lastRaw_) * 1e-6 : 0.0, std::memory_order_relaxed);
+        pubFrames_.store(frames_, std::memory_order_relaxed);
+        pubDropped_.store(dropped_, std::memory_order_relaxed);
+        pubResyncs_.store(resyncs_, std::memory_order_relaxed);
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    void ClockRecovery::stats(gcap_clock_stats_t &out) const
+    {
+        for (;;)
+        {
+            const uint32_t s = seq_.load(std::memory_order_acquire);
+            if (s & 1u)
+                continue;
+            out.locked = pubLocked_.load(std::memory_order_relaxed);
+            out.nominal_fps = pubNominal_.load(std::memory_order_relaxed);
+            out.measured_fps = pubMeasured_.load(std::memory_order_relaxed);
+            out.clock_fps = pubClock_.load(std::memory_order_relaxed);
+            out.jitter_ms = pubJitter_.load(std::memory_order_relaxed);
+            out.offset_ms = pubOffset_.load(std::memory_order_relaxed);
+            out.frames = pubFrames_.load(std::memory_order_relaxed);
+            out.dropped = pubDropped_.load(std::memory_order_relaxed);
+            out.resyncs = pubResyncs_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == s)
+                break;
+        }
+    }
+}
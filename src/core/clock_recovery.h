@@ -0,0 +1,95 @@
+// clock_recovery.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "gcapture.h"
+
+namespace gcap
+{
+    /**
+     * @brief Recovers a steady frame clock from jittery device timestamps.
+     *
+     * Every frame is placed on a frame index: one past the previous frame,
+     * or further when its timestamp lands kDropFrames periods or more after
+     * it (the missing indices are counted as drops). A least-squares line of
+     * device time against frame index over the last kMaxPoints frames gives
+     * the frame period; until the window holds kMinPoints frames the fit is
+     * pulled toward the negotiated (nominal) period, weighted as if it were
+     * a kMinPoints-frame window of its own. Each frame's PTS is that line
+     * evaluated at its index, so arrival jitter is smoothed out while the
+     * device clock rate (and A/V drift against it) is kept.
+     *
+     * Output PTS only moves forward. A discontinuity flagged by the source, a
+     * timestamp going backwards, one arriving kJumpNs early, or a gap longer
+     * than kMaxGapNs restarts the fit, continuing from the last output PTS.
+     *
+     * Pure arithmetic on timestamps: no clock reads, so it can be driven by
+     * synthetic traces. reset() and update() belong to the capture thread;
+     * stats() may be called from any thread.
+     */
+    class ClockRecovery
+    {
+    public:
+        static constexpr int kMaxPoints = 120;           // regression window, frames
+        static constexpr int kMinPoints = 30;            // frames before the fit is trusted (locked)
+        static constexpr double kDropFrames = 1.75;      // periods after the last frame that mean drops
+        static constexpr int64_t kJumpNs = 250000000;    // this early against the line restarts
+        static constexpr int64_t kMaxGapNs = 2000000000; // longer gaps restart instead of counting drops
+
+        ClockRecovery();
+
+        // New stream; nominal rate from the media type (num = 0: unknown).
+        void reset(int nominalNum = 0, int nominalDen = 1);
+
+        // Smoothed, strictly increasing PTS for a frame stamped rawNs.
+        int64_t update(int64_t rawNs, bool discontinuity = false);
+
+        // Capture thread: recovered frame rate, 0 until two frames were seen.
+        double clockFps() const { return periodNs_ > 0.0 ? 1e9 / periodNs_ : 0.0; }
+
+        void stats(gcap_clock_stats_t &out) const;
+
+    private:
+        struct Point
+        {
+            double index; // frames since the window base
+            double time;  // device ns since the window base
+        };
+
+        void rebase(int64_t rawNs, int64_t outNs);
+        void fit();
+        void publish();
+
+        double nominalNs_ = 0.0; // 0 = unknown
+
+        bool based_ = false;
+        int64_t baseRaw_ = 0; // device time of index 0
+        int64_t baseOut_ = 0; // output time of index 0
+        int64_t index_ = 0;   // current frame's index
+        int64_t lastRaw_ = 0;
+        int64_t lastOut_ = 0;
+
+        Point pts_[kMaxPoints];
+        int head_ = 0, count_ = 0;
+        double periodNs_ = 0.0;  // fitted slope
+        double interceptNs_ = 0.0;
+        double jitterNs_ = 0.0;  // RMS residual of the window
+        double measuredFps_ = 0.0;
+
+        uint64_t frames_ = 0;
+        uint64_t dropped_ = 0;
+        uint32_t resyncs_ = 0;
+
+        // published values
+        std::atomic<uint32_t> seq_{0};
+        std::atomic<int> pubLocked_{0};
+        std::atomic<double> pubNominal_{0.0};
+        std::atomic<double> pubMeasured_{0.0};
+        std::atomic<double> pubClock_{0.0};
+        std::atomic<double> pubJitter_{0.0};
+        std::atomic<double> pubOffset_{0.0};
+        std::atomic<uint64_t> pubFrames_{0};
+        std::atomic<uint64_t> pubDropped_{0};
+        std::atomic<uint32_t> pubResyncs_{0};
+    };
+}
@@ -0,0 +1,335 @@
+// convert_plan.cpp
+#include "convert_plan.h"
+#include "frame_converter.h"
+#include "scaler.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace
+{
+    using gcap::ImageRef;
+
+    void k_nv12_to_argb(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::nv12_to_argb(s.data[0], s.data[1], s.width, s.height, s.stride[0], s.stride[1],
+                           d.data[0], d.stride[0]);
+    }
+
+    void k_yuy2_to_argb(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::yuy2_to_argb(s.data[0], s.width, s.height, s.stride[0], d.data[0], d.stride[0]);
+    }
+
+    void k_p010_to_nv12(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::p010_to_nv12(s.data[0], s.data[1], s.width, s.height, s.stride[0], s.stride[1],
+                           d.data[0], d.data[1], d.stride[0], d.stride[1]);
+    }
+
+    void k_v210_to_p010(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::v210_to_p010(s.data[0], s.width, s.height, s.stride[0],
+                           d.data[0], d.data[1], d.stride[0], d.stride[1]);
+    }
+
+    void k_nv16_to_argb(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::nv16_to_argb(s.data[0], s.data[1], s.width, s.height, s.stride[0], s.stride[1],
+                           d.data[0], d.stride[0]);
+    }
+
+    void k_nv24_to_argb(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::nv24_to_argb(s.data[0], s.data[1], s.width, s.height, s.stride[0], s.stride[1],
+                           d.data[0], d.stride[0]);
+    }
+
+    void k_v210_to_p210(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::v210_to_p210(s.data[0], s.width, s.height, s.stride[0],
+                           d.data[0], d.data[1], d.stride[0], d.stride[1]);
+    }
+
+    void k_nv16_to_nv12(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::nv16_to_nv12(s.data[0], s.data[1], s.width, s.height, s.stride[0], s.stride[1],
+                           d.data[0], d.data[1], d.stride[0], d.stride[1]);
+    }
+
+    void k_nv24_to_nv12(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::nv24_to_nv12(s.data[0], s.data[1], s.width, s.height, s.stride[0], s.stride[1],
+                           d.data[0], d.data[1], d.stride[0], d.stride[1]);
+    }
+
+    void k_p210_to_p010(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::p210_to_p010(s.data[0], s.data[1], s.width, s.height, s.stride[0], s.stride[1],
+                           d.data[0], d.data[1], d.stride[0], d.stride[1]);
+    }
+
+    void k_p210_to_nv16(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::p210_to_nv16(s.data[0], s.data[1], s.width, s.height, s.stride[0], s.stride[1],
+                           d.data[0], d.data[1], d.stride[0], d.stride[1]);
+    }
+
+    void k_y210_to_p210(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::y210_to_p210(s.data[0], s.width, s.height, s.stride[0],
+                           d.data[0], d.data[1], d.stride[0], d.stride[1]);
+    }
+
+    void k_y8_to_gray8(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::y8_to_gray8(s.data[0], s.width, s.height, s.stride[0], d.data[0], d.stride[0]);
+    }
+
+    void k_y16_to_gray8(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::y16_to_gray8(s.data[0], s.width, s.height, s.stride[0], d.data[0], d.stride[0]);
+    }
+
+    void k_yuy2_to_gray8(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::yuy2_to_gray8(s.data[0], s.width, s.height, s.stride[0], d.data[0], d.stride[0]);
+    }
+
+    void k_argb_to_gray8(const ImageRef &s, const ImageRef &d)
+    {
+        gcap::argb_to_gray8(s.data[0], s.width, s.height, s.stride[0], d.data[0], d.stride[0]);
+    }
+
+    // Costs are rough per-pixel weights; 4:2:2 → BGRA goes through NV16 so the
+    // delivered image keeps full-height chroma.
+    const gcap::ConvertKernel kKernels[] = {
+        {GCAP_FMT_NV12, GCAP_FMT_ARGB, 2, k_nv12_to_argb},
+        {GCAP_FMT_NV16, GCAP_FMT_ARGB, 2, k_nv16_to_argb},
+        {GCAP_FMT_NV24, GCAP_FMT_ARGB, 2, k_nv24_to_argb},
+        {GCAP_FMT_YUY2, GCAP_FMT_ARGB, 4, k_yuy2_to_argb},
+        {GCAP_FMT_P010, GCAP_FMT_NV12, 1, k_p010_to_nv12},
+        {GCAP_FMT_P210, GCAP_FMT_P010, 1, k_p210_to_p010},
+        {GCAP_FMT_P210, GCAP_FMT_NV16, 1, k_p210_to_nv16},
+        {GCAP_FMT_NV16, GCAP_FMT_NV12, 1, k_nv16_to_nv12},
+        {GCAP_FMT_NV24, GCAP_FMT_NV12, 1, k_nv24_to_nv12},
+        {GCAP_FMT_Y210, GCAP_FMT_P210, 1, k_y210_to_p210},
+        {GCAP_FMT_V210, GCAP_FMT_P210, 2, k_v210_to_p210},
+        {GCAP_FMT_V210, GCAP_FMT_P010, 3, k_v210_to_p010},
+        {GCAP_FMT_NV12, GCAP_FMT_GRAY8, 1, k_y8_to_gray8},
+        {GCAP_FMT_NV16, GCAP_FMT_GRAY8, 1, k_y8_to_gray8},
+        {GCAP_FMT_NV24, GCAP_FMT_GRAY8, 1, k_y8_to_gray8},
+        {GCAP_FMT_P010, GCAP_FMT_GRAY8, 1, k_y16_to_gray8},
+        {GCAP_FMT_P210, GCAP_FMT_GRAY8, 1, k_y16_to_gray8},
+        {GCAP_FMT_YUY2, GCAP_FMT_GRAY8, 1, k_yuy2_to_gray8},
+        {GCAP_FMT_ARGB, GCAP_FMT_GRAY8, 2, k_argb_to_gray8},
+    };
+    constexpr int kKernelCount = (int)(sizeof(kKernels) / sizeof(kKernels[0]));
+
+    // per-pixel cost of a resize on a native format (0 = PlaneScaler can't)
+    int scale_cost(gcap_pixfmt_t f)
+    {
+        switch (f)
+        {
+        case GCAP_FMT_NV12:
+            return 3;
+        case GCAP_FMT_YUY2:
+            return 4;
+        case GCAP_FMT_P010:
+            return 6;
+        case GCAP_FMT_GRAY8:
+            return 2;
+        case GCAP_FMT_ARGB:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+
+    constexpr int kRowAlign = 64;
+
+    int aligned_row_bytes(gcap_pixfmt_t f, int plane, int width)
+    {
+        return (gcap::pixfmt_row_bytes(f, plane, width) + kRowAlign - 1) / kRowAlign * kRowAlign;
+    }
+}
+
+namespace gcap
+{
+    const ConvertKernel *convert_kernels(int *count)
+    {
+        if (count)
+            *count = kKernelCount;
+        return kKernels;
+    }
+
+    ConvertPlan::ConvertPlan() = default;
+    ConvertPlan::~ConvertPlan() = default;
+
+    void ConvertPlan::reset()
+    {
+        valid_ = false;
+        steps_.clear();
+        inter_.clear();
+        storage_.clear();
+    }
+
+    bool ConvertPlan::build(gcap_pixfmt_t from, int srcW, int srcH,
+                            gcap_pixfmt_t to, int dstW, int dstH,
+                            gcap_scale_filter_t filter)
+    {
+        reset();
+        if (!pixfmt_valid(from) || !pixfmt_valid(to) || srcW <= 0 || srcH <= 0 || dstW <= 0 || dstH <= 0)
+            return false;
+
+        from_ = from;
+        const bool needScale = (srcW != dstW || srcH != dstH);
+        const int64_t srcArea = (int64_t)srcW * srcH;
+        const int64_t dstArea = (int64_t)dstW * dstH;
+
+        // node = format + layer (0: source size, 1: destination size)
+        constexpr int N = kPixelFormatCount * 2;
+        constexpr int64_t kInf = std::numeric_limits<int64_t>::max();
+        constexpr int kScaleEdge = -1;
+        int64_t dist[N];
+        int prev[N], via[N];
+        bool done[N] = {};
+        std::fill(dist, dist + N, kInf);
+        std::fill(prev, prev + N, -1);
+        std::fill(via, via + N, kScaleEdge);
+
+        const int start = (int)from;
+        const int goal = (int)to + (needScale ? kPixelFormatCount : 0);
+        dist[start] = 0;
+
+        for (;;)
+        {
+            int u = -1;
+            for (int i = 0; i < N; ++i)
+                if (!done[i] && dist[i] != kInf && (u < 0 || dist[i] < dist[u]))
+                    u = i;
+            if (u < 0 || u == goal)
+                break;
+            done[u] = true;
+
+            const int layer = u / kPixelFormatCount;
+            const gcap_pixfmt_t uf = (gcap_pixfmt_t)(u % kPixelFormatCount);
+            const int64_t area = layer ? dstArea : srcArea;
+
+            auto relax = [&](int v, int64_t w, int edge)
+            {
+                if (dist[u] + w < dist[v])
+                {
+                    dist[v] = dist[u] + w;
+                    prev[v] = u;
+                    via[v] = edge;
+                }
+            };
+
+            for (int k = 0; k < kKernelCount; ++k)
+                if (kKernels[k].from == uf)
+                    relax((int)kKernels[k].to + layer * kPixelFormatCount, kKernels[k].cost * area, k);
+
+            if (needScale && layer == 0 && scale_cost(uf) > 0)
+                relax(u + kPixelFormatCount, scale_cost(uf) * std::max(srcArea, dstArea), kScaleEdge);
+        }
+
+        if (dist[goal] == kInf)
+            return false;
+
+        for (int v = goal; v != start; v = prev[v])
+        {
+            const int layer = v / kPixelFormatCount;
+            Step s{};
+            s.fn = via[v] == kScaleEdge ? nullptr : kKernels[via[v]].fn;
+            s.out = (gcap_pixfmt_t)(v % kPixelFormatCount);
+            s.width = layer ? dstW : srcW;
+            s.height = layer ? dstH : srcH;
+            steps_.push_back(s);
+        }
+        std::reverse(steps_.begin(), steps_.end());
+
+        for (size_t i = 0; i < steps_.size(); ++i)
+        {
+            const Step &s = steps_[i];
+            if (!s.fn)
+            {
+                if (!scaler_)
+                    scaler_ = std::make_unique<PlaneScaler>();
+                if (!scaler_->configure(s.out, srcW, srcH, dstW, dstH, filter))
+                {
+                    reset();
+                    return false;
+                }
+            }
+
+            // every step but the last writes into a plan-owned buffer
+            if (i + 1 == steps_.size())
+                break;
+            const PixelFormatDesc &d = pixfmt_desc(s.out);
+            ImageRef img;
+            img.width = s.width;
+            img.height = s.height;
+            img.format = s.out;
+            size_t bytes = 0;
+            for (int p = 0; p < d.planeCount; ++p)
+            {
+                img.stride[p] = aligned_row_bytes(s.out, p, s.width);
+                bytes += (size_t)img.stride[p] * pixfmt_plane_rows(s.out, p, s.height);
+            }
+            storage_.emplace_back();
+            if (!storage_.back().allocate(bytes, node_))
+            {
+                reset();
+                return false;
+            }
+            uint8_t *base = storage_.back().data(); // page-aligned, so kRowAlign too
+            for (int p = 0; p < d.planeCount; ++p)
+            {
+                img.data[p] = base;
+                base += (size_t)img.stride[p] * pixfmt_plane_rows(s.out, p, s.height);
+            }
+            inter_.push_back(img);
+        }
+
+        valid_ = true;
+        return true;
+    }
+
+    std::string ConvertPlan::describe() const
+    {
+        if (!valid_)
+            return "(none)";
+        std::string s = pixfmt_desc(from_).name;
+        for (const auto &st : steps_)
+        {
+            s += " -> ";
+            s += st.fn ? pixfmt_desc(st.out).name : "scale";
+        }
+        return s;
+    }
+
+    void ConvertPlan::run(const ImageRef &src, const ImageRef &dst)
+    {
+        GCAP_TRACE_SCOPE("convert");
+        const ImageRef *in = &src;
+        for (size_t i = 0; i < steps_.size(); ++i)
+        {
+            const ImageRef &out = (i + 1 == steps_.size()) ? dst : inter_[i];
+            if (steps_[i].fn)
+            {
+                steps_[i].fn(*in, out);
+            }
+            else
+            {
+                const uint8_t *const sp[2] = {in->data[0], in->data[1]};
+                const int ss[2] = {in->stride[0], in->stride[1]};
+                uint8_t *const dp[2] = {out.data[0], out.data[1]};
+                const int ds[2] = {out.stride[0], out.stride[1]};
+                scaler_->scale(sp, ss, dp, ds);
+            }
+            in = &out;
+        }
+    }
+}
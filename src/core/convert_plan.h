@@ -0,0 +1,78 @@
+// convert_plan.h
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "gcapture.h"
+#include "pixel_format.h"
+#include "thread_tuning.h"
+
+namespace gcap
+{
+    class PlaneScaler;
+
+    // src and dst have the kernel's formats and the same size.
+    using ConvertFn = void (*)(const ImageRef &src, const ImageRef &dst);
+
+    struct ConvertKernel
+    {
+        gcap_pixfmt_t from;
+        gcap_pixfmt_t to;
+        int cost; // relative cost per pixel
+        ConvertFn fn;
+    };
+
+    // All registered single-step kernels.
+    const ConvertKernel *convert_kernels(int *count);
+
+    /**
+     * @brief Chain of conversion kernels chosen once per negotiated format.
+     *
+     * build() runs a shortest-path search over the registered kernels (and an
+     * optional resize on a native YUV format), weighting each step by its
+     * per-pixel cost and the number of pixels it touches. The chosen chain is
+     * stored as bound function pointers plus preallocated intermediate
+     * buffers, so run() makes no decisions and no allocations.
+     */
+    class ConvertPlan
+    {
+    public:
+        ConvertPlan();
+        ~ConvertPlan();
+
+        ConvertPlan(const ConvertPlan &) = delete;
+        ConvertPlan &operator=(const ConvertPlan &) = delete;
+
+        bool build(gcap_pixfmt_t from, int srcW, int srcH,
+                   gcap_pixfmt_t to, int dstW, int dstH,
+                   gcap_scale_filter_t filter = GCAP_SCALE_BILINEAR);
+        void reset();
+        // NUMA node for the intermediates of the next build() (-1 = anywhere)
+        void setNumaNode(int node) { node_ = node; }
+
+        bool valid() const { return valid_; }
+        // source already has the requested format and size
+        bool passthrough() const { return valid_ && steps_.empty(); }
+
+        // e.g. "V210 -> P010 -> NV12 -> scale -> ARGB"
+        std::string describe() const;
+
+        void run(const ImageRef &src, const ImageRef &dst);
+
+    private:
+        struct Step
+        {
+            ConvertFn fn;      // nullptr => resize with scaler_
+            gcap_pixfmt_t out; // format written by this step
+            int width, height; // size written by this step
+        };
+
+        bool valid_ = false;
+        gcap_pixfmt_t from_ = GCAP_FMT_ARGB;
+        std::vector<Step> steps_;
+        std::vector<ImageRef> inter_;               // output of step i (all but the last)
+        std::vector<NumaBuffer> storage_;           // backing for inter_ (page-aligned)
+        int node_ = -1;
+        std::unique_ptr<PlaneScaler> scaler_;
+    };
+}
@@ -0,0 +1,89 @@
+// device_cache.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "gcapture.h"
+
+namespace gcap
+{
+    /**
+     * @brief Process-wide device list, enumerated once and reused until invalidated.
+     *
+     * get() returns an immutable snapshot; it enumerates through the loader
+     * only when the list was invalidated (or is older than the max age, for
+     * backends without change notifications). Concurrent callers wait for
+     * the one enumeration in flight and share its result. Failures are not
+     * cached.
+     *
+     * invalidate() only bumps a generation counter, so backends can call it
+     * straight from their notification threads. The generation is sampled
+     * before enumerating: a change that arrives during an enumeration makes
+     * the next get() enumerate again.
+     *
+     * The loader is the only platform code, so the cache can be driven by a
+     * fake backend.
+     */
+    template <typename T>
+    class DeviceListCache
+    {
+    public:
+        using List = std::vector<T>;
+        using Loader = std::function<gcap_status_t(List &)>;
+
+        explicit DeviceListCache(Loader loader) : loader_(std::move(loader)) {}
+
+        DeviceListCache(const DeviceListCache &) = delete;
+        DeviceListCache &operator=(const DeviceListCache &) = delete;
+
+        gcap_status_t get(std::shared_ptr<const List> &out)
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            const uint64_t gen = generation_.load(std::memory_order_acquire);
+            const auto now = std::chrono::steady_clock::now();
+            const int64_t maxAgeMs = maxAgeMs_.load(std::memory_order_relaxed);
+            if (list_ && listGeneration_ == gen &&
+                (maxAgeMs <= 0 || now - loadedAt_ < std::chrono::milliseconds(maxAgeMs)))
+            {
+                out = list_;
+                return GCAP_OK;
+            }
+
+            List fresh;
+            const gcap_status_t st = loader_(fresh);
+            if (st != GCAP_OK)
+                return st;
+            list_ = std::make_shared<const List>(std::move(fresh));
+            listGeneration_ = gen;
+            loadedAt_ = now;
+            enumerations_.fetch_add(1, std::memory_order_relaxed);
+            out = list_;
+            return GCAP_OK;
+        }
+
+        // Any thread; never blocks.
+        void invalidate() { generation_.fetch_add(1, std::memory_order_release); }
+
+        // Re-enumerate at least this often; 0 = only when invalidated (default).
+        void setMaxAge(std::chrono::milliseconds age) { maxAgeMs_.store((int64_t)age.count(), std::memory_order_relaxed); }
+
+        // Loader calls that succeeded so far.
+        uint64_t enumerations() const { return enumerations_.load(std::memory_order_relaxed); }
+
+    private:
+        Loader loader_;
+        std::atomic<uint64_t> generation_{1};
+        std::atomic<int64_t> maxAgeMs_{0};
+        std::atomic<uint64_t> enumerations_{0};
+
+        std::mutex mutex_; // held across the loader call
+        std::shared_ptr<const List> list_;
+        uint64_t listGeneration_ = 0;
+        std::chrono::steady_clock::time_point loadedAt_{};
+    };
+}
@@ -1,6 +1,8 @@
 // frame_converter.cpp
 #include "frame_converter.h"
+#include "simd.h"
 #include <algorithm>
+#include <cstring>
 
 static inline void yuv_to_rgb(int Y, int U, int V, uint8_t &R, uint8_t &G, uint8_t &B)
 {
@@ -15,36 +17,111 @@ static inline void yuv_to_rgb(int Y, int U, int V, uint8_t &R, uint8_t &G, uint8
     B = (uint8_t)std::clamp(b, 0, 255);
 }
 
-void gcap::nv12_to_argb(const uint8_t *y, const uint8_t *uv,
-                        int w, int h, int yStride, int uvStride,
-                        uint8_t *out, int outStride)
+// ------------------------------------------------------------
+// 8-bit semi-planar → BGRA (NV12 / NV16 / NV24)
+// ------------------------------------------------------------
+// One output row. FullChroma: one UV pair per pixel (4:4:4), else one per two.
+// The SIMD path reproduces yuv_to_rgb() bit for bit.
+template <bool FullChroma>
+static void semiplanar_row_to_bgra(const uint8_t *yRow, const uint8_t *uvRow, int w, uint8_t *dst)
 {
-    for (int j = 0; j < h; ++j)
+    int i = 0;
+#if defined(GCAP_SIMD_SSE2)
+    const __m128i z = _mm_setzero_si128();
+    const __m128i lowByte = _mm_set1_epi16(0x00FF);
+    const __m128i k16 = _mm_set1_epi16(16);
+    const __m128i k128 = _mm_set1_epi16(128);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i round = _mm_set1_epi32(128);
+    const __m128i alpha = _mm_set1_epi8((char)0xFF);
+    // madd coefficient pairs (lo, hi)
+    const __m128i cR = _mm_set1_epi32((409 << 16) | 298);                 // (C, E)
+    const __m128i cB = _mm_set1_epi32((516 << 16) | 298);                 // (C, D)
+    const __m128i cG1 = _mm_set1_epi32((int)(0xFF9Cu << 16) | 298);       // (C, D): 298, -100
+    const __m128i cG2 = _mm_set1_epi32((128 << 16) | (0xFFFF & -208));    // (E, 1): -208, +128
+
+    for (; i + 8 <= w; i += 8)
     {
-        const uint8_t *yRow = y + j * yStride;
-        const uint8_t *uvRow = uv + (j / 2) * uvStride;
-        uint8_t *dst = out + j * outStride;
-        for (int i = 0; i < w; i += 2)
+        const __m128i C = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(yRow + i)), z), k16);
+
+        __m128i U, V;
+        if (FullChroma)
         {
-            uint8_t Y1 = yRow[i], Y2 = yRow[i + 1];
-            uint8_t U = uvRow[i], V = uvRow[i + 1];
-            uint8_t r, g, b;
-
-            yuv_to_rgb(Y1, U, V, r, g, b);
-            dst[0] = b;
-            dst[1] = g;
-            dst[2] = r;
-            dst[3] = 255; // BGRA
-            yuv_to_rgb(Y2, U, V, r, g, b);
-            dst[4] = b;
-            dst[5] = g;
-            dst[6] = r;
-            dst[7] = 255;
-            dst += 8;
+            const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(uvRow + 2 * i));
+            U = _mm_and_si128(raw, lowByte);
+            V = _mm_srli_epi16(raw, 8);
+        }
+        else
+        {
+            const __m128i raw = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(uvRow + i));
+            const __m128i u4 = _mm_and_si128(raw, lowByte);
+            const __m128i v4 = _mm_srli_epi16(raw, 8);
+            U = _mm_unpacklo_epi16(u4, u4);
+            V = _mm_unpacklo_epi16(v4, v4);
         }
+        const __m128i D = _mm_sub_epi16(U, k128);
+        const __m128i E = _mm_sub_epi16(V, k128);
+
+        const __m128i ceL = _mm_unpacklo_epi16(C, E), ceH = _mm_unpackhi_epi16(C, E);
+        const __m128i cdL = _mm_unpacklo_epi16(C, D), cdH = _mm_unpackhi_epi16(C, D);
+        const __m128i e1L = _mm_unpacklo_epi16(E, one), e1H = _mm_unpackhi_epi16(E, one);
+
+        const __m128i r = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ceL, cR), round), 8),
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ceH, cR), round), 8));
+        const __m128i g = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cdL, cG1), _mm_madd_epi16(e1L, cG2)), 8),
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cdH, cG1), _mm_madd_epi16(e1H, cG2)), 8));
+        const __m128i b = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cdL, cB), round), 8),
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cdH, cB), round), 8));
+
+        const __m128i bg = _mm_unpacklo_epi8(_mm_packus_epi16(b, b), _mm_packus_epi16(g, g));
+        const __m128i ra = _mm_unpacklo_epi8(_mm_packus_epi16(r, r), alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4 * i), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4 * i + 16), _mm_unpackhi_epi16(bg, ra));
+    }
+#endif
+    for (; i < w; ++i)
+    {
+        const uint8_t *c = FullChroma ? uvRow + 2 * i : uvRow + (i & ~1);
+        uint8_t r, g, b;
+        yuv_to_rgb(yRow[i], c[0], c[1], r, g, b);
+        uint8_t *d = dst + 4 * i;
+        d[0] = b;
+        d[1] = g;
+        d[2] = r;
+        d[3] = 255; // BGRA
     }
 }
 
+void gcap::nv12_to_argb(const uint8_t *y, const uint8_t *uv,
+                        int w, int h, int yStride, int uvStride,
+                        uint8_t *out, int outStride)
+{
+    for (int j = 0; j < h; ++j)
+        semiplanar_row_to_bgra<false>(y + (size_t)j * yStride, uv + (size_t)(j / 2) * uvStride,
+                                      w, out + (size_t)j * outStride);
+}
+
+void gcap::nv16_to_argb(const uint8_t *y, const uint8_t *uv,
+                        int w, int h, int yStride, int uvStride,
+                        uint8_t *out, int outStride)
+{
+    for (int j = 0; j < h; ++j)
+        semiplanar_row_to_bgra<false>(y + (size_t)j * yStride, uv + (size_t)j * uvStride,
+                                      w, out + (size_t)j * outStride);
+}
+
+void gcap::nv24_to_argb(const uint8_t *y, const uint8_t *uv,
+                        int w, int h, int yStride, int uvStride,
+                        uint8_t *out, int outStride)
+{
+    for (int j = 0; j < h; ++j)
+        semiplanar_row_to_bgra<true>(y + (size_t)j * yStride, uv + (size_t)j * uvStride,
+                                     w, out + (size_t)j * outStride);
+}
+
 // ------------------------------------------------------------
 // YUY2 → ARGB
 // ------------------------------------------------------------
@@ -88,3 +165,361 @@ void gcap::yuy2_to_argb(const uint8_t *yuy2,
         }
     }
 }
+
+// ------------------------------------------------------------
+// P010 → NV12
+// ------------------------------------------------------------
+static void p010_row_to_8bit(const uint16_t *src, uint8_t *dst, int n)
+{
+    int i = 0;
+#if defined(GCAP_SIMD_SSE2)
+    const __m128i half = _mm_set1_epi16(0x80);
+    for (; i + 16 <= n; i += 16)
+    {
+        // saturating add keeps 0xFFC0 + 0x80 from wrapping
+        __m128i a = _mm_adds_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), half);
+        __m128i b = _mm_adds_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 8)), half);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+    }
+#elif defined(GCAP_SIMD_NEON)
+    for (; i + 16 <= n; i += 16)
+    {
+        const uint16x8_t a = vld1q_u16(src + i);
+        const uint16x8_t b = vld1q_u16(src + i + 8);
+        vst1q_u8(dst + i, vcombine_u8(vqrshrn_n_u16(a, 8), vqrshrn_n_u16(b, 8)));
+    }
+#endif
+    for (; i < n; ++i)
+        dst[i] = (uint8_t)std::min(255, (src[i] + 0x80) >> 8);
+}
+
+void gcap::p010_to_nv12(const uint8_t *y, const uint8_t *uv,
+                        int width, int height, int yStrideBytes, int uvStrideBytes,
+                        uint8_t *outY, uint8_t *outUV, int outYStride, int outUVStride)
+{
+    for (int j = 0; j < height; ++j)
+        p010_row_to_8bit(reinterpret_cast<const uint16_t *>(y + (size_t)j * yStrideBytes),
+                         outY + (size_t)j * outYStride, width);
+    for (int j = 0; j < height / 2; ++j)
+        p010_row_to_8bit(reinterpret_cast<const uint16_t *>(uv + (size_t)j * uvStrideBytes),
+                         outUV + (size_t)j * outUVStride, width & ~1);
+}
+
+// ------------------------------------------------------------
+// V210 → P010
+// ------------------------------------------------------------
+// One 16-byte group: Cb0 Y0 Cr0 | Y1 Cb1 Y2 | Cr1 Y3 Cb2 | Y4 Cr2 Y5
+static inline void v210_unpack_group(const uint8_t *p, uint16_t ys[6], uint16_t cb[3], uint16_t cr[3])
+{
+    uint32_t w[4];
+    for (int k = 0; k < 4; ++k)
+        w[k] = (uint32_t)p[4 * k] | ((uint32_t)p[4 * k + 1] << 8) |
+               ((uint32_t)p[4 * k + 2] << 16) | ((uint32_t)p[4 * k + 3] << 24);
+
+    cb[0] = w[0] & 0x3FF;
+    ys[0] = (w[0] >> 10) & 0x3FF;
+    cr[0] = (w[0] >> 20) & 0x3FF;
+    ys[1] = w[1] & 0x3FF;
+    cb[1] = (w[1] >> 10) & 0x3FF;
+    ys[2] = (w[1] >> 20) & 0x3FF;
+    cr[1] = w[2] & 0x3FF;
+    ys[3] = (w[2] >> 10) & 0x3FF;
+    cb[2] = (w[2] >> 20) & 0x3FF;
+    ys[4] = w[3] & 0x3FF;
+    cr[2] = (w[3] >> 10) & 0x3FF;
+    ys[5] = (w[3] >> 20) & 0x3FF;
+}
+
+void gcap::v210_to_p010(const uint8_t *v210,
+                        int width, int height, int v210Stride,
+                        uint8_t *outY, uint8_t *outUV, int outYStrideBytes, int outUVStrideBytes)
+{
+    const int groups = (width + 5) / 6;
+    uint16_t ys[6], cb[3], cr[3], cb2[3], cr2[3], dummy[6];
+
+    for (int j = 0; j < height; j += 2)
+    {
+        const uint8_t *r0 = v210 + (size_t)j * v210Stride;
+        const uint8_t *r1 = (j + 1 < height) ? r0 + v210Stride : r0;
+        uint16_t *y0 = reinterpret_cast<uint16_t *>(outY + (size_t)j * outYStrideBytes);
+        uint16_t *y1 = reinterpret_cast<uint16_t *>(outY + (size_t)(j + 1) * outYStrideBytes);
+        uint16_t *c = reinterpret_cast<uint16_t *>(outUV + (size_t)(j / 2) * outUVStrideBytes);
+
+        for (int g = 0; g < groups; ++g)
+        {
+            const int x0 = g * 6;
+            const int n = std::min(6, width - x0);
+
+            v210_unpack_group(r0 + (size_t)g * 16, ys, cb, cr);
+            for (int k = 0; k < n; ++k)
+                y0[x0 + k] = (uint16_t)(ys[k] << 6);
+
+            v210_unpack_group(r1 + (size_t)g * 16, j + 1 < height ? ys : dummy, cb2, cr2);
+            if (j + 1 < height)
+                for (int k = 0; k < n; ++k)
+                    y1[x0 + k] = (uint16_t)(ys[k] << 6);
+
+            // 4:2:2 → 4:2:0: average the two chroma rows
+            for (int k = 0; k < (n + 1) / 2; ++k)
+            {
+                c[x0 + 2 * k] = (uint16_t)(((cb[k] + cb2[k] + 1) >> 1) << 6);
+                c[x0 + 2 * k + 1] = (uint16_t)(((cr[k] + cr2[k] + 1) >> 1) << 6);
+            }
+        }
+    }
+}
+
+// ------------------------------------------------------------
+// 4:2:2 / 4:4:4 → 4:2:0 and bit-depth reductions
+// ------------------------------------------------------------
+static void copy_rows(const uint8_t *src, int srcStride, uint8_t *dst, int dstStride, size_t rowBytes, int rows)
+{
+    for (int j = 0; j < rows; ++j)
+        memcpy(dst + (size_t)j * dstStride, src + (size_t)j * srcStride, rowBytes);
+}
+
+void gcap::nv16_to_nv12(const uint8_t *y, const uint8_t *uv,
+                        int width, int height, int yStride, int uvStride,
+                        uint8_t *outY, uint8_t *outUV, int outYStride, int outUVStride)
+{
+    copy_rows(y, yStride, outY, outYStride, (size_t)width, height);
+
+    const int n = (width + 1) & ~1; // interleaved UV bytes per row
+    for (int j = 0; j < height / 2; ++j)
+    {
+        const uint8_t *a = uv + (size_t)(2 * j) * uvStride;
+        const uint8_t *b = a + uvStride;
+        uint8_t *d = outUV + (size_t)j * outUVStride;
+        int i = 0;
+#if defined(GCAP_SIMD_SSE2)
+        for (; i + 16 <= n; i += 16)
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d + i),
+                             _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)),
+                                          _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i))));
+#elif defined(GCAP_SIMD_NEON)
+        for (; i + 16 <= n; i += 16)
+            vst1q_u8(d + i, vrhaddq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+#endif
+        for (; i < n; ++i)
+            d[i] = (uint8_t)((a[i] + b[i] + 1) >> 1);
+    }
+}
+
+void gcap::nv24_to_nv12(const uint8_t *y, const uint8_t *uv,
+                        int width, int height, int yStride, int uvStride,
+                        uint8_t *outY, uint8_t *outUV, int outYStride, int outUVStride)
+{
+    copy_rows(y, yStride, outY, outYStride, (size_t)width, height);
+
+    const int pairs = width / 2; // output UV pairs per row
+    for (int j = 0; j < height / 2; ++j)
+    {
+        const uint8_t *a = uv + (size_t)(2 * j) * uvStride;
+        const uint8_t *b = a + uvStride;
+        uint8_t *d = outUV + (size_t)j * outUVStride;
+        int p = 0;
+#if defined(GCAP_SIMD_SSE2)
+        const __m128i z = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+        // 8 source pixels (16 bytes per row) → 4 output pairs
+        for (; p + 4 <= pairs; p += 4)
+        {
+            const __m128i ra = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 4 * p));
+            const __m128i rb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + 4 * p));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(ra, z), _mm_unpacklo_epi8(rb, z));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(ra, z), _mm_unpackhi_epi8(rb, z));
+            // (U0 V0)(U1 V1) → (U0+U1, V0+V1) in even 32-bit lanes
+            lo = _mm_shuffle_epi32(_mm_add_epi16(lo, _mm_srli_si128(lo, 4)), _MM_SHUFFLE(3, 1, 2, 0));
+            hi = _mm_shuffle_epi32(_mm_add_epi16(hi, _mm_srli_si128(hi, 4)), _MM_SHUFFLE(3, 1, 2, 0));
+            const __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(d + 2 * p), _mm_packus_epi16(sum, sum));
+        }
+#endif
+        for (; p < pairs; ++p)
+        {
+            const uint8_t *sa = a + 4 * p, *sb = b + 4 * p;
+            d[2 * p] = (uint8_t)((sa[0] + sa[2] + sb[0] + sb[2] + 2) >> 2);
+            d[2 * p + 1] = (uint8_t)((sa[1] + sa[3] + sb[1] + sb[3] + 2) >> 2);
+        }
+    }
+}
+
+void gcap::p210_to_p010(const uint8_t *y, const uint8_t *uv,
+                        int width, int height, int yStrideBytes, int uvStrideBytes,
+                        uint8_t *outY, uint8_t *outUV, int outYStrideBytes, int outUVStrideBytes)
+{
+    copy_rows(y, yStrideBytes, outY, outYStrideBytes, (size_t)width * 2, height);
+
+    const int n = (width + 1) & ~1; // interleaved UV samples per row
+    for (int j = 0; j < height / 2; ++j)
+    {
+        const uint16_t *a = reinterpret_cast<const uint16_t *>(uv + (size_t)(2 * j) * uvStrideBytes);
+        const uint16_t *b = reinterpret_cast<const uint16_t *>(uv + (size_t)(2 * j + 1) * uvStrideBytes);
+        uint16_t *d = reinterpret_cast<uint16_t *>(outUV + (size_t)j * outUVStrideBytes);
+        int i = 0;
+#if defined(GCAP_SIMD_SSE2)
+        // average the 10-bit codes so the 6 padding bits stay zero
+        for (; i + 8 <= n; i += 8)
+        {
+            const __m128i va = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)), 6);
+            const __m128i vb = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)), 6);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d + i), _mm_slli_epi16(_mm_avg_epu16(va, vb), 6));
+        }
+#elif defined(GCAP_SIMD_NEON)
+        for (; i + 8 <= n; i += 8)
+            vst1q_u16(d + i, vshlq_n_u16(vrhaddq_u16(vshrq_n_u16(vld1q_u16(a + i), 6),
+                                                     vshrq_n_u16(vld1q_u16(b + i), 6)),
+                                         6));
+#endif
+        for (; i < n; ++i)
+            d[i] = (uint16_t)((((a[i] >> 6) + (b[i] >> 6) + 1) >> 1) << 6);
+    }
+}
+
+void gcap::p210_to_nv16(const uint8_t *y, const uint8_t *uv,
+                        int width, int height, int yStrideBytes, int uvStrideBytes,
+                        uint8_t *outY, uint8_t *outUV, int outYStride, int outUVStride)
+{
+    for (int j = 0; j < height; ++j)
+    {
+        p010_row_to_8bit(reinterpret_cast<const uint16_t *>(y + (size_t)j * yStrideBytes),
+                         outY + (size_t)j * outYStride, width);
+        p010_row_to_8bit(reinterpret_cast<const uint16_t *>(uv + (size_t)j * uvStrideBytes),
+                         outUV + (size_t)j * outUVStride, (width + 1) & ~1);
+    }
+}
+
+// ------------------------------------------------------------
+// Y210 → P210 (packed → semi-planar, lossless)
+// ------------------------------------------------------------
+void gcap::y210_to_p210(const uint8_t *y210,
+                        int width, int height, int y210Stride,
+                        uint8_t *outY, uint8_t *outUV, int outYStrideBytes, int outUVStrideBytes)
+{
+    for (int j = 0; j < height; ++j)
+    {
+        const uint16_t *s = reinterpret_cast<const uint16_t *>(y210 + (size_t)j * y210Stride);
+        uint16_t *dy = reinterpret_cast<uint16_t *>(outY + (size_t)j * outYStrideBytes);
+        uint16_t *duv = reinterpret_cast<uint16_t *>(outUV + (size_t)j * outUVStrideBytes);
+        int i = 0;
+#if defined(GCAP_SIMD_SSE2)
+        // Y0 U0 Y1 V0 Y2 U1 Y3 V1 → [Y0 Y1 Y2 Y3 | U0 V0 U1 V1]
+        auto split = [](__m128i v)
+        {
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 1, 2, 0));
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 1, 2, 0));
+            return _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 2, 0));
+        };
+        for (; i + 8 <= width; i += 8)
+        {
+            const __m128i a = split(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 2 * i)));
+            const __m128i b = split(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 2 * i + 8)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dy + i), _mm_unpacklo_epi64(a, b));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(duv + i), _mm_unpackhi_epi64(a, b));
+        }
+#elif defined(GCAP_SIMD_NEON)
+        for (; i + 8 <= width; i += 8)
+        {
+            const uint16x8x2_t v = vld2q_u16(s + 2 * i); // val[0] = Y, val[1] = U V U V ...
+            vst1q_u16(dy + i, v.val[0]);
+            vst1q_u16(duv + i, v.val[1]);
+        }
+#endif
+        for (; i < width; ++i)
+        {
+            dy[i] = s[2 * i];
+            duv[i] = s[2 * i + 1];
+        }
+    }
+}
+
+// ------------------------------------------------------------
+// V210 → P210 (keeps full chroma resolution)
+// ------------------------------------------------------------
+void gcap::v210_to_p210(const uint8_t *v210,
+                        int width, int height, int v210Stride,
+                        uint8_t *outY, uint8_t *outUV, int outYStrideBytes, int outUVStrideBytes)
+{
+    const int groups = (width + 5) / 6;
+    uint16_t ys[6], cb[3], cr[3];
+
+    for (int j = 0; j < height; ++j)
+    {
+        const uint8_t *r = v210 + (size_t)j * v210Stride;
+        uint16_t *y = reinterpret_cast<uint16_t *>(outY + (size_t)j * outYStrideBytes);
+        uint16_t *c = reinterpret_cast<uint16_t *>(outUV + (size_t)j * outUVStrideBytes);
+
+        for (int g = 0; g < groups; ++g)
+        {
+            const int x0 = g * 6;
+            const int n = std::min(6, width - x0);
+            v210_unpack_group(r + (size_t)g * 16, ys, cb, cr);
+            for (int k = 0; k < n; ++k)
+                y[x0 + k] = (uint16_t)(ys[k] << 6);
+            for (int k = 0; k < (n + 1) / 2; ++k)
+            {
+                c[x0 + 2 * k] = (uint16_t)(cb[k] << 6);
+                c[x0 + 2 * k + 1] = (uint16_t)(cr[k] << 6);
+            }
+        }
+    }
+}
+
+// ------------------------------------------------------------
+// → GRAY8 (luma only)
+// ------------------------------------------------------------
+void gcap::y8_to_gray8(const uint8_t *y, int width, int height, int yStride,
+                       uint8_t *out, int outStride)
+{
+    for (int j = 0; j < height; ++j)
+        memcpy(out + (size_t)j * outStride, y + (size_t)j * yStride, (size_t)width);
+}
+
+void gcap::y16_to_gray8(const uint8_t *y, int width, int height, int yStrideBytes,
+                        uint8_t *out, int outStride)
+{
+    for (int j = 0; j < height; ++j)
+        p010_row_to_8bit(reinterpret_cast<const uint16_t *>(y + (size_t)j * yStrideBytes),
+                         out + (size_t)j * outStride, width);
+}
+
+void gcap::yuy2_to_gray8(const uint8_t *yuy2, int width, int height, int yuy2Stride,
+                         uint8_t *out, int outStride)
+{
+    for (int j = 0; j < height; ++j)
+    {
+        const uint8_t *s = yuy2 + (size_t)j * yuy2Stride;
+        uint8_t *d = out + (size_t)j * outStride;
+        int i = 0;
+#if defined(GCAP_SIMD_SSE2)
+        const __m128i lowByte = _mm_set1_epi16(0x00FF);
+        for (; i + 16 <= width; i += 16)
+        {
+            const __m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 2 * i)), lowByte);
+            const __m128i b = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 2 * i + 16)), lowByte);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d + i), _mm_packus_epi16(a, b));
+        }
+#elif defined(GCAP_SIMD_NEON)
+        for (; i + 16 <= width; i += 16)
+            vst1q_u8(d + i, vld2q_u8(s + 2 * i).val[0]);
+#endif
+        for (; i < width; ++i)
+            d[i] = s[2 * i];
+    }
+}
+
+void gcap::argb_to_gray8(const uint8_t *argb, int width, int height, int argbStride,
+                         uint8_t *out, int outStride)
+{
+    for (int j = 0; j < height; ++j)
+    {
+        const uint8_t *s = argb + (size_t)j * argbStride;
+        uint8_t *d = out + (size_t)j * outStride;
+        for (int i = 0; i < width; ++i)
+        {
+            const int b = s[4 * i], g = s[4 * i + 1], r = s[4 * i + 2];
+            d[i] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+}
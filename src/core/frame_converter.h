@@ -9,8 +9,74 @@ namespace gcap
                       int width, int height, int yStride, int uvStride,
                       uint8_t *outARGB, int outStride);
 
+    // NV16 (4:2:2 semi-planar) → ARGB
+    void nv16_to_argb(const uint8_t *y, const uint8_t *uv,
+                      int width, int height, int yStride, int uvStride,
+                      uint8_t *outARGB, int outStride);
+
+    // NV24 (4:4:4 semi-planar) → ARGB
+    void nv24_to_argb(const uint8_t *y, const uint8_t *uv,
+                      int width, int height, int yStride, int uvStride,
+                      uint8_t *outARGB, int outStride);
+
     // YUY2 → ARGB
     void yuy2_to_argb(const uint8_t *yuy2,
                       int width, int height, int yuy2Stride,
                       uint8_t *outARGB, int outStride);
+
+    // P010 → NV12 (10-bit MSB-aligned → 8-bit, rounded)
+    void p010_to_nv12(const uint8_t *y, const uint8_t *uv,
+                      int width, int height, int yStrideBytes, int uvStrideBytes,
+                      uint8_t *outY, uint8_t *outUV, int outYStride, int outUVStride);
+
+    // V210 (4:2:2 10-bit packed) → P010; chroma rows are averaged in pairs
+    void v210_to_p010(const uint8_t *v210,
+                      int width, int height, int v210Stride,
+                      uint8_t *outY, uint8_t *outUV, int outYStrideBytes, int outUVStrideBytes);
+
+    // V210 → P210 (full-height chroma, lossless)
+    void v210_to_p210(const uint8_t *v210,
+                      int width, int height, int v210Stride,
+                      uint8_t *outY, uint8_t *outUV, int outYStrideBytes, int outUVStrideBytes);
+
+    // NV16 → NV12 (chroma rows averaged in pairs)
+    void nv16_to_nv12(const uint8_t *y, const uint8_t *uv,
+                      int width, int height, int yStride, int uvStride,
+                      uint8_t *outY, uint8_t *outUV, int outYStride, int outUVStride);
+
+    // NV24 → NV12 (2x2 chroma average)
+    void nv24_to_nv12(const uint8_t *y, const uint8_t *uv,
+                      int width, int height, int yStride, int uvStride,
+                      uint8_t *outY, uint8_t *outUV, int outYStride, int outUVStride);
+
+    // P210 → P010 (chroma rows averaged in pairs, stays 10-bit)
+    void p210_to_p010(const uint8_t *y, const uint8_t *uv,
+                      int width, int height, int yStrideBytes, int uvStrideBytes,
+                      uint8_t *outY, uint8_t *outUV, int outYStrideBytes, int outUVStrideBytes);
+
+    // P210 → NV16 (10-bit → 8-bit, chroma resolution kept)
+    void p210_to_nv16(const uint8_t *y, const uint8_t *uv,
+                      int width, int height, int yStrideBytes, int uvStrideBytes,
+                      uint8_t *outY, uint8_t *outUV, int outYStride, int outUVStride);
+
+    // 8-bit luma plane (NV12 / NV16 / NV24 Y) → GRAY8: a row copy
+    void y8_to_gray8(const uint8_t *y, int width, int height, int yStride,
+                     uint8_t *out, int outStride);
+
+    // 16-bit MSB-aligned luma plane (P010 / P210 Y) → GRAY8, rounded
+    void y16_to_gray8(const uint8_t *y, int width, int height, int yStrideBytes,
+                      uint8_t *out, int outStride);
+
+    // YUY2 → GRAY8 (the Y bytes)
+    void yuy2_to_gray8(const uint8_t *yuy2, int width, int height, int yuy2Stride,
+                       uint8_t *out, int outStride);
+
+    // ARGB (BGRA bytes) → GRAY8: BT.601 video-range luma, the inverse of the YUV → ARGB kernels
+    void argb_to_gray8(const uint8_t *argb, int width, int height, int argbStride,
+                       uint8_t *out, int outStride);
+
+    // Y210 (4:2:2 packed, 16-bit containers) → P210
+    void y210_to_p210(const uint8_t *y210,
+                      int width, int height, int y210Stride,
+                      uint8_t *outY, uint8_t *outUV, int outYStrideBytes, int outUVStrideBytes);
 }
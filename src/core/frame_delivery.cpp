@@ -0,0 +1,240 @@
+// frame_delivery.cpp
+#include "frame_delivery.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+
+namespace gcap
+{
+    FrameDelivery::~FrameDelivery()
+    {
+        interrupt();
+        stop();
+    }
+
+    bool FrameDelivery::configure(gcap_delivery_policy_t policy, int depth)
+    {
+        if (policy < GCAP_DELIVERY_SYNC || policy > GCAP_DELIVERY_LATEST)
+            return false;
+        if (depth < 0 || depth > kMaxDepth)
+            return false;
+        std::lock_guard<std::mutex> lk(configMutex_);
+        nextPolicy_ = policy;
+        nextDepth_ = depth ? depth : kDefaultDepth;
+        return true;
+    }
+
+    int FrameDelivery::framesInFlight() const
+    {
+        gcap_delivery_policy_t policy;
+        int depth;
+        {
+            std::lock_guard<std::mutex> lk(configMutex_);
+            policy = nextPolicy_;
+            depth = nextDepth_;
+        }
+        if (policy == GCAP_DELIVERY_SYNC)
+            return 0;
+        if (policy == GCAP_DELIVERY_LATEST)
+            depth = 1;
+        return depth + 2;
+    }
+
+    void FrameDelivery::start(Sink sink, ThreadHook hook)
+    {
+        stop();
+
+        gcap_delivery_policy_t policy;
+        int depth;
+        {
+            std::lock_guard<std::mutex> lk(configMutex_);
+            policy = nextPolicy_;
+            depth = policy == GCAP_DELIVERY_LATEST ? 1 : nextDepth_;
+        }
+
+        sink_ = std::move(sink);
+        hook_ = std::move(hook);
+        queued_ = 0;
+        highWater_ = 0;
+        delivered_ = 0;
+        droppedOldest_ = 0;
+        droppedNewest_ = 0;
+        droppedNoBuffer_ = 0;
+        flushed_ = 0;
+        blockedNs_ = 0;
+        stop_ = false;
+        interrupted_ = false;
+        policy_ = policy;
+
+        if (policy == GCAP_DELIVERY_SYNC)
+        {
+            depth_ = 0;
+            return;
+        }
+        depth_ = depth;
+        queue_ = std::make_unique<MpmcQueue<FramePool::Buffer *>>((size_t)depth);
+        thread_ = std::thread(&FrameDelivery::run, this);
+    }
+
+    void FrameDelivery::interrupt()
+    {
+        {
+            std::lock_guard<std::mutex> lk(waitMutex_);
+            interrupted_ = true;
+        }
+        spaceCv_.notify_all();
+    }
+
+    void FrameDelivery::stop()
+    {
+        if (thread_.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lk(waitMutex_);
+                stop_ = true;
+            }
+            dataCv_.notify_all();
+            thread_.join();
+        }
+        if (queue_)
+        {
+            FramePool::Buffer *b = nullptr;
+            while (queue_->tryPop(b))
+            {
+                FramePool::unref(b);
+                queued_.fetch_sub(1, std::memory_order_relaxed);
+                flushed_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        copies_.clear();
+    }
+
+    void FrameDelivery::noteQueued()
+    {
+        const int n = queued_.fetch_add(1, std::memory_order_relaxed) + 1;
+        int hw = highWater_.load(std::memory_order_relaxed);
+        while (n > hw && !highWater_.compare_exchange_weak(hw, n, std::memory_order_relaxed))
+        {
+        }
+        // taking the mutex orders the push before the consumer's predicate check
+        {
+            std::lock_guard<std::mutex> lk(waitMutex_);
+        }
+        dataCv_.notify_one();
+    }
+
+    void FrameDelivery::push(const gcap_frame_t &f)
+    {
+        const gcap_delivery_policy_t policy = policy_.load(std::memory_order_relaxed);
+        if (policy == GCAP_DELIVERY_SYNC)
+        {
+            if (sink_)
+                sink_(&f);
+            delivered_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        FramePool::Buffer *b = copies_.hold(f, depth_.load(std::memory_order_relaxed) + 2);
+        if (!b)
+        {
+            droppedNoBuffer_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        while (!queue_->tryPush(b))
+        {
+            switch (policy)
+            {
+            case GCAP_DELIVERY_DROP_NEWEST:
+                FramePool::unref(b);
+                droppedNewest_.fetch_add(1, std::memory_order_relaxed);
+                return;
+
+            case GCAP_DELIVERY_BLOCK:
+            {
+                const auto t0 = std::chrono::steady_clock::now();
+                bool gaveUp;
+                {
+                    std::unique_lock<std::mutex> lk(waitMutex_);
+                    spaceCv_.wait(lk, [&]
+                                  { return interrupted_.load() || queue_->size() < queue_->capacity(); });
+                    gaveUp = interrupted_;
+                }
+                blockedNs_.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now() - t0)
+                                         .count(),
+                                     std::memory_order_relaxed);
+                if (gaveUp)
+                {
+                    FramePool::unref(b);
+                    droppedNewest_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                break;
+            }
+
+            default: // DROP_OLDEST, LATEST: make room at the head
+            {
+                FramePool::Buffer *old = nullptr;
+                if (queue_->tryPop(old))
+                {
+                    FramePool::unref(old);
+                    queued_.fetch_sub(1, std::memory_order_relaxed);
+                    droppedOldest_.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+            }
+            }
+        }
+        noteQueued();
+    }
+
+    void FrameDelivery::run()
+    {
+        trace::setThreadName("delivery");
+        if (hook_)
+            hook_(true);
+        const bool block = policy_.load() == GCAP_DELIVERY_BLOCK;
+        while (!stop_.load(std::memory_order_acquire))
+        {
+            FramePool::Buffer *b = nullptr;
+            if (!queue_->tryPop(b))
+            {
+                std::unique_lock<std::mutex> lk(waitMutex_);
+                dataCv_.wait(lk, [&]
+                             { return stop_.load() || queue_->size() > 0; });
+                continue;
+            }
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            if (block)
+            {
+                {
+                    std::lock_guard<std::mutex> lk(waitMutex_);
+                }
+                spaceCv_.notify_one();
+            }
+
+            if (sink_)
+                sink_(&b->frame);
+            FramePool::unref(b);
+            delivered_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (hook_)
+            hook_(false);
+    }
+
+    void FrameDelivery::stats(gcap_delivery_stats_t &out) const
+    {
+        out = {};
+        out.policy = policy_.load(std::memory_order_relaxed);
+        out.queue_depth = depth_.load(std::memory_order_relaxed);
+        out.queued = std::max(0, queued_.load(std::memory_order_relaxed));
+        out.high_water = highWater_.load(std::memory_order_relaxed);
+        out.delivered = delivered_.load(std::memory_order_relaxed);
+        out.dropped_oldest = droppedOldest_.load(std::memory_order_relaxed);
+        out.dropped_newest = droppedNewest_.load(std::memory_order_relaxed);
+        out.dropped_no_buffer = droppedNoBuffer_.load(std::memory_order_relaxed);
+        out.flushed = flushed_.load(std::memory_order_relaxed);
+        out.blocked_ns = blockedNs_.load(std::memory_order_relaxed);
+    }
+}
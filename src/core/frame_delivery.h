@@ -0,0 +1,107 @@
+// frame_delivery.h
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "gcapture.h"
+#include "frame_pool.h"
+#include "mpmc_queue.h"
+
+namespace gcap
+{
+    /**
+     * @brief Hands captured frames to the video callback, inline or on its own thread.
+     *
+     * With GCAP_DELIVERY_SYNC push() calls the sink on the capture thread,
+     * exactly as before. Every other policy puts a bounded MpmcQueue and a
+     * delivery thread between the two, so a slow consumer costs queued or
+     * dropped frames (all counted) instead of stalling ReadSample.
+     *
+     * Queued frames are FramePool buffers: pooled frames are shared by
+     * reference, anything else (passthrough, GPU readback) is copied once
+     * into a private pool sized for the queue. push() never allocates after
+     * the first frame of a given size.
+     *
+     * configure() takes effect at the next start(). push() is for the
+     * capture thread only; stats() may be called from any thread.
+     */
+    class FrameDelivery
+    {
+    public:
+        using Sink = std::function<void(const gcap_frame_t *)>;
+        // Runs on the delivery thread: true first, false before it exits.
+        using ThreadHook = std::function<void(bool begin)>;
+
+        static constexpr int kDefaultDepth = 3;
+        static constexpr int kMaxDepth = 32;
+
+        FrameDelivery() = default;
+        ~FrameDelivery();
+
+        FrameDelivery(const FrameDelivery &) = delete;
+        FrameDelivery &operator=(const FrameDelivery &) = delete;
+
+        // false for an unknown policy or a depth outside 0..kMaxDepth (0 = default)
+        bool configure(gcap_delivery_policy_t policy, int depth);
+        // Buffers the stage may hold at once (queue, sink, one being evicted);
+        // 0 for SYNC. Upstream pools add this to their own count.
+        int framesInFlight() const;
+
+        // NUMA node for the copy pool (-1 = anywhere); call before start().
+        void setNumaNode(int node) { copies_.setNumaNode(node); }
+
+        void start(Sink sink, ThreadHook hook = {});
+        // Stop BLOCK waits (the frame is dropped); call before joining the
+        // capture thread so a stalled consumer cannot hang gcap_stop.
+        void interrupt();
+        // Join the delivery thread and drop what is still queued. The capture
+        // thread must no longer call push().
+        void stop();
+
+        void push(const gcap_frame_t &f);
+        // A frame the capture thread dropped for want of a buffer.
+        void dropNoBuffer() { droppedNoBuffer_.fetch_add(1, std::memory_order_relaxed); }
+
+        void stats(gcap_delivery_stats_t &out) const;
+        // Frame bytes copied for frames that had no pool buffer.
+        uint64_t copiedBytes() const { return copies_.copiedBytes(); }
+
+    private:
+        void run();
+        void noteQueued();
+
+        // configure() → start()
+        mutable std::mutex configMutex_;
+        gcap_delivery_policy_t nextPolicy_ = GCAP_DELIVERY_SYNC;
+        int nextDepth_ = kDefaultDepth;
+
+        // fixed between start() and stop()
+        std::atomic<gcap_delivery_policy_t> policy_{GCAP_DELIVERY_SYNC};
+        std::atomic<int> depth_{0};
+        Sink sink_;
+        ThreadHook hook_;
+        std::unique_ptr<MpmcQueue<FramePool::Buffer *>> queue_;
+        FramePool copies_; // for frames without a pool buffer
+        std::thread thread_;
+
+        // sleeping only: the queue itself is lock-free
+        std::mutex waitMutex_;
+        std::condition_variable dataCv_;
+        std::condition_variable spaceCv_;
+        std::atomic<bool> stop_{false};
+        std::atomic<bool> interrupted_{false};
+
+        std::atomic<int> queued_{0};
+        std::atomic<int> highWater_{0};
+        std::atomic<uint64_t> delivered_{0};
+        std::atomic<uint64_t> droppedOldest_{0};
+        std::atomic<uint64_t> droppedNewest_{0};
+        std::atomic<uint64_t> droppedNoBuffer_{0};
+        std::atomic<uint64_t> flushed_{0};
+        std::atomic<uint64_t> blockedNs_{0};
+    };
+}
@@ -0,0 +1,265 @@
+// frame_fanout.cpp
+#include "frame_fanout.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace gcap
+{
+    FrameFanout::FrameFanout(Logger *log) : log_(log) {}
+
+    FrameFanout::~FrameFanout() = default;
+
+    gcap_status_t FrameFanout::add(const gcap_consumer_desc_t &desc, int &id)
+    {
+        if (!desc.cb || !pixfmt_valid(desc.format))
+            return GCAP_EINVAL;
+        if (desc.width < 0 || desc.height < 0 || (desc.width == 0) != (desc.height == 0) ||
+            (desc.width | desc.height) & 1)
+            return GCAP_EINVAL;
+        if (desc.max_fps_num < 0 || (desc.max_fps_num > 0 && desc.max_fps_den <= 0))
+            return GCAP_EINVAL;
+
+        std::lock_guard<std::mutex> lk(regMutex_);
+        id = nextId_++;
+        consumers_.push_back({id, desc});
+        count_.store((int)consumers_.size(), std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_release);
+        return GCAP_OK;
+    }
+
+    gcap_status_t FrameFanout::remove(int id)
+    {
+        {
+            std::lock_guard<std::mutex> lk(regMutex_);
+            auto it = std::find_if(consumers_.begin(), consumers_.end(),
+                                   [&](const Consumer &c)
+                                   { return c.id == id; });
+            if (it == consumers_.end())
+                return GCAP_EINVAL;
+            consumers_.erase(it);
+            count_.store((int)consumers_.size(), std::memory_order_relaxed);
+            generation_.fetch_add(1, std::memory_order_release);
+        }
+        // a frame already in process() may still hold the old list: wait it
+        // out, unless this is that frame's callback
+        if (processThread_.load() != std::this_thread::get_id())
+        {
+            std::lock_guard<std::mutex> lk(processMutex_);
+        }
+        return GCAP_OK;
+    }
+
+    void FrameFanout::buildOutputs(const ImageRef &native)
+    {
+        const int node = node_.load(std::memory_order_relaxed);
+        const bool sameInput = native.format == inFormat_ && native.width == inW_ && native.height == inH_ &&
+                               node == builtNode_;
+        inFormat_ = native.format;
+        inW_ = native.width;
+        inH_ = native.height;
+        builtNode_ = node;
+
+        std::vector<std::unique_ptr<Output>> old = std::move(outputs_);
+        std::vector<Route> oldRoutes = std::move(routes_);
+        outputs_.clear();
+        routes_.clear();
+
+        for (const Consumer &c : snapshot_)
+        {
+            const gcap_consumer_desc_t &d = c.desc;
+            auto same = [&](const std::unique_ptr<Output> &o)
+            {
+                return o && o->format == d.format && o->reqW == d.width && o->reqH == d.height && o->filter == d.filter;
+            };
+
+            size_t idx;
+            auto hit = std::find_if(outputs_.begin(), outputs_.end(), same);
+            if (hit != outputs_.end())
+            {
+                idx = (size_t)(hit - outputs_.begin());
+            }
+            else
+            {
+                auto prev = std::find_if(old.begin(), old.end(), same);
+                std::unique_ptr<Output> o;
+                if (prev != old.end() && sameInput)
+                {
+                    o = std::move(*prev); // plan and pool still match
+                }
+                else
+                {
+                    o = std::make_unique<Output>();
+                    o->format = d.format;
+                    o->reqW = d.width;
+                    o->reqH = d.height;
+                    o->filter = d.filter;
+                    o->plan.setNumaNode(node);
+                    o->pool.setNumaNode(node);
+                    o->width = d.width ? d.width : native.width;
+                    o->height = d.height ? d.height : native.height;
+
+                    if (o->format == native.format && o->width == native.width && o->height == native.height)
+                    {
+                        o->usable = true; // delivered straight from the native planes
+                    }
+                    else if (o->plan.build(native.format, native.width, native.height,
+                                           o->format, o->width, o->height, o->filter))
+                    {
+                        const int stride = pixfmt_row_bytes(o->format, 0, o->width);
+                        o->pool.reserve(kBuffersPerOutput, pixfmt_frame_bytes(o->format, o->width, o->height, stride));
+                        o->usable = true;
+                    }
+                    if (log_)
+                        GCAP_LOG(*log_, GCAP_LOG_INFO, "[Fanout] {} {}x{} -> {} {}x{}: {}",
+                                 pixfmt_desc(native.format).name, native.width, native.height,
+                                 pixfmt_desc(o->format).name, o->width, o->height,
+                                 !o->usable        ? std::string("no conversion, consumer gets no frames")
+                                 : o->plan.valid() ? o->plan.describe()
+                                                   : std::string("native planes"));
+                }
+                idx = outputs_.size();
+                outputs_.push_back(std::move(o));
+            }
+
+            Route r{};
+            r.id = c.id;
+            r.cb = d.cb;
+            r.user = d.user;
+            r.output = idx;
+            r.intervalNs = d.max_fps_num > 0 ? (int64_t)(1e9 * d.max_fps_den / d.max_fps_num) : 0;
+            // keep the rate schedule of consumers that were already there
+            for (const Route &o : oldRoutes)
+                if (o.id == c.id)
+                {
+                    r.nextNs = o.nextNs;
+                    r.started = o.started;
+                }
+            routes_.push_back(r);
+        }
+    }
+
+    void FrameFanout::sync(const ImageRef &native)
+    {
+        bool rebuild = native.format != inFormat_ || native.width != inW_ || native.height != inH_ ||
+                       node_.load(std::memory_order_relaxed) != builtNode_;
+        const uint64_t gen = generation_.load(std::memory_order_acquire);
+        if (gen != seenGeneration_)
+        {
+            std::lock_guard<std::mutex> lk(regMutex_);
+            snapshot_ = consumers_;
+            seenGeneration_ = gen;
+            rebuild = true;
+        }
+        if (rebuild)
+            buildOutputs(native);
+    }
+
+    bool FrameFanout::due(Route &r, int64_t ptsNs)
+    {
+        if (r.intervalNs <= 0)
+            return true;
+        // timestamps went backwards (stream restarted): start a new schedule
+        if (r.started && r.nextNs - ptsNs > 2 * r.intervalNs)
+            r.started = false;
+        if (!r.started)
+        {
+            r.started = true;
+            r.nextNs = ptsNs + r.intervalNs;
+            return true;
+        }
+        // half a source period of slack keeps e.g. 60 -> 15 fps on every 4th frame
+        const int64_t slack = srcPeriodNs_ / 2;
+        if (ptsNs + slack < r.nextNs)
+            return false;
+        r.nextNs += r.intervalNs;
+        if (r.nextNs + slack <= ptsNs)
+            r.nextNs = ptsNs + r.intervalNs; // source slower than the cap, or a gap
+        return true;
+    }
+
+    void FrameFanout::process(const ImageRef &native, const gcap_frame_t *primary, uint64_t ptsNs, uint64_t frameId)
+    {
+        if (empty())
+            return;
+        GCAP_TRACE_SCOPE("fanout");
+
+        std::lock_guard<std::mutex> lk(processMutex_);
+        processThread_.store(std::this_thread::get_id());
+        sync(native);
+
+        const int64_t pts = (int64_t)ptsNs;
+        if (lastPtsNs_ >= 0 && pts > lastPtsNs_)
+            srcPeriodNs_ = pts - lastPtsNs_;
+        lastPtsNs_ = pts;
+
+        // rate decisions first: outputs nobody is due for are not produced
+        for (auto &o : outputs_)
+            o->due = false;
+        for (Route &r : routes_)
+        {
+            Output &o = *outputs_[r.output];
+            r.fire = o.usable && due(r, pts);
+            o.due |= r.fire;
+        }
+
+        for (size_t oi = 0; oi < outputs_.size(); ++oi)
+        {
+            Output &o = *outputs_[oi];
+            if (!o.due)
+                continue;
+
+            gcap_frame_t f{};
+            const gcap_frame_t *out = &f;
+            FramePool::Buffer *pb = nullptr;
+            if (o.format == native.format && o.width == native.width && o.height == native.height)
+            {
+                f.format = native.format;
+                f.width = native.width;
+                f.height = native.height;
+                f.plane_count = pixfmt_desc(native.format).planeCount;
+                for (int p = 0; p < f.plane_count; ++p)
+                {
+                    f.data[p] = native.data[p];
+                    f.stride[p] = native.stride[p];
+                }
+                f.pts_ns = ptsNs;
+                f.frame_id = frameId;
+            }
+            else if (primary && primary->format == o.format && primary->width == o.width && primary->height == o.height &&
+                     primary->pts_ns == ptsNs) // a paced primary carries its output-slot time
+            {
+                out = primary; // already converted for the main callback
+            }
+            else
+            {
+                pb = o.pool.acquire();
+                if (!pb)
+                    continue; // consumers still hold every buffer of this output
+                const ImageRef dst = image_from_buffer(o.format, pb->data, pixfmt_row_bytes(o.format, 0, o.width),
+                                                       o.width, o.height);
+                o.plan.run(native, dst);
+                conversions_.fetch_add(1, std::memory_order_relaxed);
+
+                gcap_frame_t &pf = pb->frame;
+                pf.format = o.format;
+                pf.width = o.width;
+                pf.height = o.height;
+                pf.plane_count = pixfmt_desc(o.format).planeCount;
+                for (int p = 0; p < pf.plane_count; ++p)
+                {
+                    pf.data[p] = dst.data[p];
+                    pf.stride[p] = dst.stride[p];
+                }
+                pf.pts_ns = ptsNs;
+                pf.frame_id = frameId;
+                out = &pf;
+            }
+
+            for (const Route &r : routes_)
+                if (r.fire && r.output == oi)
+                    r.cb(out, r.user);
+            if (pb)
+                FramePool::unref(pb);
+        }
+    }
+}
@@ -0,0 +1,121 @@
+// frame_fanout.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gcapture.h"
+#include "convert_plan.h"
+#include "frame_pool.h"
+#include "logger.h"
+#include "pixel_format.h"
+
+namespace gcap
+{
+    /**
+     * @brief Extra video consumers, each with its own format, size and frame rate.
+     *
+     * Consumers are grouped by output (format, size, filter). Per frame,
+     * process() first decides which consumers are due under their rate cap,
+     * then produces each output that has a due consumer exactly once: the
+     * native image or the primary callback's frame when they already match,
+     * otherwise one ConvertPlan run into a pooled buffer. Outputs whose
+     * consumers are all rate-limited out cost nothing.
+     *
+     * add() / remove() publish a new consumer list under a mutex and bump a
+     * generation; the capture thread only takes that mutex when the
+     * generation moved, and rebuilds its outputs then (or when the input
+     * format or size changes). Plans and pools are capture-thread state.
+     */
+    class FrameFanout
+    {
+    public:
+        static constexpr int kBuffersPerOutput = 3;
+
+        explicit FrameFanout(Logger *log = nullptr);
+        ~FrameFanout();
+
+        FrameFanout(const FrameFanout &) = delete;
+        FrameFanout &operator=(const FrameFanout &) = delete;
+
+        // Any thread.
+        gcap_status_t add(const gcap_consumer_desc_t &desc, int &id);
+        gcap_status_t remove(int id);
+        bool empty() const { return count_.load(std::memory_order_relaxed) == 0; }
+        // Any thread: NUMA node for output pools and conversion buffers (-1 =
+        // anywhere); outputs are rebuilt there on the next frame.
+        void setNumaNode(int node) { node_.store(node, std::memory_order_relaxed); }
+
+        // Capture thread. `native` is the captured image (masks applied);
+        // `primary`, if any, is the frame just given to the main callback.
+        void process(const ImageRef &native, const gcap_frame_t *primary, uint64_t ptsNs, uint64_t frameId);
+
+        // Outputs converted (not reused) so far.
+        uint64_t conversions() const { return conversions_.load(std::memory_order_relaxed); }
+
+    private:
+        struct Consumer
+        {
+            int id;
+            gcap_consumer_desc_t desc;
+        };
+
+        struct Output
+        {
+            gcap_pixfmt_t format;
+            int reqW, reqH; // as requested (0 = capture size)
+            gcap_scale_filter_t filter;
+            int width = 0, height = 0; // resolved for the current input
+            ConvertPlan plan;
+            FramePool pool;
+            bool usable = false;
+            bool due = false; // this frame
+        };
+
+        struct Route
+        {
+            int id;
+            gcap_on_video_cb cb;
+            void *user;
+            size_t output;
+            int64_t intervalNs; // 0 = every frame
+            int64_t nextNs = 0;
+            bool started = false;
+            bool fire = false; // due on the current frame
+        };
+
+        void sync(const ImageRef &native);
+        void buildOutputs(const ImageRef &native);
+        bool due(Route &r, int64_t ptsNs);
+
+        Logger *log_; // output plans, when set
+
+        // registration (any thread)
+        std::mutex regMutex_;
+        std::vector<Consumer> consumers_;
+        int nextId_ = 1;
+        std::atomic<uint64_t> generation_{0};
+        std::atomic<int> count_{0};
+        std::atomic<int> node_{-1};
+
+        // held while process() runs, so remove() can wait out an in-flight frame
+        std::mutex processMutex_;
+        std::atomic<std::thread::id> processThread_{};
+
+        // capture thread
+        uint64_t seenGeneration_ = 0;
+        std::vector<Consumer> snapshot_;
+        std::vector<std::unique_ptr<Output>> outputs_;
+        std::vector<Route> routes_;
+        gcap_pixfmt_t inFormat_ = GCAP_FMT_ARGB;
+        int inW_ = 0, inH_ = 0;
+        int builtNode_ = -1; // node_ the current outputs were allocated for
+        int64_t lastPtsNs_ = -1;
+        int64_t srcPeriodNs_ = 0;
+
+        std::atomic<uint64_t> conversions_{0};
+    };
+}
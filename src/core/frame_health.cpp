@@ -0,0 +1,241 @@
+// frame_health.cpp
+#include "frame_health.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    constexpr int kClipHi = 235; // nominal white (limited range, 8-bit)
+    constexpr int kCrushLo = 16; // nominal black
+
+    struct Sums
+    {
+        int64_t lap = 0;   // Σ laplacian
+        int64_t lap2 = 0;  // Σ laplacian²
+        int64_t noise = 0; // Σ |Immerkaer mask|
+        int64_t luma = 0;
+        int64_t hi = 0;
+        int64_t lo = 0;
+    };
+
+    inline int popcount16(unsigned m)
+    {
+        int c = 0;
+        for (; m; m &= m - 1)
+            ++c;
+        return c;
+    }
+
+    // interior samples [j0, j1) of grid row `c` (u = row above, d = row below)
+    void interior_scalar(const uint8_t *u, const uint8_t *c, const uint8_t *d,
+                         int j0, int j1, Sums &s)
+    {
+        for (int j = j0; j < j1; ++j)
+        {
+            const int cross = c[j - 1] + c[j + 1] + u[j] + d[j];
+            const int lap = 4 * c[j] - cross;
+            const int n = 4 * c[j] - 2 * cross + u[j - 1] + u[j + 1] + d[j - 1] + d[j + 1];
+            s.lap += lap;
+            s.lap2 += (int64_t)lap * lap;
+            s.noise += std::abs(n);
+        }
+    }
+
+    void levels_scalar(const uint8_t *row, int j0, int j1, Sums &s)
+    {
+        for (int j = j0; j < j1; ++j)
+        {
+            s.luma += row[j];
+            s.hi += row[j] >= kClipHi;
+            s.lo += row[j] <= kCrushLo;
+        }
+    }
+
+#if defined(GCAP_SIMD_SSE2)
+    inline int64_t hsum_epi32(__m128i v)
+    {
+        alignas(16) int32_t t[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(t), v);
+        return (int64_t)t[0] + t[1] + t[2] + t[3];
+    }
+
+    // 8 samples per step in int16; returns the first column not processed
+    int interior_sse2(const uint8_t *u, const uint8_t *c, const uint8_t *d, int gw, Sums &s)
+    {
+        const __m128i z = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi16(1);
+        __m128i accLap = z, accSq = z, accN = z;
+
+        auto ld = [&](const uint8_t *p)
+        { return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)), z); };
+
+        int j = 1;
+        for (; j + 8 <= gw - 1; j += 8)
+        {
+            const __m128i C4 = _mm_slli_epi16(ld(c + j), 2);
+            const __m128i cross = _mm_add_epi16(_mm_add_epi16(ld(c + j - 1), ld(c + j + 1)),
+                                                _mm_add_epi16(ld(u + j), ld(d + j)));
+            const __m128i diag = _mm_add_epi16(_mm_add_epi16(ld(u + j - 1), ld(u + j + 1)),
+                                               _mm_add_epi16(ld(d + j - 1), ld(d + j + 1)));
+
+            const __m128i lap = _mm_sub_epi16(C4, cross);
+            accLap = _mm_add_epi32(accLap, _mm_madd_epi16(lap, ones));
+            accSq = _mm_add_epi32(accSq, _mm_madd_epi16(lap, lap));
+
+            const __m128i n = _mm_add_epi16(_mm_sub_epi16(C4, _mm_slli_epi16(cross, 1)), diag);
+            const __m128i an = _mm_max_epi16(n, _mm_sub_epi16(z, n));
+            accN = _mm_add_epi32(accN, _mm_madd_epi16(an, ones));
+        }
+
+        // per-row flush keeps the int32 lanes far from overflow (≤ 40 steps of 2.1e6)
+        s.lap += hsum_epi32(accLap);
+        s.lap2 += hsum_epi32(accSq);
+        s.noise += hsum_epi32(accN);
+        return j;
+    }
+
+    int levels_sse2(const uint8_t *row, int gw, Sums &s)
+    {
+        const __m128i z = _mm_setzero_si128();
+        const __m128i hi = _mm_set1_epi8((char)kClipHi);
+        const __m128i lo = _mm_set1_epi8((char)kCrushLo);
+        __m128i accY = z;
+
+        int j = 0;
+        for (; j + 16 <= gw; j += 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + j));
+            accY = _mm_add_epi64(accY, _mm_sad_epu8(v, z));
+            s.hi += popcount16((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, hi), v)));
+            s.lo += popcount16((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, lo), v)));
+        }
+
+        alignas(16) int64_t t[2];
+        _mm_store_si128(reinterpret_cast<__m128i *>(t), accY);
+        s.luma += t[0] + t[1];
+        return j;
+    }
+#endif
+
+    // grid step so that the grid fits in maxN samples
+    inline int grid_step(int n, int maxN) { return std::max(1, (n + maxN - 1) / maxN); }
+}
+
+namespace gcap
+{
+    void FrameHealth::setInterval(int everyNFrames)
+    {
+        interval_.store(everyNFrames > 0 ? everyNFrames : 0, std::memory_order_relaxed);
+    }
+
+    bool FrameHealth::due(uint64_t frameId) const
+    {
+        const int n = interval_.load(std::memory_order_relaxed);
+        return n > 0 && (frameId % (uint64_t)n) == 0;
+    }
+
+    void FrameHealth::update_y8(const uint8_t *y, int w, int h, int stride, int pixelStep, uint64_t frameId)
+    {
+        if (!y || !due(frameId))
+            return;
+        const int sx = grid_step(w, kGridW), sy = grid_step(h, kGridH);
+        const int gw = w / sx, gh = h / sy;
+        grid_.resize((size_t)gw * gh);
+        for (int i = 0; i < gh; ++i)
+        {
+            const uint8_t *src = y + (size_t)i * sy * stride;
+            uint8_t *dst = &grid_[(size_t)i * gw];
+            const int step = sx * pixelStep;
+            for (int j = 0; j < gw; ++j)
+                dst[j] = src[(size_t)j * step];
+        }
+        compute(gw, gh, frameId);
+    }
+
+    void FrameHealth::update_y16(const uint8_t *y, int w, int h, int strideBytes, int pixelStep, uint64_t frameId)
+    {
+        if (!y || !due(frameId))
+            return;
+        const int sx = grid_step(w, kGridW), sy = grid_step(h, kGridH);
+        const int gw = w / sx, gh = h / sy;
+        grid_.resize((size_t)gw * gh);
+        for (int i = 0; i < gh; ++i)
+        {
+            const uint16_t *src = reinterpret_cast<const uint16_t *>(y + (size_t)i * sy * strideBytes);
+            uint8_t *dst = &grid_[(size_t)i * gw];
+            const int step = sx * pixelStep;
+            for (int j = 0; j < gw; ++j)
+                dst[j] = (uint8_t)(src[(size_t)j * step] >> 8);
+        }
+        compute(gw, gh, frameId);
+    }
+
+    void FrameHealth::update_bgra(const uint8_t *bgra, int w, int h, int stride, uint64_t frameId)
+    {
+        if (!bgra || !due(frameId))
+            return;
+        const int sx = grid_step(w, kGridW), sy = grid_step(h, kGridH);
+        const int gw = w / sx, gh = h / sy;
+        grid_.resize((size_t)gw * gh);
+        for (int i = 0; i < gh; ++i)
+        {
+            const uint8_t *src = bgra + (size_t)i * sy * stride;
+            uint8_t *dst = &grid_[(size_t)i * gw];
+            for (int j = 0; j < gw; ++j)
+            {
+                const uint8_t *p = src + (size_t)j * sx * 4;
+                dst[j] = (uint8_t)(((66 * p[2] + 129 * p[1] + 25 * p[0] + 128) >> 8) + 16);
+            }
+        }
+        compute(gw, gh, frameId);
+    }
+
+    void FrameHealth::compute(int gw, int gh, uint64_t frameId)
+    {
+        if (gw < 3 || gh < 3)
+            return;
+
+        Sums s;
+        const uint8_t *g = grid_.data();
+        for (int i = 0; i < gh; ++i)
+        {
+            const uint8_t *row = g + (size_t)i * gw;
+            int j = 0;
+#if defined(GCAP_SIMD_SSE2)
+            j = levels_sse2(row, gw, s);
+#endif
+            levels_scalar(row, j, gw, s);
+
+            if (i == 0 || i == gh - 1)
+                continue;
+            j = 1;
+#if defined(GCAP_SIMD_SSE2)
+            j = interior_sse2(row - gw, row, row + gw, gw, s);
+#endif
+            interior_scalar(row - gw, row, row + gw, j, gw - 1, s);
+        }
+
+        const double nInterior = (double)(gw - 2) * (double)(gh - 2);
+        const double nAll = (double)gw * (double)gh;
+        const double mean = (double)s.lap / nInterior;
+
+        gcap_health_stats_t r{};
+        r.frame_id = frameId;
+        r.focus = (double)s.lap2 / nInterior - mean * mean;
+        r.noise = std::sqrt(3.14159265358979 / 2.0) * (double)s.noise / (6.0 * nInterior);
+        r.clipped_ratio = (double)s.hi / nAll;
+        r.crushed_ratio = (double)s.lo / nAll;
+        r.mean_luma = (double)s.luma / nAll;
+
+        std::lock_guard<std::mutex> lk(mtx_);
+        last_ = r;
+    }
+
+    void FrameHealth::stats(gcap_health_stats_t &out) const
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        out = last_;
+    }
+}
@@ -0,0 +1,50 @@
+// frame_health.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "gcapture.h"
+
+namespace gcap
+{
+    /**
+     * @brief Cheap per-input picture health metrics.
+     *
+     * Luma is gathered onto a small grid (at most kGridW x kGridH samples)
+     * and the metrics are computed on that grid with SSE2 when available:
+     *  - focus : variance of the 4-neighbour Laplacian
+     *  - noise : Immerkaer noise sigma estimate
+     *  - clipped / crushed : share of samples at/above 235, at/below 16
+     *
+     * update_*() runs on the capture thread and only does work every
+     * `interval` frames; stats() may be called from any thread.
+     */
+    class FrameHealth
+    {
+    public:
+        static constexpr int kGridW = 320;
+        static constexpr int kGridH = 180;
+
+        void setInterval(int everyNFrames);
+        bool due(uint64_t frameId) const;
+
+        // 8-bit luma; pixelStep = 1 (planar) or 2 (YUY2)
+        void update_y8(const uint8_t *y, int width, int height, int stride, int pixelStep, uint64_t frameId);
+        // 16-bit container, MSB-aligned (P010/P210: pixelStep = 1, Y210: 2)
+        void update_y16(const uint8_t *y, int width, int height, int strideBytes, int pixelStep, uint64_t frameId);
+        // BGRA (luma derived with the BT.601 limited matrix)
+        void update_bgra(const uint8_t *bgra, int width, int height, int stride, uint64_t frameId);
+
+        void stats(gcap_health_stats_t &out) const;
+
+    private:
+        void compute(int gw, int gh, uint64_t frameId);
+
+        std::atomic<int> interval_{0}; // 0 = disabled
+        std::vector<uint8_t> grid_;
+
+        mutable std::mutex mtx_;
+        gcap_health_stats_t last_{};
+    };
+}
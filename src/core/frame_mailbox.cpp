@@ -0,0 +1,77 @@
+// frame_mailbox.cpp
+#include "frame_mailbox.h"
+#include <chrono>
+
+namespace gcap
+{
+    FrameMailbox::~FrameMailbox()
+    {
+        close();
+    }
+
+    void FrameMailbox::open()
+    {
+        if (FramePool::Buffer *stale = slot_.exchange(nullptr, std::memory_order_acq_rel))
+            FramePool::unref(stale);
+        open_ = true;
+    }
+
+    void FrameMailbox::close()
+    {
+        {
+            std::lock_guard<std::mutex> lk(waitMutex_);
+            open_ = false;
+        }
+        cv_.notify_all();
+        if (FramePool::Buffer *unread = slot_.exchange(nullptr, std::memory_order_acq_rel))
+            FramePool::unref(unread);
+        copies_.clear();
+    }
+
+    void FrameMailbox::post(const gcap_frame_t &f)
+    {
+        if (!active_.load(std::memory_order_relaxed))
+            return;
+
+        FramePool::Buffer *b = copies_.hold(f, kCopies);
+        if (!b)
+            return; // reader holds every copy; it still has a recent frame
+
+        if (FramePool::Buffer *old = slot_.exchange(b, std::memory_order_acq_rel))
+        {
+            FramePool::unref(old);
+            skipped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // taking the mutex orders the store before a waiter's predicate check
+        {
+            std::lock_guard<std::mutex> lk(waitMutex_);
+        }
+        cv_.notify_all();
+    }
+
+    gcap_status_t FrameMailbox::acquire(int timeoutMs, const gcap_frame_t *&out)
+    {
+        out = nullptr;
+        active_.store(true, std::memory_order_relaxed);
+        if (!open_.load(std::memory_order_acquire))
+            return GCAP_ESTATE;
+
+        FramePool::Buffer *b = slot_.exchange(nullptr, std::memory_order_acq_rel);
+        if (!b && timeoutMs != 0)
+        {
+            std::unique_lock<std::mutex> lk(waitMutex_);
+            auto ready = [&]
+            { return !open_.load() || slot_.load(std::memory_order_acquire) != nullptr; };
+            if (timeoutMs < 0)
+                cv_.wait(lk, ready);
+            else
+                cv_.wait_for(lk, std::chrono::milliseconds(timeoutMs), ready);
+            lk.unlock();
+            b = slot_.exchange(nullptr, std::memory_order_acq_rel);
+        }
+        if (!b)
+            return open_.load() ? GCAP_ETIMEOUT : GCAP_ESTATE;
+        out = &b->frame;
+        return GCAP_OK;
+    }
+}
@@ -0,0 +1,67 @@
+// frame_mailbox.h
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include "gcapture.h"
+#include "frame_pool.h"
+
+namespace gcap
+{
+    /**
+     * @brief Latest-frame slot behind gcap_acquire_frame / gcap_release_frame.
+     *
+     * The capture thread swaps each new frame into a single atomic slot and
+     * drops the one it replaces; acquire() swaps it out. A pooled frame moves
+     * by reference, so a pull reader sees the converter's output buffer with
+     * no copy; other frames are copied once into a small private pool.
+     *
+     * acquire() only touches the mutex when the slot is empty and it has to
+     * wait. The mailbox stays idle (post() returns at once) until the first
+     * acquire(), so callback-only users pay nothing.
+     */
+    class FrameMailbox
+    {
+    public:
+        static constexpr int kCopies = 4; // slot + reader + one being filled, plus slack
+
+        FrameMailbox() = default;
+        ~FrameMailbox();
+
+        FrameMailbox(const FrameMailbox &) = delete;
+        FrameMailbox &operator=(const FrameMailbox &) = delete;
+
+        // Streaming started / stopped. close() wakes waiting readers and drops
+        // the unread frame; the capture thread must have stopped posting.
+        void open();
+        void close();
+        // NUMA node for the copy pool (-1 = anywhere); call while closed.
+        void setNumaNode(int node) { copies_.setNumaNode(node); }
+
+        // Capture thread.
+        void post(const gcap_frame_t &f);
+
+        // Newest frame not handed out yet, waiting up to timeoutMs (0 = poll,
+        // < 0 = until one arrives). GCAP_ETIMEOUT when none came, GCAP_ESTATE
+        // when not streaming. The caller releases `out` with FramePool::unref.
+        gcap_status_t acquire(int timeoutMs, const gcap_frame_t *&out);
+
+        // A reader has called acquire() at least once.
+        bool active() const { return active_.load(std::memory_order_relaxed); }
+        // Frames replaced before anyone acquired them.
+        uint64_t skipped() const { return skipped_.load(std::memory_order_relaxed); }
+        // Frame bytes copied for frames that had no pool buffer.
+        uint64_t copiedBytes() const { return copies_.copiedBytes(); }
+
+    private:
+        std::atomic<FramePool::Buffer *> slot_{nullptr};
+        std::atomic<bool> active_{false}; // a reader has shown up
+        std::atomic<bool> open_{false};
+        std::atomic<uint64_t> skipped_{0};
+        FramePool copies_;
+
+        std::mutex waitMutex_;
+        std::condition_variable cv_;
+    };
+}
@@ -0,0 +1,280 @@
+// frame_pacer.cpp
+#include "frame_pacer.h"
+#include "pixel_format.h"
+
+namespace gcap
+{
+    namespace
+    {
+        // slot buffers: a frame's repeats / blends in flight, the held previous
+        // frame, and slack for consumers still holding recent ones
+        constexpr int kCopies = FramePacer::kMaxSlots + 4;
+
+        // dst = a + (dst - a) * w / 256, row by row; 16-bit samples stay MSB-aligned 10-bit
+        void blend_into(FramePool::Buffer *b, const gcap_frame_t &a, int w)
+        {
+            const gcap_frame_t &dst = b->frame;
+            const int iw = 256 - w;
+            const bool wide = pixfmt_desc(dst.format).bitDepth > 8;
+            for (int p = 0; p < dst.plane_count; ++p)
+            {
+                const int rows = pixfmt_plane_rows(dst.format, p, dst.height);
+                const int rowBytes = pixfmt_row_bytes(dst.format, p, dst.width);
+                uint8_t *plane = b->data + (static_cast<const uint8_t *>(dst.data[p]) - b->data);
+                for (int y = 0; y < rows; ++y)
+                {
+                    const uint8_t *s = static_cast<const uint8_t *>(a.data[p]) + (ptrdiff_t)y * a.stride[p];
+                    uint8_t *d = plane + (ptrdiff_t)y * dst.stride[p];
+                    if (wide)
+                    {
+                        const uint16_t *s16 = reinterpret_cast<const uint16_t *>(s);
+                        uint16_t *d16 = reinterpret_cast<uint16_t *>(d);
+                        for (int x = 0; x < rowBytes / 2; ++x)
+                            d16[x] = (uint16_t)(((s16[x] * iw + d16[x] * w + 128) >> 8) & 0xFFC0);
+                    }
+                    else
+                    {
+                        for (int x = 0; x < rowBytes; ++x)
+                            d[x] = (uint8_t)((s[x] * iw + d[x] * w + 128) >> 8);
+                    }
+                }
+            }
+        }
+    }
+
+    FramePacer::~FramePacer()
+    {
+        if (prev_)
+            FramePool::unref(prev_);
+    }
+
+    bool FramePacer::configure(int fpsNum, int fpsDen, bool blend)
+    {
+        if (fpsNum < 0 || (fpsNum > 0 && fpsDen <= 0))
+            return false;
+        num_.store(fpsNum, std::memory_order_relaxed);
+        den_.store(fpsNum > 0 ? fpsDen : 1, std::memory_order_relaxed);
+        blend_.store(blend, std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    bool FramePacer::blendable(gcap_pixfmt_t f)
+    {
+        return pixfmt_valid(f) && f != GCAP_FMT_V210 && f != GCAP_FMT_R210;
+    }
+
+    void FramePacer::reset()
+    {
+        seenGeneration_ = generation_.load(std::memory_order_acquire);
+        curNum_ = num_.load(std::memory_order_relaxed);
+        curDen_ = den_.load(std::memory_order_relaxed);
+        curBlend_ = blend_.load(std::memory_order_relaxed);
+        started_ = false;
+        lastPts_ = -1;
+        periodNs_ = 0;
+        slotCount_ = 0;
+        if (prev_)
+        {
+            FramePool::unref(prev_);
+            prev_ = nullptr;
+        }
+        copies_.clear();
+
+        in_ = 0;
+        out_ = 0;
+        dropped_ = 0;
+        repeated_ = 0;
+        blended_ = 0;
+        skippedSlots_ = 0;
+    }
+
+    int64_t FramePacer::slotTime(int64_t k) const
+    {
+        // exact k * den / num seconds; k < num after rebasing, so nothing overflows
+        const int64_t kd = k * curDen_;
+        return base_ + (kd / curNum_) * 1000000000LL + (kd % curNum_) * 1000000000LL / curNum_;
+    }
+
+    int FramePacer::admit(int64_t ptsNs)
+    {
+        in_.fetch_add(1, std::memory_order_relaxed);
+        slotCount_ = 0;
+
+        const uint64_t gen = generation_.load(std::memory_order_acquire);
+        if (gen != seenGeneration_)
+        {
+            seenGeneration_ = gen;
+            curNum_ = num_.load(std::memory_order_relaxed);
+            curDen_ = den_.load(std::memory_order_relaxed);
+            curBlend_ = blend_.load(std::memory_order_relaxed);
+            started_ = false;
+        }
+        if (curNum_ <= 0)
+        {
+            // turned off since the caller checked active()
+            slots_[slotCount_++] = {ptsNs, 256};
+            return slotCount_;
+        }
+
+        // timestamps went backwards (stream restarted): start a new grid
+        if (started_ && ptsNs <= lastPts_)
+            started_ = false;
+        if (!started_)
+        {
+            started_ = true;
+            base_ = ptsNs;
+            nextIndex_ = 0;
+            lastPts_ = -1;
+            periodNs_ = 0;
+            if (prev_)
+            {
+                FramePool::unref(prev_);
+                prev_ = nullptr;
+            }
+        }
+        else
+        {
+            const int64_t d = ptsNs - lastPts_;
+            if (periodNs_ == 0)
+                periodNs_ = d;
+            else if (d < 4 * periodNs_) // a gap says nothing about the rate
+                periodNs_ += (d - periodNs_) / 8;
+        }
+
+        const int64_t slotNs = slotTime(1) - slotTime(0);
+        // nearest neighbour: slots up to half a source period ahead are this
+        // frame's; blending: slots up to this frame sit between it and the last
+        const bool blend = curBlend_;
+        const int64_t limit = blend ? ptsNs : ptsNs + (periodNs_ ? periodNs_ : slotNs) / 2;
+        const int64_t prevPts = lastPts_;
+        lastPts_ = ptsNs;
+
+        if (limit - slotTime(nextIndex_) > (int64_t)kMaxSlots * slotNs)
+        {
+            // long gap: give up the missed slots and put the grid back here
+            skippedSlots_.fetch_add((uint64_t)((limit - slotTime(nextIndex_)) / slotNs), std::memory_order_relaxed);
+            base_ = ptsNs;
+            nextIndex_ = 0;
+        }
+
+        while (slotTime(nextIndex_) < limit)
+        {
+            const int64_t s = slotTime(nextIndex_);
+            int w = 256;
+            if (blend)
+                w = prevPts >= 0 && ptsNs > prevPts ? (int)((s - prevPts) * 256 / (ptsNs - prevPts)) : 256;
+            slots_[slotCount_++] = {s, w < 0 ? 0 : w};
+            if (++nextIndex_ >= curNum_)
+            {
+                base_ = slotTime(nextIndex_); // rebase once per second of slots
+                nextIndex_ = 0;
+            }
+            if (slotCount_ == kMaxSlots)
+                break;
+        }
+
+        if (slotCount_ == 0 && !blend)
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        return slotCount_;
+    }
+
+    FramePool::Buffer *FramePacer::copyOf(const gcap_frame_t &f, int64_t ptsNs)
+    {
+        gcap_frame_t src = f;
+        src.pool_ref = nullptr; // always a copy: it gets its own pts
+        FramePool::Buffer *b = copies_.hold(src, kCopies);
+        if (b)
+            b->frame.pts_ns = (uint64_t)ptsNs;
+        return b;
+    }
+
+    FramePool::Buffer *FramePacer::blendOf(const gcap_frame_t &a, const gcap_frame_t &b, int weight, int64_t ptsNs)
+    {
+        FramePool::Buffer *d = copyOf(b, ptsNs);
+        if (d)
+            blend_into(d, a, weight);
+        return d;
+    }
+
+    void FramePacer::emit(gcap_frame_t &cur, const Emit &out)
+    {
+        if (!curBlend_ || curNum_ <= 0)
+        {
+            if (slotCount_ == 0)
+                return;
+            // repeats are copied out before the frame's own pts is rewritten
+            FramePool::Buffer *repeats[kMaxSlots] = {};
+            for (int i = 1; i < slotCount_; ++i)
+                repeats[i] = copyOf(cur, slots_[i].ptsNs);
+
+            cur.pts_ns = (uint64_t)slots_[0].ptsNs;
+            out(cur);
+            out_.fetch_add(1, std::memory_order_relaxed);
+            for (int i = 1; i < slotCount_; ++i)
+            {
+                if (!repeats[i])
+                {
+                    skippedSlots_.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                out(repeats[i]->frame);
+                FramePool::unref(repeats[i]);
+                repeated_.fetch_add(1, std::memory_order_relaxed);
+                out_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        const gcap_frame_t *prev = prev_ ? &prev_->frame : nullptr;
+        const bool mixable = prev && prev->format == cur.format && prev->width == cur.width &&
+                             prev->height == cur.height && blendable(cur.format);
+        if (slotCount_ == 0 && prev_ && !prevUsed_)
+            dropped_.fetch_add(1, std::memory_order_relaxed); // the held frame fed no slot
+        for (int i = 0; i < slotCount_; ++i)
+        {
+            const Slot &s = slots_[i];
+            FramePool::Buffer *b = nullptr;
+            bool mixed = false;
+            // within 1/64 of a source frame, the nearer one is as good as a blend
+            if (!prev || s.weight >= 252)
+                b = copyOf(cur, s.ptsNs);
+            else if (s.weight <= 4 || !mixable)
+                b = copyOf(s.weight < 128 || !mixable ? *prev : cur, s.ptsNs);
+            else
+            {
+                b = blendOf(*prev, cur, s.weight, s.ptsNs);
+                mixed = b != nullptr;
+            }
+            if (!b)
+            {
+                skippedSlots_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            out(b->frame);
+            FramePool::unref(b);
+            if (mixed)
+                blended_.fetch_add(1, std::memory_order_relaxed);
+            out_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // keep this frame as the next one's earlier neighbour
+        if (prev_)
+            FramePool::unref(prev_);
+        prev_ = copies_.hold(cur, kCopies);
+        prevUsed_ = slotCount_ > 0;
+    }
+
+    void FramePacer::stats(gcap_pacing_stats_t &out) const
+    {
+        out.fps_num = num_.load(std::memory_order_relaxed);
+        out.fps_den = den_.load(std::memory_order_relaxed);
+        out.blend = blend_.load(std::memory_order_relaxed) ? 1 : 0;
+        out.frames_in = in_.load(std::memory_order_relaxed);
+        out.frames_out = out_.load(std::memory_order_relaxed);
+        out.dropped = dropped_.load(std::memory_order_relaxed);
+        out.duplicated = repeated_.load(std::memory_order_relaxed);
+        out.blended = blended_.load(std::memory_order_relaxed);
+        out.skipped = skippedSlots_.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,109 @@
+// frame_pacer.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "gcapture.h"
+#include "frame_pool.h"
+
+namespace gcap
+{
+    /**
+     * @brief Converts the delivered frame rate to a fixed target, driven by PTS.
+     *
+     * Output slots lie on an exact rational grid (slot k = t0 + k * den / num
+     * seconds, rebased now and then so the products never overflow). admit()
+     * runs before conversion and says how many slots the incoming frame
+     * fills:
+     *  - nearest neighbour: the slots within half an input period of its
+     *    PTS; 0 means the frame is dropped and never converted, > 1 means it
+     *    is repeated;
+     *  - blending: the slots between the previous frame and this one, each a
+     *    mix of the two weighted by where the slot falls (one frame of
+     *    latency; every frame is converted since each may be a neighbour).
+     *
+     * Emitted frames carry the slot time as pts_ns and the source frame_id.
+     * The first emission of a frame is the frame itself; repeats and blends
+     * are written into the pacer's own pool so each keeps its own pts.
+     * Blending needs 8- or 16-bit samples; V210 / R210 fall back to nearest.
+     *
+     * configure() may be called from any thread; the capture thread picks
+     * the new target up on its next admit() and restarts the grid there.
+     */
+    class FramePacer
+    {
+    public:
+        static constexpr int kMaxSlots = 8; // repeats per frame; longer gaps skip slots
+        using Emit = std::function<void(const gcap_frame_t &)>;
+
+        FramePacer() = default;
+        ~FramePacer();
+
+        FramePacer(const FramePacer &) = delete;
+        FramePacer &operator=(const FramePacer &) = delete;
+
+        // fpsNum = 0 turns pacing off (frames pass through untouched).
+        bool configure(int fpsNum, int fpsDen, bool blend);
+        bool active() const { return num_.load(std::memory_order_relaxed) > 0; }
+
+        // Capture thread: forget the grid and any held frame (new stream).
+        void reset();
+        // NUMA node for repeats, blends and the held frame (-1 = anywhere);
+        // like reset(), not while the capture thread runs.
+        void setNumaNode(int node) { copies_.setNumaNode(node); }
+
+        // Capture thread, before conversion: output slots this frame fills.
+        int admit(int64_t ptsNs);
+        // Capture thread, after admit(): blending holds every frame as the
+        // next one's neighbour, so it must reach emit() even with no slots.
+        bool keepsFrames() const { return curBlend_ && curNum_ > 0; }
+        // Capture thread: deliver the slots admit() assigned, `cur` being the
+        // converted frame (may be modified: its pts becomes the first slot).
+        void emit(gcap_frame_t &cur, const Emit &out);
+
+        void stats(gcap_pacing_stats_t &out) const;
+        // Frame bytes copied for repeats, blends and the held frame.
+        uint64_t copiedBytes() const { return copies_.copiedBytes(); }
+
+        static bool blendable(gcap_pixfmt_t f);
+
+    private:
+        struct Slot
+        {
+            int64_t ptsNs;
+            int weight; // 0..256 toward the current frame (blending only)
+        };
+
+        int64_t slotTime(int64_t k) const;
+        FramePool::Buffer *copyOf(const gcap_frame_t &f, int64_t ptsNs);
+        FramePool::Buffer *blendOf(const gcap_frame_t &a, const gcap_frame_t &b, int weight, int64_t ptsNs);
+
+        // configured (any thread)
+        std::atomic<int> num_{0};
+        std::atomic<int> den_{1};
+        std::atomic<bool> blend_{false};
+        std::atomic<uint64_t> generation_{0};
+
+        // capture thread
+        uint64_t seenGeneration_ = 0;
+        int curNum_ = 0, curDen_ = 1;
+        bool curBlend_ = false;
+        bool started_ = false;
+        int64_t base_ = 0;      // t0 of the grid
+        int64_t nextIndex_ = 0; // next unassigned slot
+        int64_t lastPts_ = -1;
+        int64_t periodNs_ = 0; // smoothed input period
+        Slot slots_[kMaxSlots];
+        int slotCount_ = 0;
+        FramePool::Buffer *prev_ = nullptr; // blending: the previous frame
+        bool prevUsed_ = false;             // ... and whether it fed a slot yet
+        FramePool copies_;
+
+        std::atomic<uint64_t> in_{0};
+        std::atomic<uint64_t> out_{0};
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<uint64_t> repeated_{0};
+        std::atomic<uint64_t> blended_{0};
+        std::atomic<uint64_t> skippedSlots_{0};
+    };
+}
@@ -0,0 +1,219 @@
+// frame_pool.cpp
+#include "frame_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include "pixel_format.h"
+#include "thread_tuning.h"
+
+namespace gcap
+{
+    namespace
+    {
+        constexpr size_t align_up(size_t v, size_t a) { return (v + a - 1) / a * a; }
+        // Buffer header, padded so the pixels start on a kAlign boundary
+        constexpr size_t kHeaderBytes = align_up(sizeof(FramePool::Buffer), FramePool::kAlign);
+    }
+
+    FramePool::~FramePool()
+    {
+        clear();
+    }
+
+    FramePool::Buffer *FramePool::allocate(size_t bytes, int node)
+    {
+        // header and pixels in one aligned block (NUMA blocks are page-aligned)
+        void *block = node >= 0 ? numa_alloc(kHeaderBytes + bytes, node)
+                                : ::operator new(kHeaderBytes + bytes, std::align_val_t(kAlign), std::nothrow);
+        if (!block)
+            return nullptr;
+        Buffer *b = new (block) Buffer();
+        b->data = static_cast<uint8_t *>(block) + kHeaderBytes;
+        b->capacity = bytes;
+        b->node = node;
+        return b;
+    }
+
+    void FramePool::destroy(Buffer *b)
+    {
+        const int node = b->node;
+        const size_t bytes = kHeaderBytes + b->capacity;
+        b->~Buffer();
+        if (node >= 0)
+            numa_free(b, bytes);
+        else
+            ::operator delete(static_cast<void *>(b), std::align_val_t(kAlign));
+    }
+
+    void FramePool::ref(Buffer *b)
+    {
+        b->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void FramePool::unref(Buffer *b)
+    {
+        if (b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            destroy(b);
+    }
+
+    void FramePool::reserve(int count, size_t bytes)
+    {
+        count = std::clamp(count, 1, kMaxCount);
+        bytes = align_up(std::max<size_t>(bytes, 1), kAlign);
+
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (bytes > bytes_)
+        {
+            // never shrink; held buffers are freed by their last unref
+            for (Buffer *b : buffers_)
+                unref(b);
+            buffers_.clear();
+            bytes_ = bytes;
+        }
+        while ((int)buffers_.size() > count)
+        {
+            unref(buffers_.back());
+            buffers_.pop_back();
+        }
+        while ((int)buffers_.size() < count)
+        {
+            Buffer *b = allocate(bytes_, node_);
+            if (!b)
+                break;
+            buffers_.push_back(b);
+        }
+        next_ = 0;
+    }
+
+    void FramePool::clear()
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        for (Buffer *b : buffers_)
+            unref(b);
+        buffers_.clear();
+        bytes_ = 0;
+        next_ = 0;
+    }
+
+    void FramePool::setNumaNode(int node)
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (node == node_)
+            return;
+        node_ = node;
+        for (Buffer *b : buffers_)
+            unref(b);
+        buffers_.clear();
+        bytes_ = 0;
+        next_ = 0;
+    }
+
+    FramePool::Buffer *FramePool::acquire()
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        const size_t n = buffers_.size();
+        for (size_t i = 0; i < n; ++i)
+        {
+            Buffer *b = buffers_[(next_ + i) % n];
+            // refs == 1: only the pool holds it. Nobody else can raise it from
+            // 1 (ref() needs a held reference), so the exchange cannot race.
+            int expected = 1;
+            if (b->refs.compare_exchange_strong(expected, 2, std::memory_order_acquire))
+            {
+                next_ = (next_ + i + 1) % n;
+                b->frame = {};
+                b->frame.pool_ref = b;
+                return b;
+            }
+        }
+        exhausted_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    FramePool::Buffer *FramePool::hold(const gcap_frame_t &f, int count)
+    {
+        if (f.pool_ref)
+        {
+            auto *b = static_cast<Buffer *>(f.pool_ref);
+            ref(b);
+            return b;
+        }
+
+        // reserve() only allocates when the frame size or count changed
+        const size_t bytes = copyBytes(f);
+        if (bytes == 0)
+            return nullptr;
+        if (bufferBytes() < bytes || this->count() != count)
+            reserve(count, bytes);
+        Buffer *b = acquire();
+        if (b && !copyInto(b, f))
+        {
+            unref(b);
+            b = nullptr;
+        }
+        if (b)
+            copied_.fetch_add(bytes, std::memory_order_relaxed);
+        return b;
+    }
+
+    int FramePool::count() const
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        return (int)buffers_.size();
+    }
+
+    size_t FramePool::bufferBytes() const
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        return bytes_;
+    }
+
+    size_t FramePool::copyBytes(const gcap_frame_t &f)
+    {
+        if (!pixfmt_valid(f.format) || f.width <= 0 || f.height <= 0 ||
+            f.plane_count != pixfmt_desc(f.format).planeCount)
+            return 0;
+        // aligned rows: each plane starts on a kAlign boundary too
+        size_t total = 0;
+        for (int i = 0; i < f.plane_count; ++i)
+            total += align_up((size_t)pixfmt_row_bytes(f.format, i, f.width), kAlign) *
+                     (size_t)pixfmt_plane_rows(f.format, i, f.height);
+        return total;
+    }
+
+    bool FramePool::copyInto(Buffer *b, const gcap_frame_t &f)
+    {
+        const size_t need = copyBytes(f);
+        if (need == 0 || need > b->capacity)
+            return false;
+
+        b->frame = f;
+        b->frame.pool_ref = b;
+        uint8_t *dst = b->data;
+        for (int i = 0; i < f.plane_count; ++i)
+        {
+            const int rows = pixfmt_plane_rows(f.format, i, f.height);
+            const size_t rowBytes = (size_t)pixfmt_row_bytes(f.format, i, f.width);
+            const size_t stride = align_up(rowBytes, kAlign);
+            const uint8_t *src = static_cast<const uint8_t *>(f.data[i]);
+            for (int y = 0; y < rows; ++y)
+                memcpy(dst + (size_t)y * stride, src + (ptrdiff_t)y * f.stride[i], rowBytes);
+            b->frame.data[i] = dst;
+            b->frame.stride[i] = (int)stride;
+            dst += stride * rows;
+        }
+        return true;
+    }
+
+    FramePool::Buffer *FramePool::copy(const gcap_frame_t &f)
+    {
+        const size_t bytes = copyBytes(f);
+        if (bytes == 0)
+            return nullptr;
+        Buffer *b = allocate(bytes);
+        if (!b)
+            return nullptr;
+        copyInto(b, f);
+        return b;
+    }
+}
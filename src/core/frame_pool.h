@@ -0,0 +1,98 @@
+// frame_pool.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "gcapture.h"
+
+namespace gcap
+{
+    /**
+     * @brief Preallocated, reference-counted frame buffers.
+     *
+     * Each buffer is one 64-byte-aligned allocation carrying its own
+     * gcap_frame_t (frame.pool_ref points back at the buffer), so a consumer
+     * keeps a delivered frame with gcap_frame_ref() and no copy.
+     *
+     * The pool itself holds one reference to every buffer: a buffer is free
+     * when that is the only one left. reserve() and the destructor drop the
+     * pool's reference, so buffers still held by consumers outlive a format
+     * change or gcap_close() and are freed by their last unref.
+     *
+     * acquire() runs on the capture thread and never allocates; when
+     * consumers hold every buffer it returns nullptr and the frame is
+     * skipped (counted in exhausted()).
+     */
+    class FramePool
+    {
+    public:
+        static constexpr size_t kAlign = 64;
+        static constexpr int kDefaultCount = 4;
+        static constexpr int kMaxCount = 64;
+
+        struct Buffer
+        {
+            std::atomic<int> refs{1};
+            uint8_t *data = nullptr; // kAlign-aligned
+            size_t capacity = 0;
+            int node = -1; // NUMA node the block was allocated on (-1: operator new)
+            gcap_frame_t frame{};
+        };
+
+        FramePool() = default;
+        ~FramePool();
+
+        FramePool(const FramePool &) = delete;
+        FramePool &operator=(const FramePool &) = delete;
+
+        // Keep `count` buffers of at least `bytes` (rounded up to kAlign).
+        // Free buffers that are too small are replaced; allocation happens
+        // here only, never in acquire().
+        void reserve(int count, size_t bytes);
+        // Drop the pool's reference to every buffer.
+        void clear();
+        // Allocate future buffers on this NUMA node (-1 = anywhere); a change
+        // drops the free buffers so the next reserve() allocates them there.
+        void setNumaNode(int node);
+
+        // A free buffer holding one reference for the caller (release with
+        // unref()), or nullptr when consumers hold them all.
+        Buffer *acquire();
+
+        // A reference the caller owns: f's own buffer when it is pooled, else a
+        // copy in a buffer of this pool, resized to `count` buffers when the
+        // frame size grows. nullptr when no buffer is free.
+        Buffer *hold(const gcap_frame_t &f, int count);
+
+        int count() const;
+        size_t bufferBytes() const;
+        uint64_t exhausted() const { return exhausted_.load(std::memory_order_relaxed); }
+        // Frame bytes hold() deep-copied into this pool so far.
+        uint64_t copiedBytes() const { return copied_.load(std::memory_order_relaxed); }
+
+        // Any thread. ref() requires a reference already held.
+        static void ref(Buffer *b);
+        static void unref(Buffer *b);
+        // Standalone buffer (one reference) holding a deep copy of `f`, for
+        // frames that do not come from a pool. nullptr on allocation failure.
+        static Buffer *copy(const gcap_frame_t &f);
+        // Bytes copyInto() needs for `f` (0 = not a valid frame), and the deep
+        // copy itself into a buffer the caller holds; false if it does not fit.
+        static size_t copyBytes(const gcap_frame_t &f);
+        static bool copyInto(Buffer *b, const gcap_frame_t &f);
+
+    private:
+        static Buffer *allocate(size_t bytes, int node = -1);
+        static void destroy(Buffer *b);
+
+        mutable std::mutex mutex_; // buffers_ / bytes_; not held across callbacks
+        std::vector<Buffer *> buffers_;
+        size_t bytes_ = 0;
+        size_t next_ = 0; // round-robin start for acquire()
+        int node_ = -1;
+        std::atomic<uint64_t> exhausted_{0};
+        std::atomic<uint64_t> copied_{0};
+    };
+}
@@ -0,0 +1,129 @@
+// latency_histogram.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "gcapture.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace gcap
+{
+    /**
+     * @brief Log-linear latency histogram (HDR-style) with a single writer.
+     *
+     * Values in ns land in buckets of 8 linear steps per power of two, so
+     * any percentile is known to within 12.5% from 0 ns up to ~18 minutes
+     * (larger values clamp). 312 counters, nothing allocated.
+     *
+     * record() belongs to one thread (the stage's own) and uses relaxed
+     * load + store rather than read-modify-write, so it costs a few plain
+     * moves. snapshot() may run on any thread; it sees each counter whole
+     * but not all of them at the same instant, which is fine for stats.
+     */
+    class LatencyHistogram
+    {
+    public:
+        static constexpr int kSubBits = 3;
+        static constexpr int kSub = 1 << kSubBits;
+        static constexpr int kMaxBit = 40;
+        static constexpr int kBuckets = (kMaxBit - kSubBits + 2) * kSub;
+
+        static uint64_t nowNs()
+        {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        // Writer thread.
+        void record(uint64_t ns)
+        {
+            bump(buckets_[index(ns)], 1);
+            bump(sum_, ns);
+            if (ns > max_.load(std::memory_order_relaxed))
+                max_.store(ns, std::memory_order_relaxed);
+        }
+
+        // Writer thread, or while no one records.
+        void reset()
+        {
+            for (auto &b : buckets_)
+                b.store(0, std::memory_order_relaxed);
+            sum_.store(0, std::memory_order_relaxed);
+            max_.store(0, std::memory_order_relaxed);
+        }
+
+        void snapshot(gcap_latency_t &out) const
+        {
+            uint64_t counts[kBuckets];
+            uint64_t total = 0;
+            for (int i = 0; i < kBuckets; ++i)
+                total += counts[i] = buckets_[i].load(std::memory_order_relaxed);
+
+            out = {};
+            out.count = total;
+            if (!total)
+                return;
+            out.mean_ns = sum_.load(std::memory_order_relaxed) / total;
+            out.max_ns = max_.load(std::memory_order_relaxed);
+
+            // highest value of the bucket holding each rank, capped at the max seen
+            const uint64_t ranks[4] = {(total * 500 + 999) / 1000, (total * 900 + 999) / 1000,
+                                       (total * 990 + 999) / 1000, (total * 999 + 999) / 1000};
+            uint64_t *dst[4] = {&out.p50_ns, &out.p90_ns, &out.p99_ns, &out.p999_ns};
+            uint64_t seen = 0;
+            int r = 0;
+            for (int i = 0; i < kBuckets && r < 4; ++i)
+            {
+                seen += counts[i];
+                while (r < 4 && seen >= ranks[r] && ranks[r] > 0)
+                {
+                    const uint64_t hi = upper(i);
+                    *dst[r++] = hi < out.max_ns ? hi : out.max_ns;
+                }
+            }
+        }
+
+    private:
+        static void bump(std::atomic<uint64_t> &a, uint64_t v)
+        {
+            a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+        }
+
+        static int msb(uint64_t v)
+        {
+#if defined(_MSC_VER)
+            unsigned long i;
+            _BitScanReverse64(&i, v);
+            return (int)i;
+#else
+            return 63 - __builtin_clzll(v);
+#endif
+        }
+
+        static int index(uint64_t v)
+        {
+            if (v < (uint64_t)kSub)
+                return (int)v;
+            if (v >> (kMaxBit + 1))
+                return kBuckets - 1;
+            const int m = msb(v);
+            return (m - kSubBits + 1) * kSub + (int)((v >> (m - kSubBits)) & (kSub - 1));
+        }
+
+        static uint64_t upper(int i)
+        {
+            if (i < kSub)
+                return (uint64_t)i;
+            const int shift = i / kSub - 1;
+            const uint64_t lo = (uint64_t)(kSub + i % kSub) << shift;
+            return lo + ((uint64_t)1 << shift) - 1;
+        }
+
+        std::atomic<uint64_t> buckets_[kBuckets] = {};
+        std::atomic<uint64_t> sum_{0};
+        std::atomic<uint64_t> max_{0};
+    };
+}
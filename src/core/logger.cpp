@@ -0,0 +1,202 @@
+// logger.cpp
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace gcap
+{
+    bool LogSite::admit(uint32_t &suppressedOut)
+    {
+        const uint64_t now = Logger::nowNs();
+        uint64_t start = windowStart.load(std::memory_order_relaxed);
+        if (now - start >= kWindowNs && windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+            inWindow.store(0, std::memory_order_relaxed);
+        if (inWindow.fetch_add(1, std::memory_order_relaxed) >= kBurst)
+        {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        suppressedOut = suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Logger::Record::addText(Arg &a, const char *s, size_t n)
+    {
+        a.type = Arg::Text;
+        n = std::min(n, kTextBytes - textUsed);
+        std::memcpy(text + textUsed, s, n);
+        a.text.offset = textUsed;
+        a.text.length = (uint16_t)n;
+        textUsed = (uint16_t)(textUsed + n);
+    }
+
+    Logger::~Logger()
+    {
+        stop();
+    }
+
+    uint64_t Logger::nowNs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    uint32_t Logger::threadId()
+    {
+        thread_local uint32_t id = 0;
+        if (!id)
+        {
+#ifdef _WIN32
+            id = (uint32_t)GetCurrentThreadId();
+#else
+            id = (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id()) | 1u;
+#endif
+        }
+        return id;
+    }
+
+    void Logger::setSink(Sink sink, gcap_log_level_t minLevel)
+    {
+        const bool on = (bool)sink;
+        {
+            std::lock_guard<std::mutex> lk(sinkMutex_);
+            sink_ = std::move(sink);
+        }
+        minLevel_.store(on ? minLevel : GCAP_LOG_DEBUG, std::memory_order_relaxed);
+        if (on && !thread_.joinable())
+        {
+            stop_ = false;
+            thread_ = std::thread(&Logger::run, this);
+        }
+        cv_.notify_one(); // deliver what waited for a sink
+    }
+
+    void Logger::stop()
+    {
+        if (!thread_.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lk(waitMutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    void Logger::push(const Record &r)
+    {
+        if (!queue_.tryPush(r))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // no lock: a wakeup lost to the race is picked up by the timed wait
+        cv_.notify_one();
+    }
+
+    void Logger::run()
+    {
+        for (;;)
+        {
+            drain();
+            std::unique_lock<std::mutex> lk(waitMutex_);
+            if (stop_)
+                break;
+            cv_.wait_for(lk, std::chrono::milliseconds(100));
+        }
+        drain();
+    }
+
+    void Logger::drain()
+    {
+        std::lock_guard<std::mutex> lk(sinkMutex_);
+        if (!sink_)
+            return;
+        char msg[1024];
+        Record r;
+        while (queue_.tryPop(r))
+        {
+            if (const uint64_t lost = dropped_.exchange(0, std::memory_order_relaxed))
+            {
+                std::snprintf(msg, sizeof(msg), "[Log] queue full: %" PRIu64 " messages dropped", lost);
+                gcap_log_record_t d{};
+                d.level = GCAP_LOG_WARN;
+                d.time_ns = r.timeNs;
+                d.thread_id = r.threadId;
+                d.message = msg;
+                d.file = __FILE__;
+                d.line = __LINE__;
+                sink_(d);
+            }
+            if (r.level < minLevel_.load(std::memory_order_relaxed))
+                continue; // recorded before the sink asked for less
+            format(r, msg, sizeof(msg));
+            gcap_log_record_t out{};
+            out.level = r.level;
+            out.time_ns = r.timeNs;
+            out.thread_id = r.threadId;
+            out.suppressed = r.suppressed;
+            out.file = r.file;
+            out.line = r.line;
+            out.message = msg;
+            sink_(out);
+        }
+    }
+
+    void Logger::format(const Record &r, char *out, size_t size)
+    {
+        if (!size)
+            return;
+        size_t n = 0;
+        auto put = [&](const char *s, size_t len)
+        {
+            len = std::min(len, size - 1 - n);
+            std::memcpy(out + n, s, len);
+            n += len;
+        };
+        int next = 0;
+        for (const char *p = r.fmt; *p && n + 1 < size; ++p)
+        {
+            if (p[0] != '{' || p[1] != '}' || next >= r.argCount)
+            {
+                out[n++] = *p;
+                continue;
+            }
+            ++p;
+            const Record::Arg &a = r.args[next++];
+            char num[32];
+            int len = 0;
+            switch (a.type)
+            {
+            case Record::Arg::Int:
+                len = std::snprintf(num, sizeof(num), "%" PRId64, a.i);
+                break;
+            case Record::Arg::UInt:
+                len = std::snprintf(num, sizeof(num), "%" PRIu64, a.u);
+                break;
+            case Record::Arg::Hex:
+                len = std::snprintf(num, sizeof(num), "0x%" PRIX64, a.u);
+                break;
+            case Record::Arg::Double:
+                len = std::snprintf(num, sizeof(num), "%g", a.d);
+                break;
+            case Record::Arg::Text:
+                put(r.text + a.text.offset, a.text.length);
+                continue;
+            }
+            if (len > 0)
+                put(num, std::min((size_t)len, sizeof(num) - 1));
+        }
+        out[n] = '\0';
+    }
+}
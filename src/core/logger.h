@@ -0,0 +1,225 @@
+// logger.h
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include "gcapture.h"
+#include "mpmc_queue.h"
+
+namespace gcap
+{
+    // Argument printed as 0x%X (HRESULTs, flags).
+    struct LogHex
+    {
+        uint64_t value;
+    };
+
+    /**
+     * @brief Per call-site rate limit; declared static by GCAP_LOG.
+     *
+     * At most kBurst messages per kWindowNs from one site (process-wide, so
+     * a site shared by several handles shares the budget); the next message
+     * admitted carries how many were suppressed in between. Races between
+     * threads only blur the window edge.
+     */
+    struct LogSite
+    {
+        static constexpr uint32_t kBurst = 10;
+        static constexpr uint64_t kWindowNs = 1000000000;
+
+        const char *file;
+        int line;
+        std::atomic<uint64_t> windowStart{0};
+        std::atomic<uint32_t> inWindow{0};
+        std::atomic<uint32_t> suppressed{0};
+
+        constexpr LogSite(const char *f, int l) : file(f), line(l) {}
+
+        bool admit(uint32_t &suppressedOut);
+    };
+
+    /**
+     * @brief Structured log of one capture handle, formatted off the caller's thread.
+     *
+     * GCAP_LOG() captures a string-literal format, up to kMaxArgs typed
+     * arguments and a timestamp into a fixed-size record, and pushes it to a
+     * preallocated lock-free queue: no allocation, no lock, no formatting on
+     * the logging thread. Strings are copied into the record (truncated to
+     * what is left of kTextBytes). "{}" in the format stands for the next
+     * argument; formatting happens on the logger's own thread, which hands
+     * each message to the sink.
+     *
+     * Until a sink is set records wait in the queue, so messages from open()
+     * reach a callback registered afterwards. A full queue drops the new
+     * record; the count is reported by the next message delivered.
+     *
+     * setSink() and stop() are for the owning thread and must not be called
+     * from the sink. Once setSink() returns the previous sink is not running.
+     */
+    class Logger
+    {
+    public:
+        using Sink = std::function<void(const gcap_log_record_t &)>;
+
+        static constexpr size_t kCapacity = 256;
+        static constexpr int kMaxArgs = 8;
+        static constexpr size_t kTextBytes = 256;
+
+        struct Record
+        {
+            struct Arg
+            {
+                enum Type : uint8_t
+                {
+                    Int,
+                    UInt,
+                    Hex,
+                    Double,
+                    Text
+                } type;
+                union
+                {
+                    int64_t i;
+                    uint64_t u;
+                    double d;
+                    struct
+                    {
+                        uint16_t offset, length;
+                    } text;
+                };
+            };
+
+            const char *fmt;
+            const char *file;
+            int line;
+            gcap_log_level_t level;
+            uint64_t timeNs;
+            uint32_t threadId;
+            uint32_t suppressed;
+            uint16_t textUsed;
+            uint8_t argCount;
+            Arg args[kMaxArgs];
+            char text[kTextBytes];
+
+            template <typename T>
+            void add(const T &v);
+            void addText(Arg &a, const char *s, size_t n);
+        };
+
+        Logger() = default;
+        ~Logger();
+
+        Logger(const Logger &) = delete;
+        Logger &operator=(const Logger &) = delete;
+
+        // Messages below minLevel are not recorded. An empty sink keeps
+        // records queued (and records everything) until the next sink.
+        void setSink(Sink sink, gcap_log_level_t minLevel);
+        // Deliver what is queued (when there is a sink) and join the thread.
+        void stop();
+
+        bool enabled(gcap_log_level_t level) const { return level >= minLevel_.load(std::memory_order_relaxed); }
+
+        template <typename... Args>
+        void log(const LogSite &site, uint32_t suppressed, gcap_log_level_t level, const char *fmt, const Args &...args)
+        {
+            static_assert(sizeof...(Args) <= kMaxArgs, "too many log arguments");
+            Record r;
+            r.fmt = fmt;
+            r.file = site.file;
+            r.line = site.line;
+            r.level = level;
+            r.timeNs = nowNs();
+            r.threadId = threadId();
+            r.suppressed = suppressed;
+            r.textUsed = 0;
+            r.argCount = 0;
+            (r.add(args), ...);
+            push(r);
+        }
+
+        static uint64_t nowNs();
+        static uint32_t threadId();
+        // "{}" expanded with the record's arguments; always NUL-terminated.
+        static void format(const Record &r, char *out, size_t size);
+
+    private:
+        void push(const Record &r);
+        void run();
+        void drain();
+
+        MpmcQueue<Record> queue_{kCapacity};
+        std::atomic<int> minLevel_{GCAP_LOG_DEBUG};
+        std::atomic<uint64_t> dropped_{0};
+
+        std::mutex sinkMutex_; // held while the sink runs
+        Sink sink_;
+        std::thread thread_;
+        std::mutex waitMutex_; // sleeping only
+        std::condition_variable cv_;
+        std::atomic<bool> stop_{false};
+    };
+
+    template <typename T>
+    void Logger::Record::add(const T &v)
+    {
+        Arg &a = args[argCount++];
+        if constexpr (std::is_same_v<T, LogHex>)
+        {
+            a.type = Arg::Hex;
+            a.u = v.value;
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            a.type = Arg::Int;
+            a.i = v ? 1 : 0;
+        }
+        else if constexpr (std::is_enum_v<T>)
+        {
+            a.type = Arg::Int;
+            a.i = (int64_t)v;
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+        {
+            a.type = Arg::Int;
+            a.i = (int64_t)v;
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            a.type = Arg::UInt;
+            a.u = (uint64_t)v;
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            a.type = Arg::Double;
+            a.d = (double)v;
+        }
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+            addText(a, v.data(), v.size());
+        }
+        else
+        {
+            static_assert(std::is_convertible_v<const T &, const char *>, "unsupported log argument type");
+            const char *s = v;
+            addText(a, s ? s : "(null)", s ? std::strlen(s) : 6);
+        }
+    }
+}
+
+// GCAP_LOG(logger, level, "format with {}", args...): arguments are only
+// evaluated when the level is enabled and the call site is within its rate.
+#define GCAP_LOG(logger, level, ...)                                                   \
+    do                                                                                 \
+    {                                                                                  \
+        static ::gcap::LogSite gcapLogSite_{__FILE__, __LINE__};                       \
+        uint32_t gcapLogSuppressed_ = 0;                                               \
+        if ((logger).enabled(level) && gcapLogSite_.admit(gcapLogSuppressed_))         \
+            (logger).log(gcapLogSite_, gcapLogSuppressed_, level, __VA_ARGS__);        \
+    } while (0)
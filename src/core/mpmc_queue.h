@@ -0,0 +1,110 @@
+// mpmc_queue.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace gcap
+{
+    /**
+     * @brief Bounded lock-free multi-producer / multi-consumer queue.
+     *
+     * Vyukov's array queue: every cell carries a sequence number that tells
+     * producers and consumers whose turn it is, so both sides claim a slot
+     * with one CAS on their own cursor and never wait for each other. The
+     * capacity is exact and nothing is allocated after construction.
+     *
+     * Sequences count in half-steps (2 * position, +1 once filled) so a
+     * filled cell never looks free to the next lap; that keeps capacity 1
+     * (a mailbox) valid, which the textbook form does not allow.
+     *
+     * Several consumers are needed even with one capture thread: a
+     * drop-oldest producer pops from the head itself when the queue is full.
+     */
+    template <typename T>
+    class MpmcQueue
+    {
+    public:
+        explicit MpmcQueue(size_t capacity)
+            : capacity_(capacity ? capacity : 1), cells_(new Cell[capacity_])
+        {
+            for (size_t i = 0; i < capacity_; ++i)
+                cells_[i].seq.store(2 * i, std::memory_order_relaxed);
+        }
+
+        MpmcQueue(const MpmcQueue &) = delete;
+        MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+        // false when full
+        bool tryPush(const T &v)
+        {
+            size_t pos = tail_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell &c = cells_[pos % capacity_];
+                const size_t seq = c.seq.load(std::memory_order_acquire);
+                const intptr_t dif = (intptr_t)seq - (intptr_t)(2 * pos);
+                if (dif == 0)
+                {
+                    if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        c.value = v;
+                        c.seq.store(2 * pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (dif < 0)
+                    return false;
+                else
+                    pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+
+        // false when empty
+        bool tryPop(T &out)
+        {
+            size_t pos = head_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell &c = cells_[pos % capacity_];
+                const size_t seq = c.seq.load(std::memory_order_acquire);
+                const intptr_t dif = (intptr_t)seq - (intptr_t)(2 * pos + 1);
+                if (dif == 0)
+                {
+                    if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        out = c.value;
+                        c.seq.store(2 * (pos + capacity_), std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (dif < 0)
+                    return false;
+                else
+                    pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Snapshot; may include a push or pop still in progress.
+        size_t size() const
+        {
+            const size_t tail = tail_.load(std::memory_order_acquire);
+            const size_t head = head_.load(std::memory_order_acquire);
+            return tail > head ? tail - head : 0;
+        }
+        size_t capacity() const { return capacity_; }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> seq;
+            T value{};
+        };
+
+        const size_t capacity_;
+        std::unique_ptr<Cell[]> cells_;
+        alignas(64) std::atomic<size_t> tail_{0}; // producers
+        alignas(64) std::atomic<size_t> head_{0}; // consumers
+    };
+}
@@ -0,0 +1,122 @@
+// pixel_format.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "gcapture.h"
+
+namespace gcap
+{
+    // Row layout of one plane: `bytesPerBlock` bytes cover `pixelsPerBlock`
+    // luma columns; the plane has (height >> heightShift) rows.
+    struct PlaneDesc
+    {
+        uint8_t bytesPerBlock;
+        uint8_t pixelsPerBlock;
+        uint8_t heightShift;
+    };
+
+    struct PixelFormatDesc
+    {
+        gcap_pixfmt_t format;
+        const char *name;
+        int planeCount;
+        int bitDepth;
+        bool yuv;
+        uint8_t chromaShiftX, chromaShiftY; // log2 chroma subsampling
+        uint16_t rowAlign;                  // minimum row alignment in bytes (1 = none)
+        PlaneDesc plane[3];
+    };
+
+    // Indexed by gcap_pixfmt_t; keep in enum order.
+    inline constexpr PixelFormatDesc kPixelFormats[] = {
+        {GCAP_FMT_NV12, "NV12", 2, 8, true, 1, 1, 1, {{1, 1, 0}, {2, 2, 1}, {0, 1, 0}}},
+        {GCAP_FMT_YUY2, "YUY2", 1, 8, true, 1, 0, 1, {{4, 2, 0}, {0, 1, 0}, {0, 1, 0}}},
+        {GCAP_FMT_ARGB, "ARGB", 1, 8, false, 0, 0, 1, {{4, 1, 0}, {0, 1, 0}, {0, 1, 0}}},
+        {GCAP_FMT_P010, "P010", 2, 10, true, 1, 1, 1, {{2, 1, 0}, {4, 2, 1}, {0, 1, 0}}},
+        {GCAP_FMT_V210, "V210", 1, 10, true, 1, 0, 128, {{16, 6, 0}, {0, 1, 0}, {0, 1, 0}}},
+        {GCAP_FMT_R210, "R210", 1, 10, false, 0, 0, 256, {{4, 1, 0}, {0, 1, 0}, {0, 1, 0}}},
+        {GCAP_FMT_NV16, "NV16", 2, 8, true, 1, 0, 1, {{1, 1, 0}, {2, 2, 0}, {0, 1, 0}}},
+        {GCAP_FMT_P210, "P210", 2, 10, true, 1, 0, 1, {{2, 1, 0}, {4, 2, 0}, {0, 1, 0}}},
+        {GCAP_FMT_NV24, "NV24", 2, 8, true, 0, 0, 1, {{1, 1, 0}, {2, 1, 0}, {0, 1, 0}}},
+        {GCAP_FMT_Y210, "Y210", 1, 10, true, 1, 0, 1, {{8, 2, 0}, {0, 1, 0}, {0, 1, 0}}},
+        {GCAP_FMT_GRAY8, "GRAY8", 1, 8, true, 0, 0, 1, {{1, 1, 0}, {0, 1, 0}, {0, 1, 0}}},
+    };
+
+    inline constexpr int kPixelFormatCount = (int)(sizeof(kPixelFormats) / sizeof(kPixelFormats[0]));
+
+    constexpr bool table_in_enum_order()
+    {
+        for (int i = 0; i < kPixelFormatCount; ++i)
+            if ((int)kPixelFormats[i].format != i)
+                return false;
+        return true;
+    }
+    static_assert(table_in_enum_order(), "kPixelFormats must follow gcap_pixfmt_t order");
+
+    constexpr bool pixfmt_valid(gcap_pixfmt_t f)
+    {
+        return (int)f >= 0 && (int)f < kPixelFormatCount;
+    }
+
+    constexpr const PixelFormatDesc &pixfmt_desc(gcap_pixfmt_t f)
+    {
+        return kPixelFormats[pixfmt_valid(f) ? (int)f : (int)GCAP_FMT_ARGB];
+    }
+
+    // Tight (minimum) row size of a plane, including the format's row alignment.
+    constexpr int pixfmt_row_bytes(gcap_pixfmt_t f, int plane, int width)
+    {
+        const PixelFormatDesc &d = pixfmt_desc(f);
+        const PlaneDesc &p = d.plane[plane];
+        const int bytes = (width + p.pixelsPerBlock - 1) / p.pixelsPerBlock * p.bytesPerBlock;
+        return (bytes + d.rowAlign - 1) / d.rowAlign * d.rowAlign;
+    }
+
+    constexpr int pixfmt_plane_rows(gcap_pixfmt_t f, int plane, int height)
+    {
+        return height >> pixfmt_desc(f).plane[plane].heightShift;
+    }
+
+    // Planes of a contiguous buffer share the luma pitch, scaled by the plane's
+    // row size (e.g. NV24's UV rows are twice as wide as its Y rows).
+    constexpr int pixfmt_plane_stride(gcap_pixfmt_t f, int plane, int width, int stride0)
+    {
+        const int r0 = pixfmt_row_bytes(f, 0, width);
+        return plane == 0 || r0 == 0 ? stride0 : (int)((int64_t)stride0 * pixfmt_row_bytes(f, plane, width) / r0);
+    }
+
+    constexpr size_t pixfmt_frame_bytes(gcap_pixfmt_t f, int width, int height, int stride0)
+    {
+        size_t total = 0;
+        for (int i = 0; i < pixfmt_desc(f).planeCount; ++i)
+            total += (size_t)pixfmt_plane_stride(f, i, width, stride0) * (size_t)pixfmt_plane_rows(f, i, height);
+        return total;
+    }
+
+    // Planes of one image; sources are never written through `data`.
+    struct ImageRef
+    {
+        uint8_t *data[3] = {};
+        int stride[3] = {};
+        int width = 0;
+        int height = 0;
+        gcap_pixfmt_t format = GCAP_FMT_ARGB;
+    };
+
+    // Split a contiguous buffer (planes back to back) into an ImageRef.
+    inline ImageRef image_from_buffer(gcap_pixfmt_t f, uint8_t *base, int stride0, int width, int height)
+    {
+        ImageRef r;
+        r.width = width;
+        r.height = height;
+        r.format = f;
+        uint8_t *p = base;
+        for (int i = 0; i < pixfmt_desc(f).planeCount; ++i)
+        {
+            r.data[i] = p;
+            r.stride[i] = pixfmt_plane_stride(f, i, width, stride0);
+            p += (size_t)r.stride[i] * (size_t)pixfmt_plane_rows(f, i, height);
+        }
+        return r;
+    }
+}
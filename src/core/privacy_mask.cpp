@@ -0,0 +1,429 @@
+// privacy_mask.cpp
+#include "privacy_mask.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr int kMaxSpanInts = GCAP_MASK_MAX_POINTS; // even-odd crossings per row
+    constexpr int kDefaultBlock = 16;                  // pixelate block (luma px)
+    constexpr int kDefaultRadius = 8;                  // blur radius (luma px)
+
+    // One colour component of a plane: element (x, y) lives at
+    // base[y * stride + x * step] (stride / step in elements).
+    template <typename T>
+    struct Channel
+    {
+        T *base;
+        int stride;
+        int step;
+        int width, height; // component resolution
+        int sx, sy;        // subsampling relative to luma
+        T fill;
+
+        T &at(int x, int y) const { return base[(size_t)y * stride + (size_t)x * step]; }
+    };
+
+    // Region bounding box in component coordinates, clipped to the plane.
+    template <typename T>
+    bool region_bbox(const gcap_mask_region_t &r, const Channel<T> &c,
+                     int &x0, int &y0, int &x1, int &y1)
+    {
+        int lx0, ly0, lx1, ly1;
+        if (r.point_count >= 3)
+        {
+            lx0 = lx1 = r.points[0][0];
+            ly0 = ly1 = r.points[0][1];
+            for (int i = 1; i < r.point_count; ++i)
+            {
+                lx0 = std::min(lx0, r.points[i][0]);
+                lx1 = std::max(lx1, r.points[i][0]);
+                ly0 = std::min(ly0, r.points[i][1]);
+                ly1 = std::max(ly1, r.points[i][1]);
+            }
+        }
+        else
+        {
+            lx0 = r.x;
+            ly0 = r.y;
+            lx1 = r.x + r.width;
+            ly1 = r.y + r.height;
+        }
+
+        // conservative: a chroma sample is masked if it touches any masked luma pixel
+        x0 = std::max(0, (int)std::floor((double)lx0 / c.sx));
+        y0 = std::max(0, (int)std::floor((double)ly0 / c.sy));
+        x1 = std::min(c.width, (int)std::ceil((double)lx1 / c.sx));
+        y1 = std::min(c.height, (int)std::ceil((double)ly1 / c.sy));
+        return x0 < x1 && y0 < y1;
+    }
+
+    // Sorted even-odd crossings of the horizontal line at luma `y`.
+    int crossings(const gcap_mask_region_t &r, double y, double *xs)
+    {
+        int n = 0;
+        for (int i = 0; i < r.point_count && n < kMaxSpanInts; ++i)
+        {
+            const int j = (i + 1) % r.point_count;
+            const double ax = r.points[i][0], ay = r.points[i][1];
+            const double bx = r.points[j][0], by = r.points[j][1];
+            if ((ay <= y) == (by <= y))
+                continue;
+            xs[n++] = ax + (y - ay) * (bx - ax) / (by - ay);
+        }
+        std::sort(xs, xs + n);
+        return n;
+    }
+
+    // Covered [begin, end) pairs of row `cy` (component coordinates).
+    // Returns the number of ints written to `out` (always even).
+    template <typename T>
+    int row_spans(const gcap_mask_region_t &r, const Channel<T> &c, int cy,
+                  int x0, int x1, int *out)
+    {
+        if (r.point_count < 3)
+        {
+            out[0] = x0;
+            out[1] = x1;
+            return 2;
+        }
+
+        // Conservative: everything the polygon touches within the row's
+        // luma band [yt, yb]. A covered x is either covered at one of the
+        // band edges or crossed by an edge inside the band, so the union of
+        // the spans at yt and yb and of each edge's x extent within the band
+        // is exact (a thin spike or a vertex between samples is not missed).
+        const double yt = (double)cy * c.sy;
+        const double yb = (double)(cy + 1) * c.sy;
+        struct Span
+        {
+            double b, e;
+        };
+        Span sp[kMaxSpanInts * 2];
+        int m = 0;
+        double xs[kMaxSpanInts];
+        for (const double y : {yt, yb})
+        {
+            const int n = crossings(r, y, xs);
+            for (int i = 0; i + 1 < n; i += 2)
+                sp[m++] = {xs[i], xs[i + 1]};
+        }
+        for (int i = 0; i < r.point_count; ++i)
+        {
+            const int j = (i + 1) % r.point_count;
+            double ax = r.points[i][0], ay = r.points[i][1];
+            double bx = r.points[j][0], by = r.points[j][1];
+            if (ay > by)
+            {
+                std::swap(ax, bx);
+                std::swap(ay, by);
+            }
+            if (by < yt || ay > yb)
+                continue;
+            // clip the edge to the band
+            double ex0 = ax, ex1 = bx;
+            if (by > ay)
+            {
+                if (ay < yt)
+                    ex0 = ax + (yt - ay) * (bx - ax) / (by - ay);
+                if (by > yb)
+                    ex1 = ax + (yb - ay) * (bx - ax) / (by - ay);
+            }
+            sp[m++] = {std::min(ex0, ex1), std::max(ex0, ex1)};
+        }
+        std::sort(sp, sp + m, [](const Span &a, const Span &b)
+                  { return a.b < b.b; });
+
+        int k = 0;
+        for (int i = 0; i < m; ++i)
+        {
+            const int b = std::max(x0, (int)std::floor(sp[i].b / c.sx));
+            const int e = std::min(x1, (int)std::ceil(sp[i].e / c.sx));
+            if (b >= e)
+                continue;
+            if (k > 0 && b <= out[k - 1])
+                out[k - 1] = std::max(out[k - 1], e);
+            else if (k + 2 <= kMaxSpanInts)
+            {
+                out[k++] = b;
+                out[k++] = e;
+            }
+            else
+                out[k - 1] = std::max(out[k - 1], e); // out of room: over-cover
+        }
+        return k;
+    }
+
+    template <typename T>
+    void mask_channel(const Channel<T> &c, const gcap_mask_region_t &r,
+                      std::vector<int> &spans, std::vector<uint32_t> &sum)
+    {
+        int bx0, by0, bx1, by1;
+        if (!region_bbox(r, c, bx0, by0, bx1, by1))
+            return;
+
+        // per-row span table: [count, b0, e0, b1, e1, ...]
+        const int rows = by1 - by0;
+        const size_t rowInts = kMaxSpanInts + 1;
+        if (spans.size() < (size_t)rows * rowInts)
+            spans.resize((size_t)rows * rowInts);
+        for (int yy = 0; yy < rows; ++yy)
+        {
+            int *row = &spans[(size_t)yy * rowInts];
+            row[0] = row_spans(r, c, by0 + yy, bx0, bx1, row + 1);
+        }
+
+        auto for_covered = [&](int y, int xb, int xe, auto &&fn)
+        {
+            const int *row = &spans[(size_t)(y - by0) * rowInts];
+            for (int k = 0; k < row[0]; k += 2)
+            {
+                const int b = std::max(xb, row[1 + k]);
+                const int e = std::min(xe, row[2 + k]);
+                for (int x = b; x < e; ++x)
+                    fn(x);
+            }
+        };
+
+        if (r.mode == GCAP_MASK_FILL)
+        {
+            for (int y = by0; y < by1; ++y)
+                for_covered(y, bx0, bx1, [&](int x)
+                            { c.at(x, y) = c.fill; });
+            return;
+        }
+
+        if (r.mode == GCAP_MASK_PIXELATE)
+        {
+            const int luma = r.strength > 0 ? r.strength : kDefaultBlock;
+            const int bw = std::max(1, luma / c.sx);
+            const int bh = std::max(1, luma / c.sy);
+
+            // blocks sit on an absolute grid so luma / chroma blocks line up
+            for (int yb = (by0 / bh) * bh; yb < by1; yb += bh)
+            {
+                const int ye = std::min(yb + bh, c.height);
+                for (int xb = (bx0 / bw) * bw; xb < bx1; xb += bw)
+                {
+                    const int xe = std::min(xb + bw, c.width);
+                    uint64_t acc = 0;
+                    for (int y = yb; y < ye; ++y)
+                        for (int x = xb; x < xe; ++x)
+                            acc += c.at(x, y);
+                    const uint64_t cnt = (uint64_t)(ye - yb) * (uint64_t)(xe - xb);
+                    const T mean = (T)((acc + cnt / 2) / cnt);
+
+                    for (int y = std::max(yb, by0); y < std::min(ye, by1); ++y)
+                        for_covered(y, xb, xe, [&](int x)
+                                    { c.at(x, y) = mean; });
+                }
+            }
+            return;
+        }
+
+        // GCAP_MASK_BLUR: separable box filter over the region bbox.
+        const int luma = r.strength > 0 ? r.strength : kDefaultRadius;
+        const int rx = std::max(1, luma / c.sx);
+        const int ry = std::max(1, luma / c.sy);
+        const int ey0 = std::max(0, by0 - ry);
+        const int ey1 = std::min(c.height, by1 + ry);
+        const int cols = bx1 - bx0;
+
+        // horizontal pass → sum_[row][col] holds the row-window average
+        const size_t hCount = (size_t)(ey1 - ey0) * cols;
+        if (sum.size() < hCount + cols)
+            sum.resize(hCount + cols);
+        for (int y = ey0; y < ey1; ++y)
+        {
+            uint32_t *h = &sum[(size_t)(y - ey0) * cols];
+            int wl = std::max(0, bx0 - rx);
+            int wr = std::min(c.width, bx0 + rx + 1);
+            uint32_t acc = 0;
+            for (int x = wl; x < wr; ++x)
+                acc += c.at(x, y);
+            for (int x = bx0; x < bx1; ++x)
+            {
+                h[x - bx0] = acc / (uint32_t)(wr - wl);
+                const int nl = std::max(0, x + 1 - rx);
+                const int nr = std::min(c.width, x + rx + 2);
+                if (nl > wl)
+                    acc -= c.at(wl, y);
+                if (nr > wr)
+                    acc += c.at(wr, y);
+                wl = nl;
+                wr = nr;
+            }
+        }
+
+        // vertical pass with running column sums; only covered pixels are written
+        uint32_t *col = &sum[hCount];
+        int vt = std::max(ey0, by0 - ry);
+        int vb = std::min(ey1, by0 + ry + 1);
+        for (int x = 0; x < cols; ++x)
+        {
+            uint32_t acc = 0;
+            for (int y = vt; y < vb; ++y)
+                acc += sum[(size_t)(y - ey0) * cols + x];
+            col[x] = acc;
+        }
+        for (int y = by0; y < by1; ++y)
+        {
+            const uint32_t n = (uint32_t)(vb - vt);
+            for_covered(y, bx0, bx1, [&](int x)
+                        { c.at(x, y) = (T)(col[x - bx0] / n); });
+
+            const int nt = std::max(ey0, y + 1 - ry);
+            const int nb = std::min(ey1, y + ry + 2);
+            for (int x = 0; x < cols; ++x)
+            {
+                if (nt > vt)
+                    col[x] -= sum[(size_t)(vt - ey0) * cols + x];
+                if (nb > vb)
+                    col[x] += sum[(size_t)(vb - ey0) * cols + x];
+            }
+            vt = nt;
+            vb = nb;
+        }
+    }
+
+    // BT.601 limited range (same matrix as frame_converter's yuv_to_rgb)
+    void rgb_to_yuv(const gcap_mask_region_t &r, int &Y, int &U, int &V)
+    {
+        const int R = r.fill_r, G = r.fill_g, B = r.fill_b;
+        Y = ((66 * R + 129 * G + 25 * B + 128) >> 8) + 16;
+        U = ((-38 * R - 74 * G + 112 * B + 128) >> 8) + 128;
+        V = ((112 * R - 94 * G - 18 * B + 128) >> 8) + 128;
+    }
+
+    bool region_valid(const gcap_mask_region_t &r)
+    {
+        if (r.mode != GCAP_MASK_PIXELATE && r.mode != GCAP_MASK_BLUR && r.mode != GCAP_MASK_FILL)
+            return false;
+        if (r.point_count == 0)
+            return r.width > 0 && r.height > 0;
+        return r.point_count >= 3 && r.point_count <= GCAP_MASK_MAX_POINTS;
+    }
+}
+
+namespace gcap
+{
+    bool PrivacyMask::setRegions(const gcap_mask_region_t *regions, int count)
+    {
+        if (count < 0 || (count > 0 && !regions))
+            return false;
+        for (int i = 0; i < count; ++i)
+            if (!region_valid(regions[i]))
+                return false;
+
+        std::shared_ptr<const Regions> next;
+        if (count > 0)
+            next = std::make_shared<const Regions>(regions, regions + count);
+
+        std::lock_guard<std::mutex> lk(mtx_);
+        regions_ = std::move(next);
+        count_.store(count, std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    const PrivacyMask::Regions *PrivacyMask::snapshot()
+    {
+        const uint64_t gen = generation_.load(std::memory_order_acquire);
+        if (gen != seenGeneration_)
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            current_ = regions_;
+            seenGeneration_ = generation_.load(std::memory_order_relaxed);
+        }
+        return current_.get();
+    }
+
+    void PrivacyMask::apply_nv12(uint8_t *y, uint8_t *uv, int w, int h, int yStride, int uvStride)
+    {
+        apply_semiplanar(y, uv, w, h, yStride, uvStride, 2, 2);
+    }
+
+    void PrivacyMask::apply_p010(uint8_t *y, uint8_t *uv, int w, int h, int yStrideBytes, int uvStrideBytes)
+    {
+        apply_semiplanar16(y, uv, w, h, yStrideBytes, uvStrideBytes, 2, 2);
+    }
+
+    void PrivacyMask::apply_semiplanar(uint8_t *y, uint8_t *uv, int w, int h, int yStride, int uvStride, int sx, int sy)
+    {
+        const Regions *regs = snapshot();
+        if (!regs)
+            return;
+        for (const auto &r : *regs)
+        {
+            int Y, U, V;
+            rgb_to_yuv(r, Y, U, V);
+            mask_channel(Channel<uint8_t>{y, yStride, 1, w, h, 1, 1, (uint8_t)Y}, r, spans_, sum_);
+            mask_channel(Channel<uint8_t>{uv, uvStride, 2, w / sx, h / sy, sx, sy, (uint8_t)U}, r, spans_, sum_);
+            mask_channel(Channel<uint8_t>{uv + 1, uvStride, 2, w / sx, h / sy, sx, sy, (uint8_t)V}, r, spans_, sum_);
+        }
+    }
+
+    void PrivacyMask::apply_semiplanar16(uint8_t *y, uint8_t *uv, int w, int h, int yStrideBytes, int uvStrideBytes, int sx, int sy)
+    {
+        const Regions *regs = snapshot();
+        if (!regs)
+            return;
+        auto *y16 = reinterpret_cast<uint16_t *>(y);
+        auto *uv16 = reinterpret_cast<uint16_t *>(uv);
+        const int ys = yStrideBytes / 2, uvs = uvStrideBytes / 2;
+        for (const auto &r : *regs)
+        {
+            int Y, U, V;
+            rgb_to_yuv(r, Y, U, V);
+            // 8-bit code value → 10-bit MSB-aligned in a 16-bit container
+            mask_channel(Channel<uint16_t>{y16, ys, 1, w, h, 1, 1, (uint16_t)(Y << 8)}, r, spans_, sum_);
+            mask_channel(Channel<uint16_t>{uv16, uvs, 2, w / sx, h / sy, sx, sy, (uint16_t)(U << 8)}, r, spans_, sum_);
+            mask_channel(Channel<uint16_t>{uv16 + 1, uvs, 2, w / sx, h / sy, sx, sy, (uint16_t)(V << 8)}, r, spans_, sum_);
+        }
+    }
+
+    void PrivacyMask::apply_y210(uint8_t *y210, int w, int h, int strideBytes)
+    {
+        const Regions *regs = snapshot();
+        if (!regs)
+            return;
+        auto *p = reinterpret_cast<uint16_t *>(y210);
+        const int s16 = strideBytes / 2;
+        for (const auto &r : *regs)
+        {
+            int Y, U, V;
+            rgb_to_yuv(r, Y, U, V);
+            mask_channel(Channel<uint16_t>{p, s16, 2, w, h, 1, 1, (uint16_t)(Y << 8)}, r, spans_, sum_);
+            mask_channel(Channel<uint16_t>{p + 1, s16, 4, w / 2, h, 2, 1, (uint16_t)(U << 8)}, r, spans_, sum_);
+            mask_channel(Channel<uint16_t>{p + 3, s16, 4, w / 2, h, 2, 1, (uint16_t)(V << 8)}, r, spans_, sum_);
+        }
+    }
+
+    void PrivacyMask::apply_yuy2(uint8_t *yuy2, int w, int h, int stride)
+    {
+        const Regions *regs = snapshot();
+        if (!regs)
+            return;
+        for (const auto &r : *regs)
+        {
+            int Y, U, V;
+            rgb_to_yuv(r, Y, U, V);
+            mask_channel(Channel<uint8_t>{yuy2, stride, 2, w, h, 1, 1, (uint8_t)Y}, r, spans_, sum_);
+            mask_channel(Channel<uint8_t>{yuy2 + 1, stride, 4, w / 2, h, 2, 1, (uint8_t)U}, r, spans_, sum_);
+            mask_channel(Channel<uint8_t>{yuy2 + 3, stride, 4, w / 2, h, 2, 1, (uint8_t)V}, r, spans_, sum_);
+        }
+    }
+
+    void PrivacyMask::apply_argb(uint8_t *bgra, int w, int h, int stride)
+    {
+        const Regions *regs = snapshot();
+        if (!regs)
+            return;
+        for (const auto &r : *regs)
+        {
+            mask_channel(Channel<uint8_t>{bgra + 0, stride, 4, w, h, 1, 1, r.fill_b}, r, spans_, sum_);
+            mask_channel(Channel<uint8_t>{bgra + 1, stride, 4, w, h, 1, 1, r.fill_g}, r, spans_, sum_);
+            mask_channel(Channel<uint8_t>{bgra + 2, stride, 4, w, h, 1, 1, r.fill_r}, r, spans_, sum_);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+// privacy_mask.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "gcapture.h"
+
+namespace gcap
+{
+    /**
+     * @brief Privacy masks applied in place on native frame planes.
+     *
+     * Masks are burned into the planes the provider is about to record and
+     * convert, so no delivered or recorded buffer ever contains the unmasked
+     * pixels. Only rows covered by a region are touched; the rest of the frame
+     * is never read.
+     *
+     * setRegions() may be called from any thread; apply_*() are called from
+     * the capture thread. setRegions() publishes the list under a mutex and
+     * bumps a generation; the capture thread keeps its own reference and only
+     * takes the mutex when the generation moved, so a frame never locks.
+     */
+    class PrivacyMask
+    {
+    public:
+        // Replace the region list (count == 0 clears all masks).
+        bool setRegions(const gcap_mask_region_t *regions, int count);
+        // Any thread; never blocks.
+        bool empty() const { return count_.load(std::memory_order_relaxed) == 0; }
+
+        // 4:2:0 semi-planar, 8-bit (NV12) or 16-bit container (P010)
+        void apply_nv12(uint8_t *y, uint8_t *uv, int width, int height, int yStride, int uvStride);
+        void apply_p010(uint8_t *y, uint8_t *uv, int width, int height, int yStrideBytes, int uvStrideBytes);
+
+        // Semi-planar with chroma subsampling sx, sy (1 or 2): NV16/P210 = (2, 1), NV24 = (1, 1)
+        void apply_semiplanar(uint8_t *y, uint8_t *uv, int width, int height, int yStride, int uvStride, int sx, int sy);
+        void apply_semiplanar16(uint8_t *y, uint8_t *uv, int width, int height, int yStrideBytes, int uvStrideBytes, int sx, int sy);
+
+        // 4:2:2 packed, 16-bit containers (Y210)
+        void apply_y210(uint8_t *y210, int width, int height, int strideBytes);
+
+        // 4:2:2 packed (Y0 U Y1 V)
+        void apply_yuy2(uint8_t *yuy2, int width, int height, int stride);
+
+        // 32-bit BGRA
+        void apply_argb(uint8_t *bgra, int width, int height, int stride);
+
+    private:
+        using Regions = std::vector<gcap_mask_region_t>;
+
+        // capture thread: the current list, refreshed when setRegions() ran
+        const Regions *snapshot();
+
+        std::mutex mtx_; // regions_; not taken per frame
+        std::shared_ptr<const Regions> regions_;
+        std::atomic<uint64_t> generation_{0};
+        std::atomic<int> count_{0};
+
+        // capture thread
+        uint64_t seenGeneration_ = 0;
+        std::shared_ptr<const Regions> current_;
+
+        // scratch (capture thread only; grows, never shrinks)
+        std::vector<uint32_t> sum_;
+        std::vector<int> spans_;
+    };
+}
@@ -0,0 +1,368 @@
+// scaler.cpp
+#include "scaler.h"
+#include "band_pool.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double kPi = 3.14159265358979323846;
+
+    double filter_support(gcap_scale_filter_t f)
+    {
+        switch (f)
+        {
+        case GCAP_SCALE_BICUBIC:
+            return 2.0;
+        case GCAP_SCALE_LANCZOS3:
+            return 3.0;
+        case GCAP_SCALE_BILINEAR:
+        default:
+            return 1.0;
+        }
+    }
+
+    double sinc(double x)
+    {
+        if (std::fabs(x) < 1e-8)
+            return 1.0;
+        x *= kPi;
+        return std::sin(x) / x;
+    }
+
+    double filter_weight(gcap_scale_filter_t f, double x)
+    {
+        x = std::fabs(x);
+        switch (f)
+        {
+        case GCAP_SCALE_BICUBIC:
+        {
+            // Catmull-Rom (a = -0.5)
+            const double a = -0.5;
+            if (x < 1.0)
+                return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+            if (x < 2.0)
+                return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+            return 0.0;
+        }
+        case GCAP_SCALE_LANCZOS3:
+            return x < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+        case GCAP_SCALE_BILINEAR:
+        default:
+            return x < 1.0 ? 1.0 - x : 0.0;
+        }
+    }
+
+    // Precompute `taps` weights per output sample. Out-of-range taps are folded
+    // onto the edge samples so the inner loops never clamp.
+    void build_bank(gcap::PlaneScaler::Bank &b, int srcN, int dstN, gcap_scale_filter_t f)
+    {
+        const double scale = (double)srcN / (double)dstN;
+        const double fs = std::max(1.0, scale); // widen the kernel when downscaling
+        const double support = filter_support(f) * fs;
+
+        b.taps = std::min(srcN, std::max(2, (int)std::ceil(support) * 2));
+        b.start.assign((size_t)dstN, 0);
+        b.coef.assign((size_t)dstN * b.taps, 0.0f);
+
+        std::vector<double> w((size_t)b.taps);
+        for (int i = 0; i < dstN; ++i)
+        {
+            const double center = (i + 0.5) * scale - 0.5;
+            const int first = (int)std::floor(center - support) + 1;
+            const int start = std::clamp(first, 0, srcN - b.taps);
+
+            std::fill(w.begin(), w.end(), 0.0);
+            double sum = 0.0;
+            for (int k = 0; k < b.taps; ++k)
+            {
+                const int p = first + k;
+                const double v = filter_weight(f, (p - center) / fs);
+                const int idx = std::clamp(p, 0, srcN - 1) - start;
+                if (idx >= 0 && idx < b.taps)
+                {
+                    w[(size_t)idx] += v;
+                    sum += v;
+                }
+            }
+            if (std::fabs(sum) < 1e-12)
+            {
+                w[(size_t)std::clamp((int)std::lround(center) - start, 0, b.taps - 1)] = 1.0;
+                sum = 1.0;
+            }
+
+            b.start[(size_t)i] = start;
+            for (int k = 0; k < b.taps; ++k)
+                b.coef[(size_t)i * b.taps + k] = (float)(w[(size_t)k] / sum);
+        }
+
+        b.taps4 = (b.taps + 3) & ~3;
+        b.coef4.assign((size_t)dstN * b.taps4, 0.0f);
+        for (int i = 0; i < dstN; ++i)
+            std::copy_n(&b.coef[(size_t)i * b.taps], b.taps, &b.coef4[(size_t)i * b.taps4]);
+    }
+
+    // t[x] = Σ_k w[x][k] * line[start[x] + k], over the zero-padded bank; `line`
+    // holds taps4 - 1 zeros past the last sample.
+    void horizontal_scalar(const float *line, const int *start, const float *coef, int taps4, int dstW, float *t, int x0)
+    {
+        for (int x = x0; x < dstW; ++x)
+        {
+            const float *w = coef + (size_t)x * taps4;
+            const float *s = line + start[x];
+            float acc = 0.0f;
+            for (int k = 0; k < taps4; ++k)
+                acc += w[k] * s[k];
+            t[x] = acc;
+        }
+    }
+
+    // Four outputs per step: four taps at a time per output, then one transpose
+    // folds the four partial sums of each output into a single vector.
+    int horizontal_simd(const float *line, const int *start, const float *coef, int taps4, int dstW, float *t)
+    {
+        int x = 0;
+#if defined(GCAP_SIMD_SSE2)
+        for (; x + 4 <= dstW; x += 4)
+        {
+            __m128 s[4];
+            for (int j = 0; j < 4; ++j)
+            {
+                const float *w = coef + (size_t)(x + j) * taps4;
+                const float *p = line + start[x + j];
+                __m128 a = _mm_setzero_ps();
+                for (int k = 0; k < taps4; k += 4)
+                    a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(w + k), _mm_loadu_ps(p + k)));
+                s[j] = a;
+            }
+            const __m128 t0 = _mm_add_ps(_mm_unpacklo_ps(s[0], s[1]), _mm_unpackhi_ps(s[0], s[1]));
+            const __m128 t1 = _mm_add_ps(_mm_unpacklo_ps(s[2], s[3]), _mm_unpackhi_ps(s[2], s[3]));
+            _mm_storeu_ps(t + x, _mm_add_ps(_mm_movelh_ps(t0, t1), _mm_movehl_ps(t1, t0)));
+        }
+#elif defined(GCAP_SIMD_NEON)
+        for (; x + 4 <= dstW; x += 4)
+        {
+            float32x2_t h[4];
+            for (int j = 0; j < 4; ++j)
+            {
+                const float *w = coef + (size_t)(x + j) * taps4;
+                const float *p = line + start[x + j];
+                float32x4_t a = vdupq_n_f32(0.0f);
+                for (int k = 0; k < taps4; k += 4)
+                    a = vmlaq_f32(a, vld1q_f32(w + k), vld1q_f32(p + k));
+                h[j] = vpadd_f32(vget_low_f32(a), vget_high_f32(a));
+            }
+            vst1q_f32(t + x, vcombine_f32(vpadd_f32(h[0], h[1]), vpadd_f32(h[2], h[3])));
+        }
+#else
+        (void)line, (void)start, (void)coef, (void)taps4, (void)dstW, (void)t;
+#endif
+        return x;
+    }
+
+    // acc[x] = Σ_k w[k] * rows[k][x]
+    void vertical_scalar(const float *tmp, int dstW, const float *w, int taps, float *acc, int x0)
+    {
+        for (int x = x0; x < dstW; ++x)
+        {
+            float s = 0.0f;
+            for (int k = 0; k < taps; ++k)
+                s += w[k] * tmp[(size_t)k * dstW + x];
+            acc[x] = s;
+        }
+    }
+
+#if defined(GCAP_SIMD_AVX2)
+    GCAP_TARGET_AVX2 int vertical_avx2(const float *tmp, int dstW, const float *w, int taps, float *acc)
+    {
+        int x = 0;
+        for (; x + 8 <= dstW; x += 8)
+        {
+            __m256 s = _mm256_setzero_ps();
+            for (int k = 0; k < taps; ++k)
+                s = _mm256_add_ps(s, _mm256_mul_ps(_mm256_set1_ps(w[k]),
+                                                   _mm256_loadu_ps(tmp + (size_t)k * dstW + x)));
+            _mm256_storeu_ps(acc + x, s);
+        }
+        return x;
+    }
+#endif
+
+    int vertical_simd(const float *tmp, int dstW, const float *w, int taps, float *acc)
+    {
+        int x = 0;
+#if defined(GCAP_SIMD_AVX2)
+        if (gcap::simd::cpu_has_avx2())
+            return vertical_avx2(tmp, dstW, w, taps, acc);
+#endif
+#if defined(GCAP_SIMD_SSE2)
+        for (; x + 4 <= dstW; x += 4)
+        {
+            __m128 s = _mm_setzero_ps();
+            for (int k = 0; k < taps; ++k)
+                s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(tmp + (size_t)k * dstW + x)));
+            _mm_storeu_ps(acc + x, s);
+        }
+#elif defined(GCAP_SIMD_NEON)
+        for (; x + 4 <= dstW; x += 4)
+        {
+            float32x4_t s = vdupq_n_f32(0.0f);
+            for (int k = 0; k < taps; ++k)
+                s = vmlaq_n_f32(s, vld1q_f32(tmp + (size_t)k * dstW + x), w[k]);
+            vst1q_f32(acc + x, s);
+        }
+#endif
+        return x;
+    }
+
+    inline void store_sample(uint8_t *p, float v)
+    {
+        *p = (uint8_t)std::clamp((int)(v + 0.5f), 0, 255);
+    }
+
+    // P010: 10 significant bits, MSB-aligned; keep the 6 LSBs zero
+    inline void store_sample(uint16_t *p, float v)
+    {
+        *p = (uint16_t)(std::clamp((int)(v * (1.0f / 64.0f) + 0.5f), 0, 1023) << 6);
+    }
+}
+
+namespace gcap
+{
+    PlaneScaler::PlaneScaler() = default;
+    PlaneScaler::~PlaneScaler() = default;
+
+    bool PlaneScaler::configure(gcap_pixfmt_t fmt, int srcW, int srcH, int dstW, int dstH,
+                                gcap_scale_filter_t filter, int threads)
+    {
+        fmt_valid_ = false;
+        comps_.clear();
+
+        if (fmt != GCAP_FMT_NV12 && fmt != GCAP_FMT_P010 && fmt != GCAP_FMT_YUY2 &&
+            fmt != GCAP_FMT_GRAY8 && fmt != GCAP_FMT_ARGB)
+            return false;
+        if (srcW < 2 || srcH < 2 || dstW < 2 || dstH < 2 ||
+            (srcW | srcH | dstW | dstH) & 1)
+            return false;
+
+        fmt_ = fmt;
+        build_bank(lumaH_, srcW, dstW, filter);
+        build_bank(lumaV_, srcH, dstH, filter);
+        build_bank(chromaH_, srcW / 2, dstW / 2, filter);
+
+        if (fmt == GCAP_FMT_GRAY8)
+        {
+            comps_.push_back({0, 0, 1, srcW, srcH, dstW, dstH, &lumaH_, &lumaV_});
+        }
+        else if (fmt == GCAP_FMT_ARGB)
+        {
+            // B G R A interleaved, all at full resolution
+            for (int k = 0; k < 4; ++k)
+                comps_.push_back({0, k, 4, srcW, srcH, dstW, dstH, &lumaH_, &lumaV_});
+        }
+        else if (fmt == GCAP_FMT_YUY2)
+        {
+            // 4:2:2 packed: Y0 U Y1 V; chroma keeps full height
+            comps_.push_back({0, 0, 2, srcW, srcH, dstW, dstH, &lumaH_, &lumaV_});
+            comps_.push_back({0, 1, 4, srcW / 2, srcH, dstW / 2, dstH, &chromaH_, &lumaV_});
+            comps_.push_back({0, 3, 4, srcW / 2, srcH, dstW / 2, dstH, &chromaH_, &lumaV_});
+        }
+        else
+        {
+            build_bank(chromaV_, srcH / 2, dstH / 2, filter);
+            comps_.push_back({0, 0, 1, srcW, srcH, dstW, dstH, &lumaH_, &lumaV_});
+            comps_.push_back({1, 0, 2, srcW / 2, srcH / 2, dstW / 2, dstH / 2, &chromaH_, &chromaV_});
+            comps_.push_back({1, 1, 2, srcW / 2, srcH / 2, dstW / 2, dstH / 2, &chromaH_, &chromaV_});
+        }
+
+        if (!pool_ || (threads > 0 && pool_->size() != std::min(threads, BandPool::kMaxThreads)))
+            pool_ = std::make_unique<BandPool>(threads);
+        bands_ = pool_->size();
+
+        // per-worker scratch: source rows of the tallest band, one accumulator
+        // row and one widened source row (plus the horizontal pass's zero tail)
+        size_t need = 0;
+        for (const auto &c : comps_)
+        {
+            const size_t line = (size_t)c.srcW + c.h->taps4;
+            const int rowsPerBand = (c.dstH + bands_ - 1) / bands_;
+            for (int y0 = 0; y0 < c.dstH; y0 += rowsPerBand)
+            {
+                const int y1 = std::min(c.dstH, y0 + rowsPerBand);
+                const int rows = c.v->start[(size_t)y1 - 1] + c.v->taps - c.v->start[(size_t)y0];
+                need = std::max(need, (size_t)(rows + 1) * c.dstW + line);
+            }
+        }
+        tmp_.assign((size_t)pool_->size(), std::vector<float>(need));
+
+        fmt_valid_ = true;
+        return true;
+    }
+
+    template <typename T>
+    void PlaneScaler::run_band(const Component &c, const uint8_t *src, int srcStride,
+                               uint8_t *dst, int dstStride, int y0, int y1, float *tmp)
+    {
+        const Bank &H = *c.h;
+        const Bank &V = *c.v;
+        const int r0 = V.start[(size_t)y0];
+        const int r1 = V.start[(size_t)y1 - 1] + V.taps;
+
+        float *acc = tmp + (size_t)(r1 - r0) * c.dstW;
+        float *line = acc + c.dstW;
+        std::fill(line + c.srcW, line + c.srcW + H.taps4, 0.0f);
+
+        // horizontal: source rows [r0, r1) → tmp (dstW floats per row), each
+        // widened to a contiguous float row first so the taps load as vectors
+        for (int r = r0; r < r1; ++r)
+        {
+            const T *row = reinterpret_cast<const T *>(src + (size_t)r * srcStride) + c.offset;
+            for (int x = 0; x < c.srcW; ++x)
+                line[x] = (float)row[(size_t)x * c.step];
+            float *t = tmp + (size_t)(r - r0) * c.dstW;
+            const int x0 = horizontal_simd(line, H.start.data(), H.coef4.data(), H.taps4, c.dstW, t);
+            horizontal_scalar(line, H.start.data(), H.coef4.data(), H.taps4, c.dstW, t, x0);
+        }
+
+        // vertical: SIMD across the row, then strided store
+        for (int y = y0; y < y1; ++y)
+        {
+            const float *w = &V.coef[(size_t)y * V.taps];
+            const float *rows = tmp + (size_t)(V.start[(size_t)y] - r0) * c.dstW;
+            const int x0 = vertical_simd(rows, c.dstW, w, V.taps, acc);
+            vertical_scalar(rows, c.dstW, w, V.taps, acc, x0);
+
+            T *out = reinterpret_cast<T *>(dst + (size_t)y * dstStride) + c.offset;
+            for (int x = 0; x < c.dstW; ++x)
+                store_sample(out + (size_t)x * c.step, acc[x]);
+        }
+    }
+
+    bool PlaneScaler::scale(const uint8_t *const src[2], const int srcStride[2],
+                            uint8_t *const dst[2], const int dstStride[2])
+    {
+        if (!fmt_valid_)
+            return false;
+
+        const int nComps = (int)comps_.size();
+        const std::function<void(int, int)> task = [&](int t, int worker)
+        {
+            const Component &c = comps_[(size_t)(t / bands_)];
+            const int band = t % bands_;
+            const int rowsPerBand = (c.dstH + bands_ - 1) / bands_;
+            const int y0 = band * rowsPerBand;
+            const int y1 = std::min(c.dstH, y0 + rowsPerBand);
+            if (y0 >= y1)
+                return;
+
+            float *tmp = tmp_[(size_t)worker].data();
+            if (fmt_ == GCAP_FMT_P010)
+                run_band<uint16_t>(c, src[c.plane], srcStride[c.plane], dst[c.plane], dstStride[c.plane], y0, y1, tmp);
+            else
+                run_band<uint8_t>(c, src[c.plane], srcStride[c.plane], dst[c.plane], dstStride[c.plane], y0, y1, tmp);
+        };
+        pool_->run(nComps * bands_, task);
+        return true;
+    }
+}
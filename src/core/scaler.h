@@ -0,0 +1,69 @@
+// scaler.h
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "gcapture.h"
+
+namespace gcap
+{
+    class BandPool;
+
+    /**
+     * @brief Separable resampler for NV12 / P010 / YUY2 / GRAY8 / ARGB planes.
+     *
+     * Filter banks (bilinear, Catmull-Rom bicubic, Lanczos-3) are built once in
+     * configure(); scale() runs a horizontal pass into a float row buffer and a
+     * vertical pass, both SIMD, split into row bands across a BandPool. Chroma
+     * is scaled on its own grid, so no RGB round-trip is involved.
+     */
+    class PlaneScaler
+    {
+    public:
+        PlaneScaler();
+        ~PlaneScaler();
+
+        // Formats: NV12, P010, YUY2, GRAY8, ARGB. Sizes must be even.
+        bool configure(gcap_pixfmt_t fmt, int srcW, int srcH, int dstW, int dstH,
+                       gcap_scale_filter_t filter, int threads = 0);
+        bool configured() const { return fmt_valid_; }
+
+        // NV12/P010: [0]=Y, [1]=UV.  YUY2/GRAY8/ARGB: [0] only.  Strides in bytes.
+        bool scale(const uint8_t *const src[2], const int srcStride[2],
+                   uint8_t *const dst[2], const int dstStride[2]);
+
+        struct Bank
+        {
+            int taps = 0;
+            std::vector<int> start;  // first source index per output sample
+            std::vector<float> coef; // taps weights per output sample (sum = 1)
+            int taps4 = 0;            // taps rounded up to a multiple of 4
+            std::vector<float> coef4; // coef, each sample zero-padded to taps4 (horizontal pass)
+        };
+
+    private:
+        // One colour component: element (x, y) at plane[y * stride + x * step]
+        struct Component
+        {
+            int plane;
+            int offset, step; // elements
+            int srcW, srcH, dstW, dstH;
+            const Bank *h;
+            const Bank *v;
+        };
+
+        template <typename T>
+        void run_band(const Component &c, const uint8_t *src, int srcStride,
+                      uint8_t *dst, int dstStride, int y0, int y1, float *tmp);
+
+        bool fmt_valid_ = false;
+        gcap_pixfmt_t fmt_ = GCAP_FMT_NV12;
+        int bands_ = 1;
+
+        Bank lumaH_, lumaV_, chromaH_, chromaV_;
+        std::vector<Component> comps_;
+
+        std::unique_ptr<BandPool> pool_;
+        std::vector<std::vector<float>> tmp_; // per worker
+    };
+}
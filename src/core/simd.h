@@ -0,0 +1,60 @@
+// simd.h
+#pragma once
+
+// Compile-time SIMD availability for the CPU kernels.
+//  - SSE2 is baseline on x64, NEON on arm64.
+//  - AVX2 kernels are compiled per function (GCAP_TARGET_AVX2) and picked at
+//    runtime with gcap::simd::cpu_has_avx2(), so the DLL still loads on
+//    pre-Haswell machines.
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define GCAP_SIMD_SSE2 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define GCAP_SIMD_AVX2 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#define GCAP_TARGET_AVX2
+#else
+#define GCAP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define GCAP_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace gcap::simd
+{
+    inline bool detect_avx2()
+    {
+#if defined(GCAP_SIMD_AVX2)
+#if defined(_MSC_VER) && !defined(__clang__)
+        int r[4];
+        __cpuid(r, 0);
+        if (r[0] < 7)
+            return false;
+        __cpuid(r, 1);
+        const bool osxsave = (r[2] & (1 << 27)) != 0;
+        const bool avx = (r[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(r, 7, 0);
+        return (r[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+#else
+        return false;
+#endif
+    }
+
+    inline bool cpu_has_avx2()
+    {
+        static const bool has = detect_avx2();
+        return has;
+    }
+}
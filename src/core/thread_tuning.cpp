@@ -0,0 +1,256 @@
+// thread_tuning.cpp
+#include "thread_tuning.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <avrt.h>
+#pragma comment(lib, "avrt.lib")
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+namespace gcap
+{
+    namespace
+    {
+        bool priority_valid(gcap_thread_priority_t p)
+        {
+            return p >= GCAP_THREAD_PRIORITY_NORMAL && p <= GCAP_THREAD_PRIORITY_REALTIME;
+        }
+
+#ifdef _WIN32
+        thread_local HANDLE t_mmcss = nullptr;
+#elif defined(__linux__)
+        constexpr int kNiceHigh = -10;
+        constexpr unsigned long kMpolPreferred = 1; // <linux/mempolicy.h>
+        constexpr int kMaxNodes = 1024;
+
+        // CPUs of a NUMA node; false when the node does not exist
+        bool node_cpus(int node, cpu_set_t &out)
+        {
+            char path[64];
+            std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+            FILE *f = std::fopen(path, "r");
+            if (!f)
+                return false;
+            char list[4096];
+            const bool ok = std::fgets(list, sizeof(list), f) != nullptr;
+            std::fclose(f);
+            if (!ok)
+                return false;
+            // "0-15,32-47"
+            CPU_ZERO(&out);
+            for (char *p = list; *p && *p != '\n';)
+            {
+                char *end = nullptr;
+                const long lo = std::strtol(p, &end, 10);
+                if (end == p)
+                    break;
+                long hi = lo;
+                p = end;
+                if (*p == '-')
+                {
+                    hi = std::strtol(p + 1, &end, 10);
+                    p = end;
+                }
+                for (long c = lo; c <= hi && c < CPU_SETSIZE; ++c)
+                    CPU_SET((int)c, &out);
+                if (*p == ',')
+                    ++p;
+            }
+            return true;
+        }
+#endif
+    }
+
+    bool thread_config_valid(const gcap_thread_config_t &cfg)
+    {
+        if (!priority_valid(cfg.priority) || cfg.affinity_group < 0 || cfg.numa_node < -1)
+            return false;
+        if (cfg.numa_node < 0)
+            return true;
+#ifdef _WIN32
+        ULONG highest = 0;
+        return GetNumaHighestNodeNumber(&highest) && (ULONG)cfg.numa_node <= highest;
+#elif defined(__linux__)
+        cpu_set_t cpus;
+        return cfg.numa_node < kMaxNodes && node_cpus(cfg.numa_node, cpus);
+#else
+        return cfg.numa_node == 0;
+#endif
+    }
+
+    const char *thread_config_apply(const gcap_thread_config_t &cfg, ThreadRole role)
+    {
+        const char *failed = nullptr;
+#ifdef _WIN32
+        if (cfg.priority != GCAP_THREAD_PRIORITY_NORMAL || cfg.mmcss)
+        {
+            if (cfg.mmcss && !t_mmcss)
+            {
+                DWORD task = 0;
+                t_mmcss = AvSetMmThreadCharacteristicsW(role == ThreadRole::Audio ? L"Pro Audio" : L"Capture", &task);
+                if (!t_mmcss)
+                    failed = "MMCSS registration";
+            }
+            if (t_mmcss)
+            {
+                const AVRT_PRIORITY p = cfg.priority == GCAP_THREAD_PRIORITY_REALTIME ? AVRT_PRIORITY_CRITICAL
+                                        : cfg.priority == GCAP_THREAD_PRIORITY_HIGH   ? AVRT_PRIORITY_HIGH
+                                                                                      : AVRT_PRIORITY_NORMAL;
+                if (!AvSetMmThreadPriority(t_mmcss, p))
+                    failed = "MMCSS priority";
+            }
+            else if (cfg.priority != GCAP_THREAD_PRIORITY_NORMAL)
+            {
+                const int p = cfg.priority == GCAP_THREAD_PRIORITY_REALTIME ? THREAD_PRIORITY_TIME_CRITICAL
+                                                                            : THREAD_PRIORITY_HIGHEST;
+                if (!SetThreadPriority(GetCurrentThread(), p))
+                    failed = "thread priority";
+            }
+        }
+
+        if (cfg.affinity_mask || cfg.numa_node >= 0)
+        {
+            GROUP_AFFINITY ga{};
+            ga.Group = (WORD)cfg.affinity_group;
+            ga.Mask = (KAFFINITY)cfg.affinity_mask;
+            bool ok = true;
+            if (cfg.numa_node >= 0)
+            {
+                GROUP_AFFINITY node{};
+                if (!GetNumaNodeProcessorMaskEx((USHORT)cfg.numa_node, &node))
+                    ok = false;
+                else if (!cfg.affinity_mask)
+                    ga = node;
+                else if (node.Group != ga.Group || !(ga.Mask & node.Mask))
+                    ok = false; // the mask has no CPU on that node
+                else
+                    ga.Mask &= node.Mask;
+            }
+            if (!ok)
+                failed = "NUMA node affinity";
+            else if (!SetThreadGroupAffinity(GetCurrentThread(), &ga, nullptr))
+                failed = "CPU affinity";
+        }
+#elif defined(__linux__)
+        (void)role; // no MMCSS
+        if (cfg.priority == GCAP_THREAD_PRIORITY_HIGH)
+        {
+            // per-thread on Linux: the nice value belongs to the task (thread) id
+            if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), kNiceHigh) != 0)
+                failed = "thread priority";
+        }
+        else if (cfg.priority == GCAP_THREAD_PRIORITY_REALTIME)
+        {
+            sched_param sp{};
+            sp.sched_priority = (sched_get_priority_min(SCHED_FIFO) + sched_get_priority_max(SCHED_FIFO)) / 2;
+            if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) != 0)
+                failed = "SCHED_FIFO priority";
+        }
+
+        if (cfg.affinity_mask || cfg.numa_node >= 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int i = 0; i < 64; ++i)
+            {
+                const int cpu = cfg.affinity_group * 64 + i;
+                if ((cfg.affinity_mask >> i) & 1u && cpu < CPU_SETSIZE)
+                    CPU_SET(cpu, &set);
+            }
+            bool ok = true;
+            if (cfg.numa_node >= 0)
+            {
+                cpu_set_t node;
+                if (!node_cpus(cfg.numa_node, node))
+                    ok = false;
+                else if (!cfg.affinity_mask)
+                    set = node;
+                else
+                    CPU_AND(&set, &set, &node);
+                if (ok && CPU_COUNT(&set) == 0)
+                    ok = false; // the mask has no CPU on that node
+            }
+            if (!ok)
+                failed = "NUMA node affinity";
+            else if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+                failed = "CPU affinity";
+        }
+#else
+        (void)role;
+        if (cfg.priority != GCAP_THREAD_PRIORITY_NORMAL || cfg.affinity_mask || cfg.numa_node >= 0)
+            failed = "thread configuration (unsupported platform)";
+#endif
+        return failed;
+    }
+
+    void thread_config_revert()
+    {
+#ifdef _WIN32
+        if (t_mmcss)
+        {
+            AvRevertMmThreadCharacteristics(t_mmcss);
+            t_mmcss = nullptr;
+        }
+#endif
+    }
+
+    void *numa_alloc(size_t bytes, int node)
+    {
+        if (!bytes)
+            return nullptr;
+#ifdef _WIN32
+        if (node >= 0)
+            return VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE,
+                                      (DWORD)node);
+        return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#elif defined(__linux__)
+        void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            return nullptr;
+        if (node >= 0 && node < kMaxNodes)
+        {
+            // pages are placed on first touch, so the policy must be set before
+            unsigned long mask[kMaxNodes / (8 * sizeof(unsigned long))] = {};
+            mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+            syscall(SYS_mbind, p, bytes, kMpolPreferred, mask, (unsigned long)kMaxNodes + 1, 0u);
+        }
+        return p;
+#else
+        (void)node;
+        constexpr size_t kPage = 4096;
+        void *p = std::aligned_alloc(kPage, (bytes + kPage - 1) / kPage * kPage);
+        if (p)
+            std::memset(p, 0, bytes);
+        return p;
+#endif
+    }
+
+    void numa_free(void *p, size_t bytes)
+    {
+        if (!p)
+            return;
+#ifdef _WIN32
+        (void)bytes;
+        VirtualFree(p, 0, MEM_RELEASE);
+#elif defined(__linux__)
+        munmap(p, bytes);
+#else
+        (void)bytes;
+        std::free(p);
+#endif
+    }
+}
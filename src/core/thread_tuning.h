@@ -0,0 +1,105 @@
+// thread_tuning.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "gcapture.h"
+
+namespace gcap
+{
+    /**
+     * @brief Priority, CPU affinity and NUMA placement of the library's threads.
+     *
+     * Windows: SetThreadPriority, optionally MMCSS (avrt), and one
+     * processor group's affinity via SetThreadGroupAffinity, so machines
+     * with more than 64 logical CPUs are covered. Linux: nice / SCHED_FIFO
+     * and pthread_setaffinity_np, with "group" g meaning CPUs 64g..64g+63.
+     * A NUMA node narrows the affinity to the node's CPUs (on Linux read from
+     * /sys/devices/system/node) and numa_alloc() places memory on it
+     * (VirtualAllocExNuma, or mbind with a preferred policy, so a full node
+     * falls back to another one instead of failing).
+     *
+     * Raising priority usually needs privileges (Linux: CAP_SYS_NICE or an
+     * rtprio limit); what cannot be applied is reported and the rest still
+     * is, since a capture thread at normal priority beats no capture.
+     */
+
+    // What a thread does; picks the MMCSS task it joins.
+    enum class ThreadRole
+    {
+        Video, // "Capture"
+        Audio  // "Pro Audio"
+    };
+
+    // false for values the machine cannot honour (unknown priority, missing node)
+    bool thread_config_valid(const gcap_thread_config_t &cfg);
+    // Calling thread. nullptr when all of cfg took effect, else what did not.
+    const char *thread_config_apply(const gcap_thread_config_t &cfg, ThreadRole role);
+    // Calling thread, before it exits: leave MMCSS if apply joined it.
+    void thread_config_revert();
+
+    // Page-aligned, zero-filled memory preferably on `node`; nullptr on failure.
+    void *numa_alloc(size_t bytes, int node);
+    void numa_free(void *p, size_t bytes);
+
+    // Owning numa_alloc() block, for scratch buffers that live as long as a
+    // negotiated format (conversion intermediates, recording input).
+    class NumaBuffer
+    {
+    public:
+        NumaBuffer() = default;
+        ~NumaBuffer() { reset(); }
+
+        NumaBuffer(NumaBuffer &&o) noexcept
+            : data_(std::exchange(o.data_, nullptr)), bytes_(std::exchange(o.bytes_, 0)) {}
+        NumaBuffer &operator=(NumaBuffer &&o) noexcept
+        {
+            if (this != &o)
+            {
+                reset();
+                data_ = std::exchange(o.data_, nullptr);
+                bytes_ = std::exchange(o.bytes_, 0);
+            }
+            return *this;
+        }
+
+        // Replaces the block with `bytes` zero-filled bytes on `node` (-1 =
+        // anywhere); false (and empty) on failure.
+        bool allocate(size_t bytes, int node)
+        {
+            reset();
+            data_ = static_cast<uint8_t *>(numa_alloc(bytes, node));
+            bytes_ = data_ ? bytes : 0;
+            return data_ != nullptr;
+        }
+        void reset()
+        {
+            numa_free(data_, bytes_);
+            data_ = nullptr;
+            bytes_ = 0;
+        }
+
+        uint8_t *data() const { return data_; }
+        size_t size() const { return bytes_; }
+
+    private:
+        uint8_t *data_ = nullptr;
+        size_t bytes_ = 0;
+    };
+
+    // apply() for the lifetime of a thread function.
+    class ScopedThreadConfig
+    {
+    public:
+        ScopedThreadConfig(const gcap_thread_config_t &cfg, ThreadRole role) : failed_(thread_config_apply(cfg, role)) {}
+        ~ScopedThreadConfig() { thread_config_revert(); }
+
+        ScopedThreadConfig(const ScopedThreadConfig &) = delete;
+        ScopedThreadConfig &operator=(const ScopedThreadConfig &) = delete;
+
+        const char *failed() const { return failed_; }
+
+    private:
+        const char *failed_;
+    };
+}
@@ -0,0 +1,217 @@
+// trace.cpp
+#include "trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace gcap
+{
+    namespace trace
+    {
+        namespace
+        {
+            struct Event
+            {
+                std::atomic<const char *> name{nullptr};
+                std::atomic<uint64_t> begin{0};
+                std::atomic<uint64_t> dur{0};
+            };
+
+            struct Ring
+            {
+                std::mutex mutex; // (re)allocation against write()
+                std::unique_ptr<Event[]> events;
+                uint64_t mask = 0;
+                uint32_t epoch = 0; // session the events belong to
+                std::atomic<uint64_t> head{0};
+                std::atomic<const char *> name{nullptr};
+                std::atomic<bool> detached{false}; // its thread exited
+                int tid = 0;
+            };
+
+            std::mutex g_regMutex;
+            std::vector<std::unique_ptr<Ring>> g_rings; // never shrinks: rings are reused
+            std::atomic<uint32_t> g_epoch{0};
+            std::atomic<int> g_capacity{kDefaultEvents};
+
+            struct ThreadRing
+            {
+                Ring *ring = nullptr;
+                const char *name = nullptr;
+                ~ThreadRing()
+                {
+                    if (ring)
+                        ring->detached.store(true, std::memory_order_release);
+                }
+            };
+            thread_local ThreadRing t_ring;
+
+            Ring *attach()
+            {
+                std::lock_guard<std::mutex> lk(g_regMutex);
+                const uint32_t epoch = g_epoch.load(std::memory_order_acquire);
+                Ring *r = nullptr;
+                for (auto &c : g_rings)
+                {
+                    // a dead thread's ring, once its events are from an older session
+                    if (c->detached.load(std::memory_order_acquire))
+                    {
+                        std::lock_guard<std::mutex> rk(c->mutex);
+                        if (c->epoch != epoch)
+                        {
+                            r = c.get();
+                            break;
+                        }
+                    }
+                }
+                if (!r)
+                {
+                    g_rings.push_back(std::make_unique<Ring>());
+                    r = g_rings.back().get();
+                    r->epoch = epoch - 1; // sized on first use
+                    r->tid = (int)g_rings.size();
+                }
+                r->name.store(t_ring.name, std::memory_order_relaxed);
+                r->detached.store(false, std::memory_order_relaxed);
+                t_ring.ring = r;
+                return r;
+            }
+
+            FILE *open_utf8(const char *path)
+            {
+#ifdef _WIN32
+                const int len = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+                if (len <= 0)
+                    return nullptr;
+                std::wstring wpath((size_t)len, L'\0');
+                MultiByteToWideChar(CP_UTF8, 0, path, -1, &wpath[0], len);
+                return _wfopen(wpath.c_str(), L"wb");
+#else
+                return std::fopen(path, "wb");
+#endif
+            }
+        }
+
+        bool enable(bool on, int eventsPerThread)
+        {
+            if (eventsPerThread < 0 || eventsPerThread > kMaxEvents)
+                return false;
+            if (on)
+            {
+                int cap = 1;
+                while (cap < (eventsPerThread ? eventsPerThread : kDefaultEvents))
+                    cap <<= 1;
+                g_capacity.store(cap, std::memory_order_relaxed);
+                g_epoch.fetch_add(1, std::memory_order_release);
+            }
+            detail::enabled.store(on, std::memory_order_relaxed);
+            return true;
+        }
+
+        void setThreadName(const char *name)
+        {
+            t_ring.name = name;
+            if (t_ring.ring)
+                t_ring.ring->name.store(name, std::memory_order_relaxed);
+        }
+
+        void record(const char *name, uint64_t beginNs, uint64_t endNs)
+        {
+            Ring *r = t_ring.ring ? t_ring.ring : attach();
+            const uint32_t epoch = g_epoch.load(std::memory_order_acquire);
+            if (r->epoch != epoch)
+            {
+                // new session: this thread sizes and clears its own ring
+                std::lock_guard<std::mutex> lk(r->mutex);
+                const uint64_t cap = (uint64_t)g_capacity.load(std::memory_order_relaxed);
+                if (r->mask + 1 != cap || !r->events)
+                {
+                    r->events.reset(new (std::nothrow) Event[cap]);
+                    r->mask = r->events ? cap - 1 : 0;
+                }
+                r->head.store(0, std::memory_order_relaxed);
+                r->epoch = epoch;
+            }
+            if (!r->events)
+                return;
+
+            const uint64_t h = r->head.load(std::memory_order_relaxed);
+            Event &e = r->events[h & r->mask];
+            e.name.store(name, std::memory_order_relaxed);
+            e.begin.store(beginNs, std::memory_order_relaxed);
+            e.dur.store(endNs > beginNs ? endNs - beginNs : 0, std::memory_order_relaxed);
+            r->head.store(h + 1, std::memory_order_release);
+        }
+
+        bool write(const char *pathUtf8)
+        {
+            if (!pathUtf8 || !*pathUtf8)
+                return false;
+            FILE *f = open_utf8(pathUtf8);
+            if (!f)
+                return false;
+
+            std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"gcapture\"}}");
+
+            std::vector<Ring *> rings;
+            {
+                std::lock_guard<std::mutex> lk(g_regMutex);
+                for (auto &r : g_rings)
+                    rings.push_back(r.get());
+            }
+            const uint32_t epoch = g_epoch.load(std::memory_order_acquire);
+            struct Copy
+            {
+                const char *name;
+                uint64_t begin, dur;
+            };
+            std::vector<Copy> copy;
+            for (Ring *r : rings)
+            {
+                std::lock_guard<std::mutex> lk(r->mutex);
+                if (r->epoch != epoch || !r->events)
+                    continue;
+                const uint64_t cap = r->mask + 1;
+                const uint64_t h1 = r->head.load(std::memory_order_acquire);
+                const uint64_t first = h1 > cap ? h1 - cap : 0;
+                copy.clear();
+                for (uint64_t i = first; i < h1; ++i)
+                {
+                    const Event &e = r->events[i & r->mask];
+                    copy.push_back({e.name.load(std::memory_order_relaxed), e.begin.load(std::memory_order_relaxed),
+                                    e.dur.load(std::memory_order_relaxed)});
+                }
+                // the writer kept going: drop slots it may have overwritten meanwhile
+                const uint64_t h2 = r->head.load(std::memory_order_acquire);
+                const uint64_t valid = h2 >= cap ? h2 - cap + 1 : 0;
+                const size_t skip = valid > first ? (size_t)std::min<uint64_t>(valid - first, copy.size()) : 0;
+
+                const char *tname = r->name.load(std::memory_order_relaxed);
+                std::fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                             r->tid, tname ? tname : "thread");
+                for (size_t i = skip; i < copy.size(); ++i)
+                {
+                    const Copy &c = copy[i];
+                    if (!c.name)
+                        continue;
+                    std::fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"gcap\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                                 c.name, r->tid, (double)c.begin / 1000.0, (double)c.dur / 1000.0);
+                }
+            }
+            std::fprintf(f, "\n]}\n");
+            const bool ok = !std::ferror(f);
+            return std::fclose(f) == 0 && ok;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+// trace.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace gcap
+{
+    /**
+     * @brief Process-wide scoped trace events, exported as Chrome trace JSON.
+     *
+     * GCAP_TRACE_SCOPE("name") records one complete event (begin + duration)
+     * into the calling thread's ring when its scope ends. Rings are
+     * per-thread, single-writer and fixed-size (oldest events are
+     * overwritten), so recording takes no lock: a clock read at each end and
+     * three relaxed stores. While tracing is off a scope costs one relaxed
+     * load.
+     *
+     * enable(true) starts a new session: every ring forgets what it held and
+     * is (re)sized by its own thread on its next event. write() may run while
+     * tracing is on; it skips slots a writer could be overwriting. Rings of
+     * threads that exited are kept for the dump and reused by later threads
+     * once a newer session starts. Names must be string literals.
+     */
+    namespace trace
+    {
+        constexpr int kDefaultEvents = 1 << 16; // per thread
+        constexpr int kMaxEvents = 1 << 22;
+
+        namespace detail
+        {
+            inline std::atomic<bool> enabled{false};
+        }
+
+        inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+        inline uint64_t nowNs()
+        {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        // eventsPerThread: 0 = kDefaultEvents, rounded up to a power of two;
+        // false when above kMaxEvents.
+        bool enable(bool on, int eventsPerThread = 0);
+        // Shown as the thread's name in the timeline (string literal).
+        void setThreadName(const char *name);
+        void record(const char *name, uint64_t beginNs, uint64_t endNs);
+        // Events of the current session as Chrome trace JSON; false on I/O failure.
+        bool write(const char *pathUtf8);
+
+        class Scope
+        {
+        public:
+            explicit Scope(const char *name) : name_(name), begin_(enabled() ? nowNs() : 0) {}
+            ~Scope()
+            {
+                if (begin_)
+                    record(name_, begin_, nowNs());
+            }
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            const char *name_;
+            uint64_t begin_;
+        };
+    }
+}
+
+#define GCAP_TRACE_CAT2(a, b) a##b
+#define GCAP_TRACE_CAT(a, b) GCAP_TRACE_CAT2(a, b)
+#define GCAP_TRACE_SCOPE(name) ::gcap::trace::Scope GCAP_TRACE_CAT(gcapTraceScope_, __LINE__)(name)
@@ -0,0 +1,51 @@
+// device_watch.cpp
+#include "device_watch.h"
+
+#include <windows.h>
+#include <cfgmgr32.h>
+
+#include <utility>
+
+#pragma comment(lib, "cfgmgr32.lib")
+
+namespace
+{
+    // Interface classes MF and DirectShow enumerate video sources from
+    // (ksmedia.h names; defined here to avoid pulling in the KS GUID library).
+    constexpr GUID kVideoCamera = {0xE5323777, 0xF976, 0x4F5B, {0x9B, 0x55, 0xB9, 0x46, 0x99, 0xC4, 0x6E, 0x44}}; // KSCATEGORY_VIDEO_CAMERA
+    constexpr GUID kCapture = {0x65E8773D, 0x8F56, 0x11D0, {0xA3, 0xB9, 0x00, 0xA0, 0xC9, 0x22, 0x31, 0x96}};     // KSCATEGORY_CAPTURE
+    constexpr GUID kVideo = {0x6994AD05, 0x93EF, 0x11D0, {0xA3, 0xCC, 0x00, 0xA0, 0xC9, 0x22, 0x31, 0x96}};       // KSCATEGORY_VIDEO
+
+    DWORD CALLBACK on_device_notification(HCMNOTIFICATION, PVOID context, CM_NOTIFY_ACTION action,
+                                          PCM_NOTIFY_EVENT_DATA, DWORD)
+    {
+        if (action == CM_NOTIFY_ACTION_DEVICEINTERFACEARRIVAL || action == CM_NOTIFY_ACTION_DEVICEINTERFACEREMOVAL)
+            (*static_cast<std::function<void()> *>(context))();
+        return ERROR_SUCCESS;
+    }
+}
+
+namespace gcap
+{
+    bool watch_video_devices(std::function<void()> onChange)
+    {
+        // the callback and the registrations are intentionally leaked (never unregistered)
+        auto *context = new std::function<void()>(std::move(onChange));
+        int registered = 0, classes = 0;
+        for (const GUID &cls : {kVideoCamera, kCapture, kVideo})
+        {
+            ++classes;
+            CM_NOTIFY_FILTER filter{};
+            filter.cbSize = sizeof(filter);
+            filter.FilterType = CM_NOTIFY_FILTER_TYPE_DEVICEINTERFACE;
+            filter.u.DeviceInterface.ClassGuid = cls;
+            HCMNOTIFICATION handle = nullptr;
+            if (CM_Register_Notification(&filter, context, on_device_notification, &handle) == CR_SUCCESS)
+                ++registered;
+        }
+        if (!registered)
+            delete context;
+        // a class without notifications would leave the cache stale
+        return registered == classes;
+    }
+}
@@ -0,0 +1,12 @@
+// device_watch.h
+#pragma once
+#include <functional>
+
+namespace gcap
+{
+    // Calls onChange (from a system thread) whenever a video capture device
+    // interface (camera, capture card, DirectShow video input) arrives or is
+    // removed. Registered for the life of the process; false when device
+    // notifications are unavailable.
+    bool watch_video_devices(std::function<void()> onChange);
+}
@@ -5,441 +5,29 @@
 #endif
 
 #include "mf_recorder.h"
+#include "../core/trace.h"
 
 #include <mferror.h>
 
-#include <comdef.h>
 #include <windows.h>
 #include <ksmedia.h>
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cmath>
 #include <condition_variable>
-#include <deque>
 #include <mutex>
-#include <sstream>
 
 using Microsoft::WRL::ComPtr;
 
-// WASAPI 需要 ole32
-#pragma comment(lib, "ole32.lib")
-
-static std::string hr_msg(HRESULT hr)
-{
-    _com_error ce(hr);
-    std::ostringstream oss;
-    oss << "hr=0x" << std::hex << std::uppercase << (unsigned long)hr
-        << " (" << (ce.ErrorMessage() ? ce.ErrorMessage() : "unknown") << ")";
-    return oss.str();
-}
-
-// ------------------------------
-// WasapiCapture
-// ------------------------------
-
-WasapiCapture::WasapiCapture() = default;
-
-WasapiCapture::~WasapiCapture()
-{
-    stop();
-}
-
-bool WasapiCapture::start(UINT32 sampleRate, UINT32 channels, UINT32 bits,
-                          const std::wstring &endpointId, ActualFormat *outFmt)
-{
-    stop();
-    // OBS-style: local cursor timeline (do not trust devPos)
-    tsCursor100ns_ = 0;
-
-    sampleRate_ = sampleRate;
-    channels_ = channels;
-    bits_ = bits;
-    endpointId_ = endpointId;
-    {
-        std::lock_guard<std::mutex> lk(initMutex_);
-        initDone_ = false;
-        initOk_ = false;
-        actual_ = {};
-        cap_ = {};
-    }
-
-    running_.store(true);
-    thread_ = std::thread([this]()
-                          { this->run(); });
-    // Wait for init result so caller can decide whether to enable audio
-
-    std::unique_lock<std::mutex> ulk(initMutex_);
-    initCv_.wait_for(ulk, std::chrono::milliseconds(800), [this]()
-                     { return initDone_; });
-    if (outFmt)
-        *outFmt = actual_;
-    return initOk_;
-}
-
-void WasapiCapture::stop()
-{
-    running_.store(false);
-    if (event_)
-        SetEvent(event_);
-    if (thread_.joinable())
-        thread_.join();
-
-    if (captureClient_)
-        captureClient_.Reset();
-    if (audioClient_)
-        audioClient_.Reset();
-    if (dev_)
-        dev_.Reset();
-    if (enumerator_)
-        enumerator_.Reset();
-    if (event_)
-    {
-        CloseHandle(event_);
-        event_ = nullptr;
-    }
-
-    std::lock_guard<std::mutex> lk(mutex_);
-    queue_.clear();
-    tsCursor100ns_ = 0;
-}
-
-bool WasapiCapture::pop(Chunk &out)
-{
-    std::lock_guard<std::mutex> lk(mutex_);
-    if (queue_.empty())
-        return false;
-    out = std::move(queue_.front());
-    queue_.pop_front();
-    return true;
-}
-
-bool WasapiCapture::waitForData(int timeoutMs)
-{
-    std::unique_lock<std::mutex> lk(mutex_);
-    if (!cv_.wait_for(lk, std::chrono::milliseconds(timeoutMs), [&]()
-                      { return !queue_.empty() || !running_.load(); }))
-        return false;
-    return !queue_.empty();
-}
-
-static bool parse_mix_format(WAVEFORMATEX *wfex, WasapiCapture::CaptureFormat &out)
-{
-    if (!wfex)
-        return false;
-
-    out.sampleRate = wfex->nSamplesPerSec;
-    out.channels = wfex->nChannels;
-    out.blockAlign = wfex->nBlockAlign;
-
-    out.bits = wfex->wBitsPerSample;
-    out.isFloat = false;
-
-    if (wfex->wFormatTag == WAVE_FORMAT_IEEE_FLOAT)
-        out.isFloat = true;
-    else if (wfex->wFormatTag == WAVE_FORMAT_EXTENSIBLE)
-    {
-        auto *wfe = reinterpret_cast<WAVEFORMATEXTENSIBLE *>(wfex);
-        if (wfe->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT)
-            out.isFloat = true;
-        out.bits = wfe->Format.wBitsPerSample;
-    }
-    return true;
-}
-
-// Convert float32 or int32 mix format to PCM16 interleaved
-static void mix_to_pcm16(const BYTE *src, UINT32 frames,
-                         const WasapiCapture::CaptureFormat &cap,
-                         std::vector<uint8_t> &dst)
-{
-    const UINT32 ch = cap.channels;
-    dst.resize((size_t)frames * ch * 2);
-    int16_t *out = reinterpret_cast<int16_t *>(dst.data());
-
-    if (cap.isFloat)
-    {
-        const float *in = reinterpret_cast<const float *>(src);
-        const size_t n = (size_t)frames * ch;
-        for (size_t i = 0; i < n; ++i)
-        {
-            float v = in[i];
-            if (v > 1.0f)
-                v = 1.0f;
-            if (v < -1.0f)
-                v = -1.0f;
-            out[i] = (int16_t)lrintf(v * 32767.0f);
-        }
-        return;
-    }
-
-    // 16-bit PCM already
-    if (cap.bits == 16)
-    {
-        memcpy(dst.data(), src, dst.size());
-        return;
-    }
-
-    // 32-bit PCM
-    if (cap.bits == 32)
-    {
-        const int32_t *in = reinterpret_cast<const int32_t *>(src);
-        const size_t n = (size_t)frames * ch;
-        for (size_t i = 0; i < n; ++i)
-            out[i] = (int16_t)(in[i] >> 16);
-        return;
-    }
-
-    // Fallback: silence
-    memset(dst.data(), 0, dst.size());
-}
-
-void WasapiCapture::run()
-{
-    // COM init for this thread
-    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
-    auto notifyInit = [&](bool ok)
-    {
-        std::lock_guard<std::mutex> lk(initMutex_);
-        initDone_ = true;
-        initOk_ = ok;
-        actual_.sampleRate = sampleRate_;
-        actual_.channels = channels_;
-        // We always output PCM16 to the upper layer (OBS-style stability)
-        actual_.bits = (isFloat_ && bits_ == 32) ? 16 : bits_;
-        actual_.isFloat = false;
-        actual_.blockAlign = actual_.channels * (actual_.bits / 8);
-        initCv_.notify_all();
-    };
-
-    HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
-                                  IID_PPV_ARGS(&enumerator_));
-    if (FAILED(hr))
-    {
-        notifyInit(false);
-        CoUninitialize();
-        return;
-    }
-
-    // Use selected endpoint if provided; otherwise fall back to default.
-    if (!endpointId_.empty())
-    {
-        hr = enumerator_->GetDevice(endpointId_.c_str(), &dev_);
-        if (FAILED(hr))
-        {
-            // Device may have been removed / id invalid → fallback to default.
-            hr = enumerator_->GetDefaultAudioEndpoint(eCapture, eConsole, &dev_);
-        }
-    }
-    else
-    {
-        hr = enumerator_->GetDefaultAudioEndpoint(eCapture, eConsole, &dev_);
-    }
-
-    if (FAILED(hr))
-    {
-        notifyInit(false);
-        CoUninitialize();
-        return;
-    }
-
-    hr = dev_->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void **)&audioClient_);
-    if (FAILED(hr))
-    {
-        notifyInit(false);
-        CoUninitialize();
-        return;
-    }
-
-    // Request format (preferred), but fallback to mix format if unsupported.
-    WAVEFORMATEX req{};
-    req.wFormatTag = WAVE_FORMAT_PCM;
-    req.nChannels = (WORD)channels_;
-    req.nSamplesPerSec = sampleRate_;
-    req.wBitsPerSample = (WORD)bits_;
-    req.nBlockAlign = (req.nChannels * req.wBitsPerSample) / 8;
-    req.nAvgBytesPerSec = req.nSamplesPerSec * req.nBlockAlign;
-
-    // event-driven + allow engine conversion when possible
-    const DWORD flags = AUDCLNT_STREAMFLAGS_EVENTCALLBACK |
-                        AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM |
-                        AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY;
-
-    const REFERENCE_TIME bufferDur = 1'000'000; // 100ms (stable recording priority)
-
-    // try requested
-    hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_SHARED, flags, bufferDur, 0, &req, nullptr);
-    if (FAILED(hr))
-    {
-        // fallback: mix format
-        WAVEFORMATEX *mix = nullptr;
-        if (SUCCEEDED(audioClient_->GetMixFormat(&mix)) && mix)
-        {
-            // parse mix format (engine capture format)
-            cap_.blockAlign = mix->nBlockAlign;
-            cap_.sampleRate = mix->nSamplesPerSec;
-            cap_.channels = mix->nChannels;
-            cap_.bits = mix->wBitsPerSample;
-            cap_.isFloat = false;
-            if (mix->wFormatTag == WAVE_FORMAT_IEEE_FLOAT)
-                cap_.isFloat = true;
-            else if (mix->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
-                     mix->cbSize >= (sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX)))
-            {
-                auto ext = reinterpret_cast<WAVEFORMATEXTENSIBLE *>(mix);
-                if (ext->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT)
-                    cap_.isFloat = true;
-            }
-
-            hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_SHARED, flags, bufferDur, 0, mix, nullptr);
-            CoTaskMemFree(mix);
-        }
-        if (FAILED(hr))
-        {
-            notifyInit(false);
-            CoUninitialize();
-            return;
-        }
-    }
-
-    // We ALWAYS output PCM16 to upper layer (match MF input media type),
-    // but the engine capture format may be float32 if we used mix format.
-    if (cap_.sampleRate == 0)
-    {
-        // requested worked => capture format == requested
-        cap_.sampleRate = sampleRate_;
-        cap_.channels = channels_;
-        cap_.bits = bits_;
-        cap_.isFloat = false;
-        cap_.blockAlign = channels_ * (bits_ / 8);
-    }
-
-    // force output format = requested (typically PCM16)
-    isFloat_ = false;
-    if (blockAlign_ == 0)
-        blockAlign_ = channels_ * (bits_ / 8);
-
-    event_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
-    if (!event_)
-    {
-        notifyInit(false);
-        CoUninitialize();
-        return;
-    }
-    hr = audioClient_->SetEventHandle(event_);
-    if (FAILED(hr))
-    {
-        notifyInit(false);
-        CoUninitialize();
-        return;
-    }
-
-    hr = audioClient_->GetService(IID_PPV_ARGS(&captureClient_));
-    if (FAILED(hr))
-    {
-        notifyInit(false);
-        CoUninitialize();
-        return;
-    }
-
-    hr = audioClient_->Start();
-    if (FAILED(hr))
-    {
-        notifyInit(false);
-        CoUninitialize();
-        return;
-    }
-
-    notifyInit(true);
-
-    // capture loop
-    while (running_.load())
-    {
-        // wait signal
-        WaitForSingleObject(event_, 20);
-        if (!running_.load())
-            break;
-
-        UINT32 packet = 0;
-        hr = captureClient_->GetNextPacketSize(&packet);
-        if (FAILED(hr))
-            continue;
-
-        while (packet > 0)
-        {
-            BYTE *data = nullptr;
-            UINT32 frames = 0;
-            DWORD flags2 = 0;
-            UINT64 devPos = 0; // in frames
-            UINT64 qpcPos = 0; // QPC ticks
-            hr = captureClient_->GetBuffer(&data, &frames, &flags2, &devPos, &qpcPos);
-            if (FAILED(hr))
-                break;
-            // OBS-style: build timeline from local cursor; do not trust devPos (Bluetooth devices may jump).
-            const UINT32 bytesPerFrame = (blockAlign_ != 0) ? blockAlign_ : (channels_ * (bits_ / 8));
-            const UINT32 bytesIn = frames * bytesPerFrame;
-
-            Chunk ck;
-            ck.ts100ns = tsCursor100ns_;
-            ck.dur100ns = (LONGLONG)frames * 10'000'000LL / (LONGLONG)sampleRate_;
-
-            // Output is always PCM16 (even if engine gives float32)
-            const UINT32 outBytesPerFrame = channels_ * 2;
-            const UINT32 bytesOut = frames * outBytesPerFrame;
-            ck.pcm.resize(bytesOut);
-
-            if (flags2 & AUDCLNT_BUFFERFLAGS_SILENT || !data)
-            {
-                memset(ck.pcm.data(), 0, bytesOut);
-            }
-            else
-            {
-                if (isFloat_ && bits_ == 32)
-                {
-                    // interleaved float32 [-1,1] -> PCM16
-                    const float *src = reinterpret_cast<const float *>(data);
-                    int16_t *dst16 = reinterpret_cast<int16_t *>(ck.pcm.data());
-                    const size_t samples = (size_t)frames * (size_t)channels_;
-                    for (size_t i = 0; i < samples; ++i)
-                    {
-                        float v = src[i];
-                        if (v > 1.0f)
-                            v = 1.0f;
-                        if (v < -1.0f)
-                            v = -1.0f;
-                        dst16[i] = (int16_t)std::lroundf(v * 32767.0f);
-                    }
-                }
-                else
-                {
-                    // assume PCM16 compatible
-                    memcpy(ck.pcm.data(), data, bytesOut);
-                }
-            }
-
-            captureClient_->ReleaseBuffer(frames);
-
-            {
-                std::lock_guard<std::mutex> lk(mutex_);
-                // cap queue length (~2 seconds for stable recording)
-                const size_t maxQueue = (size_t)200; // 10ms * 200 = 2s
-                if (queue_.size() > maxQueue)
-                    queue_.pop_front();
-                queue_.push_back(std::move(ck));
-            }
-            cv_.notify_one();
-
-            // Keep cursor for debug only; real timestamp uses devPos.
-            tsCursor100ns_ += ck.dur100ns;
-
-            hr = captureClient_->GetNextPacketSize(&packet);
-            if (FAILED(hr))
-                break;
-        }
-    }
-
-    audioClient_->Stop();
-    CoUninitialize();
-}
+// GCAP_LOG to the owning provider's log (gcap_set_log_callback); MfRecorder members only.
+#define RLOG(level, ...)                              \
+    do                                                \
+    {                                                 \
+        if (this->log)                                \
+            GCAP_LOG(*this->log, level, __VA_ARGS__); \
+    } while (0)
 
 // ------------------------------
 // WinMFProvider::MfRecorder
@@ -448,7 +36,8 @@ void WasapiCapture::run()
 void WinMFProvider::MfRecorder::stopAudioThread()
 {
     audioRunning.store(false);
-    wasapi.stop();
+    if (audioSource)
+        audioSource->stop();
     if (audioThread.joinable())
         audioThread.join();
 }
@@ -456,11 +45,25 @@ void WinMFProvider::MfRecorder::stopAudioThread()
 void WinMFProvider::MfRecorder::close()
 {
     stopAudioThread();
+    if (hasAudio)
+    {
+        const auto rs = audioSource->ringStats();
+        if (rs.droppedPackets)
+            RLOG(GCAP_LOG_WARN, "[WinMF][Audio] ring overflow: dropped {} packets ({} bytes), high water {}/{}",
+                 rs.droppedPackets, rs.droppedBytes, rs.highWater, rs.capacity);
+        if (drift)
+        {
+            gcap_av_sync_stats_t ds{};
+            drift->stats(ds);
+            RLOG(GCAP_LOG_INFO, "[WinMF][Audio] A/V drift {} ppm ({} ms over the recording), correction {} ppm, {} restarts",
+                 ds.drift_ppm, ds.drift_ms, ds.correction_ppm, ds.rebases);
+        }
+    }
     if (writer)
     {
         HRESULT hr = writer->Finalize();
         if (FAILED(hr))
-            OutputDebugStringA(("[WinMF][Rec] Finalize failed: " + hr_msg(hr) + "\n").c_str());
+            RLOG(GCAP_LOG_ERROR, "[WinMF][Rec] Finalize failed: hr={}", gcap::LogHex{(uint32_t)hr});
         writer.Reset();
     }
     firstTs100ns = -1;
@@ -504,7 +107,7 @@ bool WinMFProvider::MfRecorder::writeOneAudioSample(LONGLONG ts100ns, LONGLONG d
     hr = writer->WriteSample(audioStreamIndex, s.Get());
     if (FAILED(hr))
     {
-        OutputDebugStringA(("[WinMF][Audio] WriteSample failed: " + hr_msg(hr) + "\\n").c_str());
+        RLOG(GCAP_LOG_ERROR, "[WinMF][Audio] WriteSample failed: hr={}", gcap::LogHex{(uint32_t)hr});
         return false;
     }
     return true;
@@ -514,39 +117,51 @@ bool WinMFProvider::MfRecorder::writeAudioDrainOnce()
 {
     if (!writer || !hasAudio)
         return true;
+    GCAP_TRACE_SCOPE("record.audio");
 
-    const UINT32 bytesPerSample = audioBits / 8;
-    const UINT32 blockAlign = (audioBlockAlign != 0) ? audioBlockAlign : (audioChannels * bytesPerSample);
-
-    const UINT32 frameSamples = audioSampleRate / 50; // 20ms @ audioSampleRate
-    const UINT32 frameBytes = frameSamples * blockAlign;
+    const UINT32 frameSamples = audioSampleRate / 50;         // 20ms @ audioSampleRate
+    const DWORD frameBytes = (DWORD)audioSlicer.frameBytes(); // sized in open()
     const LONGLONG frameDur100ns = (LONGLONG)frameSamples * 10'000'000LL / (LONGLONG)audioSampleRate;
 
     // Limit work per call so audio thread won't hog CPU
     const int kMaxChunksPerCall = 32;
 
-    WasapiCapture::Chunk ck;
+    gcap::audio::AudioChunk ck;
     int processed = 0;
-    while (processed < kMaxChunksPerCall && wasapi.pop(ck))
+    while (processed < kMaxChunksPerCall && audioSource->peek(ck))
     {
         processed++;
 
         // We ignore ck.ts100ns from device and build a continuous timeline by consumed samples (OBS-style).
-        // Append bytes
-        if (!ck.pcm.empty())
+        // Only when the ring dropped packets do we skip the PTS ahead by the missing time.
+        if (ck.discontinuity && ck.ts100ns > audioChunkEnd100ns)
+            audioPtsCursor100ns += ck.ts100ns - audioChunkEnd100ns;
+        audioChunkEnd100ns = ck.ts100ns + ck.dur100ns;
+
+        // Slice into fixed frames; each frame is written straight from the slicer.
+        const uint8_t *src = ck.pcm;
+        size_t left = ck.bytes;
+        bool ok = true;
+        while (left && ok)
         {
-            audioAccum.insert(audioAccum.end(), ck.pcm.begin(), ck.pcm.end());
-        }
-
-        // Emit fixed frames
-        while (audioAccum.size() >= frameBytes)
-        {
-            if (!writeOneAudioSample(audioPtsCursor100ns, frameDur100ns, audioAccum.data(), frameBytes))
-                return false;
+            const size_t n = audioSlicer.push(src, left);
+            src += n;
+            left -= n;
 
-            audioPtsCursor100ns += frameDur100ns;
-            audioAccum.erase(audioAccum.begin(), audioAccum.begin() + frameBytes);
+            while (const uint8_t *frame = audioSlicer.front())
+            {
+                if (!writeOneAudioSample(audioPtsCursor100ns, frameDur100ns, frame, frameBytes))
+                {
+                    ok = false;
+                    break;
+                }
+                audioPtsCursor100ns += frameDur100ns;
+                audioSlicer.pop();
+            }
         }
+        audioSource->release();
+        if (!ok)
+            return false;
     }
 
     return true;
@@ -554,7 +169,9 @@ bool WinMFProvider::MfRecorder::writeAudioDrainOnce()
 
 bool WinMFProvider::MfRecorder::open(const std::wstring &path, UINT32 w, UINT32 h,
                                      UINT32 fpsN, UINT32 fpsD, bool p010,
-                                     const std::wstring &audioEndpointIdW)
+                                     const std::wstring &audioEndpointIdW,
+                                     UINT32 outW, UINT32 outH,
+                                     gcap_scale_filter_t filter)
 {
     close();
 
@@ -564,6 +181,15 @@ bool WinMFProvider::MfRecorder::open(const std::wstring &path, UINT32 w, UINT32
     isP010 = p010;
     width = w;
     height = h;
+    outWidth = (outW && outH) ? outW : w;
+    outHeight = (outW && outH) ? outH : h;
+
+    if (outWidth != width || outHeight != height)
+    {
+        if (!scaler.configure(isP010 ? GCAP_FMT_P010 : GCAP_FMT_NV12,
+                              (int)width, (int)height, (int)outWidth, (int)outHeight, filter))
+            return false;
+    }
     fpsNum = fpsN;
     fpsDen = fpsD;
     this->fpsN = fpsN;
@@ -604,7 +230,7 @@ bool WinMFProvider::MfRecorder::open(const std::wstring &path, UINT32 w, UINT32
     if (FAILED(hr))
         return false;
 
-    hr = MFSetAttributeSize(outType.Get(), MF_MT_FRAME_SIZE, w, h);
+    hr = MFSetAttributeSize(outType.Get(), MF_MT_FRAME_SIZE, outWidth, outHeight);
     if (FAILED(hr))
         return false;
 
@@ -636,7 +262,7 @@ bool WinMFProvider::MfRecorder::open(const std::wstring &path, UINT32 w, UINT32
     if (FAILED(hr))
         return false;
 
-    hr = MFSetAttributeSize(inType.Get(), MF_MT_FRAME_SIZE, w, h);
+    hr = MFSetAttributeSize(inType.Get(), MF_MT_FRAME_SIZE, outWidth, outHeight);
     if (FAILED(hr))
         return false;
 
@@ -662,18 +288,38 @@ bool WinMFProvider::MfRecorder::open(const std::wstring &path, UINT32 w, UINT32
         //  - Assemble fixed 20ms frames (in audio thread) before writing to SinkWriter
         // ------------------------------
         hasAudio = false;
-        audioAccum.clear();
+        audioSlicer.reset();
         audioPtsCursor100ns = 0;
+        audioChunkEnd100ns = 0;
 
-        WasapiCapture::ActualFormat af{};
-        if (wasapi.start(audioSampleRate, audioChannels, audioBits, audioEndpointIdW, &af))
+        if (drift)
+            drift->reset();
+        audioSource = gcap::audio::create_audio_source(audioEndpointIdW);
+        if (audioSource)
+        {
+            audioSource->setMeter(meter);
+            audioSource->setDriftCorrection(drift);
+            audioSource->setThreadHook(audioThreadHook);
+        }
+
+        gcap::audio::AudioFormat af{};
+        if (audioSource && audioSource->start(audioSampleRate, audioChannels, audioBits, audioEndpointIdW, &af))
         {
             hasAudio = true;
+            if (drift)
+                drift->reset((int)audioSource->deviceRate());
             audioSampleRate = af.sampleRate ? af.sampleRate : audioSampleRate;
             audioChannels = af.channels ? af.channels : audioChannels;
-            audioBits = af.bits ? af.bits : audioBits; // WasapiCapture guarantees PCM16 output
+            audioBits = af.bits ? af.bits : audioBits; // sources guarantee PCM16 output
             audioIsFloat = false;
             audioBlockAlign = af.blockAlign ? af.blockAlign : (audioChannels * (audioBits / 8));
+
+            // 20 ms frames; a few frames of slack covers any WASAPI packet size
+            if (!audioSlicer.configure((size_t)(audioSampleRate / 50) * audioBlockAlign, 8))
+            {
+                audioSource->stop();
+                hasAudio = false;
+            }
         }
 
         ComPtr<IMFMediaType> outAud;
@@ -783,10 +429,11 @@ bool WinMFProvider::MfRecorder::open(const std::wstring &path, UINT32 w, UINT32
         audioRunning.store(true);
         audioThread = std::thread([this]()
                                   {
+                gcap::trace::setThreadName("recorder-audio");
                 while (audioRunning.load())
                 {
                     // wait for audio data or timeout; drain whatever we have
-                    wasapi.waitForData(50);
+                    audioSource->waitForData(50);
                     if (!writeAudioDrainOnce())
                         break;
                 }
@@ -800,17 +447,8 @@ bool WinMFProvider::MfRecorder::open(const std::wstring &path, UINT32 w, UINT32
         const char *inputName = isP010 ? "P010 10-bit" : "NV12 8-bit";
         const UINT32 kbps = 8000000 / 1000;
 
-        std::ostringstream oss;
-        oss << "[WinMF] Recorder open: codec=" << codecName
-            << ", input=" << inputName
-            << ", " << w << "x" << h
-            << " @ " << fpsN;
-        if (fpsD != 1)
-            oss << "/" << fpsD;
-        oss << " fps"
-            << ", target bitrate=" << kbps << " kbps\n";
-
-        OutputDebugStringA(oss.str().c_str());
+        RLOG(GCAP_LOG_INFO, "[WinMF] Recorder open: codec={}, input={} {}x{}, encoded {}x{} @ {}/{} fps, target bitrate={} kbps",
+             codecName, inputName, w, h, outWidth, outHeight, fpsN, fpsD, kbps);
     }
 
     return true;
@@ -822,12 +460,14 @@ bool WinMFProvider::MfRecorder::writePlanar(const uint8_t *y, const uint8_t *uv,
 {
     if (!writer || !y || !uv)
         return false;
+    GCAP_TRACE_SCOPE("record.video");
 
     if (firstTs100ns < 0)
         firstTs100ns = ts100ns;
 
-    const UINT32 w = width;
-    const UINT32 h = height;
+    const UINT32 w = outWidth;
+    const UINT32 h = outHeight;
+    const bool scaled = (w != width || h != height);
 
     // tight packed stride (no padding)
     const UINT32 bpp = isP010 ? 2 : 1; // NV12:1 byte, P010:2 bytes per sample
@@ -857,20 +497,32 @@ bool WinMFProvider::MfRecorder::writePlanar(const uint8_t *y, const uint8_t *uv,
     BYTE *dstY = dst;
     BYTE *dstUV = dst + yBytes;
 
-    // copy Y (only valid width, ignore source padding)
-    for (UINT32 row = 0; row < h; ++row)
+    if (scaled)
     {
-        memcpy(dstY + rowBytesY_tight * row,
-               y + yStrideBytes * row,
-               rowBytesY_tight);
+        // resample straight into the sample buffer
+        const uint8_t *const srcPlanes[2] = {y, uv};
+        const int srcStrides[2] = {(int)yStrideBytes, (int)uvStrideBytes};
+        uint8_t *const dstPlanes[2] = {dstY, dstUV};
+        const int dstStrides[2] = {(int)rowBytesY_tight, (int)rowBytesUV_tight};
+        scaler.scale(srcPlanes, srcStrides, dstPlanes, dstStrides);
     }
-
-    // copy UV (h/2 rows)
-    for (UINT32 row = 0; row < h / 2; ++row)
+    else
     {
-        memcpy(dstUV + rowBytesUV_tight * row,
-               uv + uvStrideBytes * row,
-               rowBytesUV_tight);
+        // copy Y (only valid width, ignore source padding)
+        for (UINT32 row = 0; row < h; ++row)
+        {
+            memcpy(dstY + rowBytesY_tight * row,
+                   y + yStrideBytes * row,
+                   rowBytesY_tight);
+        }
+
+        // copy UV (h/2 rows)
+        for (UINT32 row = 0; row < h / 2; ++row)
+        {
+            memcpy(dstUV + rowBytesUV_tight * row,
+                   uv + uvStrideBytes * row,
+                   rowBytesUV_tight);
+        }
     }
 
     buf->Unlock();
@@ -884,6 +536,10 @@ bool WinMFProvider::MfRecorder::writePlanar(const uint8_t *y, const uint8_t *uv,
     LONGLONG rtStart = ts100ns - firstTs100ns;
     sample->SetSampleTime(rtStart);
 
+    // audio clock vs this timeline; corrected on the capture thread
+    if (drift && hasAudio)
+        drift->observe(rtStart, audioSource->capturedFrames(), audioSource->discontinuities());
+
     // duration: 1 frame
     // vFpsN/vFpsD are already stored in recorder (if you don't have them, compute from profile)
     if (fpsN != 0)
@@ -901,7 +557,7 @@ bool WinMFProvider::MfRecorder::writePlanar(const uint8_t *y, const uint8_t *uv,
     hr = writer->WriteSample(streamIndex, sample.Get());
     if (FAILED(hr))
     {
-        OutputDebugStringA(("[WinMF][Rec] video WriteSample failed: " + hr_msg(hr) + "\\n").c_str());
+        RLOG(GCAP_LOG_ERROR, "[WinMF][Rec] video WriteSample failed: hr={}", gcap::LogHex{(uint32_t)hr});
         return false;
     }
 
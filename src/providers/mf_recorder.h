@@ -1,114 +1,28 @@
 #pragma once
 
 // Recording layer extracted from winmf_provider.cpp
-// - WasapiCapture helper (WASAPI endpoint capture into a queue)
 // - WinMFProvider::MfRecorder (Media Foundation Sink Writer recorder)
+// - audio comes from a gcap::audio::IAudioSource (WASAPI, or synthetic for "synthetic:..." ids),
+//   sharing the device client with a standalone audio session on the same endpoint
 
 // Need the full WinMFProvider declaration (the nested MfRecorder is declared there).
 #include "winmf_provider.h"
+#include "../core/logger.h"
+#include "../core/scaler.h"
+#include "../audio/audio_source.h"
+#include "../audio/frame_slicer.h"
 
 #include <windows.h>
 
-#include <mmdeviceapi.h>
-#include <audioclient.h>
-
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
-#include <deque>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
-// ------------------------------------------------------------
-// WASAPI capture (old stable behavior)
-//  - Shared mode
-//  - Event-driven capture
-//  - Prefer requested PCM format; fallback to mix format
-//  - Enable engine conversion (AUTOCONVERTPCM + SRC_DEFAULT_QUALITY)
-//  - Output is ALWAYS PCM16 to the upper layer (OBS-style stability)
-// ------------------------------------------------------------
-class WasapiCapture
-{
-public:
-    struct Chunk
-    {
-        LONGLONG ts100ns = 0;     // relative timeline
-        LONGLONG dur100ns = 0;    // duration
-        std::vector<uint8_t> pcm; // interleaved bytes (PCM16)
-    };
-
-    struct ActualFormat
-    {
-        UINT32 sampleRate = 0;
-        UINT32 channels = 0;
-        UINT32 bits = 0;
-        bool isFloat = false;
-        UINT32 blockAlign = 0;
-    };
-
-    // actual capture format from audio engine (may be float32)
-    struct CaptureFormat
-    {
-        UINT32 sampleRate = 0;
-        UINT32 channels = 0;
-        UINT32 bits = 0;
-        bool isFloat = false;
-        UINT32 blockAlign = 0;
-    };
-
-    // Special members are defined in mf_recorder.cpp, so they must be declared here.
-    WasapiCapture();
-    ~WasapiCapture();
-
-    WasapiCapture(const WasapiCapture &) = delete;
-    WasapiCapture &operator=(const WasapiCapture &) = delete;
-    WasapiCapture(WasapiCapture &&) = delete;
-    WasapiCapture &operator=(WasapiCapture &&) = delete;
-
-    bool start(UINT32 sampleRate, UINT32 channels, UINT32 bits,
-               const std::wstring &endpointId, ActualFormat *outFmt = nullptr);
-    void stop();
-
-    // non-blocking pop
-    bool pop(Chunk &out);
-
-    // wait until queue has data or stopped (does NOT consume)
-    bool waitForData(int timeoutMs);
-
-private:
-    void run();
-
-    std::atomic<bool> running_{false};
-    std::thread thread_;
-    HANDLE event_ = nullptr;
-
-    Microsoft::WRL::ComPtr<IMMDeviceEnumerator> enumerator_;
-    Microsoft::WRL::ComPtr<IMMDevice> dev_;
-    Microsoft::WRL::ComPtr<IAudioClient> audioClient_;
-    Microsoft::WRL::ComPtr<IAudioCaptureClient> captureClient_;
-
-    UINT32 sampleRate_ = 48000;
-    UINT32 channels_ = 2;
-    UINT32 bits_ = 16;
-    std::wstring endpointId_;
-    bool isFloat_ = false;
-    UINT32 blockAlign_ = 0;
-    CaptureFormat cap_{};
-
-    std::mutex mutex_;
-    std::condition_variable cv_;
-    std::deque<Chunk> queue_;
-    LONGLONG tsCursor100ns_ = 0;
-
-    std::mutex initMutex_;
-    std::condition_variable initCv_;
-    bool initDone_ = false;
-    bool initOk_ = false;
-    ActualFormat actual_{};
-};
-
 // Media Foundation Sink Writer recorder (NV12->H.264, P010->HEVC) extracted.
 // NOTE: This is still a nested type of WinMFProvider.
 struct WinMFProvider::MfRecorder
@@ -129,19 +43,27 @@ struct WinMFProvider::MfRecorder
     bool audioIsFloat = false;
     UINT32 audioBlockAlign = 0;
 
-    UINT32 width = 0;
+    UINT32 width = 0;     // capture (input) size
     UINT32 height = 0;
+    UINT32 outWidth = 0;  // encoded size
+    UINT32 outHeight = 0;
+    gcap::PlaneScaler scaler; // configured only when the sizes differ
     UINT32 fpsNum = 0;
     UINT32 fpsDen = 1;
     bool isP010 = false;        // false: NV12 -> H.264, true: P010 -> HEVC
     LONGLONG firstTs100ns = -1; // first video ts as 0
 
-    WasapiCapture wasapi; // WASAPI capture + queue
+    std::unique_ptr<gcap::audio::IAudioSource> audioSource; // created in open() from the endpoint id
+    gcap::Logger *log = nullptr;                            // owned by WinMFProvider
+    gcap::audio::LevelMeter *meter = nullptr;               // owned by WinMFProvider
+    gcap::audio::AvDriftEstimator *drift = nullptr;         // owned by WinMFProvider; fed by writePlanar()
+    std::function<void(bool)> audioThreadHook;              // placement of the capture thread (gcap_set_thread_config)
 
     // audio timeline state (relative 100ns, 0-based)
     LONGLONG lastAudioTs100ns = 0;
-    std::vector<uint8_t> audioAccum;  // PCM16 bytes accumulator
+    gcap::audio::FrameSlicer audioSlicer; // PCM16 -> fixed 20 ms frames
     LONGLONG audioPtsCursor100ns = 0; // continuous audio PTS (OBS-style)
+    LONGLONG audioChunkEnd100ns = 0;  // capture-side end of the last chunk (gap detection)
 
     void stopAudioThread();
     void close();
@@ -150,7 +72,9 @@ struct WinMFProvider::MfRecorder
               UINT32 w, UINT32 h,
               UINT32 fpsN, UINT32 fpsD,
               bool p010,
-              const std::wstring &audioEndpointIdW);
+              const std::wstring &audioEndpointIdW,
+              UINT32 outW = 0, UINT32 outH = 0,
+              gcap_scale_filter_t filter = GCAP_SCALE_BILINEAR);
 
     bool writeNV12(const uint8_t *y, const uint8_t *uv,
                    UINT32 yStride, UINT32 uvStride,
@@ -39,6 +39,7 @@ namespace
 }
 #pragma comment(lib, "setupapi.lib")
 #include "../core/frame_converter.h"
+#include "../core/trace.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -78,30 +79,51 @@ static std::string utf8_from_wide(const std::wstring &ws)
     return wide_to_utf8(ws);
 }
 
-static gcap_pixfmt_t mfsub_to_gcap(const GUID &sub)
+// FourCC subtypes without an MFVideoFormat_* constant in the SDK headers
+static const GUID kMFVideoFormat_NV16 = {FCC('NV16'), 0x0000, 0x0010, {0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71}};
+static const GUID kMFVideoFormat_NV24 = {FCC('NV24'), 0x0000, 0x0010, {0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71}};
+
+static bool try_mfsub_to_gcap(const GUID &sub, gcap_pixfmt_t &out)
 {
     if (sub == MFVideoFormat_NV12)
-        return GCAP_FMT_NV12;
-    if (sub == MFVideoFormat_YUY2)
-        return GCAP_FMT_YUY2;
-    if (sub == MFVideoFormat_P010)
-        return GCAP_FMT_P010;
-    if (sub == MFVideoFormat_ARGB32)
-        return GCAP_FMT_ARGB;
-    return GCAP_FMT_ARGB; // fallback（你也可改成 NV12）
+        out = GCAP_FMT_NV12;
+    else if (sub == MFVideoFormat_YUY2)
+        out = GCAP_FMT_YUY2;
+    else if (sub == MFVideoFormat_P010)
+        out = GCAP_FMT_P010;
+    else if (sub == MFVideoFormat_ARGB32)
+        out = GCAP_FMT_ARGB;
+    else if (sub == MFVideoFormat_v210)
+        out = GCAP_FMT_V210;
+    else if (sub == kMFVideoFormat_NV16)
+        out = GCAP_FMT_NV16;
+    else if (sub == MFVideoFormat_P210)
+        out = GCAP_FMT_P210;
+    else if (sub == kMFVideoFormat_NV24)
+        out = GCAP_FMT_NV24;
+    else if (sub == MFVideoFormat_Y210)
+        out = GCAP_FMT_Y210;
+    else
+        return false;
+    return true;
 }
 
-static int pixfmt_bitdepth(gcap_pixfmt_t f)
+static gcap_pixfmt_t mfsub_to_gcap(const GUID &sub)
 {
-    switch (f)
-    {
-    case GCAP_FMT_P010:
-    case GCAP_FMT_R210:
-    case GCAP_FMT_V210:
-        return 10;
-    default:
-        return 8;
-    }
+    gcap_pixfmt_t f = GCAP_FMT_ARGB; // fallback（你也可改成 NV12）
+    try_mfsub_to_gcap(sub, f);
+    return f;
+}
+
+// D3D11 texture the CPU planes of a format are uploaded into for the YUV
+// shaders; DXGI_FORMAT_UNKNOWN when no shader reads that layout.
+static DXGI_FORMAT upload_texture_format(const gcap::PixelFormatDesc &d)
+{
+    if (d.yuv && d.planeCount == 2 && d.chromaShiftX == 1 && d.chromaShiftY == 1)
+        return d.bitDepth > 8 ? DXGI_FORMAT_P010 : DXGI_FORMAT_NV12;
+    if (d.yuv && d.planeCount == 1 && d.plane[0].bytesPerBlock == 4 && d.plane[0].pixelsPerBlock == 2)
+        return DXGI_FORMAT_R8G8B8A8_UINT; // YUY2: one Y0 U Y1 V block per texel, read with Texture2D<uint4>.Load
+    return DXGI_FORMAT_UNKNOWN;
 }
 
 static std::wstring get_mf_string(IMFActivate *act, const GUID &key)
@@ -217,7 +239,7 @@ bool WinMFProvider::getSignalStatus(gcap_signal_status_t &out)
     out.fps_num = (cur_fps_num_ > 0) ? cur_fps_num_ : 0;
     out.fps_den = (cur_fps_den_ > 0) ? cur_fps_den_ : 1;
     out.pixfmt = mfsub_to_gcap(cur_subtype_);
-    out.bit_depth = pixfmt_bitdepth(out.pixfmt);
+    out.bit_depth = gcap::pixfmt_desc(out.pixfmt).bitDepth;
     out.csp = GCAP_CSP_UNKNOWN;
     out.range = GCAP_RANGE_UNKNOWN;
     out.hdr = -1;
@@ -226,9 +248,112 @@ bool WinMFProvider::getSignalStatus(gcap_signal_status_t &out)
 
 bool WinMFProvider::setProcessing(const gcap_processing_opts_t &opts)
 {
-    (void)opts;
-    // 先回不支援：等你要做「切 NV12/YUY2/P010 / Deinterlace」再補 setProfile / rebuild reader
-    return false;
+    // Deinterlace / range overrides are still not wired; only the delivered
+    // pixel format is honoured (CPU path, from the next start()).
+    if (!gcap::pixfmt_valid(opts.preferred_pixfmt))
+        return false;
+    deliver_fmt_ = opts.preferred_pixfmt;
+    return true;
+}
+
+gcap_status_t WinMFProvider::setPrivacyMasks(const gcap_mask_region_t *regions, int count)
+{
+    return mask_.setRegions(regions, count) ? GCAP_OK : GCAP_EINVAL;
+}
+
+gcap_status_t WinMFProvider::setHealthInterval(int everyNFrames)
+{
+    health_.setInterval(everyNFrames);
+    return GCAP_OK;
+}
+
+gcap_status_t WinMFProvider::getHealthStats(gcap_health_stats_t &out)
+{
+    health_.stats(out);
+    return GCAP_OK;
+}
+
+gcap_status_t WinMFProvider::getAudioLevels(gcap_audio_levels_t &out)
+{
+    audio_meter_.levels(out);
+    return GCAP_OK;
+}
+
+gcap_status_t WinMFProvider::getAvSyncStats(gcap_av_sync_stats_t &out)
+{
+    av_drift_.stats(out);
+    return GCAP_OK;
+}
+
+gcap_status_t WinMFProvider::acquireFrame(int timeoutMs, const gcap_frame_t *&out)
+{
+    return mailbox_.acquire(timeoutMs, out);
+}
+
+gcap_status_t WinMFProvider::addConsumer(const gcap_consumer_desc_t &desc, int &id)
+{
+    return fanout_.add(desc, id);
+}
+
+gcap_status_t WinMFProvider::removeConsumer(int id)
+{
+    return fanout_.remove(id);
+}
+
+gcap_status_t WinMFProvider::setDelivery(gcap_delivery_policy_t policy, int queueDepth)
+{
+    return delivery_.configure(policy, queueDepth) ? GCAP_OK : GCAP_EINVAL;
+}
+
+gcap_status_t WinMFProvider::getDeliveryStats(gcap_delivery_stats_t &out)
+{
+    delivery_.stats(out);
+    return GCAP_OK;
+}
+
+gcap_status_t WinMFProvider::setFrameRate(int fpsNum, int fpsDen, bool blend)
+{
+    return pacer_.configure(fpsNum, fpsDen, blend) ? GCAP_OK : GCAP_EINVAL;
+}
+
+gcap_status_t WinMFProvider::getPacingStats(gcap_pacing_stats_t &out)
+{
+    pacer_.stats(out);
+    return GCAP_OK;
+}
+
+gcap_status_t WinMFProvider::getClockStats(gcap_clock_stats_t &out)
+{
+    clock_.stats(out);
+    return GCAP_OK;
+}
+
+uint64_t WinMFProvider::copied_bytes() const
+{
+    return delivery_.copiedBytes() + mailbox_.copiedBytes() + pacer_.copiedBytes();
+}
+
+gcap_status_t WinMFProvider::getStats(gcap_stats_t &out)
+{
+    gcap_delivery_stats_t d{};
+    gcap_pacing_stats_t p{};
+    gcap_clock_stats_t c{};
+    delivery_.stats(d);
+    pacer_.stats(p);
+    clock_.stats(c);
+
+    out = {};
+    out.frames_captured = frames_captured_.load(std::memory_order_relaxed);
+    out.frames_delivered = d.delivered;
+    out.frames_dropped = d.dropped_oldest + d.dropped_newest + d.dropped_no_buffer + p.dropped;
+    out.frames_duplicated = p.duplicated;
+    out.frames_lost = c.dropped;
+    out.bytes_copied = copied_bytes() - copied_base_.load(std::memory_order_relaxed);
+    out.queue_depth = d.queued;
+    out.queue_high_water = d.high_water;
+    for (int i = 0; i < GCAP_STAGE_COUNT; ++i)
+        stage_ns_[i].snapshot(out.stage[i]);
+    return GCAP_OK;
 }
 
 // ---- logging helpers (for negotiated media type / stride debug) ----
@@ -246,6 +371,16 @@ static const char *mf_subtype_name(const GUID &g)
         return "RGB32";
     if (g == MFVideoFormat_MJPG)
         return "MJPG";
+    if (g == MFVideoFormat_v210)
+        return "v210";
+    if (g == kMFVideoFormat_NV16)
+        return "NV16";
+    if (g == MFVideoFormat_P210)
+        return "P210";
+    if (g == kMFVideoFormat_NV24)
+        return "NV24";
+    if (g == MFVideoFormat_Y210)
+        return "Y210";
     return "(unknown)";
 }
 
@@ -284,23 +419,39 @@ gcap_status_t WinMFProvider::startRecording(const char *pathUtf8)
     if (!pathUtf8 || !*pathUtf8)
         return GCAP_EINVAL;
 
-    // 目前只支援 NV12 / P010 兩種 YUV 型態
-    bool isP010Format = false;
-    if (cur_subtype_ == MFVideoFormat_P010)
-    {
-        isP010Format = true;
-    }
-    else if (cur_subtype_ == MFVideoFormat_NV12)
-    {
-        isP010Format = false;
-    }
-    else
-    {
+    // Encoder input is NV12 (H.264) or P010 (HEVC); other YUV sources are
+    // converted by rec_plan_ (10-bit sources keep 10 bits).
+    gcap_pixfmt_t nativeFmt = GCAP_FMT_NV12;
+    if (!try_mfsub_to_gcap(cur_subtype_, nativeFmt))
         return GCAP_ENOTSUP;
+    const gcap_pixfmt_t recFmt = gcap::pixfmt_desc(nativeFmt).bitDepth > 8 ? GCAP_FMT_P010 : GCAP_FMT_NV12;
+    const int node = thread_config().numa_node;
+    rec_plan_.setNumaNode(node);
+    if (!rec_plan_.build(nativeFmt, cur_w_, cur_h_, recFmt, cur_w_, cur_h_))
+        return GCAP_ENOTSUP;
+    if (!rec_plan_.passthrough())
+    {
+        const int recStride = gcap::pixfmt_row_bytes(recFmt, 0, cur_w_);
+        if (!rec_buf_.allocate(gcap::pixfmt_frame_bytes(recFmt, cur_w_, cur_h_, recStride), node))
+            return GCAP_EIO;
+        rec_img_ = gcap::image_from_buffer(recFmt, rec_buf_.data(), recStride, cur_w_, cur_h_);
     }
+    const bool isP010Format = (recFmt == GCAP_FMT_P010);
 
     if (!recorder_)
         recorder_ = std::make_unique<MfRecorder>();
+    recorder_->log = &log_;
+    recorder_->meter = &audio_meter_;
+    recorder_->drift = &av_drift_;
+    // The device thread may outlive this recording (and this provider) when
+    // an audio session shares it, so only the start touches `this`.
+    recorder_->audioThreadHook = [this](bool begin)
+    {
+        if (begin)
+            tune_thread(true, gcap::ThreadRole::Audio);
+        else
+            gcap::thread_config_revert();
+    };
 
     UINT32 w = static_cast<UINT32>(cur_w_);
     UINT32 h = static_cast<UINT32>(cur_h_);
@@ -313,10 +464,14 @@ gcap_status_t WinMFProvider::startRecording(const char *pathUtf8)
     if (!rec_audio_device_id_.empty())
         audioIdW = utf8_to_wstring(rec_audio_device_id_.c_str());
 
-    if (!recorder_->open(wpath, w, h, fpsN, fpsD, isP010Format, audioIdW))
+    if (!recorder_->open(wpath, w, h, fpsN, fpsD, isP010Format, audioIdW,
+                         (UINT32)rec_w_, (UINT32)rec_h_, rec_filter_))
+    {
+        rec_plan_.reset();
         return GCAP_EIO;
+    }
 
-    OutputDebugStringA("[WinMF] Recorder: startRecording()\\n");
+    GCAP_LOG(log_, GCAP_LOG_INFO, "[WinMF] Recorder: startRecording()");
     return GCAP_OK;
 }
 
@@ -329,6 +484,7 @@ gcap_status_t WinMFProvider::stopRecording()
         recorder_->close();
         OutputDebugStringA("[WinMF] Recorder: stopRecording()\\n");
     }
+    rec_plan_.reset();
     return GCAP_OK;
 }
 
@@ -345,6 +501,17 @@ gcap_status_t WinMFProvider::setRecordingAudioDevice(const char *device_id_utf8)
     return GCAP_OK;
 }
 
+gcap_status_t WinMFProvider::setRecordingSize(int width, int height, gcap_scale_filter_t filter)
+{
+    std::lock_guard<std::mutex> lock(recorderMutex_);
+
+    // Only affects next startRecording call.
+    rec_w_ = width;
+    rec_h_ = height;
+    rec_filter_ = filter;
+    return GCAP_OK;
+}
+
 #define DBG(stage, hr)                                                          \
     do                                                                          \
     {                                                                           \
@@ -352,14 +519,9 @@ gcap_status_t WinMFProvider::setRecordingAudioDevice(const char *device_id_utf8)
         OutputDebugStringA((__m + "\n").c_str());                               \
     } while (0)
 
-// Member-scope debug: also forward to app log (via emit_error(GCAP_OK,...)).
+// Member-scope debug: also forward to the handle's log (gcap_set_log_callback).
 // IMPORTANT: Only use inside WinMFProvider member functions (where `this` exists).
-#define MDBG(stage, hr)                                                         \
-    do                                                                          \
-    {                                                                           \
-        std::string __m = std::string("[WinMF] ") + stage + " : " + hr_msg(hr); \
-        this->emit_error(GCAP_OK, __m.c_str());                                 \
-    } while (0)
+#define MDBG(stage, hr) GCAP_LOG(this->log_, GCAP_LOG_DEBUG, "[WinMF] {} : hr={}", stage, gcap::LogHex{(uint32_t)(hr)})
 
 static void ensure_mf()
 {
@@ -397,43 +559,73 @@ WinMFProvider::~WinMFProvider()
 {
     stop();
     close();
+    log_.stop(); // deliver what close() logged
 }
 
 void WinMFProvider::emit_error(gcap_status_t c, const char *msg)
 {
+    GCAP_LOG(log_, GCAP_LOG_ERROR, "{} (status {})", msg, c);
     if (ecb_)
-    {
         ecb_(c, msg, user_);
-        return;
+}
+
+void WinMFProvider::update_log_sink()
+{
+    if (lcb_)
+    {
+        const gcap_on_log_cb cb = lcb_;
+        void *user = lcb_user_;
+        log_.setSink([cb, user](const gcap_log_record_t &r)
+                     { cb(&r, user); },
+                     lcb_level_);
     }
+    else if (ecb_)
+    {
+        const gcap_on_error_cb cb = ecb_;
+        void *user = user_;
+        // errors already reached ecb_ with their own status (emit_error)
+        log_.setSink([cb, user](const gcap_log_record_t &r)
+                     {
+                         if (r.level < GCAP_LOG_ERROR)
+                             cb(GCAP_OK, r.message, user); },
+                     GCAP_LOG_DEBUG);
+    }
+    else
+        log_.setSink({}, GCAP_LOG_DEBUG);
+}
 
-    // callbacks 尚未設定：只暫存 GCAP_OK 的 debug 訊息（避免把錯誤吞掉）
-    if (c == GCAP_OK && msg)
-        pending_log_push(msg);
+gcap_status_t WinMFProvider::setThreadConfig(const gcap_thread_config_t &cfg)
+{
+    std::lock_guard<std::mutex> lk(thread_cfg_mtx_);
+    thread_cfg_ = cfg;
+    return GCAP_OK;
 }
 
-void WinMFProvider::pending_log_push(const char *msg)
+gcap_thread_config_t WinMFProvider::thread_config()
 {
-    std::lock_guard<std::mutex> lk(pending_mtx_);
-    if (pending_logs_.size() >= kMaxPendingLogs)
-        pending_logs_.pop_front();
-    pending_logs_.emplace_back(msg);
+    std::lock_guard<std::mutex> lk(thread_cfg_mtx_);
+    return thread_cfg_;
 }
 
-void WinMFProvider::pending_log_flush()
+void WinMFProvider::tune_thread(bool begin, gcap::ThreadRole role)
 {
-    // 把暫存 log 取出（避免在 lock 內呼叫 callback）
-    std::deque<std::string> tmp;
+    if (!begin)
     {
-        std::lock_guard<std::mutex> lk(pending_mtx_);
-        tmp.swap(pending_logs_);
-    }
-
-    if (!ecb_)
+        gcap::thread_config_revert();
         return;
+    }
+    if (const char *failed = gcap::thread_config_apply(thread_config(), role))
+        GCAP_LOG(log_, GCAP_LOG_WARN, "[WinMF] thread config: {} not applied to the {} thread", failed,
+                 role == gcap::ThreadRole::Audio ? "audio" : "delivery");
+}
 
-    for (auto &s : tmp)
-        ecb_(GCAP_OK, s.c_str(), user_);
+gcap_status_t WinMFProvider::setLogCallback(gcap_on_log_cb cb, gcap_log_level_t minLevel, void *user)
+{
+    lcb_ = cb;
+    lcb_level_ = minLevel;
+    lcb_user_ = user;
+    update_log_sink();
+    return GCAP_OK;
 }
 
 bool WinMFProvider::enumerate(std::vector<gcap_device_info_t> &list)
@@ -581,8 +773,7 @@ bool WinMFProvider::open(int index)
 
                 ensure_rt_and_pipeline(cur_w_, cur_h_);
 
-                emit_error(GCAP_OK,
-                           "[WinMF] Using device default format (OBS-style)");
+                GCAP_LOG(log_, GCAP_LOG_INFO, "[WinMF] Using device default format (OBS-style)");
                 return true;
             }
         }
@@ -602,7 +793,8 @@ bool WinMFProvider::open(int index)
         return false;
     }
 
-    // 先嘗試把輸出設成 NV12，不行再 ARGB32
+    // 4:2:2 / 4:4:4 native types are taken as-is; otherwise NV12, then ARGB32
+    if (!try_native_high_chroma())
     {
         ComPtr<IMFMediaType> mt;
         MFCreateMediaType(&mt);
@@ -644,35 +836,18 @@ bool WinMFProvider::open(int index)
     // negotiated stride (very important for capture cards with aligned rows)
     cur_stride_ = mf_default_stride_bytes(cur.Get());
     if (cur_stride_ <= 0)
-    {
-        if (cur_subtype_ == MFVideoFormat_P010)
-            cur_stride_ = cur_w_ * 2;
-        else if (cur_subtype_ == MFVideoFormat_ARGB32)
-            cur_stride_ = cur_w_ * 4;
-        else
-            cur_stride_ = cur_w_;
-    }
+        cur_stride_ = gcap::pixfmt_row_bytes(mfsub_to_gcap(cur_subtype_), 0, cur_w_);
 
     // negotiated media type (CPU/VP path)
-    {
-        std::ostringstream oss;
-        oss << "[WinMF] negotiated (CPU/VP): dev='" << dev_name_ << "'"
-            << ", subtype=" << mf_subtype_name(cur_subtype_)
-            << ", " << cur_w_ << "x" << cur_h_
-            << " @ " << fn;
-        if (fd != 1)
-            oss << "/" << fd;
-        oss << " fps"
-            << ", default_stride=" << cur_stride_ << " bytes";
-        emit_error(GCAP_OK, oss.str().c_str());
-    }
+    GCAP_LOG(log_, GCAP_LOG_INFO, "[WinMF] negotiated (CPU/VP): dev='{}', subtype={}, {}x{} @ {}/{} fps, default_stride={} bytes",
+             dev_name_, mf_subtype_name(cur_subtype_), cur_w_, cur_h_, fn, fd, cur_stride_);
 
     // 只開第一個視訊串流
     reader_->SetStreamSelection(MF_SOURCE_READER_ALL_STREAMS, FALSE);
     reader_->SetStreamSelection(MF_SOURCE_READER_FIRST_VIDEO_STREAM, TRUE);
 
     OutputDebugStringA("[WinMF] open(): using CPU pipeline\n");
-    emit_error(GCAP_OK, "[WinMF] open(): using CPU pipeline");
+    GCAP_LOG(log_, GCAP_LOG_INFO, "[WinMF] open(): using CPU pipeline");
     return true;
 }
 
@@ -704,22 +879,58 @@ bool WinMFProvider::setProfile(const gcap_profile_t &p)
 
     if (FAILED(hr))
     {
-        emit_error(GCAP_OK,
-                   "[WinMF] Custom profile rejected, fallback to device default");
+        GCAP_LOG(log_, GCAP_LOG_WARN, "[WinMF] Custom profile rejected, fallback to device default");
         return false;
     }
 
-    emit_error(GCAP_OK, "[WinMF] Custom profile applied");
+    GCAP_LOG(log_, GCAP_LOG_INFO, "[WinMF] Custom profile applied");
 
     return true;
 }
-bool WinMFProvider::setBuffers(int, size_t) { return true; }
+bool WinMFProvider::setBuffers(int count, size_t bytes_hint)
+{
+    if (count < 0 || count > gcap::FramePool::kMaxCount)
+        return false;
+    buf_count_ = count ? count : gcap::FramePool::kDefaultCount;
+    buf_bytes_hint_ = bytes_hint;
+    // already capturing: resize now (never below the current frame size)
+    if (frame_pool_.count() > 0)
+        frame_pool_.reserve(buf_count_ + delivery_.framesInFlight() + 2, bytes_hint);
+    return true;
+}
 
 bool WinMFProvider::start()
 {
     if (running_)
         return true;
     running_ = true;
+    for (auto &h : stage_ns_)
+        h.reset();
+    frames_captured_ = 0;
+    copied_base_ = copied_bytes();
+    // buffers are (re)allocated by the capture thread, on the node it runs on;
+    // every stage that copies or converts frames allocates there too
+    const int node = thread_config().numa_node;
+    frame_pool_.setNumaNode(node);
+    delivery_.setNumaNode(node);
+    mailbox_.setNumaNode(node);
+    pacer_.setNumaNode(node);
+    fanout_.setNumaNode(node);
+    delivery_.start([this](const gcap_frame_t *f)
+                    {
+                        if (!vcb_)
+                            return;
+                        const uint64_t t0 = gcap::LatencyHistogram::nowNs();
+                        vcb_(f, user_);
+                        const uint64_t t1 = gcap::LatencyHistogram::nowNs();
+                        stage_ns_[GCAP_STAGE_CALLBACK].record(t1 - t0);
+                        if (gcap::trace::enabled())
+                            gcap::trace::record("callback", t0, t1); },
+                    [this](bool begin)
+                    { tune_thread(begin, gcap::ThreadRole::Video); });
+    mailbox_.open();
+    pacer_.reset();
+    clock_.reset(cur_fps_num_, cur_fps_den_);
     th_ = std::thread(&WinMFProvider::loop, this);
     return true;
 }
@@ -729,8 +940,12 @@ void WinMFProvider::stop()
     if (!running_)
         return;
     running_ = false;
+    // a BLOCK queue must not keep the capture thread waiting on the consumer
+    delivery_.interrupt();
     if (th_.joinable())
         th_.join();
+    delivery_.stop();
+    mailbox_.close();
 }
 
 void WinMFProvider::close()
@@ -756,7 +971,7 @@ void WinMFProvider::close()
     cs_nv12_.Reset();
     cs_params_.Reset();
     rt_uav_.Reset();
-    upload_yuy2_packed_.Reset();
+    upload_tex_.Reset();
 
     if (dxgi_mgr_)
         dxgi_mgr_.Reset();
@@ -771,8 +986,8 @@ void WinMFProvider::setCallbacks(gcap_on_video_cb vcb, gcap_on_error_cb ecb, voi
     vcb_ = vcb;
     ecb_ = ecb;
     user_ = user;
-    // callbacks 設定完成後，把 open() 階段的 pending logs 一次吐出
-    pending_log_flush();
+    // callbacks 設定完成後，open() 階段的 log 由 logger thread 一次吐出
+    update_log_sink();
 }
 
 // -------------------- D3D / MF init --------------------
@@ -1041,6 +1256,57 @@ bool WinMFProvider::create_reader_with_dxgi(int devIndex)
     return true;
 }
 
+// Prefer a native 4:2:2 / 4:4:4 type over the video processor's NV12 so the
+// chroma is not decimated before we see it; the CPU plan converts for delivery.
+bool WinMFProvider::try_native_high_chroma()
+{
+    ComPtr<IMFMediaType> best;
+    long long bestScore = -1;
+
+    for (DWORD i = 0;; ++i)
+    {
+        ComPtr<IMFMediaType> t;
+        HRESULT hr = reader_->GetNativeMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, i, &t);
+        if (hr == MF_E_NO_MORE_TYPES)
+            break;
+        if (FAILED(hr) || !t)
+            continue;
+
+        GUID s = GUID_NULL;
+        gcap_pixfmt_t f = GCAP_FMT_NV12;
+        if (FAILED(t->GetGUID(MF_MT_SUBTYPE, &s)) || !try_mfsub_to_gcap(s, f))
+            continue;
+        // YUY2 gains nothing over the processor's NV12; V210 has no mask /
+        // health path in prepare_native(), so it would go out unmasked
+        const gcap::PixelFormatDesc &d = gcap::pixfmt_desc(f);
+        if (!d.yuv || d.chromaShiftY != 0 || f == GCAP_FMT_YUY2 || f == GCAP_FMT_V210)
+            continue;
+
+        UINT32 cw = 0, ch = 0, fnum = 0, fden = 1;
+        if (FAILED(MFGetAttributeSize(t.Get(), MF_MT_FRAME_SIZE, &cw, &ch)))
+            continue;
+        MFGetAttributeRatio(t.Get(), MF_MT_FRAME_RATE, &fnum, &fden);
+        const double fps = fden ? (double)fnum / fden : 0.0;
+
+        const long long score = (long long)cw * ch * 100000 + (long long)(fps * 1000) * 100 + d.bitDepth;
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = t;
+        }
+    }
+    if (!best)
+        return false;
+
+    HRESULT hr = reader_->SetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, nullptr, best.Get());
+    if (FAILED(hr))
+    {
+        DBG("SetCurrentMediaType(4:2:2/4:4:4 native)", hr);
+        return false;
+    }
+    return true;
+}
+
 bool WinMFProvider::pick_best_native(GUID &sub, UINT32 &w, UINT32 &h, UINT32 &fn, UINT32 &fd)
 {
     struct Cand
@@ -1117,22 +1383,10 @@ bool WinMFProvider::pick_best_native(GUID &sub, UINT32 &w, UINT32 &h, UINT32 &fn
             cur_fps_den_ = (int)rfd;
             cur_stride_ = mf_default_stride_bytes(cur.Get());
             if (cur_stride_ <= 0)
-            {
-                if (rsub == MFVideoFormat_P010)
-                    cur_stride_ = (int)rw * 2;
-                else
-                    cur_stride_ = (int)rw;
-            }
+                cur_stride_ = gcap::pixfmt_row_bytes(mfsub_to_gcap(rsub), 0, (int)rw);
 
-            std::ostringstream oss;
-            oss << "[WinMF] pick_best_native: subtype=" << mf_subtype_name(rsub)
-                << ", " << rw << "x" << rh
-                << " @ " << rfn;
-            if (rfd != 1)
-                oss << "/" << rfd;
-            oss << " fps"
-                << ", default_stride=" << cur_stride_ << " bytes";
-            emit_error(GCAP_OK, oss.str().c_str());
+            GCAP_LOG(log_, GCAP_LOG_INFO, "[WinMF] pick_best_native: subtype={}, {}x{} @ {}/{} fps, default_stride={} bytes",
+                     mf_subtype_name(rsub), rw, rh, rfn, rfd, cur_stride_);
         }
 
         sub = best.sub;
@@ -1411,7 +1665,8 @@ bool WinMFProvider::ensure_rt_and_pipeline(int w, int h)
 
     // staging for readback
     td.BindFlags = 0;
-    td.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    // WRITE too: privacy masks are burned into the readback on the DXGI surface path
+    td.CPUAccessFlags = D3D11_CPU_ACCESS_READ | D3D11_CPU_ACCESS_WRITE;
     td.Usage = D3D11_USAGE_STAGING;
     if (FAILED(d3d_->CreateTexture2D(&td, nullptr, &rt_stage_)))
         return false;
@@ -1494,7 +1749,7 @@ bool WinMFProvider::render_yuv_to_rgba(ID3D11Texture2D *yuvTex)
     }
     else if (cur_subtype_ == MFVideoFormat_YUY2)
     {
-        // YUY2：yuvTex 會是 upload_yuy2_packed_（RGBA8_UINT）
+        // YUY2：yuvTex 會是 upload_tex_（RGBA8_UINT）
         D3D11_SHADER_RESOURCE_VIEW_DESC sd{};
         sd.Format = DXGI_FORMAT_R8G8B8A8_UINT;
         sd.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
@@ -1676,17 +1931,150 @@ bool WinMFProvider::gpu_overlay_text(const wchar_t *text)
 
 // -------------------- Capture loop --------------------
 
+void WinMFProvider::publish_frame(gcap_frame_t &f, bool paced)
+{
+    auto deliver = [this](const gcap_frame_t &out)
+    {
+        if (vcb_)
+            delivery_.push(out);
+        mailbox_.post(out);
+    };
+    if (paced)
+        pacer_.emit(f, deliver);
+    else
+        deliver(f);
+}
+
+void WinMFProvider::plan_cpu_conversion()
+{
+    cur_fmt_known_ = try_mfsub_to_gcap(cur_subtype_, cur_fmt_);
+    cpu_plan_.reset();
+    if (!cur_fmt_known_ || !cpu_path_)
+        return;
+    cpu_plan_.setNumaNode(thread_config().numa_node);
+
+    // callbacks receive the preferred format, else ARGB (BGRA), at the capture size
+    cpu_out_fmt_ = deliver_fmt_;
+    if (!cpu_plan_.build(cur_fmt_, cur_w_, cur_h_, cpu_out_fmt_, cur_w_, cur_h_))
+    {
+        cpu_out_fmt_ = GCAP_FMT_ARGB;
+        cpu_plan_.build(cur_fmt_, cur_w_, cur_h_, cpu_out_fmt_, cur_w_, cur_h_);
+    }
+
+    if (cpu_plan_.valid())
+        GCAP_LOG(log_, GCAP_LOG_INFO, "[WinMF] CPU conversion plan: {}", cpu_plan_.describe());
+    else
+        GCAP_LOG(log_, GCAP_LOG_WARN, "[WinMF] no CPU conversion from {} to ARGB", gcap::pixfmt_desc(cur_fmt_).name);
+
+    if (cpu_plan_.valid() && !cpu_plan_.passthrough())
+    {
+        const int outStride = gcap::pixfmt_row_bytes(cpu_out_fmt_, 0, cur_w_);
+        const size_t frameBytes = gcap::pixfmt_frame_bytes(cpu_out_fmt_, cur_w_, cur_h_, outStride);
+        // consumer-held frames, whatever the delivery queue holds, the mailbox
+        // slot and the frame the pacer keeps for blending
+        frame_pool_.reserve(buf_count_ + delivery_.framesInFlight() + 2, std::max(frameBytes, buf_bytes_hint_.load()));
+    }
+}
+
+void WinMFProvider::plan_gpu_upload()
+{
+    const gcap::PixelFormatDesc &d = gcap::pixfmt_desc(cur_fmt_);
+    upload_tex_.Reset();
+    upload_fmt_ = cur_fmt_known_ ? upload_texture_format(d) : DXGI_FORMAT_UNKNOWN;
+    // packed formats take one texel per block, planar ones one per pixel
+    upload_w_ = (UINT)(d.planeCount == 1 ? (cur_w_ + d.plane[0].pixelsPerBlock - 1) / d.plane[0].pixelsPerBlock : cur_w_);
+    upload_ = upload_fmt_ != DXGI_FORMAT_UNKNOWN ? &WinMFProvider::upload_planes : nullptr;
+
+    wchar_t label[32];
+    swprintf(label, 32, L"%hs %d-bit", cur_fmt_known_ ? d.name : "?", d.bitDepth);
+    overlay_fmt_ = label;
+}
+
+void WinMFProvider::prepare_native(const gcap::ImageRef &img, uint64_t frameId, LONGLONG ts)
+{
+    // masks go into the native planes first: recorder and converter both see them
+    switch (img.format)
+    {
+    case GCAP_FMT_NV12:
+        mask_.apply_nv12(img.data[0], img.data[1], img.width, img.height, img.stride[0], img.stride[1]);
+        health_.update_y8(img.data[0], img.width, img.height, img.stride[0], 1, frameId);
+        break;
+    case GCAP_FMT_P010:
+        mask_.apply_p010(img.data[0], img.data[1], img.width, img.height, img.stride[0], img.stride[1]);
+        health_.update_y16(img.data[0], img.width, img.height, img.stride[0], 1, frameId);
+        break;
+    case GCAP_FMT_NV16:
+    case GCAP_FMT_NV24:
+    {
+        const int sx = img.format == GCAP_FMT_NV16 ? 2 : 1;
+        mask_.apply_semiplanar(img.data[0], img.data[1], img.width, img.height, img.stride[0], img.stride[1], sx, 1);
+        health_.update_y8(img.data[0], img.width, img.height, img.stride[0], 1, frameId);
+        break;
+    }
+    case GCAP_FMT_P210:
+        mask_.apply_semiplanar16(img.data[0], img.data[1], img.width, img.height, img.stride[0], img.stride[1], 2, 1);
+        health_.update_y16(img.data[0], img.width, img.height, img.stride[0], 1, frameId);
+        break;
+    case GCAP_FMT_Y210:
+        mask_.apply_y210(img.data[0], img.width, img.height, img.stride[0]);
+        health_.update_y16(img.data[0], img.width, img.height, img.stride[0], 2, frameId);
+        break;
+    case GCAP_FMT_YUY2:
+        mask_.apply_yuy2(img.data[0], img.width, img.height, img.stride[0]);
+        health_.update_y8(img.data[0], img.width, img.height, img.stride[0], 2, frameId);
+        break;
+    case GCAP_FMT_ARGB:
+        mask_.apply_argb(img.data[0], img.width, img.height, img.stride[0]);
+        health_.update_bgra(img.data[0], img.width, img.height, img.stride[0], frameId);
+        break;
+    default:
+        break;
+    }
+
+    // --- Recording: NV12 → H.264 / P010 → HEVC (native planes, or rec_plan_ output) ---
+    std::lock_guard<std::mutex> lock(recorderMutex_);
+    if (!recorder_ || !rec_plan_.valid())
+        return;
+    const uint64_t t0 = gcap::LatencyHistogram::nowNs();
+    const gcap::ImageRef *rec = &img;
+    if (!rec_plan_.passthrough())
+    {
+        rec_plan_.run(img, rec_img_);
+        rec = &rec_img_;
+    }
+    if (rec->format == GCAP_FMT_NV12)
+        recorder_->writeNV12(rec->data[0], rec->data[1],
+                             static_cast<UINT32>(rec->stride[0]),
+                             static_cast<UINT32>(rec->stride[1]),
+                             ts);
+    else
+        recorder_->writeP010(rec->data[0], rec->data[1],
+                             static_cast<UINT32>(rec->stride[0]),
+                             static_cast<UINT32>(rec->stride[1]),
+                             ts);
+    stage_ns_[GCAP_STAGE_RECORD].record(gcap::LatencyHistogram::nowNs() - t0);
+}
+
 void WinMFProvider::loop()
 {
     // Log stride/buffer length diagnostics only once per run (avoid spamming).
     bool logged_layout = false;
     bool logged_len_mismatch = false;
+    bool logged_pool_exhausted = false;
+
+    gcap::trace::setThreadName("capture");
+    const gcap::ScopedThreadConfig tuning(thread_config(), gcap::ThreadRole::Video);
+    if (tuning.failed())
+        GCAP_LOG(log_, GCAP_LOG_WARN, "[WinMF] thread config: {} not applied to the capture thread", tuning.failed());
+    plan_cpu_conversion();
+    plan_gpu_upload();
 
     while (running_)
     {
         DWORD stream = 0, flags = 0;
         LONGLONG ts = 0;
         ComPtr<IMFSample> sample;
+        const uint64_t tRead = gcap::LatencyHistogram::nowNs();
         HRESULT hr = reader_->ReadSample(MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, &stream, &flags, &ts, &sample);
         if (FAILED(hr))
         {
@@ -1695,6 +2083,20 @@ void WinMFProvider::loop()
         }
         if (!sample)
             continue;
+        const uint64_t tSample = gcap::LatencyHistogram::nowNs();
+        stage_ns_[GCAP_STAGE_READ].record(tSample - tRead);
+        frames_captured_.fetch_add(1, std::memory_order_relaxed);
+        if (gcap::trace::enabled())
+            gcap::trace::record("ReadSample", tRead, tSample);
+        GCAP_TRACE_SCOPE("frame");
+
+        // USB devices stamp frames with tens of ms of arrival jitter: callbacks,
+        // recording and A/V sync all run on the recovered clock instead
+        {
+            UINT32 discontinuity = 0;
+            sample->GetUINT32(MFSampleExtension_Discontinuity, &discontinuity);
+            ts = (LONGLONG)(clock_.update((int64_t)ts * 100, discontinuity != 0) / 100);
+        }
 
         if (cpu_path_)
         {
@@ -1706,49 +2108,37 @@ void WinMFProvider::loop()
             DWORD maxLen = 0, curLen = 0;
             if (FAILED(buf->Lock(&pData, &maxLen, &curLen)))
                 continue;
+            stage_ns_[GCAP_STAGE_LOCK].record(gcap::LatencyHistogram::nowNs() - tSample);
+
+            // 其他（例如 MJPG）理論上 VP 會幫我們解到 NV12/ARGB 之一；萬一還是 MJPG，可再加一個軟解（先不做）
+            if (!cur_fmt_known_ || !cpu_plan_.valid())
+            {
+                buf->Unlock();
+                continue;
+            }
+
+            const gcap::PixelFormatDesc &desc = gcap::pixfmt_desc(cur_fmt_);
+            const int tightStride = gcap::pixfmt_row_bytes(cur_fmt_, 0, cur_w_);
+            const int stride = (cur_stride_ > 0) ? cur_stride_ : tightStride;
 
             // (1) log negotiated stride vs code assumption
             if (!logged_layout)
             {
-                std::ostringstream oss;
-                oss << "[WinMF] buffer layout (CPU): subtype=" << mf_subtype_name(cur_subtype_)
-                    << ", curLen=" << curLen << ", maxLen=" << maxLen
-                    << ", negotiated_stride=" << cur_stride_ << " bytes"
-                    << ", code_assumes_stride=";
-                if (cur_subtype_ == MFVideoFormat_P010)
-                    oss << (cur_w_ * 2);
-                else if (cur_subtype_ == MFVideoFormat_ARGB32)
-                    oss << (cur_w_ * 4);
-                else
-                    oss << cur_w_;
-                oss << " bytes";
-                emit_error(GCAP_OK, oss.str().c_str());
+                GCAP_LOG(log_, GCAP_LOG_DEBUG,
+                         "[WinMF] buffer layout (CPU): subtype={}, curLen={}, maxLen={}, negotiated_stride={} bytes, code_assumes_stride={} bytes",
+                         mf_subtype_name(cur_subtype_), curLen, maxLen, cur_stride_, tightStride);
                 logged_layout = true;
             }
 
             // (2) bufferLen vs expectedLen
             if (!logged_len_mismatch)
             {
-                const int stride = (cur_stride_ > 0) ? cur_stride_ : (cur_subtype_ == MFVideoFormat_P010) ? (cur_w_ * 2)
-                                                                 : (cur_subtype_ == MFVideoFormat_ARGB32) ? (cur_w_ * 4)
-                                                                                                          : cur_w_;
-                size_t expected = 0;
-                if (cur_subtype_ == MFVideoFormat_NV12)
-                    expected = (size_t)stride * (size_t)cur_h_ + (size_t)stride * (size_t)(cur_h_ / 2);
-                else if (cur_subtype_ == MFVideoFormat_P010)
-                    expected = (size_t)stride * (size_t)cur_h_ + (size_t)stride * (size_t)(cur_h_ / 2);
-                else if (cur_subtype_ == MFVideoFormat_ARGB32)
-                    expected = (size_t)stride * (size_t)cur_h_;
-
-                if (expected != 0 && (size_t)curLen < expected)
+                const size_t expected = gcap::pixfmt_frame_bytes(cur_fmt_, cur_w_, cur_h_, stride);
+                if ((size_t)curLen < expected)
                 {
-                    std::ostringstream oss;
-                    oss << "[WinMF] WARNING: bufferLen < expected (CPU): curLen=" << curLen
-                        << ", expected>=" << expected
-                        << ", subtype=" << mf_subtype_name(cur_subtype_)
-                        << ", w=" << cur_w_ << ", h=" << cur_h_
-                        << ", default_stride=" << stride;
-                    emit_error(GCAP_OK, oss.str().c_str());
+                    GCAP_LOG(log_, GCAP_LOG_WARN,
+                             "[WinMF] WARNING: bufferLen < expected (CPU): curLen={}, expected>={}, subtype={}, w={}, h={}, default_stride={}",
+                             curLen, expected, desc.name, cur_w_, cur_h_, stride);
                     logged_len_mismatch = true;
                 }
             }
@@ -1759,93 +2149,76 @@ void WinMFProvider::loop()
             f.pts_ns = (uint64_t)ts * 100;
             f.frame_id = ++frame_id_;
 
-            if (cur_subtype_ == MFVideoFormat_ARGB32)
+            const gcap::ImageRef native = gcap::image_from_buffer(cur_fmt_, pData, stride, cur_w_, cur_h_);
+            prepare_native(native, f.frame_id, ts);
+
+            // passthrough frames point into the locked MF buffer; converted ones
+            // live in a pool buffer the consumer may keep (gcap_frame_ref).
+            // Nothing is converted for the main callback when only fan-out
+            // consumers are listening, nor for frames the pacer drops.
+            const bool wantPrimary = vcb_ || mailbox_.active();
+            const bool paced = wantPrimary && pacer_.active();
+            const int slots = paced ? pacer_.admit((int64_t)f.pts_ns) : 1;
+            gcap_frame_t *primary = nullptr;
+            gcap::FramePool::Buffer *pb = nullptr;
+            if (cpu_plan_.passthrough())
             {
-                f.format = GCAP_FMT_ARGB;
-                f.data[0] = pData;
-                f.stride[0] = cur_w_ * 4;
-                f.plane_count = 1;
-                if (vcb_)
-                    vcb_(&f, user_);
+                f.format = cur_fmt_;
+                f.plane_count = desc.planeCount;
+                for (int i = 0; i < desc.planeCount; ++i)
+                {
+                    f.data[i] = native.data[i];
+                    f.stride[i] = native.stride[i];
+                }
+                primary = &f;
             }
-            else if (cur_subtype_ == MFVideoFormat_NV12)
+            else if (wantPrimary && (slots > 0 || pacer_.keepsFrames()))
             {
-                // NV12: Y 面在前，UV 在後
-                const int yStride = (cur_stride_ > 0) ? cur_stride_ : cur_w_;
-                const int uvStride = yStride;
-                const uint8_t *y = pData;
-                const uint8_t *uv = pData + yStride * cur_h_;
-
-                // --- Recording: NV12 直接送進 Sink Writer (H.264) ---
+                // pool buffers were sized for cpu_out_fmt_ in plan_cpu_conversion()
+                pb = frame_pool_.acquire();
+                if (!pb)
                 {
-                    std::lock_guard<std::mutex> lock(recorderMutex_);
-                    if (recorder_)
+                    // every buffer is still held through gcap_frame_ref(): drop the frame
+                    if (!logged_pool_exhausted)
                     {
-                        recorder_->writeNV12(y, uv,
-                                             static_cast<UINT32>(yStride),
-                                             static_cast<UINT32>(uvStride),
-                                             ts);
+                        GCAP_LOG(log_, GCAP_LOG_WARN, "[WinMF] WARNING: consumer holds every frame buffer, dropping frames (see gcap_set_buffers)");
+                        logged_pool_exhausted = true;
                     }
+                    delivery_.dropNoBuffer();
+                }
+                else
+                {
+                    const gcap::ImageRef out = gcap::image_from_buffer(cpu_out_fmt_, pb->data,
+                                                                       gcap::pixfmt_row_bytes(cpu_out_fmt_, 0, cur_w_),
+                                                                       cur_w_, cur_h_);
+                    const uint64_t t0 = gcap::LatencyHistogram::nowNs();
+                    cpu_plan_.run(native, out);
+                    stage_ns_[GCAP_STAGE_CONVERT].record(gcap::LatencyHistogram::nowNs() - t0);
+
+                    f.format = cpu_out_fmt_;
+                    f.plane_count = gcap::pixfmt_desc(cpu_out_fmt_).planeCount;
+                    for (int i = 0; i < f.plane_count; ++i)
+                    {
+                        f.data[i] = out.data[i];
+                        f.stride[i] = out.stride[i];
+                    }
+                    f.pool_ref = pb;
+                    pb->frame = f;
+                    primary = &pb->frame;
                 }
-
-                const size_t needed = (size_t)cur_w_ * (size_t)cur_h_ * 4;
-                if (cpu_argb_.size() < needed)
-                    cpu_argb_.resize(needed);
-
-                gcap::nv12_to_argb(y, uv, cur_w_, cur_h_, yStride, uvStride,
-                                   cpu_argb_.data(), cur_w_ * 4);
-
-                f.format = GCAP_FMT_ARGB;
-                f.data[0] = cpu_argb_.data();
-                f.stride[0] = cur_w_ * 4;
-                f.plane_count = 1;
-                if (vcb_)
-                    vcb_(&f, user_);
-            }
-            else if (cur_subtype_ == MFVideoFormat_YUY2)
-            {
-                const int yuy2Stride = (cur_stride_ > 0) ? cur_stride_ : (cur_w_ * 2);
-                const uint8_t *yuy2 = pData;
-
-                const size_t needed = (size_t)cur_w_ * (size_t)cur_h_ * 4;
-                if (cpu_argb_.size() < needed)
-                    cpu_argb_.resize(needed);
-
-                gcap::yuy2_to_argb(yuy2, cur_w_, cur_h_, yuy2Stride,
-                                   cpu_argb_.data(), cur_w_ * 4);
-
-                f.format = GCAP_FMT_ARGB;
-                f.data[0] = cpu_argb_.data();
-                f.stride[0] = cur_w_ * 4;
-                f.plane_count = 1;
-                if (vcb_)
-                    vcb_(&f, user_);
             }
-            // 其他（例如 MJPG）理論上 VP 會幫我們解到 NV12/ARGB 之一；萬一還是 MJPG，可再加一個軟解（先不做）
+            const uint64_t pts = f.pts_ns; // publish_frame() may retime a paced frame
+            if (primary && wantPrimary)
+                publish_frame(*primary, paced);
+            // extra consumers reuse `primary` when it already matches their output
+            fanout_.process(native, primary, pts, f.frame_id);
 
             buf->Unlock();
+            if (pb)
+                gcap::FramePool::unref(pb);
             continue;
         }
 
-        // 每一筆 sample 都會有 ts (100ns 單位)；我們前面用 f.pts_ns = ts * 100
-        double fps_now = 0.0;
-        if (last_pts_ns_ != 0)
-        {
-            uint64_t delta = ((uint64_t)ts * 100) - last_pts_ns_; // ns
-            if (delta > 0)
-                fps_now = 1e9 / (double)delta;
-        }
-        // 簡單一階濾波
-        if (fps_now > 0.0)
-        {
-            if (fps_avg_ <= 0.0)
-                fps_avg_ = fps_now;
-            else
-                fps_avg_ = fps_avg_ * 0.9 + fps_now * 0.1;
-        }
-
-        last_pts_ns_ = (uint64_t)ts * 100;
-
         ComPtr<IMFMediaBuffer> buf;
         if (FAILED(sample->ConvertToContiguousBuffer(&buf)))
             continue;
@@ -1855,6 +2228,10 @@ void WinMFProvider::loop()
         HRESULT hrDX = buf.As(&dxgibuf);
 
         ComPtr<ID3D11Texture2D> yuvTex;
+        // native planes never reach the CPU on the DXGI surface path → mask the readback instead
+        bool maskReadback = false;
+        // health metrics come from native luma when the CPU sees it, else from the readback
+        bool healthDone = false;
 
         if (SUCCEEDED(hrDX) && dxgibuf)
         {
@@ -1866,6 +2243,7 @@ void WinMFProvider::loop()
                 continue;
             }
             dxgibuf->GetSubresourceIndex(&subres);
+            maskReadback = !mask_.empty();
         }
         else
         {
@@ -1901,212 +2279,71 @@ void WinMFProvider::loop()
             // (GPU upload fallback) log stride/bufferLen once
             if (!logged_layout)
             {
-                std::ostringstream oss;
-                oss << "[WinMF] buffer layout (GPU-upload fallback): subtype=" << mf_subtype_name(cur_subtype_)
-                    << ", curLen=" << curLen << ", maxLen=" << maxLen
-                    << ", negotiated_stride=" << cur_stride_ << " bytes"
-                    << ", code_assumes_stride=";
-                if (cur_subtype_ == MFVideoFormat_P010)
-                    oss << (cur_w_ * 2);
-                else
-                    oss << cur_w_;
-                oss << " bytes";
-                emit_error(GCAP_OK, oss.str().c_str());
+                GCAP_LOG(log_, GCAP_LOG_DEBUG,
+                         "[WinMF] buffer layout (GPU-upload fallback): subtype={}, curLen={}, maxLen={}, negotiated_stride={} bytes, code_assumes_stride={} bytes",
+                         mf_subtype_name(cur_subtype_), curLen, maxLen, cur_stride_, gcap::pixfmt_row_bytes(cur_fmt_, 0, cur_w_));
                 logged_layout = true;
             }
 
-            if (!ensure_upload_yuv(cur_w_, cur_h_))
-            {
-                if (locked2d)
-                    buf2d->Unlock2D();
-                else
-                    buf->Unlock();
-                continue;
-            }
+            // Lock2D pitch wins, then the negotiated default stride, then the tight row size
+            const int srcStride = (locked2d && srcPitchLong > 0) ? (int)srcPitchLong
+                                  : (cur_stride_ > 0)            ? cur_stride_
+                                                                 : gcap::pixfmt_row_bytes(cur_fmt_, 0, cur_w_);
 
-            D3D11_MAPPED_SUBRESOURCE mapped{};
-            HRESULT hrMap = ctx_->Map(upload_yuv_.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-            if (FAILED(hrMap))
+            if (!upload_)
             {
                 if (locked2d)
                     buf2d->Unlock2D();
                 else
                     buf->Unlock();
-                MDBG("DXGI: Map(upload_yuv_) failed", hrMap);
                 continue;
             }
 
-            // bufferLen vs expected (upload path) + RowPitch
+            // bufferLen vs expected (upload path)
             if (!logged_len_mismatch)
             {
-                const int assumeStride =
-                    (locked2d && srcPitchLong > 0) ? (int)srcPitchLong : (cur_stride_ > 0)                  ? cur_stride_
-                                                                     : (cur_subtype_ == MFVideoFormat_P010) ? (cur_w_ * 2)
-                                                                                                            : cur_w_;
-
-                const size_t expected = (size_t)assumeStride * (size_t)cur_h_ +
-                                        (size_t)assumeStride * (size_t)(cur_h_ / 2);
+                const size_t expected = gcap::pixfmt_frame_bytes(cur_fmt_, cur_w_, cur_h_, srcStride);
 
                 // 如果 curLen=0（常見於 2D buffer），就略過這個檢查
                 if (curLen != 0 && (size_t)curLen < expected)
                 {
-                    std::ostringstream oss;
-                    oss << "[WinMF] WARNING: bufferLen < expected (upload): curLen=" << curLen
-                        << ", expected>=" << expected
-                        << ", subtype=" << mf_subtype_name(cur_subtype_)
-                        << ", w=" << cur_w_ << ", h=" << cur_h_
-                        << ", default_stride=" << assumeStride
-                        << ", upload_RowPitch=" << mapped.RowPitch;
-                    emit_error(GCAP_OK, oss.str().c_str());
+                    GCAP_LOG(log_, GCAP_LOG_WARN,
+                             "[WinMF] WARNING: bufferLen < expected (upload): curLen={}, expected>={}, subtype={}, w={}, h={}, default_stride={}",
+                             curLen, expected, mf_subtype_name(cur_subtype_), cur_w_, cur_h_, srcStride);
                     logged_len_mismatch = true;
                 }
             }
 
-            int w = cur_w_;
-            int h = cur_h_;
-
-            if (cur_subtype_ == MFVideoFormat_NV12)
-            {
-                const int srcStride = (locked2d && srcPitchLong > 0) ? (int)srcPitchLong : (cur_stride_ > 0) ? cur_stride_
-                                                                                                             : w;
-                const size_t rowBytes = (size_t)w; // NV12 Y/UV 每列 bytes = w
-
-                const uint8_t *srcY = pData;
-                const uint8_t *srcUV = pData + (size_t)srcStride * (size_t)h;
-
-                // --- Recording: NV12 直接送進 Sink Writer (H.264) ---
-                {
-                    std::lock_guard<std::mutex> lock(recorderMutex_);
-                    if (recorder_)
-                    {
-                        recorder_->writeNV12(srcY, srcUV,
-                                             static_cast<UINT32>(srcStride),
-                                             static_cast<UINT32>(srcStride),
-                                             ts);
-                    }
-                }
-
-                uint8_t *dst = static_cast<uint8_t *>(mapped.pData);
-
-                // Y plane
-                for (int y = 0; y < h; ++y)
-                    memcpy(dst + mapped.RowPitch * y,
-                           srcY + (size_t)srcStride * y,
-                           rowBytes);
-                // UV plane (h/2 行，pitch 相同)
-                for (int y = 0; y < h / 2; ++y)
-                    memcpy(dst + mapped.RowPitch * (h + y),
-                           srcUV + (size_t)srcStride * y,
-                           rowBytes);
-            }
-            else if (cur_subtype_ == MFVideoFormat_P010)
-            {
-                // P010: 10-bit，2 bytes per sample
-                const int srcStride = (locked2d && srcPitchLong > 0) ? (int)srcPitchLong : (cur_stride_ > 0) ? cur_stride_
-                                                                                                             : (w * 2);
-                const size_t rowBytes = (size_t)w * 2;
-
-                const uint8_t *srcY = pData;
-                const uint8_t *srcUV = pData + (size_t)srcStride * (size_t)h;
-                // --- Recording: P010 直接送進 Sink Writer (HEVC) ---
-                {
-                    std::lock_guard<std::mutex> lock(recorderMutex_);
-                    if (recorder_)
-                    {
-                        recorder_->writeP010(srcY, srcUV,
-                                             static_cast<UINT32>(srcStride),
-                                             static_cast<UINT32>(srcStride),
-                                             ts);
-                    }
-                }
-
-                uint8_t *dst = static_cast<uint8_t *>(mapped.pData);
-
-                for (int y = 0; y < h; ++y)
-                    memcpy(dst + mapped.RowPitch * y,
-                           srcY + (size_t)srcStride * y,
-                           rowBytes);
-                for (int y = 0; y < h / 2; ++y)
-                    memcpy(dst + mapped.RowPitch * (h + y),
-                           srcUV + (size_t)srcStride * y,
-                           rowBytes);
-            }
-            else if (cur_subtype_ == MFVideoFormat_YUY2)
-            {
-                const int srcStride = (locked2d && srcPitchLong > 0) ? (int)srcPitchLong
-                                                                     : (cur_stride_ > 0 ? cur_stride_ : (w * 2));
-                const size_t rowBytes = (size_t)w * 2; // YUY2 每像素 2 bytes
-
-                // 這裡的 upload texture 是「packed」：width = ceil(w/2)，RGBA8_UINT
-                if (!ensure_upload_yuv(w, h))
-                {
-                    if (locked2d)
-                        buf2d->Unlock2D();
-                    else
-                        buf->Unlock();
-                    continue;
-                }
-
-                D3D11_MAPPED_SUBRESOURCE mapped{};
-                HRESULT hrMap = ctx_->Map(upload_yuy2_packed_.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-                if (FAILED(hrMap))
-                {
-                    MDBG("DXGI: Map(upload_yuy2_packed_) failed", hrMap);
-                    if (locked2d)
-                        buf2d->Unlock2D();
-                    else
-                        buf->Unlock();
-                    continue;
-                }
-
-                uint8_t *dst = (uint8_t *)mapped.pData;
-                const int w2 = (w + 1) / 2;
-                for (int yy = 0; yy < h; ++yy)
-                {
-                    const uint8_t *srcRow = pData + (size_t)srcStride * (size_t)yy;
-                    uint8_t *dstRow = dst + (size_t)mapped.RowPitch * (size_t)yy;
-
-                    // 每 4 bytes（Y0 U Y1 V）→ 寫成 1 個 RGBA8_UINT texel
-                    for (int x = 0; x < w2; ++x)
-                    {
-                        const int srcX = x * 4;
-                        // 注意：若 w 是奇數，最後一組的 Y1 可能不存在，這裡用 Y0 補
-                        uint8_t Y0 = srcRow[srcX + 0];
-                        uint8_t U = srcRow[srcX + 1];
-                        uint8_t Y1 = (srcX + 2 < (int)rowBytes) ? srcRow[srcX + 2] : Y0;
-                        uint8_t V = (srcX + 3 < (int)rowBytes) ? srcRow[srcX + 3] : srcRow[srcX + 1];
-
-                        uint8_t *d4 = dstRow + x * 4;
-                        d4[0] = Y0;
-                        d4[1] = U;
-                        d4[2] = Y1;
-                        d4[3] = V;
-                    }
-                }
-
-                ctx_->Unmap(upload_yuy2_packed_.Get(), 0);
-                if (locked2d)
-                    buf2d->Unlock2D();
-                else
-                    buf->Unlock();
-
-                yuvTex = upload_yuy2_packed_.Get();
-            }
-
-            if (cur_subtype_ == MFVideoFormat_NV12 || cur_subtype_ == MFVideoFormat_P010)
-            {
-                ctx_->Unmap(upload_yuv_.Get(), 0);
-                if (locked2d)
-                    buf2d->Unlock2D();
-                else
-                    buf->Unlock();
+            // masks / health / recording on the native planes, before upload
+            const gcap::ImageRef native = gcap::image_from_buffer(cur_fmt_, pData, srcStride, cur_w_, cur_h_);
+            prepare_native(native, frame_id_ + 1, ts);
+            healthDone = true;
 
-                yuvTex = upload_yuv_.Get();
-            }
+            const bool uploaded = (this->*upload_)(native);
+            if (locked2d)
+                buf2d->Unlock2D();
+            else
+                buf->Unlock();
+            if (!uploaded)
+                continue;
+            yuvTex = upload_tex_.Get();
         }
 
         if (!yuvTex)
             continue;
+        const uint64_t tConvert = gcap::LatencyHistogram::nowNs();
+        stage_ns_[GCAP_STAGE_LOCK].record(tConvert - tSample);
+
+        // the pacer decides before any GPU work, as on the CPU path: a frame it
+        // drops is neither rendered nor read back unless fan-out consumers want it
+        const uint64_t pts = (uint64_t)ts * 100;
+        const bool paced = (vcb_ || mailbox_.active()) && pacer_.active();
+        const bool wantPrimary = !paced || pacer_.admit((int64_t)pts) > 0 || pacer_.keepsFrames();
+        if (!wantPrimary && fanout_.empty())
+        {
+            ++frame_id_;
+            continue;
+        }
 
         if (!render_yuv_to_rgba(yuvTex.Get()))
         {
@@ -2128,18 +2365,7 @@ void WinMFProvider::loop()
             }
         }
 
-        const wchar_t *fmtName =
-            (cur_subtype_ == MFVideoFormat_P010)     ? L"P010"
-            : (cur_subtype_ == MFVideoFormat_NV12)   ? L"NV12"
-            : (cur_subtype_ == MFVideoFormat_YUY2)   ? L"YUY2"
-            : (cur_subtype_ == MFVideoFormat_ARGB32) ? L"ARGB32"
-                                                     : L"?";
-
-        const wchar_t *bitDepth =
-            (cur_subtype_ == MFVideoFormat_P010) ? L"10-bit"
-                                                 : L"8-bit"; // NV12 / ARGB32 皆 8-bit
-
-        double fps_show = fps_avg_ > 0.0 ? fps_avg_ : 0.0;
+        const double fps_show = clock_.clockFps();
 
         const wchar_t *gpuName =
             (!gpu_name_w_.empty() ? gpu_name_w_.c_str() : L"(GPU: unknown)");
@@ -2147,22 +2373,26 @@ void WinMFProvider::loop()
         wchar_t line[512];
         swprintf(line,
                  512,
-                 L"%s | GPU: %s | %dx%d @ %.2f fps | %s %s | #%llu",
+                 L"%s | GPU: %s | %dx%d @ %.2f fps | %s | #%llu",
                  (wdev[0] ? wdev : L"Device"),
                  gpuName,
                  cur_w_,
                  cur_h_,
                  fps_show,
-                 fmtName,
-                 bitDepth,
+                 overlay_fmt_.c_str(),
                  (unsigned long long)frame_id_);
         gpu_overlay_text(line);
 
         // Readback -> staging -> map
         ctx_->CopyResource(rt_stage_.Get(), rt_rgba_.Get());
         D3D11_MAPPED_SUBRESOURCE m{};
-        if (SUCCEEDED(ctx_->Map(rt_stage_.Get(), 0, D3D11_MAP_READ, 0, &m)))
+        const D3D11_MAP mapType = maskReadback ? D3D11_MAP_READ_WRITE : D3D11_MAP_READ;
+        if (SUCCEEDED(ctx_->Map(rt_stage_.Get(), 0, mapType, 0, &m)))
         {
+            stage_ns_[GCAP_STAGE_CONVERT].record(gcap::LatencyHistogram::nowNs() - tConvert);
+            if (maskReadback)
+                mask_.apply_argb(static_cast<uint8_t *>(m.pData), cur_w_, cur_h_, (int)m.RowPitch);
+
             gcap_frame_t f{};
             f.data[0] = m.pData;
             f.stride[0] = (int)m.RowPitch;
@@ -2170,88 +2400,73 @@ void WinMFProvider::loop()
             f.width = cur_w_;
             f.height = cur_h_;
             f.format = GCAP_FMT_ARGB;
-            f.pts_ns = (uint64_t)ts * 100;
+            f.pts_ns = pts;
             f.frame_id = ++frame_id_;
-            if (vcb_)
-                vcb_(&f, user_);
+            if (!healthDone)
+                health_.update_bgra(static_cast<const uint8_t *>(m.pData), cur_w_, cur_h_, (int)m.RowPitch, f.frame_id);
+            if (wantPrimary)
+                publish_frame(f, paced);
+            if (!fanout_.empty())
+                fanout_.process(gcap::image_from_buffer(GCAP_FMT_ARGB, static_cast<uint8_t *>(m.pData), (int)m.RowPitch, cur_w_, cur_h_),
+                                &f, pts, f.frame_id);
             ctx_->Unmap(rt_stage_.Get(), 0);
         }
     }
 }
 
-bool WinMFProvider::ensure_upload_yuv(int w, int h)
+bool WinMFProvider::ensure_upload_tex()
 {
+    if (upload_tex_)
+        return true;
     if (!d3d_)
         return false;
 
-    if (cur_subtype_ == MFVideoFormat_YUY2)
-    {
-        return ensure_upload_yuy2_packed(w, h);
-    }
-
-    if (upload_yuv_)
-    {
-        D3D11_TEXTURE2D_DESC desc{};
-        upload_yuv_->GetDesc(&desc);
-        if ((int)desc.Width == w && (int)desc.Height == h)
-            return true; // 尺寸相同就重複使用
-        upload_yuv_.Reset();
-    }
-
     D3D11_TEXTURE2D_DESC td{};
-    td.Width = w;
-    td.Height = h;
+    td.Width = upload_w_;
+    td.Height = (UINT)cur_h_;
     td.MipLevels = 1;
     td.ArraySize = 1;
     td.SampleDesc.Count = 1;
-    td.Format = (cur_subtype_ == MFVideoFormat_P010) ? DXGI_FORMAT_P010 : DXGI_FORMAT_NV12;
+    td.Format = upload_fmt_;
     td.Usage = D3D11_USAGE_DYNAMIC;             // 可 CPU 寫入
     td.BindFlags = D3D11_BIND_SHADER_RESOURCE;  // 給 pixel shader 當 SRV 用
     td.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE; // CPU write
     td.MiscFlags = 0;
 
-    HRESULT hr = d3d_->CreateTexture2D(&td, nullptr, &upload_yuv_);
+    HRESULT hr = d3d_->CreateTexture2D(&td, nullptr, &upload_tex_);
     if (FAILED(hr))
     {
-        MDBG("DXGI: Create upload NV12 texture failed", hr);
+        MDBG("DXGI: Create upload texture failed", hr);
         return false;
     }
     return true;
 }
 
-bool WinMFProvider::ensure_upload_yuy2_packed(int w, int h)
+bool WinMFProvider::upload_planes(const gcap::ImageRef &src)
 {
-    if (!d3d_)
+    if (!ensure_upload_tex())
         return false;
 
-    const int w2 = (w + 1) / 2;
-    if (upload_yuy2_packed_)
+    D3D11_MAPPED_SUBRESOURCE mapped{};
+    HRESULT hr = ctx_->Map(upload_tex_.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+    if (FAILED(hr))
     {
-        D3D11_TEXTURE2D_DESC desc{};
-        upload_yuy2_packed_->GetDesc(&desc);
-        if ((int)desc.Width == w2 && (int)desc.Height == h && desc.Format == DXGI_FORMAT_R8G8B8A8_UINT)
-            return true;
-        upload_yuy2_packed_.Reset();
+        MDBG("DXGI: Map(upload_tex_) failed", hr);
+        return false;
     }
 
-    D3D11_TEXTURE2D_DESC td{};
-    td.Width = (UINT)w2;
-    td.Height = (UINT)h;
-    td.MipLevels = 1;
-    td.ArraySize = 1;
-    td.SampleDesc.Count = 1;
-    td.Format = DXGI_FORMAT_R8G8B8A8_UINT; // 給 Texture2D<uint4>.Load 用
-    td.Usage = D3D11_USAGE_DYNAMIC;
-    td.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-    td.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    td.MiscFlags = 0;
-
-    HRESULT hr = d3d_->CreateTexture2D(&td, nullptr, &upload_yuy2_packed_);
-    if (FAILED(hr))
+    // NV12 / P010 textures keep the UV rows right below the Y rows, at the same RowPitch
+    uint8_t *dst = static_cast<uint8_t *>(mapped.pData);
+    for (int i = 0; i < gcap::pixfmt_desc(src.format).planeCount; ++i)
     {
-        MDBG("DXGI: Create upload YUY2 packed texture failed", hr);
-        return false;
+        const size_t rowBytes = (size_t)gcap::pixfmt_row_bytes(src.format, i, src.width);
+        const int rows = gcap::pixfmt_plane_rows(src.format, i, src.height);
+        for (int y = 0; y < rows; ++y)
+            memcpy(dst + (size_t)mapped.RowPitch * y, src.data[i] + (size_t)src.stride[i] * y, rowBytes);
+        dst += (size_t)mapped.RowPitch * rows;
     }
+
+    ctx_->Unmap(upload_tex_.Get(), 0);
     return true;
 }
 
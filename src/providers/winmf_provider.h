@@ -4,10 +4,23 @@
 #include <vector>
 #include <string>
 #include <mutex>
-#include <deque>
 
 #include "gcapture.h"
 #include "../core/capture_manager.h"
+#include "../core/privacy_mask.h"
+#include "../core/frame_health.h"
+#include "../core/convert_plan.h"
+#include "../core/frame_pool.h"
+#include "../core/frame_delivery.h"
+#include "../core/frame_mailbox.h"
+#include "../core/frame_fanout.h"
+#include "../core/frame_pacer.h"
+#include "../core/clock_recovery.h"
+#include "../core/latency_histogram.h"
+#include "../core/logger.h"
+#include "../core/thread_tuning.h"
+#include "../audio/audio_meter.h"
+#include "../audio/av_drift.h"
 
 // Media Foundation
 #include <mfapi.h>
@@ -53,6 +66,9 @@ public:
     // device_id_utf8 from gcap_enumerate_audio_devices; nullptr/"" => use default endpoint.
     gcap_status_t setRecordingAudioDevice(const char *device_id_utf8);
 
+    // Encoded size (0, 0 => capture size); native planes are rescaled before encode.
+    gcap_status_t setRecordingSize(int width, int height, gcap_scale_filter_t filter);
+
     // Set number of buffers and size hints (unused here)
     bool setBuffers(int count, size_t bytes_hint) override;
 
@@ -71,6 +87,22 @@ public:
     bool getDeviceProps(gcap_device_props_t &out) override;
     bool getSignalStatus(gcap_signal_status_t &out) override;
     bool setProcessing(const gcap_processing_opts_t &opts) override;
+    gcap_status_t setPrivacyMasks(const gcap_mask_region_t *regions, int count) override;
+    gcap_status_t setHealthInterval(int everyNFrames) override;
+    gcap_status_t getHealthStats(gcap_health_stats_t &out) override;
+    gcap_status_t getAudioLevels(gcap_audio_levels_t &out) override;
+    gcap_status_t getAvSyncStats(gcap_av_sync_stats_t &out) override;
+    gcap_status_t acquireFrame(int timeoutMs, const gcap_frame_t *&out) override;
+    gcap_status_t addConsumer(const gcap_consumer_desc_t &desc, int &id) override;
+    gcap_status_t removeConsumer(int id) override;
+    gcap_status_t setDelivery(gcap_delivery_policy_t policy, int queueDepth) override;
+    gcap_status_t getDeliveryStats(gcap_delivery_stats_t &out) override;
+    gcap_status_t setFrameRate(int fpsNum, int fpsDen, bool blend) override;
+    gcap_status_t getPacingStats(gcap_pacing_stats_t &out) override;
+    gcap_status_t getClockStats(gcap_clock_stats_t &out) override;
+    gcap_status_t getStats(gcap_stats_t &out) override;
+    gcap_status_t setLogCallback(gcap_on_log_cb cb, gcap_log_level_t minLevel, void *user) override;
+    gcap_status_t setThreadConfig(const gcap_thread_config_t &cfg) override;
 
     bool isUsingGpu() const { return use_dxgi_ && !cpu_path_; }
 
@@ -80,9 +112,12 @@ private:
     gcap_on_error_cb ecb_ = nullptr;
     void *user_ = nullptr;
 
-    std::mutex pending_mtx_;
-    std::deque<std::string> pending_logs_;
-    static constexpr size_t kMaxPendingLogs = 256;
+    // Diagnostics go to the log callback, else to ecb_ with GCAP_OK; until
+    // either is set they wait in the logger's queue (messages from open())
+    gcap::Logger log_;
+    gcap_on_log_cb lcb_ = nullptr;
+    gcap_log_level_t lcb_level_ = GCAP_LOG_DEBUG;
+    void *lcb_user_ = nullptr;
 
     // ---- State ----
     std::atomic<bool> running_{false};
@@ -90,8 +125,8 @@ private:
     uint64_t frame_id_ = 0;
     std::string dev_name_;        // 目前選用的裝置名稱（UTF-8）
     std::wstring dev_sym_link_w_; // MF device symbolic link（給 SetupAPI 查 Driver/FW/Serial 用）
-    double fps_avg_ = 0.0;
-    uint64_t last_pts_ns_ = 0;
+    // device timestamps -> smoothed frame PTS (also the overlay's fps)
+    gcap::ClockRecovery clock_;
     bool use_dxgi_ = false;
     bool cpu_path_ = true;
 
@@ -109,6 +144,19 @@ private:
     int cur_fps_den_ = 1;
     int cur_stride_ = 0;
     GUID cur_subtype_ = GUID_NULL; // MFVideoFormat_NV12 or MFVideoFormat_P010 or MFVideoFormat_YUY2
+    gcap_pixfmt_t cur_fmt_ = GCAP_FMT_NV12; // cur_subtype_ as gcap format
+    bool cur_fmt_known_ = false;            // false => subtype has no CPU layout (e.g. MJPG)
+
+    // Native → delivered format chain, planned once per run (CPU path)
+    gcap::ConvertPlan cpu_plan_;
+    gcap_pixfmt_t deliver_fmt_ = GCAP_FMT_ARGB; // setProcessing(preferred_pixfmt)
+    gcap_pixfmt_t cpu_out_fmt_ = GCAP_FMT_ARGB; // what cpu_plan_ actually produces
+    void plan_cpu_conversion();
+    // masks, health metrics and recording on the native planes
+    void prepare_native(const gcap::ImageRef &img, uint64_t frameId, LONGLONG ts);
+    // hand a finished frame to the callback (via delivery_) and the pull mailbox;
+    // `paced`: the pacer admitted it and delivers its output slots instead
+    void publish_frame(gcap_frame_t &f, bool paced);
 
     // ---- D3D11 / DXGI ----
     ComPtr<ID3D11Device> d3d_;
@@ -124,10 +172,12 @@ private:
     ComPtr<ID3D11RenderTargetView> rtv_rgba_;
     ComPtr<ID3D11Texture2D> rt_stage_;
 
-    // CPU→GPU 上傳用的 NV12 / P010 / YUY2  texture
-    Microsoft::WRL::ComPtr<ID3D11Texture2D> upload_yuv_;
-    // CPU→GPU 上傳用的 YUY2（打包成 RGBA8_UINT，寬度 = ceil(w/2)）
-    Microsoft::WRL::ComPtr<ID3D11Texture2D> upload_yuy2_packed_;
+    // CPU→GPU upload (no DXGI surfaces), planned once per run from pixfmt_desc(cur_fmt_)
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> upload_tex_;
+    DXGI_FORMAT upload_fmt_ = DXGI_FORMAT_UNKNOWN; // NV12 / P010, or RGBA8_UINT for packed YUY2
+    UINT upload_w_ = 0;                            // texels per row (YUY2: ceil(w/2))
+    bool (WinMFProvider::*upload_)(const gcap::ImageRef &src) = nullptr; // nullptr => no upload for cur_fmt_
+    std::wstring overlay_fmt_;                     // e.g. "P010 10-bit"
 
     // +++ Compute shader (NV12 → RGBA) + UAV for output
     Microsoft::WRL::ComPtr<ID3D11ComputeShader> cs_nv12_;
@@ -158,14 +208,15 @@ private:
     // --- internal helpers ---
     void loop();
     void emit_error(gcap_status_t c, const char *msg);
-    // open() 階段 callbacks 尚未設好時，先把 GCAP_OK 類型 log 暫存起來
-    void pending_log_push(const char *msg);
-    void pending_log_flush();
+    void update_log_sink();
+    // ThreadHook for the delivery / audio threads: apply run_thread_cfg_, or undo it
+    void tune_thread(bool begin, gcap::ThreadRole role);
 
     // init
     bool create_d3d();
     bool create_reader_with_dxgi(int devIndex);
     bool pick_best_native(GUID &sub, UINT32 &w, UINT32 &h, UINT32 &fn, UINT32 &fd);
+    bool try_native_high_chroma();
 
     // rendering
     bool ensure_rt_and_pipeline(int w, int h);
@@ -173,10 +224,10 @@ private:
     bool render_yuv_to_rgba(ID3D11Texture2D *yuvTex);
     bool gpu_overlay_text(const wchar_t *text);
 
-    // 確保 upload_yuv_ 尺寸 / format 正確
-    bool ensure_upload_yuv(int w, int h);
-    // 確保 upload_yuy2_packed_ 尺寸 / format 正確（寬度 = ceil(w/2)）
-    bool ensure_upload_yuy2_packed(int w, int h);
+    // CPU→GPU upload of the native planes
+    void plan_gpu_upload();
+    bool ensure_upload_tex();
+    bool upload_planes(const gcap::ImageRef &src);
 
     // Compute shader 相關 helper
     bool ensure_compute_shader();
@@ -198,8 +249,48 @@ private:
     std::mutex recorderMutex_;
     // Recording audio endpoint id (WASAPI endpoint id, UTF-8). Empty => system default.
     std::string rec_audio_device_id_;
-
-    std::vector<uint8_t> cpu_argb_;
+    // Recording output size (0 => capture size) and resampling filter
+    int rec_w_ = 0;
+    int rec_h_ = 0;
+    gcap_scale_filter_t rec_filter_ = GCAP_SCALE_BILINEAR;
+    // Native → NV12/P010 for the encoder when the source is 4:2:2 / 4:4:4 / V210
+    gcap::ConvertPlan rec_plan_;
+    gcap::NumaBuffer rec_buf_; // rec_plan_ output, on the configured NUMA node
+    gcap::ImageRef rec_img_;
+    // Recording audio levels; outlives recorder_ so readers never race its creation
+    gcap::audio::LevelMeter audio_meter_;
+    // Recording audio clock vs video PTS; drives the capture-side resampling trim
+    gcap::audio::AvDriftEstimator av_drift_;
+
+    // Converted CPU frames; consumers may keep them past the callback (gcap_frame_ref)
+    gcap::FramePool frame_pool_;
+    std::atomic<int> buf_count_{gcap::FramePool::kDefaultCount};
+    std::atomic<size_t> buf_bytes_hint_{0};
+    // vcb_ inline or on a delivery thread (gcap_set_delivery)
+    gcap::FrameDelivery delivery_;
+    // newest frame for gcap_acquire_frame
+    gcap::FrameMailbox mailbox_;
+    // gcap_add_consumer outputs, converted once per distinct format / size
+    gcap::FrameFanout fanout_{&log_};
+    // gcap_set_frame_rate: drops / repeats frames for the main output before conversion
+    gcap::FramePacer pacer_;
+
+    // gcap_set_thread_config; each thread reads it as it starts
+    std::mutex thread_cfg_mtx_;
+    gcap_thread_config_t thread_cfg_{GCAP_THREAD_PRIORITY_NORMAL, 0, 0, 0, -1};
+    gcap_thread_config_t thread_config();
+
+    // gcap_get_stats: each stage's histogram has one writer (capture or delivery thread)
+    gcap::LatencyHistogram stage_ns_[GCAP_STAGE_COUNT];
+    std::atomic<uint64_t> frames_captured_{0};
+    std::atomic<uint64_t> copied_base_{0}; // bytes_copied at the last start()
+    uint64_t copied_bytes() const;
+
+    // Privacy masks: burned into the native planes before record / convert
+    gcap::PrivacyMask mask_;
+
+    // Focus / noise / exposure metrics (every N frames, off by default)
+    gcap::FrameHealth health_;
 
     bool prefer_gpu_ = true;
 
@@ -0,0 +1,275 @@
+// audio_convert_test.cpp
+#include "test.h"
+#include "audio_convert.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <random>
+
+using namespace gcap::audio;
+
+namespace
+{
+    const Kernel kSimdKernels[] = {Kernel::Sse2, Kernel::Avx2, Kernel::Neon};
+
+    // Sizes around the 8 / 16 sample SIMD steps and the 256-sample dither block.
+    const size_t kSizes[] = {0, 1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 33, 255, 256, 257, 1000, 1023};
+
+    // Restores Auto when a test leaves.
+    struct KernelScope
+    {
+        explicit KernelScope(Kernel k) { ok = set_kernel(k); }
+        ~KernelScope() { set_kernel(Kernel::Auto); }
+        bool ok;
+    };
+
+    std::vector<float> random_f32(size_t n, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> d(-1.25f, 1.25f); // some clipping
+        std::vector<float> v(n);
+        for (auto &x : v)
+            x = d(rng);
+        return v;
+    }
+
+    std::vector<int32_t> random_s32(size_t n, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::vector<int32_t> v(n);
+        for (auto &x : v)
+            x = (int32_t)rng();
+        return v;
+    }
+
+    std::vector<uint8_t> random_s24(size_t n, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::vector<uint8_t> v(n * 3);
+        for (auto &x : v)
+            x = (uint8_t)rng();
+        return v;
+    }
+
+    // Output of `type` -> s16 under `kernel`, with dither when seed != 0.
+    std::vector<int16_t> convert(Kernel kernel, SampleType type, const void *src, size_t n, uint32_t seed,
+                                 uint32_t *stateOut = nullptr)
+    {
+        KernelScope k(kernel);
+        CHECK(k.ok);
+        std::vector<int16_t> out(n + 1, 0x5A5A); // sentinel past the end
+        TpdfDither d(seed);
+        to_s16(src, type, out.data(), n, seed ? &d : nullptr);
+        CHECK(out[n] == 0x5A5A);
+        out.pop_back();
+        if (stateOut)
+            *stateOut = d.state;
+        return out;
+    }
+
+    // Every supported SIMD kernel against the scalar loop.
+    void check_kernels_match(SampleType type, const void *src, size_t n, uint32_t seed)
+    {
+        uint32_t refState = 0;
+        const auto ref = convert(Kernel::Scalar, type, src, n, seed, &refState);
+        for (Kernel k : kSimdKernels)
+        {
+            if (!kernel_supported(k))
+                continue;
+            uint32_t state = 0;
+            CHECK(convert(k, type, src, n, seed, &state) == ref);
+            CHECK(state == refState);
+        }
+    }
+
+    void put_s24(uint8_t *p, int32_t v)
+    {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+    }
+}
+
+TEST(convert_kernel_selection)
+{
+    CHECK(kernel_supported(Kernel::Scalar));
+    CHECK(kernel_supported(Kernel::Auto));
+    int simd = 0;
+    for (Kernel k : kSimdKernels)
+        simd += kernel_supported(k) ? 1 : 0;
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    CHECK(simd > 0);
+#endif
+    CHECK(!(kernel_supported(Kernel::Sse2) && kernel_supported(Kernel::Neon)));
+    if (!kernel_supported(Kernel::Neon))
+    {
+        CHECK(!set_kernel(Kernel::Neon));
+        CHECK(kernel() == Kernel::Auto);
+    }
+}
+
+TEST(convert_f32_matches_scalar)
+{
+    for (size_t n : kSizes)
+    {
+        const auto src = random_f32(n, (uint32_t)n + 1);
+        check_kernels_match(SampleType::F32, src.data(), n, 0);
+        check_kernels_match(SampleType::F32, src.data(), n, 12345);
+    }
+}
+
+TEST(convert_s32_matches_scalar)
+{
+    for (size_t n : kSizes)
+    {
+        const auto src = random_s32(n, (uint32_t)n + 7);
+        check_kernels_match(SampleType::S32, src.data(), n, 0);
+        check_kernels_match(SampleType::S32, src.data(), n, 777);
+    }
+}
+
+TEST(convert_s24_matches_scalar)
+{
+    for (size_t n : kSizes)
+    {
+        const auto src = random_s24(n, (uint32_t)n + 13);
+        check_kernels_match(SampleType::S24, src.data(), n, 0);
+        check_kernels_match(SampleType::S24, src.data(), n, 4242);
+    }
+}
+
+TEST(convert_f32_clipping_and_nan)
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    // 17 samples: a SIMD body plus a scalar tail see the same special values
+    const float src[17] = {1.0f, -1.0f, 2.0f, -2.0f, inf, -inf, nan, 0.0f,
+                           1.0f, -1.0f, 2.0f, -2.0f, inf, -inf, nan, -0.0f, nan};
+    const int16_t want[17] = {32767, -32767, 32767, -32767, 32767, -32767, -32767, 0,
+                              32767, -32767, 32767, -32767, 32767, -32767, -32767, 0, -32767};
+    for (Kernel k : {Kernel::Scalar, Kernel::Sse2, Kernel::Avx2, Kernel::Neon})
+    {
+        if (!kernel_supported(k))
+            continue;
+        const auto out = convert(k, SampleType::F32, src, 17, 0);
+        for (int i = 0; i < 17; ++i)
+            CHECK(out[i] == want[i]);
+    }
+    // full-scale input stays in [-32767, 32767] with dither added
+    std::vector<float> full(600);
+    for (size_t i = 0; i < full.size(); ++i)
+        full[i] = (i & 1) ? 1.0f : -1.0f;
+    check_kernels_match(SampleType::F32, full.data(), full.size(), 99);
+    for (int16_t v : convert(Kernel::Auto, SampleType::F32, full.data(), full.size(), 99))
+        CHECK(v >= 32766 || v <= -32766);
+}
+
+TEST(convert_f32_ties_round_to_even)
+{
+    // inputs whose product with 32767 is exactly n + 0.5
+    std::vector<float> src;
+    std::vector<int16_t> want;
+    for (int n = -3000; n < 3000 && src.size() < 64; ++n)
+    {
+        const float half = (float)n + 0.5f;
+        const float x = half / 32767.0f;
+        if (x * 32767.0f != half)
+            continue;
+        src.push_back(x);
+        want.push_back((int16_t)(n % 2 == 0 ? n : n + 1));
+    }
+    CHECK(src.size() >= 16);
+    for (Kernel k : {Kernel::Scalar, Kernel::Sse2, Kernel::Avx2, Kernel::Neon})
+    {
+        if (!kernel_supported(k))
+            continue;
+        CHECK(convert(k, SampleType::F32, src.data(), src.size(), 0) == want);
+    }
+}
+
+TEST(convert_int_truncation)
+{
+    const int32_t s32[9] = {0x7FFFFFFF, (int32_t)0x80000000, 0x0000FFFF, -1, 0x00010000, -0x10000, -0x10001, 0, 0x12345678};
+    const int16_t want[9] = {32767, -32768, 0, -1, 1, -1, -2, 0, 0x1234};
+    for (Kernel k : {Kernel::Scalar, Kernel::Sse2, Kernel::Avx2, Kernel::Neon})
+    {
+        if (!kernel_supported(k))
+            continue;
+        const auto out = convert(k, SampleType::S32, s32, 9, 0);
+        for (int i = 0; i < 9; ++i)
+            CHECK(out[i] == want[i]);
+    }
+}
+
+TEST(convert_s24_sign_extension)
+{
+    const int32_t v[6] = {-1, -8388608, 8388607, -256, -257, 256};
+    uint8_t src[18];
+    for (int i = 0; i < 6; ++i)
+        put_s24(src + i * 3, v[i]);
+
+    // truncation keeps the top 16 bits of the sign-extended value
+    const auto t = convert(Kernel::Scalar, SampleType::S24, src, 6, 0);
+    const int16_t wantT[6] = {-1, -32768, 32767, -1, -2, 1};
+    for (int i = 0; i < 6; ++i)
+        CHECK(t[i] == wantT[i]);
+
+    // dithered: dither (< 1 LSB) plus rounding (0.5 LSB) from value / 256, clamped to +-32767
+    const auto d = convert(Kernel::Auto, SampleType::S24, src, 6, 31337);
+    for (int i = 0; i < 6; ++i)
+    {
+        const double exact = std::max(-32767.0, std::min(32767.0, v[i] / 256.0));
+        CHECK(std::fabs(d[i] - exact) < 1.5);
+    }
+
+    float f[6];
+    to_f32(src, SampleType::S24, f, 6);
+    CHECK(f[0] == -1.0f / 8388608.0f);
+    CHECK(f[1] == -1.0f);
+    CHECK(f[2] == 8388607.0f / 8388608.0f);
+    CHECK(f[3] < 0.0f && f[4] < 0.0f && f[5] > 0.0f);
+}
+
+TEST(convert_dither_deterministic)
+{
+    const auto src = random_f32(5000, 3);
+    const auto a = convert(Kernel::Auto, SampleType::F32, src.data(), src.size(), 2024);
+    const auto b = convert(Kernel::Auto, SampleType::F32, src.data(), src.size(), 2024);
+    const auto c = convert(Kernel::Auto, SampleType::F32, src.data(), src.size(), 2025);
+    CHECK(a == b);
+    CHECK(a != c);
+
+    // one call or many: the stream of dither values is the same
+    TpdfDither whole(7), split(7);
+    std::vector<int16_t> x(src.size()), y(src.size());
+    f32_to_s16(src.data(), x.data(), src.size(), &whole);
+    for (size_t off = 0, step = 1; off < src.size(); off += step, step = step * 3 % 509 + 1)
+        f32_to_s16(src.data() + off, y.data() + off, std::min(step, src.size() - off), &split);
+    CHECK(x == y);
+    CHECK(whole.state == split.state);
+
+    // a zero seed is replaced, not a stuck generator
+    CHECK(TpdfDither(0).state != 0);
+}
+
+TEST(convert_dither_distribution)
+{
+    // silence + TPDF dither: values in {-1, 0, 1}, about 3/4 of them 0
+    const size_t n = 100000;
+    std::vector<float> zero(n, 0.0f);
+    const auto out = convert(Kernel::Auto, SampleType::F32, zero.data(), n, 555);
+    size_t zeros = 0;
+    long long sum = 0;
+    bool inRange = true;
+    for (int16_t v : out)
+    {
+        inRange = inRange && v >= -1 && v <= 1;
+        zeros += v == 0 ? 1 : 0;
+        sum += v;
+    }
+    CHECK(inRange);
+    CHECK(zeros > n * 70 / 100 && zeros < n * 80 / 100);
+    CHECK(std::llabs(sum) < (long long)(n / 100));
+}
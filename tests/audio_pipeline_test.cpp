@@ -0,0 +1,228 @@
+// audio_pipeline_test.cpp
+#include "test.h"
+#include "audio_source.h"
+#include "av_drift.h"
+#include "frame_slicer.h"
+#include "shared_source.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace gcap::audio;
+
+// A synthetic 44.1 kHz / 24-bit device, unpaced, through the whole consumer
+// side of a recording: ring -> FrameSlicer (AAC-sized frames) with the A/V
+// drift estimator trimming the resampler, against a simulated video clock
+// that runs 300 ppm slow (so audio is 300 ppm fast relative to video).
+TEST(pipeline_synthetic_to_slicer_with_drift)
+{
+    const uint32_t rate = 48000, channels = 2;
+    const double audioFastPpm = 300.0;
+    const double seconds = 45.0; // past AvDriftEstimator::kMinSpan
+    const std::wstring id = L"synthetic:fast,rate=44100,bits=24,float=0,packet=441,pjitter=40,seed=7";
+
+    std::unique_ptr<IAudioSource> src = create_audio_source(id);
+    CHECK(src != nullptr);
+    if (!src)
+        return;
+    AvDriftEstimator drift;
+    drift.reset(44100);
+    src->setDriftCorrection(&drift);
+    src->setDither(true);
+
+    AudioFormat fmt;
+    CHECK(src->start(rate, channels, 16, id, &fmt));
+    CHECK(fmt.sampleRate == rate && fmt.channels == channels && fmt.blockAlign == channels * 2);
+    CHECK(src->deviceRate() == 44100);
+
+    FrameSlicer slicer;
+    const size_t frameBytes = 1024 * fmt.blockAlign;
+    CHECK(slicer.configure(frameBytes, 4));
+
+    uint64_t bytesIn = 0, framesOut = 0;
+    int64_t nextTs = 0;
+    bool contiguous = true, aligned = true, timedOut = false;
+    int64_t lastVideo = -1;
+    auto drain = [&]()
+    {
+        AudioChunk c;
+        while (src->peek(c))
+        {
+            contiguous = contiguous && !c.discontinuity && c.ts100ns == nextTs;
+            aligned = aligned && c.bytes % fmt.blockAlign == 0;
+            nextTs = c.ts100ns + c.dur100ns;
+
+            for (size_t off = 0; off < c.bytes;)
+            {
+                off += slicer.push(c.pcm + off, c.bytes - off);
+                while (slicer.front())
+                {
+                    slicer.pop();
+                    ++framesOut;
+                }
+            }
+            bytesIn += c.bytes;
+            src->release();
+
+            // one "video frame" per 20 ms of device audio, stamped on the slow video clock
+            const uint64_t captured = src->capturedFrames();
+            const int64_t video = (int64_t)((double)captured / 44100.0 * (1.0 - audioFastPpm * 1e-6) * 1e7);
+            if (video - lastVideo >= 200000)
+            {
+                drift.observe(video, captured, src->discontinuities());
+                lastVideo = video;
+            }
+        }
+    };
+    while (src->capturedFrames() < (uint64_t)(seconds * 44100))
+    {
+        if (!src->waitForData(1000))
+        {
+            timedOut = true;
+            break;
+        }
+        drain();
+    }
+    src->stop();
+    drain(); // what was still buffered stays readable after stop()
+
+    CHECK(!timedOut);
+    CHECK(contiguous);
+    CHECK(aligned);
+    CHECK(framesOut == bytesIn / frameBytes);
+    CHECK(slicer.buffered() == bytesIn % frameBytes);
+    CHECK(src->discontinuities() == 0);
+    CHECK(src->ringStats().droppedPackets == 0);
+
+    gcap_av_sync_stats_t st{};
+    drift.stats(st);
+    CHECK(st.active == 1);
+    CHECK(std::fabs(st.drift_ppm - audioFastPpm) < 10.0);
+    CHECK(st.rebases == 0);
+    // fast audio is trimmed: fewer output frames per device frame
+    CHECK(drift.correction() < 1.0);
+    CHECK(std::fabs((1.0 - drift.correction()) * 1e6 - audioFastPpm) < 10.0);
+
+    // every device frame came out, at 48/44.1 within the applied trim
+    const double ratio = (double)(bytesIn / fmt.blockAlign) / (double)src->capturedFrames() * 44100.0 / rate;
+    CHECK(ratio < 1.0 + 50e-6 && ratio > 1.0 - audioFastPpm * 1e-6 - 50e-6);
+}
+
+// stop() wakes a consumer blocked in waitForData() instead of leaving it to the timeout.
+TEST(pipeline_stop_wakes_consumer)
+{
+    std::unique_ptr<IAudioSource> src = create_audio_source(L"synthetic");
+    CHECK(src && src->start(48000, 2, 16, L"synthetic:silence,packet=48000")); // first packet due in 1 s
+    if (!src)
+        return;
+
+    using clock = std::chrono::steady_clock;
+    bool got = true;
+    clock::duration waited{};
+    std::thread consumer([&]()
+                         {
+                             const auto t0 = clock::now();
+                             got = src->waitForData(5000);
+                             waited = clock::now() - t0; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    src->stop();
+    consumer.join();
+    CHECK(!got);
+    CHECK(waited < std::chrono::milliseconds(900));
+}
+
+// Two consumers of one endpoint share a single device client, each with its own format.
+TEST(pipeline_shared_device)
+{
+    const std::wstring id = L"synthetic:fast,rate=44100,ch=2,packet=441";
+    std::unique_ptr<IAudioSource> a = create_audio_source(id);
+    std::unique_ptr<IAudioSource> b = create_audio_source(id);
+    CHECK(shared_audio_users(id) == 0);
+
+    AudioFormat fa, fb;
+    CHECK(a->start(48000, 2, 16, id, &fa));
+    CHECK(b->start(16000, 1, 16, id, &fb));
+    CHECK(shared_audio_users(id) == 2);
+    CHECK(fa.sampleRate == 48000 && fa.channels == 2);
+    CHECK(fb.sampleRate == 16000 && fb.channels == 1 && fb.blockAlign == 2);
+    CHECK(a->deviceRate() == 44100 && b->deviceRate() == 44100);
+
+    // both outputs are fed from the same packets
+    auto consume = [](IAudioSource &s, uint64_t bytes)
+    {
+        uint64_t got = 0;
+        AudioChunk c;
+        while (got < bytes && s.waitForData(1000))
+            while (s.peek(c))
+            {
+                got += c.bytes;
+                s.release();
+            }
+        return got;
+    };
+    CHECK(consume(*a, 48000 * 4) >= 48000 * 4);
+    CHECK(consume(*b, 16000 * 2) >= 16000 * 2);
+
+    // one consumer leaving keeps the device running for the other
+    a->stop();
+    CHECK(!a->running() && b->running());
+    CHECK(shared_audio_users(id) == 1);
+    const uint64_t before = b->capturedFrames();
+    CHECK(consume(*b, 16000 * 2) >= 16000 * 2);
+    CHECK(b->capturedFrames() > before);
+
+    b->stop();
+    CHECK(shared_audio_users(id) == 0);
+    CHECK(b->capturedFrames() >= before); // counts stay readable after stop()
+
+    // a different id is a device of its own
+    const std::wstring other = L"synthetic:fast,rate=48000";
+    CHECK(a->start(48000, 2, 16, id));
+    CHECK(b->start(48000, 2, 16, other));
+    CHECK(shared_audio_users(id) == 1 && shared_audio_users(other) == 1);
+    a.reset();
+    b.reset();
+    CHECK(shared_audio_users(id) == 0 && shared_audio_users(other) == 0);
+}
+
+// A hot 5.1 source folded to stereo stays below full scale unless
+// normalisation is turned off.
+TEST(pipeline_downmix_normalized)
+{
+    DeviceFormat dev;
+    dev.sampleRate = 48000;
+    dev.channels = 6;
+    dev.bits = 32;
+    dev.isFloat = true;
+    dev.blockAlign = 6 * 4;
+
+    const uint32_t frames = 480;
+    std::vector<float> in((size_t)frames * 6, 0.5f);
+    auto peak = [&](bool normalize)
+    {
+        AudioOutput out;
+        out.setNormalizeDownmix(normalize);
+        out.prepare(48000, 2);
+        if (!out.configure(dev, frames))
+            return -1;
+        out.deliver(dev, in.data(), frames, false);
+        int p = 0;
+        AudioChunk c;
+        while (out.peek(c))
+        {
+            const int16_t *s = (const int16_t *)c.pcm;
+            for (size_t i = 0; i < c.bytes / 2; ++i)
+                p = std::max(p, std::abs((int)s[i]));
+            out.release();
+        }
+        return p;
+    };
+    // L = FL + C/sqrt2 + SL/sqrt2 = 1.21 at -6 dBFS input; normalised back to 0.5
+    const int normalized = peak(true);
+    CHECK(std::abs(normalized - 16384) < 8);
+    CHECK(peak(false) == 32767);
+}
@@ -0,0 +1,175 @@
+// clock_recovery_test.cpp
+#include "test.h"
+#include "clock_recovery.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+using gcap::ClockRecovery;
+
+namespace
+{
+    constexpr int64_t kPeriod30 = 33333333; // 30 fps
+
+    gcap_clock_stats_t stats_of(const ClockRecovery &c)
+    {
+        gcap_clock_stats_t s{};
+        c.stats(s);
+        return s;
+    }
+}
+
+// 29.97 fps device (NTSC rate against a 30 fps nominal) with +-12.5 ms of
+// arrival jitter: the output follows the ideal timeline of the device clock.
+TEST(clock_jitter_smoothed)
+{
+    const double period = 1e9 * 1001.0 / 30000.0;
+    const int64_t t0 = 5000000000;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> jitter(-12.5e6, 12.5e6);
+
+    ClockRecovery c;
+    c.reset(30, 1);
+    double worst = 0.0;
+    for (int k = 0; k < 600; ++k)
+    {
+        const double ideal = (double)t0 + period * k;
+        const int64_t out = c.update((int64_t)(ideal + (k ? jitter(rng) : 0.0)));
+        if (k >= 120) // one full window in
+            worst = std::max(worst, std::fabs((double)out - ideal));
+    }
+    CHECK(worst < 5e6);
+
+    const gcap_clock_stats_t s = stats_of(c);
+    CHECK(s.locked == 1);
+    CHECK(std::fabs(s.nominal_fps - 30.0) < 1e-9);
+    CHECK(std::fabs(s.clock_fps - 30000.0 / 1001.0) < 0.05);
+    CHECK(s.jitter_ms > 5.0 && s.jitter_ms < 10.0); // uniform +-12.5 ms: RMS ~7.2 ms
+    CHECK(s.frames == 600 && s.dropped == 0 && s.resyncs == 0);
+}
+
+// Gaps of 1.75 periods or more are drops; anything shorter is one frame.
+TEST(clock_drops_counted)
+{
+    ClockRecovery c;
+    c.reset(30, 1);
+    for (int k = 0; k < 60; ++k)
+        c.update(k * kPeriod30);
+
+    // frame 60 arrives 1.7 periods after frame 59: late, not a drop
+    c.update(59 * kPeriod30 + kPeriod30 * 17 / 10);
+    CHECK(stats_of(c).dropped == 0);
+    const int64_t out61 = c.update(61 * kPeriod30);
+    CHECK(stats_of(c).dropped == 0);
+
+    // frame 62 missing: the PTS skips its slot instead of closing the gap
+    const int64_t out63 = c.update(63 * kPeriod30);
+    CHECK(stats_of(c).dropped == 1);
+    CHECK(std::llabs(out63 - out61 - 2 * kPeriod30) < kPeriod30 / 10);
+
+    // 65..67 missing
+    c.update(64 * kPeriod30);
+    c.update(68 * kPeriod30);
+    CHECK(stats_of(c).dropped == 4);
+    CHECK(stats_of(c).resyncs == 0);
+}
+
+// A timestamp going backwards or a gap past kMaxGapNs restarts the fit and
+// carries on from the last output PTS.
+TEST(clock_restarts)
+{
+    ClockRecovery c;
+    c.reset(30, 1);
+    int64_t t = 1000000000, out = 0;
+    for (int k = 0; k < 40; ++k, t += kPeriod30)
+        out = c.update(t);
+
+    // device clock restarted near zero
+    int64_t next = c.update(10000);
+    CHECK(stats_of(c).resyncs == 1);
+    CHECK(next > out && next - out <= kPeriod30 + 1);
+    out = next;
+
+    // three seconds of nothing: the elapsed time is kept, not counted as drops
+    next = c.update(10000 + 3000000000LL);
+    CHECK(stats_of(c).resyncs == 2);
+    CHECK(next - out == 3000000000LL);
+    CHECK(stats_of(c).dropped == 0);
+    out = next;
+
+    // a flagged discontinuity restarts too
+    next = c.update(10000 + 3000000000LL + kPeriod30, true);
+    CHECK(stats_of(c).resyncs == 3);
+    CHECK(next - out == kPeriod30);
+
+    // the period survives a restart
+    CHECK(std::fabs(c.clockFps() - 30.0) < 0.01);
+    CHECK(stats_of(c).locked == 0);
+}
+
+// Until kMinPoints frames are in, the nominal period weighs in as a
+// 30-point window of its own; afterwards only the data counts.
+TEST(clock_nominal_prior)
+{
+    const double devPeriod = 40e6; // 25 fps device behind a 30 fps media type
+    const double nominal = 1e9 / 30.0;
+    const double prior = 30.0 * (30.0 * 30.0 - 1.0) / 12.0;
+
+    ClockRecovery c;
+    c.reset(30, 1);
+    for (int n = 1; n <= ClockRecovery::kMinPoints + 10; ++n)
+    {
+        c.update((int64_t)(devPeriod * (n - 1)));
+        if (n < 2)
+            continue;
+        const double sii = n * ((double)n * n - 1.0) / 12.0;
+        const double want = n < ClockRecovery::kMinPoints ? (sii * devPeriod + prior * nominal) / (sii + prior)
+                                                          : devPeriod;
+        CHECK(std::fabs(1e9 / c.clockFps() - want) < 1.0);
+        CHECK(stats_of(c).locked == (n >= ClockRecovery::kMinPoints ? 1 : 0));
+    }
+    CHECK(stats_of(c).dropped == 0);
+
+    // with no nominal rate the data alone sets the period from the second frame
+    ClockRecovery u;
+    u.reset();
+    u.update(0);
+    u.update((int64_t)devPeriod);
+    CHECK(std::fabs(u.clockFps() - 25.0) < 1e-6);
+}
+
+// Whatever the input does, output PTS strictly increases.
+TEST(clock_output_monotonic)
+{
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> event(0, 99);
+    std::uniform_real_distribution<double> jitter(-20e6, 20e6);
+
+    ClockRecovery c;
+    c.reset(60, 1);
+    const double period = 1e9 / 60.0;
+    double t = 0.0;
+    int64_t last = INT64_MIN;
+    bool increasing = true;
+    for (int k = 0; k < 5000; ++k)
+    {
+        const int e = event(rng);
+        if (e < 2)
+            t -= 500e6; // clock steps back
+        else if (e < 4)
+            t += 5 * period; // burst of drops
+        else if (e < 5)
+            t += 2.5e9; // long gap
+        else if (e < 15)
+            t += 0.05 * period; // frames bunched together
+        else
+            t += period;
+        const int64_t out = c.update((int64_t)(t + jitter(rng)), e == 99);
+        increasing = increasing && out > last;
+        last = out;
+    }
+    CHECK(increasing);
+    CHECK(stats_of(c).frames == 5000);
+    CHECK(stats_of(c).resyncs > 0);
+}
@@ -0,0 +1,158 @@
+// device_cache_test.cpp
+#include "test.h"
+#include "device_cache.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using gcap::DeviceListCache;
+
+namespace
+{
+    // Stand-in backend: each enumeration lists `devices` ids, tagged with
+    // the call number, and fails while `fail` is set.
+    struct FakeBackend
+    {
+        std::atomic<int> calls{0};
+        std::atomic<int> devices{2};
+        std::atomic<bool> fail{false};
+        std::function<void()> during; // runs inside the enumeration
+
+        gcap_status_t load(std::vector<int> &out)
+        {
+            const int call = ++calls;
+            if (during)
+                during();
+            if (fail)
+                return GCAP_EIO;
+            for (int i = 0; i < devices; ++i)
+                out.push_back(call * 100 + i);
+            return GCAP_OK;
+        }
+    };
+
+    using Cache = DeviceListCache<int>;
+
+    Cache make_cache(FakeBackend &b)
+    {
+        return Cache([&b](std::vector<int> &out)
+                     { return b.load(out); });
+    }
+}
+
+TEST(device_cache_hit)
+{
+    FakeBackend b;
+    Cache c = make_cache(b);
+    std::shared_ptr<const std::vector<int>> first, second;
+    CHECK(c.get(first) == GCAP_OK);
+    CHECK(c.get(second) == GCAP_OK);
+    CHECK(b.calls == 1 && c.enumerations() == 1);
+    CHECK(first == second); // the same snapshot, not a copy
+    CHECK(first && *first == std::vector<int>({100, 101}));
+}
+
+TEST(device_cache_invalidate_reloads)
+{
+    FakeBackend b;
+    Cache c = make_cache(b);
+    std::shared_ptr<const std::vector<int>> before, after;
+    CHECK(c.get(before) == GCAP_OK);
+    b.devices = 3; // hotplug
+    c.invalidate();
+    CHECK(c.get(after) == GCAP_OK);
+    CHECK(b.calls == 2);
+    CHECK(after && after->size() == 3 && after->front() == 200);
+    // a snapshot already handed out is never modified
+    CHECK(before && *before == std::vector<int>({100, 101}));
+}
+
+TEST(device_cache_max_age)
+{
+    FakeBackend b;
+    Cache c = make_cache(b);
+    c.setMaxAge(std::chrono::milliseconds(30));
+    std::shared_ptr<const std::vector<int>> l;
+    CHECK(c.get(l) == GCAP_OK);
+    CHECK(c.get(l) == GCAP_OK);
+    CHECK(b.calls == 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(c.get(l) == GCAP_OK);
+    CHECK(b.calls == 2 && l && l->front() == 200);
+
+    // back to invalidation only
+    c.setMaxAge(std::chrono::milliseconds(0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(c.get(l) == GCAP_OK);
+    CHECK(b.calls == 2);
+}
+
+TEST(device_cache_failure_not_cached)
+{
+    FakeBackend b;
+    Cache c = make_cache(b);
+    std::shared_ptr<const std::vector<int>> l;
+    b.fail = true;
+    CHECK(c.get(l) == GCAP_EIO);
+    CHECK(!l);
+    CHECK(c.get(l) == GCAP_EIO);
+    CHECK(b.calls == 2 && c.enumerations() == 0);
+
+    b.fail = false;
+    CHECK(c.get(l) == GCAP_OK);
+    CHECK(l && l->front() == 300);
+
+    // a failed reload leaves the old list in place
+    c.invalidate();
+    b.fail = true;
+    std::shared_ptr<const std::vector<int>> again;
+    CHECK(c.get(again) == GCAP_EIO);
+    b.fail = false;
+    CHECK(c.get(again) == GCAP_OK);
+    CHECK(b.calls == 5 && again && again->front() == 500);
+}
+
+// A change notified while an enumeration runs: that result may already be
+// stale, so the next get() does not reuse it.
+TEST(device_cache_change_during_enumeration)
+{
+    FakeBackend b;
+    Cache c = make_cache(b);
+    b.during = [&]
+    {
+        if (b.calls == 1)
+        {
+            b.devices = 4;
+            c.invalidate();
+        }
+    };
+    std::shared_ptr<const std::vector<int>> l;
+    CHECK(c.get(l) == GCAP_OK);
+    CHECK(l && l->size() == 4 && l->front() == 100);
+    CHECK(c.get(l) == GCAP_OK);
+    CHECK(b.calls == 2 && l && l->front() == 200);
+    CHECK(c.get(l) == GCAP_OK);
+    CHECK(b.calls == 2);
+}
+
+// Callers arriving during an enumeration share its result.
+TEST(device_cache_concurrent_get)
+{
+    FakeBackend b;
+    Cache c = make_cache(b);
+    b.during = []
+    { std::this_thread::sleep_for(std::chrono::milliseconds(20)); };
+    std::vector<std::shared_ptr<const std::vector<int>>> got(8);
+    std::vector<std::thread> ts;
+    for (auto &g : got)
+        ts.emplace_back([&c, &g]
+                        { c.get(g); });
+    for (auto &t : ts)
+        t.join();
+    CHECK(b.calls == 1);
+    bool same = true;
+    for (auto &g : got)
+        same = same && g && g == got[0];
+    CHECK(same);
+}
@@ -0,0 +1,129 @@
+// frame_slicer_test.cpp
+#include "test.h"
+#include "frame_slicer.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+using gcap::audio::FrameSlicer;
+
+TEST(slicer_configure_rejects_zero)
+{
+    FrameSlicer s;
+    CHECK(!s.configure(0, 4));
+    CHECK(!s.configure(16, 0));
+    CHECK(!s.configure(0, 0));
+    CHECK(s.frameBytes() == 0);
+    CHECK(s.front() == nullptr);
+    CHECK(s.framesReady() == 0);
+    const uint8_t b = 1;
+    CHECK(s.push(&b, 1) == 0); // no storage yet
+
+    // a rejected reconfigure keeps the working configuration and its data
+    CHECK(s.configure(4, 2));
+    const uint8_t data[4] = {1, 2, 3, 4};
+    CHECK(s.push(data, 4) == 4);
+    CHECK(!s.configure(0, 8));
+    CHECK(s.frameBytes() == 4);
+    CHECK(s.front() && std::memcmp(s.front(), data, 4) == 0);
+}
+
+TEST(slicer_partial_push_when_full)
+{
+    FrameSlicer s;
+    CHECK(s.configure(4, 3)); // 12 bytes
+    uint8_t data[20];
+    for (int i = 0; i < 20; ++i)
+        data[i] = (uint8_t)i;
+
+    CHECK(s.push(data, 10) == 10);
+    CHECK(s.space() == 2);
+    CHECK(s.push(data + 10, 10) == 2); // only what fits
+    CHECK(s.space() == 0);
+    CHECK(s.push(data + 12, 1) == 0);
+    CHECK(s.framesReady() == 3);
+
+    s.pop();
+    CHECK(s.space() == 4);
+    CHECK(s.push(data + 12, 8) == 4); // lands across the wrap point
+    for (int f = 0; f < 3; ++f)
+    {
+        CHECK(s.front() && std::memcmp(s.front(), data + 4 + f * 4, 4) == 0);
+        s.pop();
+    }
+    CHECK(s.front() == nullptr);
+    CHECK(s.buffered() == 0);
+}
+
+TEST(slicer_front_aligned_after_wrap)
+{
+    // a frame size that does not divide the pushes, so writes wrap mid-frame
+    FrameSlicer s;
+    CHECK(s.configure(6, 4));
+    std::vector<uint8_t> stream(6 * 40);
+    for (size_t i = 0; i < stream.size(); ++i)
+        stream[i] = (uint8_t)(i * 7 + 3);
+
+    size_t in = 0, out = 0;
+    while (out < stream.size())
+    {
+        in += s.push(stream.data() + in, std::min<size_t>(5, stream.size() - in));
+        while (const uint8_t *f = s.front())
+        {
+            CHECK(std::memcmp(f, stream.data() + out, 6) == 0);
+            s.pop();
+            out += 6;
+        }
+    }
+    CHECK(in == stream.size());
+    CHECK(s.buffered() == 0);
+
+    // pop() without a whole frame is a no-op
+    const uint8_t part[3] = {9, 9, 9};
+    CHECK(s.push(part, 3) == 3);
+    s.pop();
+    CHECK(s.buffered() == 3);
+    s.reset();
+    CHECK(s.buffered() == 0 && s.space() == 24);
+}
+
+TEST(slicer_random_pushes)
+{
+    std::mt19937 rng(42);
+    for (const size_t frame : {1u, 3u, 64u, 1920u})
+    {
+        FrameSlicer s;
+        const size_t frames = 1 + rng() % 5;
+        CHECK(s.configure(frame, frames));
+
+        std::deque<uint8_t> model; // bytes the slicer should hold
+        uint8_t next = 0;
+        std::vector<uint8_t> chunk;
+        for (int iter = 0; iter < 2000; ++iter)
+        {
+            // up to twice the capacity, so pushes regularly straddle the wrap and the full state
+            chunk.resize(rng() % (2 * frame * frames + 1));
+            for (auto &b : chunk)
+                b = next++;
+            const size_t took = s.push(chunk.data(), chunk.size());
+            CHECK(took == std::min(chunk.size(), frame * frames - model.size()));
+            model.insert(model.end(), chunk.begin(), chunk.begin() + took);
+            next = (uint8_t)(next - (chunk.size() - took)); // rejected bytes are sent again
+            CHECK(s.buffered() == model.size());
+            CHECK(s.framesReady() == model.size() / frame);
+
+            for (size_t pops = rng() % (frames + 1); pops > 0 && s.front(); --pops)
+            {
+                const uint8_t *f = s.front();
+                bool same = true;
+                for (size_t i = 0; i < frame; ++i)
+                    same = same && f[i] == model[i];
+                CHECK(same);
+                s.pop();
+                model.erase(model.begin(), model.begin() + frame);
+            }
+        }
+    }
+}
@@ -0,0 +1,144 @@
+// numa_placement_test.cpp
+#include "test.h"
+#include "convert_plan.h"
+#include "frame_delivery.h"
+#include "frame_pool.h"
+#include "thread_tuning.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace gcap;
+
+namespace
+{
+    // Node 0 where the machine reports NUMA topology, else "anywhere".
+    int test_node()
+    {
+        gcap_thread_config_t cfg{};
+        cfg.numa_node = 0;
+        return thread_config_valid(cfg) ? 0 : -1;
+    }
+
+    bool page_aligned(const void *p)
+    {
+        return (uintptr_t)p % 4096 == 0;
+    }
+}
+
+TEST(numa_config_validation)
+{
+    gcap_thread_config_t cfg{};
+    cfg.numa_node = -1;
+    CHECK(thread_config_valid(cfg));
+    cfg.numa_node = -2;
+    CHECK(!thread_config_valid(cfg));
+    cfg.numa_node = 1 << 20; // no machine has that many nodes
+    CHECK(!thread_config_valid(cfg));
+}
+
+TEST(numa_buffer_alloc)
+{
+    for (const int node : {-1, test_node()})
+    {
+        NumaBuffer a;
+        CHECK(a.data() == nullptr && a.size() == 0);
+        CHECK(a.allocate(10000, node));
+        CHECK(a.data() && a.size() == 10000 && page_aligned(a.data()));
+        bool zero = true;
+        for (size_t i = 0; i < a.size(); ++i)
+            zero = zero && a.data()[i] == 0;
+        CHECK(zero);
+        a.data()[a.size() - 1] = 1; // the whole block is writable
+
+        uint8_t *const p = a.data();
+        NumaBuffer b = std::move(a);
+        CHECK(a.data() == nullptr && a.size() == 0);
+        CHECK(b.data() == p && b.size() == 10000);
+        b.reset();
+        CHECK(b.data() == nullptr);
+        CHECK(!b.allocate(0, node));
+    }
+}
+
+TEST(numa_frame_pool_node)
+{
+    const int node = test_node();
+    FramePool pool;
+    pool.reserve(2, 1000);
+    FramePool::Buffer *b = pool.acquire();
+    CHECK(b && b->node == -1);
+    pool.setNumaNode(node);
+    CHECK(pool.count() == 0); // free buffers are dropped, the held one survives
+    CHECK(b && b->capacity >= 1000);
+    FramePool::unref(b);
+
+    pool.reserve(2, 1000);
+    b = pool.acquire();
+    CHECK(b && b->node == node && ((uintptr_t)b->data % FramePool::kAlign) == 0);
+    FramePool::unref(b);
+}
+
+// Intermediates on a node convert exactly like ordinary ones.
+TEST(numa_convert_plan_intermediates)
+{
+    const int w = 48, h = 16;
+    const int stride = pixfmt_row_bytes(GCAP_FMT_V210, 0, w);
+    std::vector<uint8_t> src((size_t)stride * h);
+    std::mt19937 rng(5);
+    for (auto &v : src)
+        v = (uint8_t)rng();
+    const ImageRef in = image_from_buffer(GCAP_FMT_V210, src.data(), stride, w, h);
+
+    std::vector<uint8_t> out[2];
+    int i = 0;
+    for (const int node : {-1, test_node()})
+    {
+        ConvertPlan plan;
+        plan.setNumaNode(node);
+        CHECK(plan.build(GCAP_FMT_V210, w, h, GCAP_FMT_ARGB, w, h));
+        CHECK(plan.valid() && !plan.passthrough());
+        out[i].assign((size_t)w * 4 * h, 0);
+        plan.run(in, image_from_buffer(GCAP_FMT_ARGB, out[i].data(), w * 4, w, h));
+        ++i;
+    }
+    CHECK(out[0] == out[1]);
+}
+
+// Frames the delivery thread gets are copies placed on the configured node.
+TEST(numa_delivery_copies)
+{
+    const int node = test_node();
+    FrameDelivery d;
+    CHECK(d.configure(GCAP_DELIVERY_DROP_OLDEST, 2));
+    d.setNumaNode(node);
+    std::atomic<int> got{0}, onNode{0};
+    d.start([&](const gcap_frame_t *f)
+            {
+                const auto *b = static_cast<const FramePool::Buffer *>(f->pool_ref);
+                onNode += b && b->node == node ? 1 : 0;
+                ++got; });
+
+    std::vector<uint8_t> argb(64 * 4 * 8, 0x80);
+    gcap_frame_t f{};
+    f.data[0] = argb.data();
+    f.stride[0] = 64 * 4;
+    f.plane_count = 1;
+    f.width = 64;
+    f.height = 8;
+    f.format = GCAP_FMT_ARGB;
+    for (int n = 0; n < 3; ++n)
+    {
+        f.frame_id = (uint64_t)n + 1;
+        d.push(f);
+        for (int spin = 0; spin < 1000 && got.load() <= n; ++spin)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    d.stop();
+    CHECK(got.load() == 3);
+    CHECK(onNode.load() == 3);
+    CHECK(d.copiedBytes() > 0);
+}
@@ -0,0 +1,75 @@
+// privacy_mask_test.cpp
+#include "test.h"
+#include "privacy_mask.h"
+
+#include <vector>
+
+using namespace gcap;
+
+namespace
+{
+    gcap_mask_region_t fill_rect(int x, int y, int w, int h, uint8_t v)
+    {
+        gcap_mask_region_t r{};
+        r.mode = GCAP_MASK_FILL;
+        r.x = x;
+        r.y = y;
+        r.width = w;
+        r.height = h;
+        r.fill_r = r.fill_g = r.fill_b = v;
+        return r;
+    }
+
+    std::vector<uint8_t> grey_argb(int w, int h, uint8_t v)
+    {
+        return std::vector<uint8_t>((size_t)w * h * 4, v);
+    }
+}
+
+TEST(mask_empty_tracks_regions)
+{
+    PrivacyMask m;
+    CHECK(m.empty());
+    gcap_mask_region_t r = fill_rect(0, 0, 4, 4, 255);
+    CHECK(m.setRegions(&r, 1));
+    CHECK(!m.empty());
+    CHECK(m.setRegions(nullptr, 0));
+    CHECK(m.empty());
+}
+
+TEST(mask_invalid_set_keeps_previous)
+{
+    PrivacyMask m;
+    gcap_mask_region_t r = fill_rect(0, 0, 4, 4, 255);
+    CHECK(m.setRegions(&r, 1));
+    gcap_mask_region_t bad = fill_rect(0, 0, 0, 4, 255);
+    CHECK(!m.setRegions(&bad, 1));
+    CHECK(!m.empty());
+}
+
+TEST(mask_republished_between_frames)
+{
+    const int w = 8, h = 8;
+    PrivacyMask m;
+
+    gcap_mask_region_t a = fill_rect(0, 0, 2, 2, 255);
+    CHECK(m.setRegions(&a, 1));
+    auto f1 = grey_argb(w, h, 0);
+    m.apply_argb(f1.data(), w, h, w * 4);
+    CHECK(f1[0] == 255);
+    CHECK(f1[(size_t)(6 * w + 6) * 4] == 0);
+
+    // A new set must be picked up by the very next frame.
+    gcap_mask_region_t b = fill_rect(6, 6, 2, 2, 255);
+    CHECK(m.setRegions(&b, 1));
+    auto f2 = grey_argb(w, h, 0);
+    m.apply_argb(f2.data(), w, h, w * 4);
+    CHECK(f2[0] == 0);
+    CHECK(f2[(size_t)(6 * w + 6) * 4] == 255);
+
+    CHECK(m.setRegions(nullptr, 0));
+    auto f3 = grey_argb(w, h, 0);
+    m.apply_argb(f3.data(), w, h, w * 4);
+    for (uint8_t v : f3)
+        CHECK(v == 0);
+}
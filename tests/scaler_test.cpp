@@ -0,0 +1,136 @@
+// scaler_test.cpp
+#include "test.h"
+#include "pixel_format.h"
+#include "scaler.h"
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace gcap;
+
+namespace
+{
+    const gcap_scale_filter_t kFilters[] = {GCAP_SCALE_BILINEAR, GCAP_SCALE_BICUBIC, GCAP_SCALE_LANCZOS3};
+    const gcap_pixfmt_t kFormats[] = {GCAP_FMT_NV12, GCAP_FMT_P010, GCAP_FMT_YUY2, GCAP_FMT_GRAY8, GCAP_FMT_ARGB};
+
+    struct Image
+    {
+        gcap_pixfmt_t fmt;
+        int w, h, stride;
+        std::vector<uint8_t> bytes;
+        ImageRef ref;
+
+        Image(gcap_pixfmt_t f, int width, int height)
+            : fmt(f), w(width), h(height), stride(pixfmt_row_bytes(f, 0, width) + 64) // padded rows
+        {
+            bytes.assign(pixfmt_frame_bytes(f, w, h, stride), 0);
+            ref = image_from_buffer(f, bytes.data(), stride, w, h);
+        }
+
+        bool scale(PlaneScaler &s, Image &dst) const
+        {
+            const uint8_t *const sp[2] = {ref.data[0], ref.data[1]};
+            const int ss[2] = {ref.stride[0], ref.stride[1]};
+            uint8_t *const dp[2] = {dst.ref.data[0], dst.ref.data[1]};
+            const int ds[2] = {dst.ref.stride[0], dst.ref.stride[1]};
+            return s.scale(sp, ss, dp, ds);
+        }
+
+        // every sample of every plane, P010 as 10-bit codes
+        template <typename Fn>
+        void each(Fn fn)
+        {
+            for (int p = 0; p < pixfmt_desc(fmt).planeCount; ++p)
+                for (int y = 0; y < pixfmt_plane_rows(fmt, p, h); ++y)
+                {
+                    uint8_t *row = ref.data[p] + (size_t)ref.stride[p] * y;
+                    const int n = pixfmt_row_bytes(fmt, p, w);
+                    if (fmt == GCAP_FMT_P010)
+                        for (int i = 0; i < n / 2; ++i)
+                            fn(p, i, y, reinterpret_cast<uint16_t *>(row)[i]);
+                    else
+                        for (int i = 0; i < n; ++i)
+                            fn(p, i, y, row[i]);
+                }
+        }
+    };
+
+    template <typename T>
+    void put(T &sample, int v, bool p010)
+    {
+        sample = (T)(p010 ? (v & 1023) << 6 : v & 255);
+    }
+
+    template <typename T>
+    int get(T sample, bool p010)
+    {
+        return p010 ? sample >> 6 : sample;
+    }
+}
+
+// Same size with the bilinear filter is the identity: the horizontal pass
+// picks each sample out of its interleaved component, SIMD body and tail.
+TEST(scaler_identity_exact)
+{
+    std::mt19937 rng(17);
+    for (gcap_pixfmt_t f : kFormats)
+        for (int w : {2, 6, 10, 34})
+        {
+            const bool p010 = f == GCAP_FMT_P010;
+            Image src(f, w, 8), dst(f, w, 8);
+            src.each([&](int, int, int, auto &v)
+                     { put(v, (int)rng(), p010); });
+            PlaneScaler s;
+            CHECK(s.configure(f, w, 8, w, 8, GCAP_SCALE_BILINEAR, 2));
+            CHECK(src.scale(s, dst));
+            std::vector<int> a, b;
+            src.each([&](int, int, int, auto &v)
+                     { a.push_back(get(v, p010)); });
+            dst.each([&](int, int, int, auto &v)
+                     { b.push_back(get(v, p010)); });
+            CHECK(a == b);
+        }
+}
+
+// Weights sum to one, so a flat image stays flat at any size and filter.
+TEST(scaler_flat_stays_flat)
+{
+    const int sizes[][4] = {{64, 36, 22, 14}, {18, 10, 70, 30}, {30, 30, 58, 6}};
+    for (gcap_pixfmt_t f : kFormats)
+        for (gcap_scale_filter_t filt : kFilters)
+            for (const auto &d : sizes)
+            {
+                const bool p010 = f == GCAP_FMT_P010;
+                Image src(f, d[0], d[1]), dst(f, d[2], d[3]);
+                src.each([&](int p, int i, int, auto &v)
+                         { put(v, 100 + p * 40 + (f == GCAP_FMT_ARGB ? i % 4 * 10 : 0), p010); });
+                PlaneScaler s;
+                CHECK(s.configure(f, d[0], d[1], d[2], d[3], filt));
+                CHECK(src.scale(s, dst));
+                bool flat = true;
+                dst.each([&](int p, int i, int, auto &v)
+                         { flat = flat && get(v, p010) == 100 + p * 40 + (f == GCAP_FMT_ARGB ? i % 4 * 10 : 0); });
+                CHECK(flat);
+            }
+}
+
+// Bilinear 2x upscale of a horizontal ramp lands between its neighbours.
+TEST(scaler_ramp_bilinear)
+{
+    const int w = 40, h = 4;
+    Image src(GCAP_FMT_GRAY8, w, h), dst(GCAP_FMT_GRAY8, 2 * w, h);
+    src.each([&](int, int i, int, auto &v)
+             { v = (uint8_t)(i * 6); });
+    PlaneScaler s;
+    CHECK(s.configure(GCAP_FMT_GRAY8, w, h, 2 * w, h, GCAP_SCALE_BILINEAR));
+    CHECK(src.scale(s, dst));
+    bool ok = true;
+    dst.each([&](int, int x, int, auto &v)
+             {
+                 // output x sits at source (x + 0.5) / 2 - 0.5, clamped at the edges
+                 double c = (x + 0.5) / 2.0 - 0.5;
+                 c = c < 0 ? 0 : (c > w - 1 ? w - 1 : c);
+                 ok = ok && std::abs((int)v - (int)(c * 6 + 0.5)) <= 1; });
+    CHECK(ok);
+}
@@ -0,0 +1,50 @@
+// test.h
+#pragma once
+#include <cstdio>
+#include <vector>
+
+// Minimal self-registering test harness: TEST(name) { CHECK(...); }.
+// A failed CHECK prints its location and fails the test without stopping it.
+namespace gcap::test
+{
+    struct Case
+    {
+        const char *name;
+        void (*fn)();
+    };
+
+    inline std::vector<Case> &cases()
+    {
+        static std::vector<Case> all;
+        return all;
+    }
+
+    inline int &failures()
+    {
+        static int n = 0;
+        return n;
+    }
+
+    struct Register
+    {
+        Register(const char *name, void (*fn)()) { cases().push_back({name, fn}); }
+    };
+
+    inline void fail(const char *file, int line, const char *expr)
+    {
+        std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+        ++failures();
+    }
+}
+
+#define TEST(name)                                                  \
+    static void test_##name();                                      \
+    static ::gcap::test::Register testReg_##name{#name, &test_##name}; \
+    static void test_##name()
+
+#define CHECK(expr)                                         \
+    do                                                      \
+    {                                                       \
+        if (!(expr))                                        \
+            ::gcap::test::fail(__FILE__, __LINE__, #expr);  \
+    } while (0)
@@ -0,0 +1,24 @@
+// test_main.cpp
+#include "test.h"
+#include <cstring>
+
+// <test binary> [name-filter]: runs every registered test whose name
+// contains the filter; exits non-zero when any CHECK failed.
+int main(int argc, char **argv)
+{
+    const char *filter = argc > 1 ? argv[1] : "";
+    int run = 0, failed = 0;
+    for (const auto &c : gcap::test::cases())
+    {
+        if (!std::strstr(c.name, filter))
+            continue;
+        const int before = gcap::test::failures();
+        c.fn();
+        ++run;
+        const bool ok = gcap::test::failures() == before;
+        failed += ok ? 0 : 1;
+        std::printf("[%s] %s\n", ok ? "  OK  " : " FAIL ", c.name);
+    }
+    std::printf("%d tests, %d failed\n", run, failed);
+    return failed ? 1 : 0;
+}